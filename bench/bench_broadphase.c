@@ -0,0 +1,75 @@
+#include "bench_util.h"
+#include "body.h"
+#include "collision.h"
+#include "forces.h"
+#include "scene.h"
+#include "shape_utility.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Balls bouncing around a closed box through the scene's collision pipeline.
+// Each ball is registered once, so setup is linear in the number of balls.
+// The last column is the share of narrowphase pairs rejected by their bounds.
+
+const size_t BALL_COUNTS[] = {100, 1000, 5000};
+const size_t TICKS = 500;
+const double RADIUS = 1;
+const double SPACING = 4;
+const double SPEED = 20;
+const double DT = 1e-2;
+const double ELASTICITY = 1;
+
+const size_t BENCH_BALL = 1 << 0;
+const size_t BENCH_WALL = 1 << 1;
+
+void add_wall(scene_t *scene, double x, double y, double w, double h) {
+    sprite_info_t sprite = {.is_sprite = false};
+    body_t *wall = body_init(generate_rect_shape(x, y, w, h), sprite, INFINITY);
+    scene_add_body(scene, wall);
+    scene_add_collider(scene, wall, BENCH_WALL);
+}
+
+int main() {
+    srand(0);
+    printf("%8s %14s %14s %12s %10s\n", "balls", "setup ns", "ns/tick",
+           "pairs/tick", "rejected");
+    for (size_t c = 0; c < sizeof(BALL_COUNTS) / sizeof(*BALL_COUNTS); c++) {
+        size_t n = BALL_COUNTS[c];
+        size_t side = (size_t)ceil(sqrt(n));
+        double size = side * SPACING;
+        double start = now_ns();
+        scene_t *scene = scene_init();
+        create_physics_collision_rule(scene, ELASTICITY, BENCH_BALL, BENCH_BALL);
+        create_physics_collision_rule(scene, ELASTICITY, BENCH_BALL, BENCH_WALL);
+        add_wall(scene, size / 2, -1, size + 4, 2);
+        add_wall(scene, size / 2, size + 1, size + 4, 2);
+        add_wall(scene, -1, size / 2, 2, size + 4);
+        add_wall(scene, size + 1, size / 2, 2, size + 4);
+        sprite_info_t sprite = {.is_sprite = false};
+        for (size_t i = 0; i < n; i++) {
+            vector_t center = {SPACING * (i % side + 0.5),
+                               SPACING * (i / side + 0.5)};
+            body_t *ball = body_init_circle(center, RADIUS, sprite, 1);
+            double angle = 2 * M_PI * rand() / RAND_MAX;
+            body_set_velocity(ball, vec_rotate((vector_t){SPEED, 0}, angle));
+            scene_add_body(scene, ball);
+            scene_add_collider(scene, ball, BENCH_BALL);
+        }
+        double setup_ns = now_ns() - start;
+
+        size_t pairs = 0;
+        collision_reset_stats();
+        start = now_ns();
+        for (size_t t = 0; t < TICKS; t++) {
+            scene_tick(scene, DT);
+            pairs += scene_collision_candidates(scene);
+        }
+        double tick_ns = (now_ns() - start) / TICKS;
+        collision_stats_t stats = collision_get_stats();
+        printf("%8zu %14.0f %14.0f %12.1f %9.1f%%\n", n, setup_ns, tick_ns,
+               (double)pairs / TICKS, 100.0 * stats.rejects / stats.tests);
+        scene_free(scene);
+    }
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include "bench_util.h"
+#include "body.h"
+#include "collision.h"
+#include "polygon.h"
+#include "shape_utility.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Compares the ball-ball narrowphase on 30-gon outlines (SAT) against
+// the circle primitive, over a sweep of colliding and separated pairs.
+// Polygon bodies go through the same SAT, but separated pairs are mostly
+// rejected by their cached bounds first.
+
+const size_t ITERATIONS = 200000;
+const double TEST_RADIUS = 11.25;
+
+vector_t sweep_offset(size_t i) {
+    // distances from 0 to 4 radii, so roughly half of the pairs collide
+    double dist = 4 * TEST_RADIUS * (i % 64) / 64.0;
+    return vec_rotate((vector_t){dist, 0}, i * 0.1);
+}
+
+int main() {
+    polygon_t *outline1 = generate_ball(0, 0, TEST_RADIUS);
+    polygon_t *outline2 = generate_ball(0, 0, TEST_RADIUS);
+    vector_t position = VEC_ZERO;
+    size_t hits = 0;
+    double start = now_ns();
+    for (size_t i = 0; i < ITERATIONS; i++) {
+        vector_t offset = sweep_offset(i);
+        polygon_translate(outline2, vec_subtract(offset, position));
+        position = offset;
+        hits += find_collision(outline1, outline2).collided;
+    }
+    double sat_ns = (now_ns() - start) / ITERATIONS;
+    printf("polygon SAT   %10.1f ns/pair (%zu hits)\n", sat_ns, hits);
+
+    sprite_info_t sprite = {.is_sprite = false};
+    body_t *gon1 = body_init(generate_ball(0, 0, TEST_RADIUS), sprite, 1);
+    body_t *gon2 = body_init(generate_ball(0, 0, TEST_RADIUS), sprite, 1);
+    hits = 0;
+    collision_reset_stats();
+    start = now_ns();
+    for (size_t i = 0; i < ITERATIONS; i++) {
+        body_set_centroid(gon2, sweep_offset(i));
+        hits += find_body_collision(gon1, gon2).collided;
+    }
+    double body_sat_ns = (now_ns() - start) / ITERATIONS;
+    collision_stats_t stats = collision_get_stats();
+    printf("polygon body  %10.1f ns/pair (%zu hits, %.1f%% rejected)\n",
+           body_sat_ns, hits, 100.0 * stats.rejects / stats.tests);
+
+    body_t *ball1 = body_init_circle(VEC_ZERO, TEST_RADIUS, sprite, 1);
+    body_t *ball2 = body_init_circle(VEC_ZERO, TEST_RADIUS, sprite, 1);
+    hits = 0;
+    start = now_ns();
+    for (size_t i = 0; i < ITERATIONS; i++) {
+        body_set_centroid(ball2, sweep_offset(i));
+        hits += find_body_collision(ball1, ball2).collided;
+    }
+    double circle_ns = (now_ns() - start) / ITERATIONS;
+    printf("circle-circle %10.1f ns/pair (%zu hits)\n", circle_ns, hits);
+    printf("speedup       %10.1fx\n", sat_ns / circle_ns);
+
+    polygon_free(outline1);
+    polygon_free(outline2);
+    body_free(gon1);
+    body_free(gon2);
+    body_free(ball1);
+    body_free(ball2);
+    return 0;
+}
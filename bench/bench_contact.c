@@ -0,0 +1,125 @@
+#include "bench_util.h"
+#include "body.h"
+#include "forces.h"
+#include "pool_table.h"
+#include "scene.h"
+#include "shape_utility.h"
+#include "vector.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Measures the contact solver on a break shot at several tick lengths,
+// reporting the passes it needs and how far balls end up inside each other,
+// and on columns of balls resting on a floor under gravity, where every
+// contact pushes on the next and the solver has to carry the weight down.
+
+const double BREAK_DTS[] = {1e-4, 1e-3, 1e-2};
+const double BREAK_SECONDS = 30; // cut off if the balls have not stopped
+const size_t STACK_HEIGHTS[] = {5, 20, 50};
+const size_t STACK_TICKS = 2000;
+const double STACK_DT = 1.0 / 60;
+const double GRAVITY = 1000;
+const size_t STACK_BALL = 1 << 0;
+const size_t STACK_FLOOR = 1 << 1;
+
+// The deepest overlap between any two balls still on the table
+double max_overlap(scene_t *scene) {
+    double deepest = 0;
+    size_t n = scene_bodies(scene);
+    for (size_t i = 0; i < n; i++) {
+        body_t *body1 = scene_get_body(scene, i);
+        if (body_get_shape_kind(body1) != SHAPE_CIRCLE || !is_ball(body1)) {
+            continue;
+        }
+        for (size_t j = i + 1; j < n; j++) {
+            body_t *body2 = scene_get_body(scene, j);
+            if (body_get_shape_kind(body2) != SHAPE_CIRCLE || !is_ball(body2)) {
+                continue;
+            }
+            double gap = vec_magnitude(vec_subtract(body_get_centroid(body1),
+                                                    body_get_centroid(body2))) -
+                         body_get_radius(body1) - body_get_radius(body2);
+            deepest = fmax(deepest, -gap);
+        }
+    }
+    return deepest;
+}
+
+void bench_break(double dt) {
+    scene_t *scene = scene_init();
+    generate_pool_table(scene, false, false);
+    body_add_impulse(get_cueball_body(scene),
+                     vec_rotate((vector_t){1500, 0}, 185 * M_PI / 180));
+    size_t max_ticks = BREAK_SECONDS / dt;
+    size_t ticks = 0;
+    size_t passes = 0;
+    size_t most_passes = 0;
+    double deepest = 0;
+    double elapsed = 0;
+    while (ticks < max_ticks && !balls_stopped(scene)) {
+        double start = now_ns();
+        scene_tick(scene, dt);
+        elapsed += now_ns() - start;
+        ticks++;
+        size_t tick_passes = scene_contact_iterations(scene);
+        passes += tick_passes;
+        if (tick_passes > most_passes) {
+            most_passes = tick_passes;
+        }
+        deepest = fmax(deepest, max_overlap(scene));
+    }
+    printf("%10g %10zu %14.1f %10.2f %10zu %12.4f\n", dt, ticks,
+           elapsed / ticks, (double)passes / ticks, most_passes, deepest);
+    scene_free(scene);
+}
+
+// A column of unit-mass balls dropped onto an immovable floor
+void bench_stack(size_t height) {
+    scene_t *scene = scene_init();
+    scene_add_contact_rule(scene, STACK_BALL, STACK_BALL, 0.5);
+    scene_add_contact_rule(scene, STACK_BALL, STACK_FLOOR, 0.5);
+    body_t *floor = body_init(generate_rect_shape(0, -5, 100, 10),
+                              bench_sprite(), INFINITY);
+    scene_add_body(scene, floor);
+    scene_add_collider(scene, floor, STACK_FLOOR);
+    double radius = 10;
+    for (size_t i = 0; i < height; i++) {
+        body_t *ball = body_init_circle(
+            (vector_t){0, radius + 2 * radius * i}, radius, bench_sprite(), 1);
+        scene_add_body(scene, ball);
+        scene_add_collider(scene, ball, STACK_BALL);
+        create_uniform_gravity(scene, (vector_t){0, -GRAVITY}, ball);
+    }
+    size_t passes = 0;
+    double start = now_ns();
+    for (size_t t = 0; t < STACK_TICKS; t++) {
+        scene_tick(scene, STACK_DT);
+        passes += scene_contact_iterations(scene);
+    }
+    double per_tick = (now_ns() - start) / STACK_TICKS;
+    // how far the column has sunk into itself and the floor
+    body_t *top = scene_get_body(scene, height);
+    double sunk = radius + 2 * radius * (height - 1) -
+                  body_get_centroid(top).y;
+    printf("%10zu %14.1f %10.2f %12.4f %12.4f\n", height, per_tick,
+           (double)passes / STACK_TICKS, sunk,
+           fabs(body_get_velocity(top).y));
+    scene_free(scene);
+}
+
+int main() {
+    printf("%10s %10s %14s %10s %10s %12s\n", "dt", "ticks", "ns/tick",
+           "passes", "most", "max overlap");
+    for (size_t c = 0; c < sizeof(BREAK_DTS) / sizeof(*BREAK_DTS); c++) {
+        bench_break(BREAK_DTS[c]);
+    }
+
+    printf("\n%10s %14s %10s %12s %12s\n", "stacked", "ns/tick", "passes",
+           "sunk", "top speed");
+    for (size_t c = 0; c < sizeof(STACK_HEIGHTS) / sizeof(*STACK_HEIGHTS);
+         c++) {
+        bench_stack(STACK_HEIGHTS[c]);
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include "bench_util.h"
+#include "body.h"
+#include "event_sim.h"
+#include "pool_table.h"
+#include "scene.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Measures the cost of simulating a whole break shot with the event-driven
+// simulator and with scene_tick() at a few step sizes.
+// Table setup is outside the timed region.
+
+const double SHOT_SPEED = 1500;
+const size_t SHOT_ANGLES = 16; // spread over the rack
+const double MAX_TIME = 60;
+const double STEPS[] = {1e-3, 1e-2};
+
+scene_t *racked_table(size_t shot) {
+    scene_t *scene = scene_init();
+    generate_pool_table(scene, false, false);
+    double angle = (shot - SHOT_ANGLES / 2.0) * M_PI / 180;
+    body_set_velocity(get_cueball_body(scene),
+                      vec_rotate((vector_t){SHOT_SPEED, 0}, angle));
+    return scene;
+}
+
+int main() {
+    printf("%12s %14s %14s\n", "engine", "us/shot", "steps/shot");
+    size_t events = 0;
+    double elapsed = 0;
+    for (size_t shot = 0; shot < SHOT_ANGLES; shot++) {
+        scene_t *scene = racked_table(shot);
+        event_sim_t *sim = pool_event_sim(scene);
+        double start = now_ns();
+        events += event_sim_run(sim, MAX_TIME);
+        elapsed += now_ns() - start;
+        event_sim_free(sim);
+        scene_free(scene);
+    }
+    printf("%12s %14.1f %14.1f\n", "event", elapsed / 1e3 / SHOT_ANGLES,
+           (double)events / SHOT_ANGLES);
+
+    for (size_t s = 0; s < sizeof(STEPS) / sizeof(*STEPS); s++) {
+        size_t ticks = 0;
+        elapsed = 0;
+        for (size_t shot = 0; shot < SHOT_ANGLES; shot++) {
+            scene_t *scene = racked_table(shot);
+            double start = now_ns();
+            double time = 0;
+            do {
+                scene_tick(scene, STEPS[s]);
+                ticks++;
+                time += STEPS[s];
+            } while (!balls_stopped(scene) && time < MAX_TIME);
+            elapsed += now_ns() - start;
+            scene_free(scene);
+        }
+        char name[32];
+        snprintf(name, sizeof(name), "dt=%g", STEPS[s]);
+        printf("%12s %14.1f %14.1f\n", name, elapsed / 1e3 / SHOT_ANGLES,
+               (double)ticks / SHOT_ANGLES);
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include "bench_util.h"
+#include "gravity.h"
+#include "kinematics.h"
+#include "rng.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Compares mutual gravity on 1k, 10k and 100k bodies computed pairwise
+// and with the Barnes-Hut tree at several opening angles (see gravity.h).
+// Errors are measured against exact pairwise sums on a sample of bodies,
+// relative to the sample's RMS force, since bodies near the middle feel
+// almost no net force. Pairwise gravity on 100k bodies is too slow to run in
+// full, so its time is extrapolated from the sample.
+
+const double BENCH_G = 15;
+const double BENCH_MIN_DISTANCE = 5;
+const size_t BENCH_SAMPLE = 256;
+const double THETAS[] = {0.3, 0.5, 0.8};
+const size_t THETA_COUNT = sizeof(THETAS) / sizeof(THETAS[0]);
+const size_t MAX_FULL_PAIRWISE = 10000;
+
+// A disk of bodies, denser towards the middle like a galaxy, with
+// 10 bodies per 100 x 100 area on average
+kinematics_t *make_bodies(size_t n) {
+    rng_t rng;
+    rng_seed(&rng, n);
+    kinematics_t *kin = kinematics_init(n);
+    double radius = 100 * sqrt(n / (10 * M_PI));
+    for (size_t i = 0; i < n; i++) {
+        double r = radius * rng_uniform(&rng);
+        double angle = 2 * M_PI * rng_uniform(&rng);
+        vector_t centroid = {r * cos(angle), r * sin(angle)};
+        double mass = 1 + 9 * rng_uniform(&rng);
+        size_t slot = kinematics_add(kin, NULL, centroid, 1 / mass);
+        kin->gravitating[slot] = true;
+    }
+    return kin;
+}
+
+// The force on a slot as a force creator per pair would give it, with the
+// same plain arithmetic as the tree's inner loop
+vector_t pairwise_force(kinematics_t *kin, size_t slot) {
+    double x = kin->centroid[slot].x;
+    double y = kin->centroid[slot].y;
+    double fx = 0;
+    double fy = 0;
+    for (size_t j = 0; j < kin->size; j++) {
+        double dx = kin->centroid[j].x - x;
+        double dy = kin->centroid[j].y - y;
+        double squared = dx * dx + dy * dy;
+        if (j != slot && squared >= BENCH_MIN_DISTANCE * BENCH_MIN_DISTANCE) {
+            double scale = 1 / (kin->inv_mass[j] * squared * sqrt(squared));
+            fx += scale * dx;
+            fy += scale * dy;
+        }
+    }
+    double scale = BENCH_G / kin->inv_mass[slot];
+    return (vector_t){scale * fx, scale * fy};
+}
+
+void clear_forces(kinematics_t *kin) {
+    for (size_t i = 0; i < kin->size; i++) {
+        kin->force[i] = VEC_ZERO;
+    }
+}
+
+// RMS and maximum error of the computed forces on the sample,
+// relative to the RMS exact force
+void force_errors(kinematics_t *kin, vector_t *exact, double *rms,
+                  double *max) {
+    size_t stride = kin->size / BENCH_SAMPLE;
+    double error_sum = 0;
+    double force_sum = 0;
+    double max_error = 0;
+    for (size_t k = 0; k < BENCH_SAMPLE; k++) {
+        vector_t error = vec_subtract(kin->force[k * stride], exact[k]);
+        double squared = vec_dot(error, error);
+        error_sum += squared;
+        force_sum += vec_dot(exact[k], exact[k]);
+        max_error = squared > max_error ? squared : max_error;
+    }
+    *rms = sqrt(error_sum / force_sum);
+    *max = sqrt(max_error * BENCH_SAMPLE / force_sum);
+}
+
+void print_row(size_t n, const char *mode, double ns, double per_body,
+               double rms, double max) {
+    printf("%7zu %14s %12.2f %12.1f %12.2e %12.2e\n", n, mode, ns / 1e6,
+           per_body, rms, max);
+}
+
+void bench_bodies(size_t n) {
+    kinematics_t *kin = make_bodies(n);
+    size_t stride = n / BENCH_SAMPLE;
+    vector_t exact[BENCH_SAMPLE];
+    double start = now_ns();
+    for (size_t k = 0; k < BENCH_SAMPLE; k++) {
+        exact[k] = pairwise_force(kin, k * stride);
+    }
+    double sample_ns = now_ns() - start;
+    print_row(n, "pairwise (est)", sample_ns * n / BENCH_SAMPLE, n - 1, 0, 0);
+
+    gravity_t *gravity = gravity_init(BENCH_G, 0, BENCH_MIN_DISTANCE);
+    double rms, max;
+    if (n <= MAX_FULL_PAIRWISE) {
+        clear_forces(kin);
+        start = now_ns();
+        gravity_apply(gravity, kin, NULL);
+        double ns = now_ns() - start;
+        force_errors(kin, exact, &rms, &max);
+        print_row(n, "tree 0", ns, (double)gravity_interactions(gravity) / n,
+                  rms, max);
+    }
+    for (size_t t = 0; t < THETA_COUNT; t++) {
+        gravity_set_theta(gravity, THETAS[t]);
+        // the first call sizes the tree's memory, like a scene's first tick
+        gravity_apply(gravity, kin, NULL);
+        size_t rounds = n >= 100000 ? 2 : 10;
+        double ns = 0;
+        for (size_t r = 0; r < rounds; r++) {
+            clear_forces(kin);
+            start = now_ns();
+            gravity_apply(gravity, kin, NULL);
+            ns += now_ns() - start;
+        }
+        force_errors(kin, exact, &rms, &max);
+        char mode[16];
+        snprintf(mode, sizeof(mode), "tree %.1f", THETAS[t]);
+        print_row(n, mode, ns / rounds,
+                  (double)gravity_interactions(gravity) / n, rms, max);
+    }
+    gravity_free(gravity);
+    kinematics_free(kin);
+}
+
+int main() {
+    printf("%7s %14s %12s %12s %12s %12s\n", "bodies", "mode", "ms/tick",
+           "forces/body", "rms error", "max error");
+    bench_bodies(1000);
+    bench_bodies(10000);
+    bench_bodies(100000);
+    return 0;
+}
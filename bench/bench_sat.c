@@ -0,0 +1,82 @@
+#include "bench_util.h"
+#include "collision.h"
+#include "graphics.h"
+#include "polygon.h"
+#include "sat.h"
+#include "shape_utility.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Compares the SAT projection kernels (see sat.h) on a 30-gon ball and the
+// 11-vertex top cushion of the pool table: projecting a shape on each of
+// its edge normals one at a time and as one batch, and the full
+// polygon-polygon test of a ball resting against the cushion.
+
+const size_t PROJECTION_ROUNDS = 200000;
+const size_t COLLISION_ROUNDS = 100000;
+
+// The unit edge normals, as find_collision() uses them
+size_t edge_normals(polygon_t *shape, vector_t *axes) {
+    size_t n = polygon_size(shape);
+    vector_t *vertices = polygon_vertices(shape);
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        vector_t side = vec_subtract(vertices[(i + 1) % n], vertices[i]);
+        if (vec_magnitude(side) > 0) {
+            axes[count++] = vec_unit((vector_t){side.y, -side.x});
+        }
+    }
+    return count;
+}
+
+// ns per axis, projecting one axis at a time or all of them at once
+void bench_projections(polygon_t *shape, double *single_ns, double *batch_ns) {
+    size_t n = polygon_size(shape);
+    vector_t *vertices = polygon_vertices(shape);
+    vector_t axes[n];
+    vector_t projs[n];
+    size_t n_axes = edge_normals(shape, axes);
+    double sink = 0;
+    double start = now_ns();
+    for (size_t r = 0; r < PROJECTION_ROUNDS; r++) {
+        for (size_t k = 0; k < n_axes; k++) {
+            sink += sat_project(vertices, n, axes[k]).y;
+        }
+    }
+    *single_ns = (now_ns() - start) / (PROJECTION_ROUNDS * n_axes);
+    start = now_ns();
+    for (size_t r = 0; r < PROJECTION_ROUNDS; r++) {
+        sat_project_axes(vertices, n, axes, n_axes, projs);
+        sink += projs[r % n_axes].y;
+    }
+    *batch_ns = (now_ns() - start) / (PROJECTION_ROUNDS * n_axes);
+    if (sink == 0) {
+        puts("");
+    }
+}
+
+int main() {
+    polygon_t *ball = generate_ball(500, 394, 11.25);
+    polygon_t *wall = generate_table_top_shape();
+    printf("%8s %12s %12s %12s %12s %12s\n", "kernel", "ball ns/ax",
+           "ball batch", "wall ns/ax", "wall batch", "ns/pair");
+    for (sat_kernel_t k = SAT_SCALAR; k <= SAT_AVX2; k++) {
+        if (!sat_kernel_supported(k)) {
+            continue;
+        }
+        sat_set_kernel(k);
+        double ball_single, ball_batch, wall_single, wall_batch;
+        bench_projections(ball, &ball_single, &ball_batch);
+        bench_projections(wall, &wall_single, &wall_batch);
+        double start = now_ns();
+        for (size_t r = 0; r < COLLISION_ROUNDS; r++) {
+            find_collision(ball, wall);
+        }
+        double pair_ns = (now_ns() - start) / COLLISION_ROUNDS;
+        printf("%8s %12.2f %12.2f %12.2f %12.2f %12.1f\n", sat_kernel_name(k),
+               ball_single, ball_batch, wall_single, wall_batch, pair_ns);
+    }
+    polygon_free(ball);
+    polygon_free(wall);
+    return 0;
+}
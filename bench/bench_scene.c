@@ -0,0 +1,210 @@
+#include "bench_util.h"
+#include "body.h"
+#include "forces.h"
+#include "pool_table.h"
+#include "scene.h"
+#include "shape_utility.h"
+#include "slab.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Measures the cost of scene_tick() integration (no force creators)
+// for scenes of different sizes, removing bodies in batches, the bookkeeping
+// of pair force creators, moving and turning bodies with and without asking
+// for their outlines, drag on every ball like the pool table's, and rolling
+// back a pool table.
+
+const size_t BODY_COUNTS[] = {16, 1000, 10000};
+const size_t TOTAL_BODY_TICKS = 50000000; // ticks * bodies per measurement
+const double DT = 1e-3;
+const size_t SNAPSHOTS = 100000; // each also freed
+const size_t ROLLBACKS = 1000000;
+const size_t REMOVAL_BODIES = 10000;
+const size_t REMOVAL_BATCHES[] = {10, 100, 1000};
+const size_t FORCER_BODIES = 100;
+const size_t FORCER_COUNTS[] = {100, 1000, 10000};
+const size_t TOTAL_FORCER_TICKS = 50000000; // ticks * force creators
+const size_t TRANSFORM_BODIES = 1000;
+const size_t TRANSFORM_ROUNDS = 1000;
+const size_t DRAG_BODIES[] = {16, 1000, 10000};
+
+// Removes every body of a scene, batch bodies per tick, like a row of
+// bricks or a volley of lasers
+void bench_removal(size_t batch) {
+    scene_t *scene = scene_init();
+    body_t **bodies = malloc(sizeof(body_t *) * REMOVAL_BODIES);
+    for (size_t i = 0; i < REMOVAL_BODIES; i++) {
+        bodies[i] = body_init_circle((vector_t){i % 100, i / 100}, 1,
+                                     bench_sprite(), 1);
+        scene_add_body(scene, bodies[i]);
+    }
+    double start = now_ns();
+    for (size_t i = 0; i < REMOVAL_BODIES; i++) {
+        // spread over the scene, so the remaining bodies have to move up
+        body_remove(bodies[(i * 7919) % REMOVAL_BODIES]);
+        if ((i + 1) % batch == 0) {
+            scene_tick(scene, DT);
+        }
+    }
+    double per_removal = (now_ns() - start) / REMOVAL_BODIES;
+    printf("%10zu %14.1f\n", batch, per_removal);
+    free(bodies);
+    scene_free(scene);
+}
+
+void no_force(void *aux) {}
+
+// Each tick with nothing removed, then removes one body per tick until
+// none are left; pair force creators go away with either of their bodies
+void bench_forcers(size_t forcers) {
+    scene_t *scene = scene_init();
+    body_t *bodies[FORCER_BODIES];
+    for (size_t i = 0; i < FORCER_BODIES; i++) {
+        bodies[i] = body_init_circle((vector_t){i, 0}, 1, bench_sprite(), 1);
+        scene_add_body(scene, bodies[i]);
+    }
+    for (size_t i = 0; i < forcers; i++) {
+        list_t *pair = list_init(2, NULL);
+        list_add(pair, bodies[i % FORCER_BODIES]);
+        list_add(pair, bodies[(i * 7 + 1) % FORCER_BODIES]);
+        scene_add_bodies_force_creator(scene, no_force, NULL, pair, NULL);
+    }
+    size_t ticks = TOTAL_FORCER_TICKS / forcers;
+    double start = now_ns();
+    for (size_t t = 0; t < ticks; t++) {
+        scene_tick(scene, DT);
+    }
+    double per_tick = (now_ns() - start) / ticks;
+    start = now_ns();
+    for (size_t i = 0; i < FORCER_BODIES; i++) {
+        body_remove(bodies[i]);
+        scene_tick(scene, DT);
+    }
+    double per_removal = (now_ns() - start) / FORCER_BODIES;
+    printf("%10zu %14.1f %14.1f\n", forcers, per_tick, per_removal);
+    scene_free(scene);
+}
+
+// Teleports and turns balls with 30-gon outlines every round; the outline is
+// only placed when asked for, once per round in the second measurement
+void bench_transforms() {
+    body_t *bodies[TRANSFORM_BODIES];
+    for (size_t i = 0; i < TRANSFORM_BODIES; i++) {
+        bodies[i] = body_init_circle((vector_t){i, 0}, 1, bench_sprite(), 1);
+        body_get_shape(bodies[i]);
+    }
+    size_t ops = TRANSFORM_BODIES * TRANSFORM_ROUNDS;
+    double start = now_ns();
+    for (size_t r = 0; r < TRANSFORM_ROUNDS; r++) {
+        for (size_t i = 0; i < TRANSFORM_BODIES; i++) {
+            body_set_centroid(bodies[i], (vector_t){i, r});
+            body_set_rotation(bodies[i], r * 0.01);
+        }
+    }
+    double per_move = (now_ns() - start) / ops;
+    double checksum = 0;
+    start = now_ns();
+    for (size_t r = 0; r < TRANSFORM_ROUNDS; r++) {
+        for (size_t i = 0; i < TRANSFORM_BODIES; i++) {
+            body_set_centroid(bodies[i], (vector_t){i, r});
+            body_set_rotation(bodies[i], r * 0.01);
+            checksum += polygon_get(body_get_shape(bodies[i]), 0).x;
+        }
+    }
+    double per_placed = (now_ns() - start) / ops;
+    slab_t *meshes = slab_find("mesh");
+    printf("%10zu %14.1f %14.1f %10zu\n", TRANSFORM_BODIES, per_move,
+           per_placed, meshes == NULL ? 0 : slab_stats(meshes).live);
+    for (size_t i = 0; i < TRANSFORM_BODIES; i++) {
+        body_free(bodies[i]);
+    }
+    if (checksum == 0) {
+        puts("");
+    }
+}
+
+// Linear and constant drag on every body, which keeps them all moving
+void bench_drag(size_t n) {
+    scene_t *scene = scene_init();
+    for (size_t i = 0; i < n; i++) {
+        body_t *body = body_init_circle((vector_t){i % 100, i / 100}, 1,
+                                        bench_sprite(), 1);
+        body_set_velocity(body, (vector_t){1e6, (double)(i % 7)});
+        scene_add_body(scene, body);
+        create_drag(scene, 0.1, body);
+        create_constant_drag_force(scene, 1, body);
+    }
+    size_t ticks = TOTAL_BODY_TICKS / n;
+    double start = now_ns();
+    for (size_t t = 0; t < ticks; t++) {
+        scene_tick(scene, DT);
+    }
+    double per_tick = (now_ns() - start) / ticks;
+    printf("%10zu %14.1f %14.3f %10zu\n", n, per_tick, per_tick / n,
+           scene_force_creators(scene));
+    scene_free(scene);
+}
+
+int main() {
+    printf("%10s %14s %14s\n", "bodies", "ns/tick", "ns/body-tick");
+    for (size_t c = 0; c < sizeof(BODY_COUNTS) / sizeof(*BODY_COUNTS); c++) {
+        size_t n = BODY_COUNTS[c];
+        scene_t *scene = scene_init();
+        for (size_t i = 0; i < n; i++) {
+            body_t *body = body_init(generate_ball(i % 100, i / 100, 1),
+                                     bench_sprite(), 1);
+            body_set_velocity(body, (vector_t){1, (double)(i % 7)});
+            scene_add_body(scene, body);
+        }
+        size_t ticks = TOTAL_BODY_TICKS / n;
+        double start = now_ns();
+        for (size_t t = 0; t < ticks; t++) {
+            scene_tick(scene, DT);
+        }
+        double per_tick = (now_ns() - start) / ticks;
+        printf("%10zu %14.1f %14.3f\n", n, per_tick, per_tick / n);
+        scene_free(scene);
+    }
+
+    printf("\n%10s %14s\n", "batch", "ns/removal");
+    for (size_t c = 0; c < sizeof(REMOVAL_BATCHES) / sizeof(*REMOVAL_BATCHES);
+         c++) {
+        bench_removal(REMOVAL_BATCHES[c]);
+    }
+
+    printf("\n%10s %14s %14s\n", "forcers", "ns/tick", "ns/removal");
+    for (size_t c = 0; c < sizeof(FORCER_COUNTS) / sizeof(*FORCER_COUNTS);
+         c++) {
+        bench_forcers(FORCER_COUNTS[c]);
+    }
+
+    printf("\n%10s %14s %14s %10s\n", "dragged", "ns/tick", "ns/body-tick",
+           "forcers");
+    for (size_t c = 0; c < sizeof(DRAG_BODIES) / sizeof(*DRAG_BODIES); c++) {
+        bench_drag(DRAG_BODIES[c]);
+    }
+
+    printf("\n%10s %14s %14s %10s\n", "bodies", "ns/move+turn", "ns/placed",
+           "meshes");
+    bench_transforms();
+
+    scene_t *scene = scene_init();
+    generate_pool_table(scene, false, false);
+    double start = now_ns();
+    for (size_t i = 0; i < SNAPSHOTS; i++) {
+        scene_snapshot_free(scene, scene_snapshot(scene));
+    }
+    double per_snapshot = (now_ns() - start) / SNAPSHOTS;
+    scene_snapshot_t *snapshot = scene_snapshot(scene);
+    start = now_ns();
+    for (size_t i = 0; i < ROLLBACKS; i++) {
+        scene_restore(scene, snapshot);
+    }
+    double per_restore = (now_ns() - start) / ROLLBACKS;
+    printf("\n%10s %14s %14s\n", "bodies", "ns/snapshot", "ns/restore");
+    printf("%10zu %14.1f %14.1f\n", scene_bodies(scene), per_snapshot,
+           per_restore);
+    scene_snapshot_free(scene, snapshot);
+    scene_free(scene);
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include "bench_util.h"
+#include "body.h"
+#include "forces.h"
+#include "scene.h"
+#include "thread_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Speedup of scene_tick() on a thread pool (see scene_set_thread_pool())
+// with 1 to 32 threads over ticking without one, for three kinds of scene:
+// n-body gravity with a force creator per pair, a large board of bodies
+// linked by springs with drag (integration-heavy), and mutual gravity on a
+// Barnes-Hut tree. Each run also checks that the final state is bit-for-bit
+// the same as without a pool.
+
+const size_t THREAD_COUNTS[] = {1, 2, 4, 8, 16, 32};
+const size_t THREAD_RUNS = sizeof(THREAD_COUNTS) / sizeof(THREAD_COUNTS[0]);
+const size_t PAIR_BODIES = 600;
+const size_t BOARD_BODIES = 200000;
+const size_t TREE_BODIES = 20000;
+const size_t BENCH_TICKS = 20;
+const double BENCH_DT = 1e-3;
+
+// Bodies on a square grid with a little jitter, so no two are aligned
+void add_grid(scene_t *scene, size_t n, double spacing) {
+    size_t side = 1;
+    while (side * side < n) {
+        side++;
+    }
+    for (size_t i = 0; i < n; i++) {
+        vector_t centroid = {(i % side) * spacing + (i * 7 % 13) * 0.01,
+                             (i / side) * spacing + (i * 11 % 17) * 0.01};
+        body_t *body = body_init_circle(centroid, 1, bench_sprite(), 1 + i % 5);
+        scene_add_body(scene, body);
+    }
+}
+
+scene_t *make_pairs() {
+    scene_t *scene = scene_init();
+    add_grid(scene, PAIR_BODIES, 20);
+    for (size_t i = 0; i < PAIR_BODIES; i++) {
+        for (size_t j = i + 1; j < PAIR_BODIES; j++) {
+            create_newtonian_gravity(scene, 10, scene_get_body(scene, i),
+                                     scene_get_body(scene, j));
+        }
+    }
+    return scene;
+}
+
+scene_t *make_board() {
+    scene_t *scene = scene_init();
+    add_grid(scene, BOARD_BODIES, 10);
+    for (size_t i = 0; i < BOARD_BODIES; i++) {
+        body_t *body = scene_get_body(scene, i);
+        create_drag(scene, 0.1, body);
+        create_uniform_gravity(scene, (vector_t){0, -9.8}, body);
+        if (i % 50 != 0) {
+            create_spring(scene, 2, scene_get_body(scene, i - 1), body);
+        }
+    }
+    return scene;
+}
+
+scene_t *make_tree() {
+    scene_t *scene = scene_init();
+    add_grid(scene, TREE_BODIES, 20);
+    for (size_t i = 0; i < TREE_BODIES; i++) {
+        body_set_gravitating(scene_get_body(scene, i), true);
+    }
+    create_mutual_gravity(scene, 10, 0.5);
+    return scene;
+}
+
+// ms per tick, and the final centroids and velocities
+double run(scene_t *(*make)(), thread_pool_t *pool, vector_t *state) {
+    scene_t *scene = make();
+    scene_set_thread_pool(scene, pool);
+    scene_tick(scene, BENCH_DT); // builds the schedule and tree memory
+    double start = now_ns();
+    for (size_t t = 0; t < BENCH_TICKS; t++) {
+        scene_tick(scene, BENCH_DT);
+    }
+    double ms = (now_ns() - start) / 1e6 / BENCH_TICKS;
+    for (size_t i = 0; i < scene_bodies(scene); i++) {
+        body_t *body = scene_get_body(scene, i);
+        state[2 * i] = body_get_centroid(body);
+        state[2 * i + 1] = body_get_velocity(body);
+    }
+    scene_free(scene);
+    return ms;
+}
+
+void bench_scene(const char *name, scene_t *(*make)(), size_t bodies) {
+    vector_t *expected = malloc(sizeof(vector_t) * 2 * bodies);
+    vector_t *state = malloc(sizeof(vector_t) * 2 * bodies);
+    double serial = run(make, NULL, expected);
+    printf("%8s %8s %10.2f %8s\n", name, "none", serial, "-");
+    for (size_t r = 0; r < THREAD_RUNS; r++) {
+        thread_pool_t *pool = thread_pool_init(THREAD_COUNTS[r]);
+        double ms = run(make, pool, state);
+        bool same = memcmp(state, expected, sizeof(vector_t) * 2 * bodies) == 0;
+        printf("%8s %8zu %10.2f %7.2fx %s\n", name, thread_pool_threads(pool),
+               ms, serial / ms, same ? "" : "MISMATCH");
+        thread_pool_free(pool);
+    }
+    free(expected);
+    free(state);
+}
+
+int main() {
+    printf("%8s %8s %10s %8s\n", "scene", "threads", "ms/tick", "speedup");
+    bench_scene("pairs", make_pairs, PAIR_BODIES);
+    bench_scene("board", make_board, BOARD_BODIES);
+    bench_scene("tree", make_tree, TREE_BODIES);
+    return 0;
+}
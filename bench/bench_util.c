@@ -0,0 +1,10 @@
+#include "bench_util.h"
+#include <time.h>
+
+double now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+sprite_info_t bench_sprite() { return (sprite_info_t){.is_sprite = false}; }
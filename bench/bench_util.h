@@ -0,0 +1,22 @@
+/** Common functions for benchmarks. */
+
+#ifndef __BENCH_UTIL_H__
+#define __BENCH_UTIL_H__
+
+#include "graphics.h"
+
+/**
+ * Reads a monotonic clock, for timing the code between two calls.
+ *
+ * @return the time in nanoseconds since an arbitrary start
+ */
+double now_ns();
+
+/**
+ * Makes sprite info that draws nothing, for bodies that are only simulated.
+ *
+ * @return the sprite info
+ */
+sprite_info_t bench_sprite();
+
+#endif // #ifndef __BENCH_UTIL_H__
@@ -25,7 +25,7 @@ typedef struct state {
 
 /**
  * Creates a star-shaped polygon
- * Returns a polygon stored as a vec_list_t*
+ * Returns a polygon stored as a list_t*
  */
 list_t *create_star(size_t outer_radius, size_t inner_radius, size_t num_points,
                     size_t center_x, size_t center_y) {
@@ -55,6 +55,11 @@ const size_t WALL_ID = 4;
 const size_t HEALTHBAR_ID = 5;
 const size_t HEALTHBAR_BG_ID = 6;
 
+// Collision categories, see scene_add_collider()
+const size_t BALL_COLLIDER = 1 << 0;
+const size_t BRICK_COLLIDER = 1 << 1;
+const size_t SOLID_COLLIDER = 1 << 2; // paddle and walls
+
 const double STARTING_RED = 0.99;
 const double STARTING_GREEN = 0.01;
 const double STARTING_BLUE = 0.01;
@@ -230,18 +235,20 @@ void player_handler(state_t *state, char key, key_event_type_t type,
 }
 
 void ball_collision_checker(state_t *state) {
-  body_t *ball = scene_get_body(state->scene, 0);
+  create_destructive_physics_collision_rule(state->scene, ELASTICITY,
+                                            BALL_COLLIDER, BRICK_COLLIDER);
+  create_physics_collision_rule(state->scene, ELASTICITY, SOLID_COLLIDER,
+                                BALL_COLLIDER);
 
-  for (size_t i = 1; i < scene_bodies(state->scene); i++) {
-    body_t *body1 = scene_get_body(state->scene, i);
-    if (*(size_t *)body_get_info(body1) == BRICK_ID) {
-      create_destructive_physics_collision(state->scene, ELASTICITY, ball,
-                                           body1);
-    } else if (*(size_t *)body_get_info(body1) == HEALTHBAR_BG_ID ||
-               *(size_t *)body_get_info(body1) == HEALTHBAR_ID) {
-      continue;
-    } else {
-      create_physics_collision(state->scene, ELASTICITY, body1, ball);
+  for (size_t i = 0; i < scene_bodies(state->scene); i++) {
+    body_t *body = scene_get_body(state->scene, i);
+    size_t id = *(size_t *)body_get_info(body);
+    if (id == BALL_ID) {
+      scene_add_collider(state->scene, body, BALL_COLLIDER);
+    } else if (id == BRICK_ID) {
+      scene_add_collider(state->scene, body, BRICK_COLLIDER);
+    } else if (id == PADDLE_ID || id == WALL_ID) {
+      scene_add_collider(state->scene, body, SOLID_COLLIDER);
     }
   }
 }
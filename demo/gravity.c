@@ -6,7 +6,6 @@
 #include "scene.h"
 #include "sdl_wrapper.h"
 #include "state.h"
-#include "vec_list.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
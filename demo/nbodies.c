@@ -27,6 +27,7 @@ const vector_t MIN_VELOCITY = (vector_t){.x = -10, .y = -10};
 const vector_t MAX_VELOCITY = (vector_t){.x = 10, .y = 10};
 // gravitational accelaration ($\vec{g}$)
 const double G = 15;
+const double THETA = 0.5;
 
 typedef struct state {
   scene_t *scene;
@@ -108,8 +109,11 @@ state_t *emscripten_init() {
 
   init_state->scene = scene_init();
   for (size_t i = 0; i < NUM_BODIES; i++) {
-    scene_add_body(init_state->scene, generate_random_body());
+    body_t *body = generate_random_body();
+    scene_add_body(init_state->scene, body);
+    body_set_gravitating(body, true);
   }
+  create_mutual_gravity(init_state->scene, G, THETA);
   return init_state;
 }
 
@@ -117,10 +121,6 @@ void emscripten_main(state_t *state) {
   sdl_clear();
   double dt = time_since_last_tick();
   for (size_t i = 0; i < scene_bodies(state->scene); i++) {
-    for (size_t j = i + 1; j < scene_bodies(state->scene); j++) {
-      create_newtonian_gravity(state->scene, G, scene_get_body(state->scene, i),
-                               scene_get_body(state->scene, j));
-    }
     body_tick(scene_get_body(state->scene, i), dt);
   }
   scene_tick(state->scene, dt);
@@ -29,20 +29,21 @@
 
 #define BALL_MASS 2.0
 
+// Collision categories, see scene_add_collider()
+#define BALL_CATEGORY (1 << 0)
+#define WALL_CATEGORY (1 << 1) // or peg
+#define FROZEN_CATEGORY (1 << 2)
+
 #define BALL_COLOR ((rgb_color_t) {1, 0, 0})
 #define PEG_COLOR ((rgb_color_t) {0, 1, 0})
 #define WALL_COLOR ((rgb_color_t) {0, 0, 1})
 
-#define G 6.67E-11 // N m^2 / kg^2
-#define M 6E24 // kg
 #define g 9.8 // m / s^2
-#define R (sqrt(G * M / g)) // m
 
 typedef enum {
     BALL,
     FROZEN,
-    WALL, // or peg
-    GRAVITY
+    WALL // or peg
 } body_type_t;
 
 body_type_t *make_type_info(body_type_t type) {
@@ -103,24 +104,6 @@ vector_t get_peg_center(size_t row, size_t col) {
     return center;
 }
 
-/** Creates an Earth-like mass to accelerate the balls */
-void add_gravity_body(scene_t *scene) {
-    // Will be offscreen, so shape is irrelevant
-    list_t *gravity_ball = rect_init(1, 1);
-    body_t *body = body_init_with_info(
-        gravity_ball,
-        M,
-        WALL_COLOR,
-        make_type_info(GRAVITY),
-        free
-    );
-
-    // Move a distnace R below the scene
-    vector_t gravity_center = {.x = MAX.x / 2, .y = -R};
-    body_set_centroid(body, gravity_center);
-    scene_add_body(scene, body);
-}
-
 /** Creates a ball with the given starting position and velocity */
 body_t *get_ball(vector_t center, vector_t velocity) {
     list_t *shape = circle_init(BALL_RADIUS);
@@ -151,13 +134,7 @@ void freeze(body_t *ball, body_t *target, vector_t axis, void *aux) {
     scene_add_body(scene, frozen);
 
     // Make other falling bodies freeze when they collide with this body
-    size_t body_count = scene_bodies(scene);
-    for (size_t i = 0; i < body_count; i++) {
-        body_t *body = scene_get_body(scene, i);
-        if (get_type(body) == BALL) {
-            create_collision(scene, body, frozen, freeze, scene, NULL);
-        }
-    }
+    scene_add_collider(scene, frozen, FROZEN_CATEGORY);
 }
 
 /** Adds a ball to the scene */
@@ -168,30 +145,24 @@ void add_ball(scene_t *scene) {
         .y = DROP_Y
     };
     body_t *ball = get_ball(ball_center, START_VELOCITY);
-    size_t body_count = scene_bodies(scene);
     scene_add_body(scene, ball);
+    // Collides according to add_peg_collision_rules()
+    scene_add_collider(scene, ball, BALL_CATEGORY);
+    // Earth's gravity, without a force creator per ball
+    create_uniform_gravity(scene, (vector_t){0, -g}, ball);
+}
 
-    // Add force creators with other bodies
-    for (size_t i = 0; i < body_count; i++) {
-        body_t *body = scene_get_body(scene, i);
-        switch (get_type(body)) {
-            case BALL:
-                // Bounce off other balls
-                create_physics_collision(scene, BALL_ELASTICITY, ball, body);
-                break;
-            case WALL:
-                // Bounce off walls and pegs
-                create_physics_collision(scene, PEG_ELASTICITY, ball, body);
-                break;
-            case FROZEN:
-                // Freeze when hitting the ground or frozen balls
-                create_collision(scene, ball, body, freeze, scene, NULL);
-                break;
-            case GRAVITY:
-                // Simulate earth's gravity acting on the ball
-                create_newtonian_gravity(scene, G, body, ball);
-        }
-    }
+/** Sets up the collisions between each category of bodies */
+void add_peg_collision_rules(scene_t *scene) {
+    // Bounce off other balls
+    create_physics_collision_rule(scene, BALL_ELASTICITY, BALL_CATEGORY,
+                                  BALL_CATEGORY);
+    // Bounce off walls and pegs
+    create_physics_collision_rule(scene, PEG_ELASTICITY, BALL_CATEGORY,
+                                  WALL_CATEGORY);
+    // Freeze when hitting the ground or frozen balls
+    scene_add_collision_rule(scene, BALL_CATEGORY, FROZEN_CATEGORY, freeze,
+                             scene, NULL);
 }
 
 /** Adds the pegs to the scene */
@@ -209,6 +180,7 @@ void add_pegs(scene_t *scene) {
             );
             body_set_centroid(body, get_peg_center(i, j));
             scene_add_body(scene, body);
+            scene_add_collider(scene, body, WALL_CATEGORY);
         }
     }
 }
@@ -227,18 +199,21 @@ void add_walls(scene_t *scene) {
         free
     );
     scene_add_body(scene, body);
+    scene_add_collider(scene, body, WALL_CATEGORY);
 
     rect = rect_init(WALL_LENGTH, WALL_WIDTH);
     polygon_translate(rect, (vector_t) {.x = MAX.x - WALL_LENGTH / 2, .y = 0.0});
     polygon_rotate(rect, -WALL_ANGLE, (vector_t) {.x = MAX.x, .y = 0.0});
     body = body_init_with_info(rect, INFINITY, WALL_COLOR, make_type_info(WALL), free);
     scene_add_body(scene, body);
+    scene_add_collider(scene, body, WALL_CATEGORY);
 
     // Ground is special; it freezes balls when they touch it
     rect = rect_init(MAX.x, WALL_WIDTH);
     body = body_init_with_info(rect, INFINITY, WALL_COLOR, make_type_info(FROZEN), free);
     body_set_centroid(body, (vector_t) {.x = MAX.x / 2, .y = WALL_WIDTH / 2});
     scene_add_body(scene, body);
+    scene_add_collider(scene, body, FROZEN_CATEGORY);
 }
 
 typedef struct state {
@@ -252,7 +227,7 @@ state_t *emscripten_init(void) {
     sdl_init(VEC_ZERO, MAX);
     scene_t *scene = scene_init();
     // Add elements to the scene
-    add_gravity_body(scene);
+    add_peg_collision_rules(scene);
     add_pegs(scene);
     add_walls(scene);
     // Repeatedly render scene
@@ -29,6 +29,9 @@
 
 const vector_t WINDOW_SIZE = (vector_t){.x = 1000, .y = 500};
 const double ELASTICITY = 0.8;
+// Physics runs in fixed 1 ms steps; a hitch longer than 100 ms is dropped
+const double PHYSICS_TIMESTEP = 1e-3;
+const size_t MAX_PHYSICS_STEPS = 100;
 
 // Ball constants
 extern const size_t BALL_RADIUS;
@@ -264,8 +267,8 @@ void cueball_mouse_handler(state_t *state, mouse_event_type_t type, vector_t cli
         if (old_cueball != NULL) {
             body_remove(old_cueball);
         }
-        list_t *tentative_cue = generate_ball(clicked_point.x, clicked_point.y,
-                                              get_ball_radius());
+        polygon_t *tentative_cue = generate_ball(clicked_point.x, clicked_point.y,
+                                                 get_ball_radius());
         size_t bodies = scene_bodies(state->scene);
         bool collided = false;
         for (size_t i = 0; i < bodies && !collided; i++) {
@@ -279,7 +282,7 @@ void cueball_mouse_handler(state_t *state, mouse_event_type_t type, vector_t cli
         if (!collided) { // so cueball position is valid, didn't collide
             put_cueball(state->scene, tentative_cue, state->chaos, state->powerup);
         } else {
-            list_free(tentative_cue);
+            polygon_free(tentative_cue);
         }
     }
 }
@@ -597,18 +600,18 @@ void scoreboard_free(scoreboard_t *sboard) {
 }
 
 state_t *emscripten_init() {
-    // set up seed for rand
-    size_t ltime = time(NULL);
-    size_t time = (unsigned)ltime / 2;
-    srand(time);
-
     sdl_on_mouse(menu_mouse_handler);
 
     sdl_init(VEC_ZERO, WINDOW_SIZE);
+    graphics_on_image_dimensions(sdl_get_image_dimensions);
+    pool_table_on_sound(sdl_play_sound_effect);
     state_t *init_state = malloc(sizeof(state_t));
     assert(init_state != NULL);
 
     init_state->scene = scene_init();
+    // every game is different; pass a fixed seed to replay one
+    scene_seed(init_state->scene, time(NULL));
+    scene_set_timestep(init_state->scene, PHYSICS_TIMESTEP, MAX_PHYSICS_STEPS);
     init_state->general = MENU; // we start in MENU general state
     init_state->pool_stick_on_scene = false;
     init_state->locked = false;
@@ -694,18 +697,18 @@ void emscripten_main(state_t *state) {
     }
     if (state->general == CUEBALL_IN_HAND) {
         if (state->gamemode == SP_EASY && state->current_player == 2) {
-            list_t *cue = ai_easy_put_cue(state->scene, state->current_player_side);
+            polygon_t *cue = ai_easy_put_cue(state->scene, state->current_player_side);
             put_cueball(state->scene, cue, state->chaos, state->powerup);
             state->general = SHOOTING; // time to shoot
         } else if (state->gamemode == SP_MED && state->current_player == 2) {
-            list_t *cue = ai_medium_put_cue(state->scene, state->current_player_side);
+            polygon_t *cue = ai_medium_put_cue(state->scene, state->current_player_side);
             put_cueball(state->scene, cue, state->chaos, state->powerup);
             state->general = SHOOTING;
         } else {
             sdl_on_mouse(cueball_mouse_handler);
         }
     }
-    scene_tick(state->scene, dt);
+    scene_step(state->scene, dt);
     sdl_render_scene(state->scene);
 
     // text-handling area
@@ -0,0 +1,144 @@
+#include "body.h"
+#include "ids.h"
+#include "pool_table.h"
+#include "scene.h"
+#include "vector.h"
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Headless shot simulator: racks a table, hits the cue ball once and
+// prints where everything ended up. Links only against libpoolsim.a.
+
+const double DEFAULT_SHOT_ANGLE = 0;      // degrees, 0 = towards the rack
+const double DEFAULT_SHOT_IMPULSE = 500;  // same scale as the AI's HIT_MOMENTUM
+const double DEFAULT_DT = 1e-3;
+const double DEFAULT_MAX_TIME = 60;
+const uint64_t DEFAULT_TABLE_SEED = 0; // runs are reproducible unless -s is given
+
+void print_usage(char *program) {
+    fprintf(stderr,
+            "usage: %s [-a angle_deg] [-i impulse] [-t dt] [-m max_time] [-s seed] [-c] [-p] [-e]\n"
+            "  -s  seed for chaos pairings and the powerup spot\n"
+            "  -c  chaos mode\n"
+            "  -p  place a powerup on the table\n"
+            "  -e  jump between collisions instead of ticking (ignores -t, -c and -p)\n",
+            program);
+}
+
+char *body_name(size_t id) {
+    if (id == CUEBALL_ID) {
+        return "cue";
+    } else if (id == EIGHTBALL_ID) {
+        return "eight";
+    } else if (id == SOLID_BALL_ID) {
+        return "solid";
+    } else if (id == STRIPED_BALL_ID) {
+        return "striped";
+    }
+    return "other";
+}
+
+int main(int argc, char *argv[]) {
+    double angle = DEFAULT_SHOT_ANGLE;
+    double impulse = DEFAULT_SHOT_IMPULSE;
+    double dt = DEFAULT_DT;
+    double max_time = DEFAULT_MAX_TIME;
+    uint64_t seed = DEFAULT_TABLE_SEED;
+    bool chaos = false;
+    bool powerup = false;
+    bool event_driven = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "a:i:t:m:s:cpe")) != -1) {
+        switch (opt) {
+        case 'a':
+            angle = atof(optarg);
+            break;
+        case 'i':
+            impulse = atof(optarg);
+            break;
+        case 't':
+            dt = atof(optarg);
+            break;
+        case 'm':
+            max_time = atof(optarg);
+            break;
+        case 's':
+            seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'c':
+            chaos = true;
+            break;
+        case 'p':
+            powerup = true;
+            break;
+        case 'e':
+            event_driven = true;
+            break;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (dt <= 0 || max_time <= 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if (event_driven) {
+        chaos = powerup = false;
+    }
+    scene_t *scene = scene_init();
+    scene_seed(scene, seed);
+    generate_pool_table(scene, chaos, powerup);
+    body_t *cueball = get_cueball_body(scene);
+    assert(cueball != NULL);
+    vector_t dir = vec_rotate((vector_t){1, 0}, angle * M_PI / 180);
+
+    size_t steps = 0;
+    double time = 0;
+    bool settled;
+    if (event_driven) {
+        body_set_velocity(cueball,
+                          vec_multiply(impulse / body_get_mass(cueball), dir));
+        event_sim_t *sim = pool_event_sim(scene);
+        steps = event_sim_run(sim, max_time);
+        time = event_sim_time(sim);
+        settled = event_sim_settled(sim);
+        event_sim_apply(sim);
+        event_sim_free(sim);
+        scene_tick(scene, 0); // reaps the pocketed balls
+        printf("events %zu\n", steps);
+    } else {
+        body_add_impulse(cueball, vec_multiply(impulse, dir));
+        do {
+            scene_tick(scene, dt);
+            steps++;
+            time += dt;
+        } while (!balls_stopped(scene) && time < max_time);
+        settled = balls_stopped(scene);
+        printf("ticks %zu\n", steps);
+    }
+
+    printf("time %.6f\n", time);
+    printf("settled %s\n", settled ? "yes" : "no");
+    printf("solids %zu\n", solid_count(scene));
+    printf("stripes %zu\n", striped_count(scene));
+    printf("eightball %s\n", eightball_in_play(scene) ? "in_play" : "pocketed");
+    printf("cueball %s\n", cueball_in_play(scene) ? "in_play" : "pocketed");
+    for (size_t i = 0; i < scene_bodies(scene); i++) {
+        body_t *body = scene_get_body(scene, i);
+        if (is_ball(body)) {
+            vector_t pos = body_get_centroid(body);
+            printf("ball %s %.3f %.3f\n", body_name(body_id(body)), pos.x, pos.y);
+        }
+    }
+
+    scene_free(scene);
+    return 0;
+}
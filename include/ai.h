@@ -47,7 +47,7 @@ void ai_medium_make_move(scene_t *scene, size_t side);
  * 
  * @return shape of the cueball to be put back into game.
 */
-list_t* ai_easy_put_cue(scene_t *scene, size_t side);
+polygon_t *ai_easy_put_cue(scene_t *scene, size_t side);
 
 /**
  * Medium AI puts cueball back in game
@@ -57,6 +57,6 @@ list_t* ai_easy_put_cue(scene_t *scene, size_t side);
  * 
  * @return shape of the cueball to be put back into game.
 */
-list_t* ai_medium_put_cue(scene_t *scene, size_t side);
+polygon_t *ai_medium_put_cue(scene_t *scene, size_t side);
 
 #endif // #ifndef __AI_H__
\ No newline at end of file
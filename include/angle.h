@@ -11,7 +11,7 @@
  * @param start_position ending position of desired line
  * @param width desired width of line
  */
-list_t *line_shape(vector_t start_position, vector_t end_position, double width);
+polygon_t *line_shape(vector_t start_position, vector_t end_position, double width);
 
 /**
  * Generates the predicted trajectory line of cueball following hit by stick.
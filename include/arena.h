@@ -0,0 +1,58 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>
+
+/**
+ * A bump-pointer allocator for short-lived memory.
+ * Allocating just advances a pointer, and arena_reset() releases everything
+ * at once. When a block fills up another one is chained on; the next reset
+ * merges them into a single block big enough for all of it, so an arena
+ * that is reset every tick stops calling malloc() once it has seen its
+ * busiest tick.
+ */
+typedef struct arena arena_t;
+
+/**
+ * Allocates an empty arena.
+ * Asserts that the required memory was allocated.
+ *
+ * @param capacity the number of bytes to reserve up front
+ * @return the new arena
+ */
+arena_t *arena_init(size_t capacity);
+
+/**
+ * Releases an arena and everything allocated from it.
+ *
+ * @param arena an arena returned from arena_init()
+ */
+void arena_free(arena_t *arena);
+
+/**
+ * Allocates memory that lives until the next arena_reset().
+ * The memory is suitably aligned for any type, and is not zeroed.
+ * Asserts that the required memory was allocated.
+ *
+ * @param arena the arena
+ * @param size the number of bytes
+ * @return the memory
+ */
+void *arena_alloc(arena_t *arena, size_t size);
+
+/**
+ * Releases everything allocated from an arena.
+ *
+ * @param arena the arena
+ */
+void arena_reset(arena_t *arena);
+
+/**
+ * Gets the number of bytes an arena can hand out before it needs malloc().
+ *
+ * @param arena the arena
+ * @return the total size of its blocks
+ */
+size_t arena_capacity(arena_t *arena);
+
+#endif // #ifndef __ARENA_H__
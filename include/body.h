@@ -3,30 +3,61 @@
 
 #include "color.h"
 #include "list.h"
+#include "polygon.h"
 #include "vector.h"
 #include "graphics.h"
+#include "kinematics.h"
+#include "mesh.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 /**
  * A rigid body constrained to the plane.
  * Implemented as a polygon with uniform density.
+ * The polygon is kept as a local-space mesh (see mesh.h), which bodies of
+ * the same shape can share, plus the body's position and rotation.
+ * Moving or rotating a body does not touch its vertices; they are placed
+ * in world space only when body_get_shape() asks for them.
  * Bodies can accumulate forces and impulses during each tick.
  * Angular physics (i.e. torques) are not currently implemented.
  */
 typedef struct body body_t;
 
+/**
+ * A stable reference to a body in a scene (see scene_get_handle()).
+ * index picks a slot of the scene's handle table, and generation tells
+ * the body the handle was issued for apart from later occupants of the slot.
+ */
+typedef struct body_handle
+{
+  uint32_t index;
+  uint32_t generation;
+} body_handle_t;
+
+/**
+ * The geometry a body is defined by.
+ * Circles are stored as a radius around the centroid; their polygon outline
+ * is only generated when body_get_shape() is called (e.g. for rendering),
+ * from a mesh shared by all circles of the same radius.
+ */
+typedef enum
+{
+  SHAPE_POLYGON,
+  SHAPE_CIRCLE
+} shape_kind_t;
+
 /**
  * Initializes a body without any info.
  * Acts like body_init_with_info() where info and info_freer are NULL.
  */
-body_t *body_init(list_t *shape, sprite_info_t sprite, double mass);
+body_t *body_init(polygon_t *shape, sprite_info_t sprite, double mass);
 
 /**
  * Allocates memory for a body with the given parameters.
  * The body is initially at rest.
  * Asserts that the mass is positive and that the required memory is allocated.
  *
- * @param shape a list of vectors describing the initial shape of the body
+ * @param shape the initial shape of the body; the body takes ownership of it
  * @param sprite the sprite of the body (color, img_path, img_scale, img_pos, is_sprite, and texture)
  * @param mass the mass of the body (if INFINITY, stops the body from moving)
  * @param info additional information to associate with the body,
@@ -34,9 +65,52 @@ body_t *body_init(list_t *shape, sprite_info_t sprite, double mass);
  * @param info_freer if non-NULL, a function call on the info to free it
  * @return a pointer to the newly allocated body
  */
-body_t *body_init_with_info(list_t *shape, sprite_info_t sprite, double mass,
+body_t *body_init_with_info(polygon_t *shape, sprite_info_t sprite, double mass,
                             void *info, free_func_t info_freer);
 
+/**
+ * Allocates memory for a body whose outline is a shared mesh.
+ * Acts like body_init_with_info(), but no vertices are copied.
+ *
+ * @param mesh the outline relative to the centroid; the body adds a
+ *   reference to it
+ * @param centroid the initial centroid of the body
+ * @param sprite the sprite of the body (see body_init_with_info())
+ * @param mass the mass of the body (if INFINITY, stops the body from moving)
+ * @param info additional information to associate with the body
+ * @param info_freer if non-NULL, a function call on the info to free it
+ * @return a pointer to the newly allocated body
+ */
+body_t *body_init_with_mesh(mesh_t *mesh, vector_t centroid,
+                            sprite_info_t sprite, double mass, void *info,
+                            free_func_t info_freer);
+
+/**
+ * Initializes a circular body without any info.
+ * Acts like body_init_circle_with_info() where info and info_freer are NULL.
+ */
+body_t *body_init_circle(vector_t center, double radius, sprite_info_t sprite,
+                         double mass);
+
+/**
+ * Allocates memory for a circular body with the given parameters.
+ * Collisions against circles skip the polygon math entirely
+ * (see find_body_collision()).
+ * Asserts that the radius and mass are positive
+ * and that the required memory is allocated.
+ *
+ * @param center the initial centroid of the circle
+ * @param radius the radius of the circle
+ * @param sprite the sprite of the body (see body_init_with_info())
+ * @param mass the mass of the body (if INFINITY, stops the body from moving)
+ * @param info additional information to associate with the body
+ * @param info_freer if non-NULL, a function call on the info to free it
+ * @return a pointer to the newly allocated body
+ */
+body_t *body_init_circle_with_info(vector_t center, double radius,
+                                   sprite_info_t sprite, double mass,
+                                   void *info, free_func_t info_freer);
+
 /**
  * Releases the memory allocated for a body.
  *
@@ -46,23 +120,72 @@ void body_free(body_t *body);
 
 /**
  * Gets the current shape of a body.
- * Returns a newly allocated vector list, which must be list_free()d.
+ * Returns a newly allocated polygon, which must be polygon_free()d.
  *
  * @param body a pointer to a body returned from body_init()
  * @return the polygon describing the body's current position
  * 
  * NOTE: output NEEDS TO BE FREED!
  */
-list_t *body_get_deepcopied_shape(body_t *body);
+polygon_t *body_get_deepcopied_shape(body_t *body);
 
 /**
  * Gets the current shape of a body.
  * It will point to the body's polygon (so don't free it!).
+ * The vertices are placed from the body's mesh if it has moved or turned
+ * since the last call, and stay valid until the body is changed again.
  *
  * @param body a pointer to a body returned from body_init()
  * @return the polygon describing the body's current position
  */
-list_t *body_get_shape(body_t *body);
+polygon_t *body_get_shape(body_t *body);
+
+/**
+ * Gets the outline of a body relative to its centroid, before rotation.
+ * The body keeps its reference; use mesh_retain() to share the mesh.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's mesh
+ */
+mesh_t *body_get_mesh(body_t *body);
+
+/**
+ * Gets the kind of geometry a body has.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return SHAPE_CIRCLE for bodies from body_init_circle(), else SHAPE_POLYGON
+ */
+shape_kind_t body_get_shape_kind(body_t *body);
+
+/**
+ * Gets the radius of a circular body.
+ * Asserts that the body is a circle.
+ *
+ * @param body a pointer to a body returned from body_init_circle()
+ * @return the radius passed to body_init_circle()
+ */
+double body_get_radius(body_t *body);
+
+/**
+ * Gets the radius of a circle around a body's centroid that contains it.
+ * The radius is cached, and only recomputed when the body is rotated
+ * or given a new shape, so this is cheap enough to call for every pair
+ * the narrowphase sees.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the distance from the centroid to the farthest point of the body
+ */
+double body_get_bounding_radius(body_t *body);
+
+/**
+ * Gets the smallest axis-aligned box containing a body.
+ * The box is cached relative to the centroid (see body_get_bounding_radius()),
+ * so this does not touch the body's vertices.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's current bounding box
+ */
+aabb_t body_get_aabb(body_t *body);
 
 /**
  * Gets the current center of mass of a body.
@@ -156,6 +279,64 @@ void body_add_force(body_t *body, vector_t force);
  */
 void body_add_impulse(body_t *body, vector_t impulse);
 
+/**
+ * Subjects a body to linear drag, a force of -gamma * velocity,
+ * from every tick of the scene containing it on.
+ * Drags on the same body add up. See kinematics_apply_fields().
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param gamma the proportionality constant between force and velocity
+ */
+void body_add_drag(body_t *body, double gamma);
+
+/**
+ * Subjects a body to a constant force against its direction of motion,
+ * from every tick of the scene containing it on.
+ * Constant drags on the same body add up. See kinematics_apply_fields().
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param force the magnitude of the force
+ */
+void body_add_constant_drag(body_t *body, double force);
+
+/**
+ * Sets how fast the body must move for its constant drag to act on it,
+ * so a body that has all but stopped is not pushed back and forth.
+ * The default is 0.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param min_speed the slowest speed constant drag acts at
+ */
+void body_set_constant_drag_min_speed(body_t *body, double min_speed);
+
+/**
+ * Subjects a body to uniform gravity, a force of mass * acceleration,
+ * from every tick of the scene containing it on.
+ * Has no effect on bodies with INFINITY mass. See kinematics_apply_fields().
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param acceleration the acceleration due to gravity
+ */
+void body_add_gravity(body_t *body, vector_t acceleration);
+
+/**
+ * Makes a body attract and be attracted by the other gravitating bodies
+ * of its scene, once the scene has a gravity solver (see
+ * scene_set_gravity()). Bodies with INFINITY mass never gravitate.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param gravitating whether the body takes part in mutual gravity
+ */
+void body_set_gravitating(body_t *body, bool gravitating);
+
+/**
+ * Returns whether a body takes part in mutual gravity.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return whether body_set_gravitating() last turned it on
+ */
+bool body_is_gravitating(body_t *body);
+
 /**
  * Updates the body after a given time interval has elapsed.
  * Sets acceleration and velocity according to the forces and impulses
@@ -178,6 +359,15 @@ void body_tick(body_t *body, double dt);
  */
 void body_remove(body_t *body);
 
+/**
+ * Clears the mark set by body_remove().
+ * Only useful while the body has not been freed yet; scene_restore() uses it
+ * to bring back bodies removed after a snapshot.
+ *
+ * @param body the body to unmark
+ */
+void body_revive(body_t *body);
+
 /**
  * Returns whether a body has been marked for removal.
  * This function returns false until body_remove() is called on the body,
@@ -188,6 +378,125 @@ void body_remove(body_t *body);
  */
 bool body_is_removed(body_t *body);
 
+/**
+ * Gets the force creators acting on the body.
+ * The body only stores the list (created on the first call) and frees it;
+ * scene.c keeps it in sync with the scene's force creators, so removing the
+ * body only needs to look at the force creators that depend on it.
+ *
+ * @param body the body
+ * @return the list of force creators, which does not own them
+ */
+list_t *body_get_forcers(body_t *body);
+
+/**
+ * Returns whether a body is asleep.
+ * A scene puts bodies to sleep once they have been nearly still for a while
+ * (see scene_set_sleep_threshold()). Sleeping bodies are not integrated
+ * and do not collide with each other.
+ * Impulses, nonzero velocities, teleports and contacts wake them up.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return whether the body is asleep
+ */
+bool body_is_asleep(body_t *body);
+
+/**
+ * Wakes a sleeping body. Does nothing if the body is awake.
+ *
+ * @param body a pointer to a body returned from body_init()
+ */
+void body_wake(body_t *body);
+
+/**
+ * Moves the body's kinematic state (centroid, velocity, pending force and
+ * impulse, inverse mass) into a new slot of the given storage.
+ * Used by scene_add_body() so all of a scene's bodies are integrated together.
+ * The one-slot storage embedded in a standalone body is left unused.
+ *
+ * @param body the body to move
+ * @param kin the storage to move into
+ */
+void body_move_to_kinematics(body_t *body, kinematics_t *kin);
+
+/**
+ * Gets the storage holding the body's kinematic state.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the storage; index it with body_get_slot()
+ */
+kinematics_t *body_get_kinematics(body_t *body);
+
+/**
+ * Gets the body's slot in its kinematic storage.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the slot index
+ */
+size_t body_get_slot(body_t *body);
+
+/**
+ * Records that the body's kinematic state was moved to another slot
+ * of the same storage (see kinematics_remove()).
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param slot the new slot index
+ */
+void body_set_slot(body_t *body, size_t slot);
+
+/**
+ * Gets the handle the body's scene issued for it.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the handle recorded by body_set_handle()
+ */
+body_handle_t body_get_handle(body_t *body);
+
+/**
+ * Records the handle a scene issued for the body.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param handle the handle
+ */
+void body_set_handle(body_t *body, body_handle_t handle);
+
+/**
+ * Sets a list that body_remove() appends the body to when it marks it,
+ * so a scene can find its removed bodies without looking at the others.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param queue the list, which does not own the body, or NULL for none
+ */
+void body_set_removal_queue(body_t *body, list_t *queue);
+
+/**
+ * Marks the body as held by the snapshot being restored.
+ * scene_restore() marks every body of the snapshot with a number it never
+ * used before, so it can tell which bodies to bring back and which to take
+ * out without searching the snapshot. New bodies have mark 0.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param mark the restore's number
+ */
+void body_set_restore_mark(body_t *body, size_t mark);
+
+/**
+ * Gets the mark last set by body_set_restore_mark().
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the mark, or 0 if none was set
+ */
+size_t body_get_restore_mark(body_t *body);
+
+/**
+ * Brings the body's shape and sprite up to date with its centroid.
+ * Integration only moves the centroid; the getters call this lazily,
+ * so it is only needed by code that reads the shape behind our back.
+ *
+ * @param body a pointer to a body returned from body_init()
+ */
+void body_sync(body_t *body);
+
 /**
  * Draws body in window.
  *
@@ -214,12 +523,15 @@ void body_update(body_t *body, double dt);
 void body_set_ang_velocity(body_t *body, double omega);
 
 /**
- * Updates the body's shape
+ * Updates the body's shape.
+ * A circular body becomes a polygon body with the new shape.
+ * The shape is taken as the body's outline at its current centroid
+ * and angle, and the body's mesh is replaced by one made from it.
  * 
  * @param body a pointer to a body returned from body_init()
  * @param shape a pointer to the new desired shape for the body
 */
-void body_set_shape(body_t *body, list_t *shape);
+void body_set_shape(body_t *body, polygon_t *shape);
 
 /**
  * Updates the body's color
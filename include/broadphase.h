@@ -0,0 +1,178 @@
+#ifndef __BROADPHASE_H__
+#define __BROADPHASE_H__
+
+#include "body.h"
+#include "collision.h"
+#include "contact.h"
+#include "list.h"
+#include <stddef.h>
+
+/**
+ * A scene-wide collision pipeline.
+ * Bodies are registered once with a bitmask of collision categories,
+ * and rules say which handler runs when bodies of two categories collide.
+ * Each tick a sweep-and-prune pass over the bodies' bounding boxes finds
+ * the candidate pairs, and only candidates a rule applies to reach the
+ * narrowphase (find_body_swept_collision()). Each contact is tested once and
+ * recorded as a collision_event_t, which is then handed to every rule
+ * that matches the pair. Pairs under a contact rule also go to the tick's
+ * contact solver, every tick they touch, to be resolved together.
+ *
+ * Boxes are stretched to cover each body's motion over the tick, and the
+ * narrowphase is swept, so a fast circle collides with whatever it would
+ * reach during the tick instead of passing through it. The contact is
+ * resolved at the start of the tick, before the bodies meet.
+ *
+ * Pairs of sleeping bodies are skipped, and a contact wakes both bodies.
+ *
+ * The boxes stay sorted by their left edge between ticks, so re-sorting
+ * after small movements is close to linear.
+ */
+typedef struct broadphase broadphase_t;
+
+/**
+ * Allocates an empty pipeline with no bodies or rules.
+ * Asserts that the required memory was allocated.
+ *
+ * @return the new pipeline
+ */
+broadphase_t *broadphase_init(void);
+
+/**
+ * Releases the pipeline and the aux values of its rules.
+ * Does not free the bodies.
+ *
+ * @param broadphase a pipeline returned from broadphase_init()
+ */
+void broadphase_free(broadphase_t *broadphase);
+
+/**
+ * Registers a body for collision detection.
+ *
+ * @param broadphase the pipeline
+ * @param body the body
+ * @param categories a nonzero bitmask of the categories the body belongs to
+ */
+void broadphase_add_body(broadphase_t *broadphase, body_t *body,
+                         size_t categories);
+
+/**
+ * Registers a handler for collisions between two categories.
+ * When a body in categories1 collides with a body in categories2,
+ * handler is called with them in that order.
+ * Like create_collision(), the handler is called once per contact:
+ * when the bodies start touching, and while they keep touching, only
+ * again if they start moving towards each other again.
+ * A NULL handler makes the pipeline test the pair and publish its
+ * contacts (see broadphase_get_collision()) without calling anything.
+ *
+ * @param broadphase the pipeline
+ * @param categories1 the bitmask the first body must match
+ * @param categories2 the bitmask the second body must match
+ * @param handler a function to call whenever matching bodies collide
+ * @param aux an auxiliary value to pass to the handler
+ * @param freer if non-NULL, a function to call in order to free aux
+ */
+void broadphase_add_rule(broadphase_t *broadphase, size_t categories1,
+                         size_t categories2, collision_handler_t handler,
+                         void *aux, free_func_t freer);
+
+/**
+ * Registers a physical response between two categories: every tick that
+ * a body in categories1 and one in categories2 touch (or would meet within
+ * the tick), their contact is added to the contact solver passed to
+ * broadphase_tick(), which resolves all of the tick's contacts together.
+ * Contacts also count as collisions for the events and handlers.
+ *
+ * @param broadphase the pipeline
+ * @param categories1 the bitmask the first body must match
+ * @param categories2 the bitmask the second body must match
+ * @param elasticity the coefficient of restitution of the contacts
+ */
+void broadphase_add_contact_rule(broadphase_t *broadphase, size_t categories1,
+                                 size_t categories2, double elasticity);
+
+/**
+ * Forgets every body marked with body_remove().
+ * Must be called before removed bodies are freed.
+ *
+ * @param broadphase the pipeline
+ */
+void broadphase_prune(broadphase_t *broadphase);
+
+/**
+ * Finds the pairs that collide now or within dt at their current
+ * velocities, calls their handlers and adds the contacts of pairs under
+ * contact rules to a solver.
+ *
+ * @param broadphase the pipeline
+ * @param dt the length of the coming tick
+ * @param contacts the solver to add contacts to; may be NULL if there are
+ *   no contact rules
+ */
+void broadphase_tick(broadphase_t *broadphase, double dt,
+                     contact_solver_t *contacts);
+
+/**
+ * Gets the number of contacts found by the last tick.
+ *
+ * @param broadphase the pipeline
+ * @return the number of collision events
+ */
+size_t broadphase_collisions(broadphase_t *broadphase);
+
+/**
+ * Gets a contact found by the last tick.
+ * Contacts involving bodies removed since then are dropped by
+ * broadphase_prune(), so the bodies are always valid.
+ *
+ * @param broadphase the pipeline
+ * @param index the index of the contact (starting at 0)
+ * @return the contact
+ */
+collision_event_t broadphase_get_collision(broadphase_t *broadphase,
+                                           size_t index);
+
+/**
+ * Gets the number of pairs sent to the narrowphase by the last tick.
+ *
+ * @param broadphase the pipeline
+ * @return the number of find_body_swept_collision() calls in the last tick
+ */
+size_t broadphase_candidates(broadphase_t *broadphase);
+
+/**
+ * The per-tick state of a pipeline: its colliders with their boxes, the
+ * pairs that were touching and the last tick's contacts. Rules are not
+ * included.
+ */
+typedef struct broadphase_state broadphase_state_t;
+
+/**
+ * Copies the per-tick state of a pipeline.
+ * Asserts that the required memory was allocated.
+ *
+ * @param broadphase the pipeline
+ * @param state a state to overwrite, reusing its memory, or NULL for a new one
+ * @return a copy to pass to broadphase_restore()
+ */
+broadphase_state_t *broadphase_save(broadphase_t *broadphase,
+                                    broadphase_state_t *state);
+
+/**
+ * Puts a pipeline back into a saved state.
+ * The bodies in the state must not have been freed.
+ *
+ * @param broadphase the pipeline the state was saved from
+ * @param state a state returned from broadphase_save()
+ */
+void broadphase_restore(broadphase_t *broadphase, broadphase_state_t *state);
+
+/**
+ * Releases a saved state.
+ *
+ * @param state a state returned from broadphase_save()
+ */
+void broadphase_state_free(broadphase_state_t *state);
+
+#endif // #ifndef __BROADPHASE_H__
@@ -1,7 +1,8 @@
 #ifndef __COLLISION_H__
 #define __COLLISION_H__
 
-#include "list.h"
+#include "body.h"
+#include "polygon.h"
 #include "vector.h"
 #include <stdbool.h>
 
@@ -19,11 +20,55 @@ typedef struct {
    * If collided is false, this value is undefined.
    */
   vector_t axis;
+  /**
+   * If the shapes are colliding, how far they overlap along the axis.
+   * Swept collisions (see find_body_swept_collision()) between bodies that
+   * only meet later in the tick have a negative depth: minus the gap along
+   * the axis that closes by the time of impact.
+   */
+  double depth;
 } collision_info_t;
 
+/**
+ * A function called when a collision occurs.
+ * @param body1 the first body passed to create_collision()
+ * @param body2 the second body passed to create_collision()
+ * @param axis a unit vector pointing from body1 towards body2
+ *   that defines the direction the two bodies are colliding in
+ * @param aux the auxiliary value passed to create_collision()
+ */
+typedef void (*collision_handler_t)(body_t *body1, body_t *body2, vector_t axis,
+                                    void *aux);
+
+/**
+ * A contact found by a scene's collision pipeline (see scene_add_collider()).
+ * Contacts are computed once per pair per tick and published to every
+ * subscriber: the matching collision rules and force creators that read
+ * them with scene_get_collision().
+ */
+typedef struct {
+  body_t *body1;
+  body_t *body2;
+  /** A unit vector pointing from body1 towards body2 */
+  vector_t axis;
+} collision_event_t;
+
+/**
+ * Counters of the body narrowphase (see find_body_collision()),
+ * for telling how much work the bounds checks save.
+ */
+typedef struct {
+  /** Pairs tested */
+  size_t tests;
+  /** Pairs rejected by their bounding circles or boxes alone */
+  size_t rejects;
+  /** Pairs found colliding */
+  size_t hits;
+} collision_stats_t;
+
 /**
  * Computes the status of the collision between two convex polygons.
- * The shapes are given as lists of vertices in counterclockwise order.
+ * The shapes are given as vertices in counterclockwise order.
  * There is an edge between each pair of consecutive vertices,
  * and one between the first vertex and the last vertex.
  *
@@ -32,7 +77,126 @@ typedef struct {
  * @return whether the shapes are colliding, and if so, the collision axis.
  * The axis should be a unit vector pointing from shape1 towards shape2.
  */
-collision_info_t find_collision(list_t *shape1, list_t *shape2);
+collision_info_t find_collision(polygon_t *shape1, polygon_t *shape2);
+
+/**
+ * Computes the status of the collision between two circles.
+ * Only compares the distance between the centers against the radii.
+ *
+ * @param center1 the center of the first circle
+ * @param radius1 the radius of the first circle
+ * @param center2 the center of the second circle
+ * @param radius2 the radius of the second circle
+ * @return whether the circles are colliding, and if so, the unit axis
+ * pointing from the first center towards the second
+ */
+collision_info_t find_circle_collision(vector_t center1, double radius1,
+                                       vector_t center2, double radius2);
+
+/**
+ * Computes the status of the collision between a circle and a convex polygon
+ * by finding the point of the polygon's boundary closest to the circle.
+ * The polygon may be in either winding order.
+ *
+ * @param center the center of the circle
+ * @param radius the radius of the circle
+ * @param shape the polygon
+ * @return whether the shapes are colliding, and if so, the unit axis
+ * pointing from the circle towards the polygon
+ */
+collision_info_t find_circle_polygon_collision(vector_t center, double radius,
+                                               polygon_t *shape);
+
+/**
+ * Computes the axis a circle centered at a point would collide with a
+ * convex polygon along, whether or not they touch: the normal towards the
+ * polygon's closest feature (an edge or a vertex), as used by
+ * find_circle_polygon_collision().
+ *
+ * @param center the center of the circle
+ * @param shape the polygon
+ * @return the unit axis pointing from the center towards the polygon
+ */
+vector_t find_circle_polygon_axis(vector_t center, polygon_t *shape);
+
+/**
+ * Computes the status of the collision between two bodies,
+ * using the cheapest test for the pair of shape kinds:
+ * circle-circle compares distances, circle-polygon uses
+ * find_circle_polygon_collision() and polygon-polygon uses find_collision().
+ * Pairs whose cached bounding circles or boxes (see body_get_aabb())
+ * do not overlap are rejected before any of those.
+ *
+ * @param body1 the first body
+ * @param body2 the second body
+ * @return whether the bodies are colliding, and if so, the collision axis
+ * pointing from body1 towards body2
+ */
+collision_info_t find_body_collision(body_t *body1, body_t *body2);
+
+/**
+ * Gets the counters of find_body_collision() since the last reset.
+ *
+ * @return the counters
+ */
+collision_stats_t collision_get_stats();
+
+/**
+ * Sets the counters of find_body_collision() back to zero.
+ */
+void collision_reset_stats();
+
+/**
+ * Finds when two circles moving at constant velocities first touch.
+ *
+ * @param center1 the center of the first circle
+ * @param velocity1 the velocity of the first circle
+ * @param radius1 the radius of the first circle
+ * @param center2 the center of the second circle
+ * @param velocity2 the velocity of the second circle
+ * @param radius2 the radius of the second circle
+ * @param dt the length of the time interval to check
+ * @return the time of impact in [0, dt] (0 if they already touch),
+ * or INFINITY if they do not touch within dt
+ */
+double circle_time_of_impact(vector_t center1, vector_t velocity1,
+                             double radius1, vector_t center2,
+                             vector_t velocity2, double radius2, double dt);
+
+/**
+ * Finds when a circle moving at a constant velocity relative to a convex
+ * polygon first touches one of its edges or vertices.
+ *
+ * @param center the center of the circle
+ * @param velocity the velocity of the circle relative to the polygon
+ * @param radius the radius of the circle
+ * @param shape the polygon
+ * @param dt the length of the time interval to check
+ * @return the time of impact in [0, dt] (0 if they already touch),
+ * or INFINITY if they do not touch within dt
+ */
+double circle_polygon_time_of_impact(vector_t center, vector_t velocity,
+                                     double radius, polygon_t *shape, double dt);
+
+/**
+ * Like find_body_collision(), but also reports bodies that are not
+ * touching yet if a circle would reach the other body within dt
+ * at the current velocities (a swept test), so fast bodies cannot
+ * pass through each other between ticks.
+ * The axis is the collision axis at the time of impact, and the depth
+ * is minus the gap along it that the bodies close before they touch, so
+ * a contact solver can let them approach by that much within the tick
+ * (a speculative contact) instead of resolving the impact early.
+ * Polygon-polygon pairs only get the discrete test.
+ *
+ * @param body1 the first body
+ * @param body2 the second body
+ * @param dt the length of the coming tick
+ * @return whether the bodies collide within dt, and if so, the collision axis
+ * pointing from body1 towards body2
+ */
+collision_info_t find_body_swept_collision(body_t *body1, body_t *body2,
+                                           double dt);
 
 /**
  * Determines if the projections overlap on the axis's from shape1.
@@ -42,7 +206,7 @@ collision_info_t find_collision(list_t *shape1, list_t *shape2);
  * @param info the updating collision info
  * @param overlap the updating overlap
  */
-void find_collision_projs(list_t *shape1, list_t *shape2,
+void find_collision_projs(polygon_t *shape1, polygon_t *shape2,
                           collision_info_t *info, double *overlap);
 
 /**
@@ -53,6 +217,6 @@ void find_collision_projs(list_t *shape1, list_t *shape2,
  * @param line the line
  * @return the minimum and maximum projection of a shape's vertices on the line
  */
-vector_t find_shape_projs(list_t *shape, vector_t line);
+vector_t find_shape_projs(polygon_t *shape, vector_t line);
 
 #endif // #ifndef __COLLISION_H__
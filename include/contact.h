@@ -0,0 +1,160 @@
+#ifndef __CONTACT_H__
+#define __CONTACT_H__
+
+#include "body.h"
+#include "collision.h"
+#include "kinematics.h"
+#include "vector.h"
+#include <stddef.h>
+
+/**
+ * A contact between two bodies, gathered during a tick for the solver.
+ */
+typedef struct {
+  body_t *body1;
+  body_t *body2;
+  /** A unit vector pointing from body1 towards body2 */
+  vector_t axis;
+  /** How far the bodies overlap along the axis (negative if they only meet
+   * later in the tick; see collision_info_t) */
+  double depth;
+  /** The coefficient of restitution, from 0 (inelastic) to 1 (elastic) */
+  double elasticity;
+} contact_t;
+
+/**
+ * Resolves all of a tick's contacts together with sequential impulses.
+ * Each pass over the contacts gives every contact the impulse that makes
+ * its bodies separate at the speed its restitution asks for, starting from
+ * the velocities the earlier contacts left. The total impulse on a contact
+ * only ever pushes its bodies apart. Passes repeat until no velocity
+ * changes by more than the tolerance, or an iteration cap is hit, so a
+ * ball touching several others at once (a rack, a stack) settles all its
+ * contacts consistently instead of each pair being resolved on its own.
+ * Passes alternate direction, so a push travels along a chain of contacts
+ * both ways. A pair that was in contact at the last solve starts from the
+ * impulse it ended that solve with, so resting contacts, like a stack under
+ * gravity, carry their load from tick to tick instead of rebuilding it.
+ *
+ * A contact with a negative depth is speculative: its bodies may approach
+ * by up to the gap within the tick, and only bounce if they close it.
+ * Once the bodies have moved, contact_solver_arrive() puts those that
+ * bounced where they would be had they turned back at the contact, rather
+ * than short of it, and keeps the others from passing it.
+ *
+ * Afterwards bodies that overlap are moved apart along their axes, by
+ * most of the overlap, in proportion to their inverse masses. The moves
+ * are repeated against the overlaps left by the moves so far, so a stack
+ * pressed together is pushed apart all the way up.
+ */
+typedef struct contact_solver contact_solver_t;
+
+// Default most passes over the contacts per solve
+extern const size_t CONTACT_SOLVER_ITERATIONS;
+// Default velocity change, relative to the fastest approach, to stop at
+extern const double CONTACT_SOLVER_TOLERANCE;
+
+/**
+ * Allocates a solver with no contacts.
+ * Asserts that the required memory was allocated.
+ *
+ * @return the new solver
+ */
+contact_solver_t *contact_solver_init(void);
+
+/**
+ * Releases the memory allocated for a solver.
+ *
+ * @param solver a pointer to a solver returned from contact_solver_init()
+ */
+void contact_solver_free(contact_solver_t *solver);
+
+/**
+ * Sets when solving stops. The defaults are CONTACT_SOLVER_ITERATIONS and
+ * CONTACT_SOLVER_TOLERANCE.
+ *
+ * @param solver a pointer to a solver returned from contact_solver_init()
+ * @param max_iterations the most passes over the contacts, at least 1
+ * @param tolerance solving stops once no pass changes a velocity by more
+ *   than this fraction of the fastest approach among the contacts
+ */
+void contact_solver_set_iterations(contact_solver_t *solver,
+                                   size_t max_iterations, double tolerance);
+
+/**
+ * Adds a contact to be resolved by the next contact_solver_solve().
+ *
+ * @param solver a pointer to a solver returned from contact_solver_init()
+ * @param contact the contact
+ */
+void contact_solver_add(contact_solver_t *solver, contact_t contact);
+
+/**
+ * Gets the number of contacts waiting to be solved.
+ *
+ * @param solver a pointer to a solver returned from contact_solver_init()
+ * @return the number of contacts
+ */
+size_t contact_solver_contacts(contact_solver_t *solver);
+
+/**
+ * Resolves the contacts added since the last call and forgets them.
+ * The velocities solved for are those the bodies will have after
+ * integration with the impulses and forces accumulated so far; the
+ * resulting impulses are added with body_add_impulse().
+ * Contacts involving removed bodies are skipped. Every other body must
+ * occupy a slot of kin.
+ *
+ * @param solver a pointer to a solver returned from contact_solver_init()
+ * @param kin the storage the bodies live in
+ * @param dt the length of the tick the forces act over
+ * @return the number of passes made over the contacts
+ */
+size_t contact_solver_solve(contact_solver_t *solver, kinematics_t *kin,
+                            double dt);
+
+/**
+ * Finishes the speculative contacts of the last contact_solver_solve(),
+ * once the bodies have been moved over the tick. Bodies that met and
+ * bounced are moved along the axis to where they would have separated
+ * to since the time of impact; bodies the solve slowed are kept from
+ * passing the contact. Must be called before any more contacts are added.
+ *
+ * @param solver a pointer to a solver returned from contact_solver_init()
+ * @param dt the length of the tick the bodies moved over
+ */
+void contact_solver_arrive(contact_solver_t *solver, double dt);
+
+/**
+ * The impulses a solver starts its next solve from.
+ */
+typedef struct contact_solver_state contact_solver_state_t;
+
+/**
+ * Copies the impulses a solver starts its next solve from.
+ * Asserts that the required memory was allocated.
+ *
+ * @param solver a pointer to a solver returned from contact_solver_init()
+ * @param state a state to overwrite, reusing its memory, or NULL for a new one
+ * @return a copy to pass to contact_solver_restore()
+ */
+contact_solver_state_t *contact_solver_save(contact_solver_t *solver,
+                                            contact_solver_state_t *state);
+
+/**
+ * Puts a solver's impulses back to a saved state.
+ *
+ * @param solver a pointer to a solver returned from contact_solver_init()
+ * @param state a state returned from contact_solver_save()
+ */
+void contact_solver_restore(contact_solver_t *solver,
+                            contact_solver_state_t *state);
+
+/**
+ * Releases a saved state.
+ *
+ * @param state a state returned from contact_solver_save()
+ */
+void contact_solver_state_free(contact_solver_state_t *state);
+
+#endif // #ifndef __CONTACT_H__
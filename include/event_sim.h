@@ -0,0 +1,162 @@
+#ifndef __EVENT_SIM_H__
+#define __EVENT_SIM_H__
+
+#include "body.h"
+#include "polygon.h"
+#include "vector.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * An event-driven simulator for balls rolling on a table with drag.
+ *
+ * Under the drag forces of create_drag() and create_constant_drag_force()
+ * a ball slows down along a straight line, so its motion between collisions
+ * has a closed form. Instead of ticking, the simulator predicts when each
+ * ball next hits another ball, a cushion or a pocket, keeps the predictions
+ * in a priority queue, and jumps straight from one event to the next.
+ * A whole shot then costs a few hundred events rather than tens of
+ * thousands of scene_tick() calls.
+ *
+ * Collisions use the same response as elastic_collision(). Nothing else in
+ * a scene (force creators, collision handlers, the cue stick) is modeled.
+ */
+typedef struct event_sim event_sim_t;
+
+/**
+ * The physical constants of a table.
+ */
+typedef struct event_sim_params {
+  double ball_radius;
+  double ball_mass;
+  /** gamma from create_drag(); must be positive */
+  double drag;
+  /** The force from create_constant_drag_force() */
+  double constant_drag;
+  /** The speed below which the constant drag stops acting */
+  double constant_drag_min_speed;
+  /** The speed at or below which a ball counts as stopped */
+  double stop_speed;
+  double ball_elasticity;
+  double cushion_elasticity;
+} event_sim_params_t;
+
+/**
+ * Allocates an empty table.
+ * Asserts that the required memory was allocated.
+ *
+ * @param params the physical constants
+ * @return the new simulator
+ */
+event_sim_t *event_sim_init(event_sim_params_t params);
+
+/**
+ * Releases the simulator. Does not free the owners of the balls.
+ *
+ * @param sim a simulator returned from event_sim_init()
+ */
+void event_sim_free(event_sim_t *sim);
+
+/**
+ * Adds a ball.
+ *
+ * @param sim the simulator
+ * @param owner the body the ball stands for (see event_sim_apply()),
+ *   or NULL
+ * @param center the ball's center
+ * @param velocity the ball's velocity
+ * @return the index of the ball
+ */
+size_t event_sim_add_ball(event_sim_t *sim, body_t *owner, vector_t center,
+                          vector_t velocity);
+
+/**
+ * Adds an immovable cushion. Only its edges are kept, so the shape is
+ * still the caller's to free.
+ *
+ * @param sim the simulator
+ * @param shape the cushion's outline
+ */
+void event_sim_add_cushion(event_sim_t *sim, polygon_t *shape);
+
+/**
+ * Adds a pocket. A ball that touches it is pocketed.
+ *
+ * @param sim the simulator
+ * @param center the pocket's center
+ * @param radius the pocket's radius
+ */
+void event_sim_add_pocket(event_sim_t *sim, vector_t center, double radius);
+
+/**
+ * Runs the simulation until every ball has stopped or max_time has passed.
+ * Can be called again with a larger max_time to continue.
+ *
+ * @param sim the simulator
+ * @param max_time the time to stop at, in seconds from the start
+ * @return the number of events processed by this call
+ */
+size_t event_sim_run(event_sim_t *sim, double max_time);
+
+/**
+ * Gets the time the simulation has reached: when the last ball stopped,
+ * or max_time if some are still moving.
+ *
+ * @param sim the simulator
+ * @return the time, in seconds from the start
+ */
+double event_sim_time(event_sim_t *sim);
+
+/**
+ * Returns whether every ball on the table has stopped.
+ *
+ * @param sim the simulator
+ * @return whether the simulation is over
+ */
+bool event_sim_settled(event_sim_t *sim);
+
+/**
+ * Gets the number of balls added with event_sim_add_ball().
+ *
+ * @param sim the simulator
+ * @return the number of balls, pocketed or not
+ */
+size_t event_sim_balls(event_sim_t *sim);
+
+/**
+ * Gets a ball's center at event_sim_time().
+ *
+ * @param sim the simulator
+ * @param index the index of the ball
+ * @return the center (where it was pocketed if it was)
+ */
+vector_t event_sim_ball_position(event_sim_t *sim, size_t index);
+
+/**
+ * Gets a ball's velocity at event_sim_time().
+ *
+ * @param sim the simulator
+ * @param index the index of the ball
+ * @return the velocity (0 if it was pocketed or has stopped)
+ */
+vector_t event_sim_ball_velocity(event_sim_t *sim, size_t index);
+
+/**
+ * Returns whether a ball has been pocketed.
+ *
+ * @param sim the simulator
+ * @param index the index of the ball
+ * @return whether the ball touched a pocket
+ */
+bool event_sim_ball_pocketed(event_sim_t *sim, size_t index);
+
+/**
+ * Copies the outcome back to the owners of the balls:
+ * pocketed balls are marked with body_remove() and the others are moved
+ * to their current positions and velocities.
+ *
+ * @param sim the simulator
+ */
+void event_sim_apply(event_sim_t *sim);
+
+#endif // #ifndef __EVENT_SIM_H__
@@ -1,19 +1,9 @@
 #ifndef __FORCES_H__
 #define __FORCES_H__
 
+#include "collision.h"
 #include "scene.h"
 
-/**
- * A function called when a collision occurs.
- * @param body1 the first body passed to create_collision()
- * @param body2 the second body passed to create_collision()
- * @param axis a unit vector pointing from body1 towards body2
- *   that defines the direction the two bodies are colliding in
- * @param aux the auxiliary value passed to create_collision()
- */
-typedef void (*collision_handler_t)(body_t *body1, body_t *body2, vector_t axis,
-                                    void *aux);
-
 /**
  * Adds a force creator to a scene that applies gravity between two bodies.
  * The force creator will be called each tick
@@ -22,6 +12,7 @@ typedef void (*collision_handler_t)(body_t *body1, body_t *body2, vector_t axis,
  * https://en.wikipedia.org/wiki/Newton%27s_law_of_universal_gravitation#Vector_form.
  * The force should not be applied when the bodies are very close,
  * because its magnitude blows up as the distance between the bodies goes to 0.
+ * For gravity between many bodies, use create_mutual_gravity() instead.
  *
  * @param scene the scene containing the bodies
  * @param G the gravitational proportionality constant
@@ -31,6 +22,19 @@ typedef void (*collision_handler_t)(body_t *body1, body_t *body2, vector_t axis,
 void create_newtonian_gravity(scene_t *scene, double G, body_t *body1,
                               body_t *body2);
 
+/**
+ * Makes every gravitating body in a scene (see body_set_gravitating())
+ * attract every other one, like create_newtonian_gravity() on each pair,
+ * but with a single Barnes-Hut tree per tick (see gravity.h) instead of
+ * n * (n - 1) / 2 force creators.
+ * Replaces any mutual gravity the scene already had.
+ *
+ * @param scene the scene
+ * @param G the gravitational proportionality constant
+ * @param theta the opening angle; 0 for exact pairwise forces
+ */
+void create_mutual_gravity(scene_t *scene, double G, double theta);
+
 /**
  * Adds a force creator to a scene that acts like a spring between two bodies.
  * The force creator will be called each tick
@@ -45,10 +49,10 @@ void create_newtonian_gravity(scene_t *scene, double G, body_t *body1,
 void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2);
 
 /**
- * Adds a force creator to a scene that applies a drag force on a body.
- * The force creator will be called each tick
- * to compute the drag force on the body proportional to its velocity.
+ * Applies a drag force on a body every tick, proportional to its velocity.
  * The force points opposite the body's velocity.
+ * Drag is a field force (see body_add_drag()): it adds no force creator,
+ * and all drags in the scene are applied in a single loop.
  *
  * @param scene the scene containing the bodies
  * @param gamma the proportionality constant between force and velocity
@@ -58,22 +62,38 @@ void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2);
 void create_drag(scene_t *scene, double gamma, body_t *body);
 
 /**
- * Adds a forcer creator to a scene that applies a constant force 
- * on a force that is opposite to the body's velocity.
- * 
+ * Applies a constant force opposite to a body's velocity every tick,
+ * as long as the body moves at least VEL_THRESH fast
+ * (see body_set_constant_drag_min_speed()).
+ * Like create_drag(), this is a field force and adds no force creator.
+ *
  * @param scene the scene containing the bodies
  * @param force the force applied to the body
  * @param body the body to slow down
-*/
+ */
 void create_constant_drag_force(scene_t *scene, double force, body_t *body);
 
+/**
+ * Applies uniform gravity to a body every tick, i.e. a force of
+ * mass * acceleration, as near the surface of a planet.
+ * Like create_drag(), this is a field force and adds no force creator,
+ * unlike create_newtonian_gravity() which needs one per pair of bodies.
+ *
+ * @param scene the scene containing the bodies
+ * @param acceleration the acceleration due to gravity
+ * @param body the body gravity acts on
+ */
+void create_uniform_gravity(scene_t *scene, vector_t acceleration,
+                            body_t *body);
+
 /**
  * Adds a force creator to a scene that calls a given collision handler
  * function each time two bodies collide.
  * This generalizes create_destructive_collision() from last week,
  * allowing different things to happen on a collision.
  * The handler is passed the bodies, the collision axis, and an auxiliary value.
- * It should only be called once while the bodies are still colliding.
+ * It is called when the bodies start colliding; while they stay in contact,
+ * it is only called again if they start moving towards each other again.
  *
  * @param scene the scene containing the bodies
  * @param body1 the first body
@@ -99,15 +119,12 @@ void create_collision(scene_t *scene, body_t *body1, body_t *body2,
 void create_destructive_collision(scene_t *scene, body_t *body1, body_t *body2);
 
 /**
- * Adds a force creator to a scene that applies impulses
- * to resolve collisions between two bodies in the scene.
- * This should be represented as an on-collision callback
- * registered with create_collision().
- *
- * You may remember from project01 that you should avoid applying impulses
- * multiple times while the bodies are still colliding.
- * You should also have a special case that allows either body1 or body2
- * to have mass INFINITY, as this is useful for simulating walls.
+ * Adds a force creator to a scene that resolves collisions between two
+ * bodies in the scene: every tick they touch, their contact is handed to
+ * the scene's contact solver (see scene_add_contact()), which resolves it
+ * together with the tick's other contacts.
+ * Either body1 or body2 may have mass INFINITY, as this is useful for
+ * simulating walls.
  *
  * @param scene the scene containing the bodies
  * @param elasticity the "coefficient of restitution" of the collision;
@@ -131,11 +148,39 @@ void create_physics_collision(scene_t *scene, double elasticity, body_t *body1,
 void create_destructive_physics_collision(scene_t *scene, double elasticity,
                                           body_t *body1, body_t *body2);
 
+/**
+ * Like create_physics_collision(), but for every pair of colliders
+ * (see scene_add_collider()) in the given categories.
+ *
+ * @param scene the scene containing the bodies
+ * @param elasticity the "coefficient of restitution" of the collision
+ * @param categories1 the categories of the first body
+ * @param categories2 the categories of the second body
+ */
+void create_physics_collision_rule(scene_t *scene, double elasticity,
+                                   size_t categories1, size_t categories2);
+
+/**
+ * Like create_destructive_physics_collision(), but for every pair of
+ * colliders (see scene_add_collider()) in the given categories.
+ *
+ * @param scene the scene containing the bodies
+ * @param elasticity the "coefficient of restitution" of the collision
+ * @param categories1 the categories of the first body
+ * @param categories2 the categories of the second body (gets destroyed)
+ */
+void create_destructive_physics_collision_rule(scene_t *scene,
+                                               double elasticity,
+                                               size_t categories1,
+                                               size_t categories2);
+
 /**
  * Adds a chaos force creator to a scene that applies impulses
  * to resolve collisions between two bodies in the scene.
  * Of the 2 bodies that actually collide, only one body receives an impulse. Another 
  * body instead of the second body receives that second body's impulse in normal conditions here.
+ * The collision is read from the scene's collision events (scene_get_collision()),
+ * so body1 and body2 must be colliders covered by a collision rule.
  *
  * @param scene the scene containing the bodies
  * @param elasticity the "coefficient of restitution" of the collision;
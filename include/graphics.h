@@ -3,9 +3,8 @@
 
 #include "color.h"
 #include "list.h"
+#include "polygon.h"
 #include "vector.h"
-#include <SDL2/SDL.h>
-#include <SDL2/SDL_image.h>
 #include <stdbool.h>
 
 extern const size_t RECTANGLE_RESOLUTION;
@@ -21,10 +20,32 @@ typedef struct sprite_info {
     vector_t img_scale;
     bool is_sprite;
     rgb_color_t color;
-    SDL_Texture *texture;
+    struct SDL_Texture *texture; // loaded lazily by the SDL front end
     vector_t img_dim;
 } sprite_info_t;
 
+/**
+ * A function that returns the pixel dimensions of the image at img_path.
+ */
+typedef vector_t (*image_dimensions_handler_t)(char *img_path);
+
+/**
+ * Registers the function used to look up sprite image dimensions.
+ * The SDL front end passes sdl_get_image_dimensions(); headless builds
+ * register nothing, in which case sprites get zero image dimensions.
+ *
+ * @param handler the lookup function, or NULL to clear it
+ */
+void graphics_on_image_dimensions(image_dimensions_handler_t handler);
+
+/**
+ * Gets the dimensions of an image through the registered handler.
+ *
+ * @param img_path the path to the image
+ * @return the image's dimensions, or VEC_ZERO if no handler is registered
+ */
+vector_t get_image_dimensions(char *img_path);
+
 /**
  * Generates the positions of the balls in the rack at the start.
  *
@@ -34,6 +55,7 @@ list_t *generate_rack_pos();
 
 /**
  * Generates a list containing all the img paths of the balls.
+ * The paths are string literals, so freeing the list leaves them alone.
  *
  * @return the list containing the img paths.
  */
@@ -182,62 +204,62 @@ sprite_info_t line_texture();
 /**
  * Generates the polygon shape for the menu background.
  *
- * @return the list containing the menu background's polygon.
+ * @return the menu background's polygon.
  */
-list_t *generate_menu_background_shape();
+polygon_t *generate_menu_background_shape();
 
 /**
  * Generates the polygon shape for the menu button.
  *
  * @param index the index of the button (button 1, button 2, etc)
  *
- * @return the list containing the menu button's polygon
+ * @return the menu button's polygon
  */
-list_t *generate_menu_button_shape(size_t index);
+polygon_t *generate_menu_button_shape(size_t index);
 
 /**
  * Generates the polygon shape for the toggle buttons.
  *
  * @param index the index of the toggle button (chaos toggle, deathmatch toggle, etc)
  *
- * @return the list containing the toggle button's polygon
+ * @return the toggle button's polygon
  */
-list_t *generate_menu_toggle_shape(size_t index);
+polygon_t *generate_menu_toggle_shape(size_t index);
 
 /**
  * Generates the shape for the button to the close the instructions.
  *
- * @return the list containing the instructions close button shape
+ * @return the instructions close button shape
  */
-list_t *generate_instructions_close_shape();
+polygon_t *generate_instructions_close_shape();
 
 /**
  * Generates the polygon shape for the top wall's body.
  *
- * @return the list containing the polygon's shape.
+ * @return the polygon's shape.
  */
-list_t *generate_table_top_shape();
+polygon_t *generate_table_top_shape();
 
 /**
  * Generates the polygon shape for the left wall's body.
  *
- * @return the list containing the polygon's shape.
+ * @return the polygon's shape.
  */
-list_t *generate_table_left_shape();
+polygon_t *generate_table_left_shape();
 
 /**
  * Generates the polygon shape for the right wall's body.
  *
- * @return the list containing the polygon's shape.
+ * @return the polygon's shape.
  */
-list_t *generate_table_right_shape();
+polygon_t *generate_table_right_shape();
 
 /**
  * Generates the polygon shape for the bottom wall's body.
  *
- * @return the list containing the polygon's shape.
+ * @return the polygon's shape.
  */
-list_t *generate_table_bottom_shape();
+polygon_t *generate_table_bottom_shape();
 
 /**
  * Generates the positions of the six pockets on the pool table.
@@ -254,8 +276,8 @@ list_t *generate_pocket_locations();
  *
  * @return the shape of the stick body
  */
-list_t *poolstick_shape(vector_t my_position,
-                        vector_t cueball_position);
+polygon_t *poolstick_shape(vector_t my_position,
+                           vector_t cueball_position);
 
 /**
  * Returns the radius of the balls.
@@ -0,0 +1,94 @@
+#ifndef __GRAVITY_H__
+#define __GRAVITY_H__
+
+#include "kinematics.h"
+#include "thread_pool.h"
+#include <stddef.h>
+
+/**
+ * Mutual Newtonian gravity between many bodies, evaluated with a
+ * Barnes-Hut quadtree instead of a force creator per pair of bodies.
+ * Each call builds a tree over the gravitating slots of a kinematics_t
+ * (see body_set_gravitating()), recording the mass and center of mass of
+ * every cell. A body then treats a cell as one point mass when the cell's
+ * width divided by its distance from the cell's center of mass is below
+ * the opening angle theta; otherwise it looks inside the cell.
+ * This takes O(n log n) time instead of O(n^2).
+ *
+ * With theta = 0 no cell would ever be approximated, so the tree is
+ * skipped and the forces are summed over every pair, exactly as
+ * create_newtonian_gravity() would, up to rounding.
+ * Like create_newtonian_gravity(), no force acts between bodies closer
+ * than min_distance, where it would blow up.
+ */
+typedef struct gravity gravity_t;
+
+/**
+ * Allocates a gravity solver. The tree's memory is kept between calls,
+ * so only calls with more bodies than ever before allocate.
+ *
+ * @param G the gravitational proportionality constant
+ * @param theta the opening angle, at least 0 (about 0.5 is typical)
+ * @param min_distance the distance below which bodies do not attract
+ * @return the new solver
+ */
+gravity_t *gravity_init(double G, double theta, double min_distance);
+
+/**
+ * Releases the memory allocated for a gravity solver.
+ *
+ * @param gravity a pointer to a solver returned from gravity_init()
+ */
+void gravity_free(gravity_t *gravity);
+
+/**
+ * Gets the opening angle.
+ *
+ * @param gravity a pointer to a solver returned from gravity_init()
+ * @return theta
+ */
+double gravity_get_theta(gravity_t *gravity);
+
+/**
+ * Changes the opening angle, trading accuracy for speed.
+ *
+ * @param gravity a pointer to a solver returned from gravity_init()
+ * @param theta the opening angle, at least 0
+ */
+void gravity_set_theta(gravity_t *gravity, double theta);
+
+/**
+ * Adds the gravitational forces between the gravitating slots of kin to
+ * their accumulated forces. Slots with INFINITY mass neither attract nor
+ * are attracted. Sleeping slots attract the others but are skipped
+ * themselves, as integration would drop their forces.
+ * With a pool and theta > 0, the bodies' forces are evaluated on the
+ * pool's threads; the results do not depend on the number of threads.
+ * Exact pairwise sums (theta = 0) always run on the calling thread.
+ *
+ * @param gravity a pointer to a solver returned from gravity_init()
+ * @param kin the storage
+ * @param pool a pointer to a pool returned from thread_pool_init(), or NULL
+ */
+void gravity_apply(gravity_t *gravity, kinematics_t *kin,
+                   thread_pool_t *pool);
+
+/**
+ * Gets the number of quadtree cells built by the last gravity_apply(),
+ * which is 0 with theta = 0.
+ *
+ * @param gravity a pointer to a solver returned from gravity_init()
+ * @return the number of cells
+ */
+size_t gravity_cells(gravity_t *gravity);
+
+/**
+ * Gets the number of body-body and body-cell forces computed by the last
+ * gravity_apply(). Exact pairwise gravity on n bodies takes n * (n - 1).
+ *
+ * @param gravity a pointer to a solver returned from gravity_init()
+ * @return the number of interactions
+ */
+size_t gravity_interactions(gravity_t *gravity);
+
+#endif // #ifndef __GRAVITY_H__
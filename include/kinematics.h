@@ -0,0 +1,258 @@
+#ifndef __KINEMATICS_H__
+#define __KINEMATICS_H__
+
+#include "vector.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Structure-of-arrays storage for the state a body needs every tick.
+ * Slot i of every array belongs to the same body, and slots are kept dense
+ * (0 to size - 1) so scene_tick() can integrate all bodies in one linear pass
+ * without touching the rest of body_t (shape, sprite, info...).
+ *
+ * Unlike most types in this library the struct is public, because body.c
+ * and scene.c index the arrays directly on their hot paths.
+ * Arrays may be reallocated when the storage grows, so never keep pointers
+ * into them; keep (storage, slot) pairs instead.
+ */
+typedef struct kinematics {
+  size_t size;
+  size_t capacity;
+  vector_t *centroid;
+  vector_t *velocity;
+  vector_t *force;
+  vector_t *impulse;
+  /** 1 / mass, so bodies with INFINITY mass have 0 */
+  double *inv_mass;
+  /** The body occupying each slot (a body_t *), used when slots move */
+  void **owner;
+  /** Sleeping slots are at rest and skipped by integration */
+  bool *asleep;
+  /** Seconds each slot has spent slow enough to fall asleep */
+  double *rest_time;
+  /**
+   * Field forces (see kinematics_apply_fields()), 0 for slots they do
+   * not act on: the linear drag coefficient, the magnitude of the constant
+   * drag, and the acceleration of uniform gravity
+   */
+  double *drag;
+  double *constant_drag;
+  vector_t *gravity;
+  /** The slowest speed at which each slot's constant drag acts */
+  double *constant_drag_min_speed;
+  /** Whether each slot takes part in mutual gravity (see gravity.h) */
+  bool *gravitating;
+  /** The number of slots that are not asleep */
+  size_t awake;
+} kinematics_t;
+
+/**
+ * How scene_tick() advances slots over a step, from the forces and impulses
+ * accumulated on them.
+ *
+ * INTEGRATOR_AVERAGE_VELOCITY (the default) changes velocities by the
+ * forces, then moves centroids by the average of the old and new velocities
+ * (see kinematics_integrate()).
+ * INTEGRATOR_SEMI_IMPLICIT_EULER moves centroids by the new velocities
+ * instead. Like velocity Verlet it is symplectic, so oscillators and orbits
+ * keep their energy over long runs instead of drifting, but it is only
+ * first order.
+ * INTEGRATOR_VELOCITY_VERLET gives each slot half of its velocity change,
+ * moves it, evaluates the forces again at the new centroids and gives it the
+ * other half from those. It is second order and symplectic.
+ * INTEGRATOR_RK4 evaluates the forces four times per step (classic
+ * fourth-order Runge-Kutta), so its error shrinks with dt^4.
+ *
+ * Integrators that evaluate the forces again within a step can only do so
+ * for forces that are pure functions of the state; see scene_set_integrator().
+ */
+typedef enum integrator {
+  INTEGRATOR_AVERAGE_VELOCITY,
+  INTEGRATOR_SEMI_IMPLICIT_EULER,
+  INTEGRATOR_VELOCITY_VERLET,
+  INTEGRATOR_RK4,
+} integrator_t;
+
+/**
+ * Per-slot scratch for the integrators that evaluate the forces more than
+ * once per step (see kinematics_stage()). Each array needs one element per
+ * slot being integrated, and the contents only matter during a step.
+ */
+typedef struct kinematics_stages {
+  /** Forces acting through the whole step, restored before each stage */
+  vector_t *held;
+  /** The centroids and velocities at the start of the step */
+  vector_t *centroid;
+  vector_t *velocity;
+  /** RK4's weighted sums of the changes in centroid and velocity */
+  vector_t *centroid_change;
+  vector_t *velocity_change;
+} kinematics_stages_t;
+
+/**
+ * Gets the number of times an integrator evaluates the forces per step.
+ *
+ * @param integrator the integrator
+ * @return the number of stages, from 1 to 4
+ */
+size_t integrator_stages(integrator_t integrator);
+
+/**
+ * Allocates empty kinematic storage.
+ * Asserts that the required memory was allocated.
+ *
+ * @param initial_capacity the number of slots to allocate space for
+ * @return the new storage
+ */
+kinematics_t *kinematics_init(size_t initial_capacity);
+
+/**
+ * Releases the storage. Does not free the owners.
+ *
+ * @param kin storage returned from kinematics_init()
+ */
+void kinematics_free(kinematics_t *kin);
+
+/**
+ * Appends a slot, growing the arrays if needed.
+ * The new slot is at rest with no accumulated force or impulse, no field
+ * forces and no mutual gravity, but awake.
+ *
+ * @param kin the storage
+ * @param owner the body that will own the slot
+ * @param centroid the initial centroid
+ * @param inv_mass the inverse mass (0 for immovable bodies)
+ * @return the index of the new slot
+ */
+size_t kinematics_add(kinematics_t *kin, void *owner, vector_t centroid,
+                      double inv_mass);
+
+/**
+ * Removes a slot by moving the last slot into its place.
+ * The caller must tell the moved owner (if any) its new slot index.
+ *
+ * @param kin the storage
+ * @param slot the slot to remove
+ * @return the owner that moved into slot, or NULL if slot was the last one
+ */
+void *kinematics_remove(kinematics_t *kin, size_t slot);
+
+/**
+ * Makes dst an exact copy of src, slot for slot, growing dst if needed.
+ * Owners are copied as pointers; the caller must tell them their slots.
+ *
+ * @param dst the storage to overwrite
+ * @param src the storage to copy
+ */
+void kinematics_copy(kinematics_t *dst, kinematics_t *src);
+
+/**
+ * Puts a slot to sleep, stopping it. Does nothing if it is already asleep.
+ *
+ * @param kin the storage
+ * @param slot the slot
+ */
+void kinematics_sleep(kinematics_t *kin, size_t slot);
+
+/**
+ * Wakes a slot up. Does nothing if it is already awake.
+ *
+ * @param kin the storage
+ * @param slot the slot
+ */
+void kinematics_wake(kinematics_t *kin, size_t slot);
+
+/**
+ * Puts to sleep the slots in [start, end) whose speed has stayed at or below
+ * max_speed for rest_time seconds. Call this after integrating.
+ *
+ * @param kin the storage
+ * @param start the first slot to check
+ * @param end one past the last slot to check
+ * @param max_speed the speed at or below which a slot counts as resting
+ * @param rest_time how long a slot must rest before it falls asleep
+ * @param dt the number of seconds elapsed
+ */
+void kinematics_settle(kinematics_t *kin, size_t start, size_t end,
+                       double max_speed, double rest_time, double dt);
+
+/**
+ * Adds the field forces to the accumulated forces of slots [start, end),
+ * in one pass over the coefficient arrays instead of a force creator per
+ * body and field:
+ * linear drag, -drag * velocity;
+ * constant drag, constant_drag against the direction of motion, but only
+ * at speeds of at least the slot's constant_drag_min_speed so it does not
+ * jitter resting bodies;
+ * and gravity, mass * gravity for slots with finite mass.
+ * Sleeping slots are skipped, as integration would drop their forces.
+ *
+ * @param kin the storage
+ * @param start the first slot
+ * @param end one past the last slot
+ */
+void kinematics_apply_fields(kinematics_t *kin, size_t start, size_t end);
+
+/**
+ * Integrates slots [start, end) over dt and clears their forces and impulses.
+ * Velocities change by (impulse + force * dt) / mass and centroids move by
+ * the average of the old and new velocities, as described in body_tick().
+ * Sleeping slots do not move, and forces on them are dropped.
+ *
+ * @param kin the storage
+ * @param start the first slot to integrate
+ * @param end one past the last slot to integrate
+ * @param dt the number of seconds elapsed
+ */
+void kinematics_integrate(kinematics_t *kin, size_t start, size_t end,
+                          double dt);
+
+/**
+ * Like kinematics_integrate(), but centroids move by the new velocities
+ * (INTEGRATOR_SEMI_IMPLICIT_EULER).
+ *
+ * @param kin the storage
+ * @param start the first slot to integrate
+ * @param end one past the last slot to integrate
+ * @param dt the number of seconds elapsed
+ */
+void kinematics_integrate_euler(kinematics_t *kin, size_t start, size_t end,
+                                double dt);
+
+/**
+ * Starts a step of an integrator with more than one stage on slots
+ * [start, end). The forces accumulated so far are held through the whole
+ * step, impulses are applied to the velocities straight away, and the
+ * centroids and velocities are saved.
+ * Then for each stage, add the forces that depend on the state and call
+ * kinematics_stage().
+ *
+ * @param kin the storage
+ * @param stages the scratch for the step
+ * @param start the first slot
+ * @param end one past the last slot
+ */
+void kinematics_begin_stages(kinematics_t *kin, kinematics_stages_t *stages,
+                             size_t start, size_t end);
+
+/**
+ * Runs one stage of an integrator on slots [start, end), using the forces
+ * accumulated at their current centroids and velocities. It moves them to
+ * where the next stage evaluates the forces, or after the last stage, to
+ * the end of the step, and then resets their forces to the held ones (or to
+ * 0 after the last stage). Sleeping slots do not move.
+ *
+ * @param kin the storage
+ * @param integrator an integrator with more than one stage
+ * @param stage the stage, from 0 to integrator_stages(integrator) - 1
+ * @param stages the scratch passed to kinematics_begin_stages()
+ * @param start the first slot
+ * @param end one past the last slot
+ * @param dt the number of seconds in the step
+ */
+void kinematics_stage(kinematics_t *kin, integrator_t integrator, size_t stage,
+                      kinematics_stages_t *stages, size_t start, size_t end,
+                      double dt);
+
+#endif // #ifndef __KINEMATICS_H__
@@ -1,6 +1,7 @@
 #ifndef __LIST_H__
 #define __LIST_H__
 
+#include "rng.h"
 #include <stddef.h>
 
 /**
@@ -64,6 +65,18 @@ void *list_get(list_t *list, size_t index);
  */
 void *list_remove(list_t *list, size_t index);
 
+/**
+ * Removes the element at a given index in a list and returns it,
+ * moving the last element into its place.
+ * Unlike list_remove() this takes constant time, but changes the order.
+ * Asserts that the index is valid, given the list's current size.
+ *
+ * @param list a pointer to a list returned from list_init()
+ * @param index the index of the element to remove
+ * @return the element at the given index in the list
+ */
+void *list_swap_remove(list_t *list, size_t index);
+
 /**
  * Appends an element to the end of a list.
  * If the list is filled to capacity, resizes the list to fit more elements
@@ -107,13 +120,23 @@ void *list_dequeue(list_t *list);
  */
 void *list_pop(list_t *list);
 
+/**
+ * Replaces the contents of a list with copies of count values.
+ * The old elements are not freed. Asserts that the values are non-NULL.
+ *
+ * @param list a pointer to a list returned from list_init()
+ * @param values the new elements, in order
+ * @param count the number of new elements
+ */
+void list_assign(list_t *list, void **values, size_t count);
 
 /**
  * Shuffles the elements of the given list.
  * Will modify the given list!
  * 
  * @param list a pointer to the list to be shuffled
+ * @param rng the generator to draw from
 */
-void list_shuffle(list_t *list);
+void list_shuffle(list_t *list, rng_t *rng);
 
 #endif // #ifndef __LIST_H__
@@ -0,0 +1,104 @@
+#ifndef __MESH_H__
+#define __MESH_H__
+
+#include "polygon.h"
+#include "vector.h"
+#include <stddef.h>
+
+/**
+ * An axis-aligned bounding box.
+ */
+typedef struct aabb
+{
+  vector_t min;
+  vector_t max;
+} aabb_t;
+
+/**
+ * An immutable outline in local space, i.e. relative to a body's centroid
+ * and before the body is rotated.
+ * Meshes are reference counted so that many bodies can share one outline
+ * (e.g. every ball of the same radius), and each body only keeps its own
+ * position and rotation. References can be taken and dropped on any thread.
+ */
+typedef struct mesh mesh_t;
+
+/**
+ * Allocates a mesh from an outline given in local space.
+ * The mesh starts out with one reference, held by the caller.
+ * Asserts that the outline has vertices
+ * and that the required memory was allocated.
+ *
+ * @param local the vertices relative to the centroid; the mesh takes
+ *   ownership of the polygon, which must not be changed afterwards
+ * @return the new mesh
+ */
+mesh_t *mesh_init(polygon_t *local);
+
+/**
+ * Gets the shared outline of a circle around the origin,
+ * allocating it if no body on any thread uses one of that radius yet.
+ * The caller gets a new reference.
+ *
+ * @param radius the radius of the circle
+ * @return a mesh with the outline from generate_ball()
+ */
+mesh_t *mesh_circle(double radius);
+
+/**
+ * Adds a reference to a mesh.
+ *
+ * @param mesh the mesh
+ * @return the same mesh, for convenience
+ */
+mesh_t *mesh_retain(mesh_t *mesh);
+
+/**
+ * Drops a reference to a mesh, and releases it if that was the last one.
+ *
+ * @param mesh a mesh returned from mesh_init(), mesh_circle() or mesh_retain()
+ */
+void mesh_release(mesh_t *mesh);
+
+/**
+ * Gets the number of references to a mesh.
+ *
+ * @param mesh the mesh
+ * @return the number of references
+ */
+size_t mesh_refs(mesh_t *mesh);
+
+/**
+ * Gets the number of vertices of a mesh.
+ *
+ * @param mesh the mesh
+ * @return the number of vertices
+ */
+size_t mesh_size(mesh_t *mesh);
+
+/**
+ * Gets the vertices of a mesh, in local space. They must not be changed.
+ *
+ * @param mesh the mesh
+ * @return a pointer to the first of mesh_size() vertices
+ */
+vector_t *mesh_vertices(mesh_t *mesh);
+
+/**
+ * Gets the distance from the origin to the farthest vertex of a mesh,
+ * which does not change when the mesh is rotated.
+ *
+ * @param mesh the mesh
+ * @return the bounding radius
+ */
+double mesh_radius(mesh_t *mesh);
+
+/**
+ * Gets the bounding box of a mesh without any rotation.
+ *
+ * @param mesh the mesh
+ * @return the bounding box, in local space
+ */
+aabb_t mesh_bounds(mesh_t *mesh);
+
+#endif // #ifndef __MESH_H__
@@ -1,49 +1,130 @@
 #ifndef __POLYGON_H__
 #define __POLYGON_H__
 
-#include "list.h"
 #include "vector.h"
+#include <stddef.h>
+
+/**
+ * A polygon, stored as a growable array of vertices.
+ * The vertices are kept contiguously and by value (rather than as pointers
+ * to individually malloc()ed vectors like a list_t), so a shape is two
+ * allocations however many vertices it has, and loops over the vertices
+ * read memory linearly.
+ */
+typedef struct polygon polygon_t;
+
+/**
+ * Allocates memory for a new polygon with space for the given number of
+ * vertices. The polygon is initially empty.
+ * Asserts that the required memory was allocated.
+ *
+ * @param initial_size the number of vertices to allocate space for
+ * @return a pointer to the newly allocated polygon
+ */
+polygon_t *polygon_init(size_t initial_size);
+
+/**
+ * Releases the memory allocated for a polygon.
+ *
+ * @param polygon a pointer to a polygon returned from polygon_init()
+ */
+void polygon_free(polygon_t *polygon);
+
+/**
+ * Allocates a copy of a polygon.
+ *
+ * @param polygon a pointer to a polygon returned from polygon_init()
+ * @return a pointer to the copy, which must be polygon_free()d
+ */
+polygon_t *polygon_copy(polygon_t *polygon);
+
+/**
+ * Gets the number of vertices in a polygon.
+ *
+ * @param polygon a pointer to a polygon returned from polygon_init()
+ * @return the number of vertices
+ */
+size_t polygon_size(polygon_t *polygon);
+
+/**
+ * Gets the vertex at a given index in a polygon.
+ * Asserts that the index is valid.
+ *
+ * @param polygon a pointer to a polygon returned from polygon_init()
+ * @param index an index in the polygon (the first vertex is at 0)
+ * @return the vertex at the given index
+ */
+vector_t polygon_get(polygon_t *polygon, size_t index);
+
+/**
+ * Moves the vertex at a given index in a polygon.
+ * Asserts that the index is valid.
+ *
+ * @param polygon a pointer to a polygon returned from polygon_init()
+ * @param index an index in the polygon (the first vertex is at 0)
+ * @param vertex the new position of the vertex
+ */
+void polygon_set(polygon_t *polygon, size_t index, vector_t vertex);
+
+/**
+ * Appends a vertex to the end of a polygon,
+ * growing its storage if it is full.
+ *
+ * @param polygon a pointer to a polygon returned from polygon_init()
+ * @param vertex the vertex to add
+ */
+void polygon_add(polygon_t *polygon, vector_t vertex);
+
+/**
+ * Gets the array holding a polygon's vertices, for loops that want to read
+ * or write them directly. There are polygon_size() of them.
+ * The pointer is invalidated by polygon_add() and polygon_free().
+ *
+ * @param polygon a pointer to a polygon returned from polygon_init()
+ * @return the first vertex
+ */
+vector_t *polygon_vertices(polygon_t *polygon);
 
 /**
  * Computes the area of a polygon.
  * See https://en.wikipedia.org/wiki/Shoelace_formula#Statement.
  *
- * @param polygon the list of vertices that make up the polygon,
+ * @param polygon the vertices that make up the polygon,
  * listed in a counterclockwise direction. There is an edge between
  * each pair of consecutive vertices, plus one between the first and last.
  * @return the area of the polygon
  */
-double polygon_area(list_t *polygon);
+double polygon_area(polygon_t *polygon);
 
 /**
  * Computes the center of mass of a polygon.
  * See https://en.wikipedia.org/wiki/Centroid#Of_a_polygon.
  *
- * @param polygon the list of vertices that make up the polygon,
+ * @param polygon the vertices that make up the polygon,
  * listed in a counterclockwise direction. There is an edge between
  * each pair of consecutive vertices, plus one between the first and last.
  * @return the centroid of the polygon
  */
-vector_t polygon_centroid(list_t *polygon);
+vector_t polygon_centroid(polygon_t *polygon);
 
 /**
  * Translates all vertices in a polygon by a given vector.
  * Note: mutates the original polygon.
  *
- * @param polygon the list of vertices that make up the polygon
+ * @param polygon the vertices that make up the polygon
  * @param translation the vector to add to each vertex's position
  */
-void polygon_translate(list_t *polygon, vector_t translation);
+void polygon_translate(polygon_t *polygon, vector_t translation);
 
 /**
  * Rotates vertices in a polygon by a given angle about a given point.
  * Note: mutates the original polygon.
  *
- * @param polygon the list of vertices that make up the polygon
+ * @param polygon the vertices that make up the polygon
  * @param angle the angle to rotate the polygon, in radians.
  * A positive angle means counterclockwise.
  * @param point the point to rotate around
  */
-void polygon_rotate(list_t *polygon, double angle, vector_t point);
+void polygon_rotate(polygon_t *polygon, double angle, vector_t point);
 
 #endif // #ifndef __POLYGON_H__
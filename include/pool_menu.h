@@ -77,7 +77,8 @@ body_t *get_powerup_toggle_body(scene_t *scene);
 /**
  * Master function that generates the entire menu at the
  * start of the game. A background with 3 buttons (2 player, easy AI, hard AI)
- * are generated.
+ * are generated. Like generate_pool_table(), this indexes the scene by
+ * body_id().
  *
  * @param scene the scene to generate the menu in
  */
@@ -3,6 +3,21 @@
 
 #include "scene.h"
 #include "body.h"
+#include "event_sim.h"
+
+/**
+ * A function that plays the sound effect at effect_path with the given volume.
+ */
+typedef void (*sound_handler_t)(char *effect_path, double volume);
+
+/**
+ * Registers the function used to play collision and pocketing sounds.
+ * The SDL front end passes sdl_play_sound_effect(); headless simulations
+ * register nothing and run silently.
+ *
+ * @param handler the sound function, or NULL to mute the table
+ */
+void pool_table_on_sound(sound_handler_t handler);
 
 void generate_table(scene_t *scene);
 
@@ -15,8 +30,18 @@ void generate_table(scene_t *scene);
  */
 size_t *generate_ID(size_t object_id);
 
+/**
+ * Releases an ID returned from generate_ID().
+ * Pass it as the info freer of bodies whose info is a generated ID.
+ *
+ * @param object_ID the ID
+ */
+void free_ID(size_t *object_ID);
+
 /**
  * Creates a new pool table with all balls at the start position.
+ * The scene is indexed by body_id() (see scene_set_tagger()), which
+ * count_balls() and get_specified_body() rely on.
  *
  * @param scene the scene to generate the table in
  * @param chaos whether we are in chaos mode
@@ -52,6 +77,17 @@ bool is_ball(body_t *body);
  */
 bool balls_stopped(scene_t *scene);
 
+/**
+ * Sets up an event-driven simulation (see event_sim.h) of the balls,
+ * cushions and pockets on the table, with the table's drag and elasticities.
+ * Each ball is owned by its body, so event_sim_apply() copies the outcome
+ * back into the scene. Chaos mode, powerups and the stick are not modeled.
+ *
+ * @param scene the scene of the pool table
+ * @return the simulator, to be freed with event_sim_free()
+ */
+event_sim_t *pool_event_sim(scene_t *scene);
+
 /**
  * Generates the poolstick body.
  *
@@ -95,6 +131,8 @@ size_t solid_count(scene_t *scene);
 
 /**
  * Counts the number of balls in play with given ID.
+ * The scene must have been set up by generate_pool_table() or
+ * generate_menu(), which index it by body_id(), so this takes constant time.
  *
  * @param scene the table's scene
  * @param searched_id the id of the balls you want to count
@@ -216,6 +254,7 @@ void destroy_poolstick(scene_t *scene);
 
 /**
  * Gets a first body in scene bodies (if it exists) that matches a given ID.
+ * Like count_balls(), this looks the ID up in the scene's tag index.
  *
  * @param scene the scene of the pool table
  * @param id specified ID
@@ -233,9 +272,28 @@ body_t *get_specified_body(scene_t *scene, size_t id);
  */
 void update_poolstick(scene_t *scene, vector_t my_position);
 
+/**
+ * Gets the collision categories (see scene_add_collider()) of a table body.
+ *
+ * @param body a body of the pool table
+ * @return the categories of the body, or 0 if it does not collide
+ */
+size_t collision_categories(body_t *body);
+
+/**
+ * Registers the collision rules between balls, walls, pockets, powerups and
+ * the stick.
+ * Called once per table by add_collisions().
+ *
+ * @param scene the scene of the table
+ * @param chaos whether we are in chaos mode
+ */
+void add_collision_rules(scene_t *scene, bool chaos);
+
 /**
  * Adds collisions and drag forces to the scene according to whether we are in chaos
  * mode or not.
+ * Every table body is registered once with the scene's collision pipeline.
  *
  * @param scene the scene of the table
  * @param chaos whether we are in chaos mode
@@ -246,12 +304,13 @@ void add_collisions(scene_t *scene, bool chaos, bool powerup);
 /**
  * Sets up a destructive collision between the cueball and stick in the scene
  * (destructive such that stick is destroyed after collision but not the cueball).
+ * The stick joins the scene's collision pipeline; the collision itself is one
+ * of the rules from add_collision_rules().
  *
- * @param stick body of the poolstick
+ * @param stick body of the poolstick, already added to the scene
  * @param scene the scene of the table
- * @param elasticity the desired elasticity of the collision
  */
-void setup_ball_stick_collisions(body_t *stick, scene_t *scene, double elasticity);
+void setup_ball_stick_collisions(body_t *stick, scene_t *scene);
 
 /**
  * Generates the power up body.
@@ -270,9 +329,10 @@ void generate_power_up(scene_t *scene, vector_t position);
  * @param powerup if we are playing with powerup
  * 
  * NOTE: it is assumed that shape is VALID! (no collisions, right radius)
+ * The cueball is a circle at the shape's centroid, and shape is freed.
  * It will also add the collision forcers for this new cueball
 */
-void put_cueball(scene_t *scene, list_t *shape, bool chaos, bool powerup);
+void put_cueball(scene_t *scene, polygon_t *shape, bool chaos, bool powerup);
 
 /**
  * Returns the id of the given body.
@@ -287,11 +347,12 @@ size_t body_id(body_t *body);
  * 
  * @param array the array to be modified
  * @param n length of the array
+ * @param rng the generator to draw from, e.g. scene_rng()
 */
-void shuffle(size_t *array, size_t n);
+void shuffle(size_t *array, size_t n, rng_t *rng);
 
 /**
- * Returns a new location for the powerup.
+ * Returns a new location for the powerup, drawn from scene_rng().
  * 
  * @param scene the scene
  * @return location of new powerup
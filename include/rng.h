@@ -0,0 +1,52 @@
+#ifndef __RNG_H__
+#define __RNG_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A seeded pseudorandom number generator (xoshiro256**).
+ * Every generator is independent of the others and of rand(), so the same
+ * seed always gives the same sequence on every platform.
+ * rng_t is defined here instead of rng.c so it can be stored and copied
+ * by value, e.g. inside a scene snapshot; do not touch the state directly.
+ */
+typedef struct {
+  uint64_t state[4];
+} rng_t;
+
+/**
+ * Resets a generator to the start of the sequence for a seed.
+ *
+ * @param rng the generator
+ * @param seed any value; equal seeds give equal sequences
+ */
+void rng_seed(rng_t *rng, uint64_t seed);
+
+/**
+ * Draws 64 random bits.
+ *
+ * @param rng the generator
+ * @return the next number in the sequence
+ */
+uint64_t rng_next(rng_t *rng);
+
+/**
+ * Draws a number uniformly from [0, 1).
+ *
+ * @param rng the generator
+ * @return the number
+ */
+double rng_uniform(rng_t *rng);
+
+/**
+ * Draws an integer uniformly from [0, n), without the bias of rand() % n.
+ * Asserts that n is positive.
+ *
+ * @param rng the generator
+ * @param n the number of possible results
+ * @return the integer
+ */
+size_t rng_below(rng_t *rng, size_t n);
+
+#endif // #ifndef __RNG_H__
@@ -0,0 +1,82 @@
+#ifndef __SAT_H__
+#define __SAT_H__
+
+#include "vector.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Kernels for the separating axis test (see find_collision()):
+ * projecting a shape's vertices onto axes and keeping the extremes.
+ * Each kernel works on a contiguous array of vertices (see
+ * polygon_vertices()), and the axes must already be unit vectors,
+ * so nothing is normalized per vertex.
+ *
+ * On x86 the vertices are projected with SSE2 or AVX2 instructions
+ * when the CPU has them; elsewhere only the scalar kernel exists.
+ * All kernels give exactly the same results.
+ */
+typedef enum
+{
+  SAT_SCALAR,
+  SAT_SSE2,
+  SAT_AVX2
+} sat_kernel_t;
+
+/**
+ * Determines whether a kernel was compiled in and the CPU can run it.
+ *
+ * @param kernel the kernel
+ * @return whether sat_set_kernel() accepts the kernel
+ */
+bool sat_kernel_supported(sat_kernel_t kernel);
+
+/**
+ * Gets the kernel in use. Until sat_set_kernel() is called,
+ * that is the fastest supported one.
+ *
+ * @return the kernel
+ */
+sat_kernel_t sat_get_kernel();
+
+/**
+ * Picks the kernel to use from now on, e.g. to compare them.
+ * Asserts that the kernel is supported.
+ *
+ * @param kernel the kernel
+ */
+void sat_set_kernel(sat_kernel_t kernel);
+
+/**
+ * Gets a kernel's name, for printing.
+ *
+ * @param kernel the kernel
+ * @return "scalar", "sse2" or "avx2"
+ */
+const char *sat_kernel_name(sat_kernel_t kernel);
+
+/**
+ * Projects vertices onto an axis.
+ *
+ * @param vertices the vertices
+ * @param n_vertices the number of vertices, which must be positive
+ * @param axis a unit vector
+ * @return the minimum projection as x and the maximum as y
+ */
+vector_t sat_project(vector_t *vertices, size_t n_vertices, vector_t axis);
+
+/**
+ * Projects vertices onto several axes in one pass over the vertices.
+ * Gives the same results as calling sat_project() for each axis.
+ *
+ * @param vertices the vertices
+ * @param n_vertices the number of vertices, which must be positive
+ * @param axes unit vectors
+ * @param n_axes the number of axes
+ * @param projs where to store the minimum (x) and maximum (y) projection
+ *   on each axis
+ */
+void sat_project_axes(vector_t *vertices, size_t n_vertices, vector_t *axes,
+                      size_t n_axes, vector_t *projs);
+
+#endif // #ifndef __SAT_H__
@@ -1,8 +1,16 @@
 #ifndef __SCENE_H__
 #define __SCENE_H__
 
+#include "arena.h"
 #include "body.h"
+#include "collision.h"
+#include "contact.h"
+#include "gravity.h"
+#include "kinematics.h"
 #include "list.h"
+#include "rng.h"
+#include "thread_pool.h"
+#include <stdint.h>
 
 /**
  * A collection of bodies and force creators.
@@ -18,6 +26,13 @@ typedef struct scene scene_t;
  */
 typedef void (*force_creator_t)(void *aux);
 
+/**
+ * A function that classifies bodies, e.g. by the type stored in their info.
+ * Tags should be small numbers, since the index has room for every tag up to
+ * the largest one.
+ */
+typedef size_t (*body_tagger_t)(body_t *body);
+
 /**
  * Allocates memory for an empty scene.
  * Makes a reasonable guess of the number of bodies to allocate space for.
@@ -43,6 +58,15 @@ void scene_free(scene_t *scene);
  */
 size_t scene_bodies(scene_t *scene);
 
+/**
+ * Gets the number of force creators in a given scene.
+ * Field forces (see body_add_drag()) are not force creators.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the number of force creators that will run next tick
+ */
+size_t scene_force_creators(scene_t *scene);
+
 /**
  * Gets the body at a given index in a scene.
  * Asserts that the index is valid.
@@ -61,6 +85,64 @@ body_t *scene_get_body(scene_t *scene, size_t index);
  */
 void scene_add_body(scene_t *scene, body_t *body);
 
+/**
+ * Gets a handle to a body in a scene.
+ * Unlike its index, a body's handle does not change when other bodies are
+ * removed, and it stops resolving once the body itself is removed.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param body a body that has been added to the scene
+ * @return the body's handle
+ */
+body_handle_t scene_get_handle(scene_t *scene, body_t *body);
+
+/**
+ * Looks up the body a handle refers to, in constant time.
+ * Removed bodies do not resolve, even before scene_tick() frees them,
+ * unless scene_restore() brings them back.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param handle a handle returned from scene_get_handle() on the same scene
+ * @return the body, or NULL if it has been removed
+ */
+body_t *scene_resolve(scene_t *scene, body_handle_t handle);
+
+/**
+ * Indexes the scene's bodies by the tags a function gives them,
+ * so bodies can be looked up and counted by tag in constant time.
+ * The index is built from the current bodies, then updated as bodies are
+ * added and taken out, so a body's tag must not change while it is in
+ * the scene. Like scene_get_body(), the index holds removed bodies
+ * until scene_tick() takes them out.
+ * Setting the tagger the scene already has does nothing.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param tagger the function giving each body its tag, or NULL to stop
+ *   indexing
+ */
+void scene_set_tagger(scene_t *scene, body_tagger_t tagger);
+
+/**
+ * Gets the number of bodies with a tag.
+ * Asserts that the scene has a tagger (see scene_set_tagger()).
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param tag the tag
+ * @return the number of bodies in the scene with the tag
+ */
+size_t scene_tagged_count(scene_t *scene, size_t tag);
+
+/**
+ * Gets a body with a tag. Bodies with the same tag are in scene order.
+ * Asserts that the index is valid.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param tag the tag
+ * @param index the index among the bodies with the tag (starting at 0)
+ * @return the body
+ */
+body_t *scene_get_tagged(scene_t *scene, size_t tag, size_t index);
+
 /**
  * @deprecated Use body_remove() instead
  *
@@ -98,16 +180,365 @@ void scene_add_bodies_force_creator(scene_t *scene, force_creator_t forcer,
                                     void *aux, list_t *bodies,
                                     free_func_t freer);
 
+/**
+ * Adds a force creator like scene_add_bodies_force_creator() that may run
+ * on another thread, at the same time as force creators that share none
+ * of its bodies, when the scene has a thread pool (see
+ * scene_set_thread_pool()). The force creator must only read its bodies
+ * and add forces and impulses to them: no other bodies, no changes to the
+ * scene, no removals and no shared state.
+ * Each body still gets its forces in the order the force creators were
+ * added, so the results are the same as without a pool.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param forcer a force creator function
+ * @param aux an auxiliary value to pass to forcer when it is called
+ * @param bodies every body the force creator reads or acts on.
+ *   This list does not own the bodies, so its freer should be NULL.
+ * @param freer if non-NULL, a function to call in order to free aux
+ */
+void scene_add_parallel_force_creator(scene_t *scene, force_creator_t forcer,
+                                      void *aux, list_t *bodies,
+                                      free_func_t freer);
+
+/**
+ * Adds a parallel force creator (see scene_add_parallel_force_creator())
+ * whose forces are a pure function of its bodies' centroids and
+ * velocities, such as a spring. Integrators with several stages evaluate
+ * these again at every stage of a tick (see scene_set_integrator()), so
+ * they must also keep no state between calls.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param forcer a force creator function
+ * @param aux an auxiliary value to pass to forcer when it is called
+ * @param bodies every body the force creator reads or acts on.
+ *   This list does not own the bodies, so its freer should be NULL.
+ * @param freer if non-NULL, a function to call in order to free aux
+ */
+void scene_add_pure_force_creator(scene_t *scene, force_creator_t forcer,
+                                  void *aux, list_t *bodies,
+                                  free_func_t freer);
+
+/**
+ * Adds a force creator like scene_add_bodies_force_creator() that carries
+ * state from one tick to the next, such as whether its bodies were
+ * touching. Snapshots save the state's bytes and scene_restore() puts them
+ * back, so a restored scene replays the same way.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param forcer a force creator function
+ * @param aux an auxiliary value to pass to forcer when it is called
+ * @param bodies the list of bodies affected by the force creator.
+ *   This list does not own the bodies, so its freer should be NULL.
+ * @param freer if non-NULL, a function to call in order to free aux
+ * @param state the state, usually part of aux, which must live as long
+ * @param state_size the size of the state in bytes
+ */
+void scene_add_stateful_force_creator(scene_t *scene, force_creator_t forcer,
+                                      void *aux, list_t *bodies,
+                                      free_func_t freer, void *state,
+                                      size_t state_size);
+
+/**
+ * Registers a body with the scene's collision pipeline (see broadphase.h).
+ * This replaces creating a collision force creator for each pair of bodies:
+ * the body collides with every other registered body that a rule from
+ * scene_add_collision_rule() applies to.
+ * The body is unregistered when it is removed.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param body a body that has been added to the scene
+ * @param categories a nonzero bitmask of the categories the body belongs to
+ */
+void scene_add_collider(scene_t *scene, body_t *body, size_t categories);
+
+/**
+ * Adds a collision handler for two categories of colliders.
+ * Whenever a collider in categories1 starts colliding with one in
+ * categories2, handler is called with them in that order,
+ * just like a handler registered with create_collision().
+ * A NULL handler only makes the contacts visible to scene_get_collision().
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param categories1 the bitmask the first body must match
+ * @param categories2 the bitmask the second body must match
+ * @param handler a function to call whenever matching bodies collide
+ * @param aux an auxiliary value to pass to handler when it is called
+ * @param freer if non-NULL, a function to call in order to free aux
+ */
+void scene_add_collision_rule(scene_t *scene, size_t categories1,
+                              size_t categories2, collision_handler_t handler,
+                              void *aux, free_func_t freer);
+
+/**
+ * Makes colliders in two categories bounce off each other. Their contacts
+ * are gathered every tick they touch and resolved together by the scene's
+ * contact solver (see contact.h) just before integration, after the force
+ * creators.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param categories1 the bitmask the first body must match
+ * @param categories2 the bitmask the second body must match
+ * @param elasticity the coefficient of restitution of the contacts
+ */
+void scene_add_contact_rule(scene_t *scene, size_t categories1,
+                            size_t categories2, double elasticity);
+
+/**
+ * Adds a contact for the scene's contact solver to resolve this tick,
+ * together with the contacts found by the collision pipeline.
+ * Meant for force creators that test pairs themselves.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param contact the contact, between bodies in the scene
+ */
+void scene_add_contact(scene_t *scene, contact_t contact);
+
+/**
+ * Sets when the contact solver stops (see contact_solver_set_iterations()).
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param max_iterations the most passes over the contacts per tick
+ * @param tolerance the largest velocity change, relative to the fastest
+ *   approach, at which the solver counts as converged
+ */
+void scene_set_contact_iterations(scene_t *scene, size_t max_iterations,
+                                  double tolerance);
+
+/**
+ * Gets the number of passes the contact solver made in the last tick.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the number of passes, 0 if there were no contacts
+ */
+size_t scene_contact_iterations(scene_t *scene);
+
+/**
+ * Gets the number of contacts the collision pipeline found in this tick.
+ * Force creators run after the pipeline, so they can subscribe to
+ * the contacts of the current tick instead of testing pairs themselves.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the number of contacts
+ */
+size_t scene_collisions(scene_t *scene);
+
+/**
+ * Gets a contact the collision pipeline found in this tick.
+ * Asserts that the index is valid.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param index the index of the contact (starting at 0)
+ * @return the colliding bodies and the collision axis
+ */
+collision_event_t scene_get_collision(scene_t *scene, size_t index);
+
+/**
+ * Gets the number of pairs the collision pipeline tested in the last tick.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the number of narrowphase tests run by the last scene_tick()
+ */
+size_t scene_collision_candidates(scene_t *scene);
+
 /**
  * Executes a tick of a given scene over a small time interval.
- * This requires executing all the force creators
- * and then ticking each body (see body_tick()).
+ * This requires running the collision pipeline, then executing all the
+ * force creators, and then advancing each body with the scene's integrator
+ * (see scene_set_integrator()).
  * If any bodies are marked for removal, they should be removed from the scene
  * and freed, along with any force creators acting on them.
+ * The remaining bodies keep their order; the cost of removal is linear in
+ * the number of bodies when any were removed, and nothing otherwise.
  *
  * @param scene a pointer to a scene returned from scene_init()
  * @param dt the time elapsed since the last tick, in seconds
  */
 void scene_tick(scene_t *scene, double dt);
 
+/**
+ * Gets the scene's frame arena, which scene_tick() resets when it finishes.
+ * Force creators and collision handlers can allocate per-tick scratch memory
+ * from it instead of calling malloc() and free().
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the arena, owned by the scene
+ */
+arena_t *scene_arena(scene_t *scene);
+
+/**
+ * Lets bodies fall asleep once they have been nearly still for a while.
+ * Sleeping bodies skip integration and the collision pipeline until
+ * something wakes them (see body_is_asleep()).
+ * Bodies never fall asleep by default.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param max_speed the speed at or below which a body counts as still,
+ *   or 0 to keep all bodies awake
+ * @param rest_time how many seconds a body must stay still to fall asleep
+ */
+void scene_set_sleep_threshold(scene_t *scene, double max_speed,
+                               double rest_time);
+
+/**
+ * Gives the scene a solver for mutual gravity between its gravitating
+ * bodies (see body_set_gravitating()), applied every tick after the force
+ * creators. The scene frees the solver, including when it is replaced.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param gravity a solver returned from gravity_init(),
+ *   or NULL to turn mutual gravity off
+ */
+void scene_set_gravity(scene_t *scene, gravity_t *gravity);
+
+/**
+ * Gets the scene's mutual gravity solver, e.g. to change its opening angle.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the solver, or NULL if there is none
+ */
+gravity_t *scene_get_gravity(scene_t *scene);
+
+/**
+ * Chooses how the scene advances its bodies each tick (see integrator_t).
+ * The default is INTEGRATOR_AVERAGE_VELOCITY.
+ *
+ * INTEGRATOR_VELOCITY_VERLET and INTEGRATOR_RK4 evaluate the forces several
+ * times per tick. Each tick they first run the force creators added without
+ * scene_add_pure_force_creator(), such as collision handlers, once and in
+ * order; their forces hold through the tick and their impulses apply at
+ * its start. Then, at each stage, they run the pure force creators, the
+ * field forces and mutual gravity, which are pure functions of the state.
+ * Force creators that read the forces gathered so far only see those of
+ * the first group.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param integrator the integrator
+ */
+void scene_set_integrator(scene_t *scene, integrator_t integrator);
+
+/**
+ * Gets the scene's integrator.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the integrator
+ */
+integrator_t scene_get_integrator(scene_t *scene);
+
+/**
+ * Spreads the work of each tick over a pool of threads: parallel force
+ * creators (see scene_add_parallel_force_creator()), field forces, mutual
+ * gravity and integration. Other force creators and collisions still run
+ * one at a time, in order. Ticks give bit-for-bit the same results with
+ * any number of threads, or none.
+ * The pool can be shared by several scenes ticked one after another,
+ * and must outlive its use; the scene does not free it.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param pool a pointer to a pool returned from thread_pool_init(),
+ *   or NULL to tick on the calling thread only (the default)
+ */
+void scene_set_thread_pool(scene_t *scene, thread_pool_t *pool);
+
+/**
+ * Returns whether every body in the scene is asleep.
+ * This takes constant time.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return whether all bodies are asleep (true for an empty scene)
+ */
+bool scene_is_asleep(scene_t *scene);
+
+/**
+ * Restarts the scene's random number generator from a seed.
+ * Everything random in a scene (rack shuffling, chaos pairings, powerup
+ * spots, AI moves) draws from this generator, and the physics itself is
+ * deterministic, so two scenes built and played with the same seed and the
+ * same inputs end up bit-for-bit identical. Every scene starts from the
+ * same default seed; seed it from the clock for varied play.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param seed the seed
+ */
+void scene_seed(scene_t *scene, uint64_t seed);
+
+/**
+ * Gets the scene's random number generator. Snapshots include its state.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the generator, owned by the scene
+ */
+rng_t *scene_rng(scene_t *scene);
+
+/**
+ * Sets the fixed step used by scene_step().
+ * Asserts that the timestep is positive and at least one substep is allowed.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param timestep the length of each scene_tick(), in seconds
+ * @param max_substeps the most ticks scene_step() may run per call
+ */
+void scene_set_timestep(scene_t *scene, double timestep, size_t max_substeps);
+
+/**
+ * Advances a scene by wall-clock time in fixed steps.
+ * The elapsed time is added to an accumulator, and scene_tick() is run
+ * with the fixed timestep for as long as a whole step is left, up to the
+ * maximum number of substeps. Any further time is dropped so a slow frame
+ * cannot make the next one even slower.
+ * This keeps results independent of the frame rate.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param elapsed the time elapsed since the last call, in seconds
+ * @return the fraction of a timestep left in the accumulator, in [0, 1),
+ *   for interpolating between the last two states when rendering
+ */
+double scene_step(scene_t *scene, double elapsed);
+
+/**
+ * The dynamic state of a scene at one moment, for rolling it back later.
+ */
+typedef struct scene_snapshot scene_snapshot_t;
+
+/**
+ * Records the dynamic state of a scene: which bodies and force creators it
+ * holds, their centroids, velocities, pending forces and impulses, removal
+ * marks, sleep state, which colliders are touching, the impulses the contact
+ * solver starts from and the random number generator.
+ * Shapes, sprites, infos, force creators and collision rules are shared
+ * with the scene, not copied, so any state they keep in aux is not rolled
+ * back, except the state of stateful force creators (see
+ * scene_add_stateful_force_creator()).
+ *
+ * While any snapshot of a scene is held, scene_tick() keeps removed bodies
+ * and their force creators alive (but out of the scene) instead of freeing
+ * them. Free snapshots with scene_snapshot_free() before the scene.
+ * Asserts that the required memory was allocated.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the snapshot
+ */
+scene_snapshot_t *scene_snapshot(scene_t *scene);
+
+/**
+ * Puts a scene back into the state recorded by a snapshot.
+ * Bodies removed since then return; bodies and force creators added since
+ * then are taken out again and freed once no snapshot is held.
+ * A snapshot can be restored any number of times.
+ *
+ * @param scene the scene the snapshot was taken of
+ * @param snapshot a snapshot returned from scene_snapshot()
+ */
+void scene_restore(scene_t *scene, scene_snapshot_t *snapshot);
+
+/**
+ * Releases a snapshot. Releasing the last one held frees the bodies and
+ * force creators that were only kept alive for restoring. The scene keeps
+ * the snapshot's memory for the next scene_snapshot().
+ *
+ * @param scene the scene the snapshot was taken of
+ * @param snapshot a snapshot returned from scene_snapshot()
+ */
+void scene_snapshot_free(scene_t *scene, scene_snapshot_t *snapshot);
+
 #endif // #ifndef __SCENE_H__
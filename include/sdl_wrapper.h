@@ -128,12 +128,12 @@ void sdl_free_audio();
 void sdl_free_text(text_info_t *text);
 
 /**
- * Draws a polygon from the given list of vertices and a color.
+ * Draws a polygon from the given vertices and a color.
  *
- * @param points the list of vertices of the polygon
+ * @param points the vertices of the polygon
  * @param color the color used to fill in the polygon
  */
-void sdl_draw_polygon(list_t *points, rgb_color_t color);
+void sdl_draw_polygon(polygon_t *points, rgb_color_t color);
 
 /**
  * Draws a sprite at the position specified.
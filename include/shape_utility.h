@@ -24,7 +24,7 @@ vector_t *gen_pos_vec(double x, double y);
  * @param radius the radius of the ball
  * @return the ball with the radius provided centered at (x, y)
  */
-list_t *generate_ball(double x, double y, double radius);
+polygon_t *generate_ball(double x, double y, double radius);
 
 /**
  * Generates a rectangle with the given width and height at the given coordinates.
@@ -34,7 +34,7 @@ list_t *generate_ball(double x, double y, double radius);
  * @param rec_height the height of the rectangle
  * @return the rectangle with dimensions rec_width X rec_height centered at (rec_x, rec_y)
  */
-list_t *generate_rect_shape(double rec_x, double rec_y, double rec_width,
-                            double rec_height);
+polygon_t *generate_rect_shape(double rec_x, double rec_y, double rec_width,
+                               double rec_height);
 
 #endif // #ifndef __SHAPE_UTILITY_H__
\ No newline at end of file
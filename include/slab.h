@@ -0,0 +1,120 @@
+#ifndef __SLAB_H__
+#define __SLAB_H__
+
+#include <stddef.h>
+
+/**
+ * A pool of same-sized objects.
+ * Objects are carved out of pages holding many of them, and released
+ * objects go on a free list that the next allocation takes from, so
+ * creating and destroying objects of one type over and over reuses the
+ * same memory instead of going through malloc() and free() each time.
+ * Pages are only returned to the system by slab_free().
+ *
+ * A slab belongs to the thread that created it: only that thread allocates
+ * from it, frees it and finds it in the registry, so threads that each keep
+ * their own slabs never wait on or race with one another. An object can be
+ * released on any thread. One released on another thread goes back to its
+ * slab through a lock-free list, which the slab's thread takes back the
+ * next time its free list runs out.
+ *
+ * When a thread exits, its slabs with no objects in use are freed. The
+ * others are kept, since their objects can still be released elsewhere.
+ *
+ * Every slab is registered under a name, in the registry of the thread that
+ * created it, so its usage can be looked up with slab_find() and
+ * slab_stats().
+ */
+typedef struct slab slab_t;
+
+/**
+ * Usage counters of a slab.
+ */
+typedef struct slab_stats {
+  /** The size of an object, rounded up for alignment */
+  size_t object_size;
+  /** Objects currently allocated */
+  size_t live;
+  /** The most objects that were ever allocated at once */
+  size_t peak;
+  /** Objects the pages have room for */
+  size_t capacity;
+  /** Calls to slab_alloc() */
+  size_t allocations;
+  /** Allocations served from the free list */
+  size_t reused;
+} slab_stats_t;
+
+/**
+ * Allocates an empty slab owned by the calling thread and registers it.
+ * No pages are allocated until the first slab_alloc().
+ * Asserts that the required memory was allocated.
+ *
+ * @param name the name to register the slab under (not copied)
+ * @param object_size the size of the objects
+ * @param objects_per_page the number of objects each page holds
+ * @return the new slab
+ */
+slab_t *slab_init(const char *name, size_t object_size,
+                  size_t objects_per_page);
+
+/**
+ * Unregisters a slab and releases it, along with every object in it.
+ * Only the thread that created the slab may free it.
+ *
+ * @param slab a slab returned from slab_init()
+ */
+void slab_free(slab_t *slab);
+
+/**
+ * Allocates an object. It is suitably aligned for any type, and not zeroed.
+ * Only the thread that created the slab may allocate from it.
+ * Asserts that the required memory was allocated.
+ *
+ * @param slab the slab
+ * @return the object
+ */
+void *slab_alloc(slab_t *slab);
+
+/**
+ * Returns an object to the slab it was allocated from, from any thread.
+ *
+ * @param object an object returned from slab_alloc()
+ */
+void slab_release(void *object);
+
+/**
+ * Gets a slab's usage counters. Objects released on other threads count as
+ * released straight away.
+ *
+ * @param slab the slab
+ * @return the counters
+ */
+slab_stats_t slab_stats(slab_t *slab);
+
+/**
+ * Gets a slab's name.
+ *
+ * @param slab the slab
+ * @return the name passed to slab_init()
+ */
+const char *slab_name(slab_t *slab);
+
+/**
+ * Finds a slab the calling thread registered, by name.
+ *
+ * @param name the name passed to slab_init()
+ * @return the slab, or NULL if there is none with that name
+ */
+slab_t *slab_find(const char *name);
+
+/**
+ * Iterates over the slabs the calling thread registered, most recently
+ * created first.
+ *
+ * @param slab NULL to get the first slab, or a slab to get the one after it
+ * @return the next slab, or NULL after the last one
+ */
+slab_t *slab_next(slab_t *slab);
+
+#endif // #ifndef __SLAB_H__
@@ -7,6 +7,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "graphics.h"
 #include "vector.h"
 
 /**
@@ -45,6 +46,11 @@ bool within(double epsilon, double d1, double d2);
  */
 bool vec_within(double epsilon, vector_t v1, vector_t v2);
 
+/**
+ * Returns sprite info that draws nothing, for bodies that are only simulated.
+ */
+sprite_info_t plain_sprite();
+
 /**
  * Open the file 'filename', read one word into 'testname', and close the file.
  * If the file cannot be found, exit with error.
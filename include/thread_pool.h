@@ -0,0 +1,70 @@
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <stddef.h>
+
+/**
+ * A fixed set of worker threads for splitting loops across cores.
+ * A loop over [0, count) is cut into chunks of grain indices, and each
+ * thread starts on its own contiguous share of the chunks, then steals
+ * chunks from the others once its share runs out.
+ *
+ * Which thread runs a chunk varies from run to run, so loop bodies must
+ * only write to what belongs to their own indices; then the results are
+ * the same for any number of threads.
+ *
+ * Where threads cannot be started (e.g. a build without pthreads support),
+ * the pool has fewer threads, down to 1, and loops simply run serially.
+ */
+typedef struct thread_pool thread_pool_t;
+
+/**
+ * A loop body, called on the indices [start, end).
+ *
+ * @param aux the auxiliary value passed to thread_pool_for()
+ * @param start the first index
+ * @param end one past the last index
+ */
+typedef void (*parallel_func_t)(void *aux, size_t start, size_t end);
+
+/**
+ * Starts a pool. The calling thread counts as one of the threads and works
+ * on every loop it starts, so a pool of 1 thread starts no workers.
+ * Asserts that the required memory was allocated.
+ *
+ * @param threads the number of threads to run loops on, at least 1
+ * @return the new pool
+ */
+thread_pool_t *thread_pool_init(size_t threads);
+
+/**
+ * Stops the pool's workers and releases the pool.
+ *
+ * @param pool a pointer to a pool returned from thread_pool_init()
+ */
+void thread_pool_free(thread_pool_t *pool);
+
+/**
+ * Gets the number of threads loops run on, including the caller's.
+ *
+ * @param pool a pointer to a pool returned from thread_pool_init()
+ * @return the number of threads
+ */
+size_t thread_pool_threads(thread_pool_t *pool);
+
+/**
+ * Runs func over [0, count) on the pool's threads and returns once all of
+ * it has run. Loops of at most grain indices, and all loops on a NULL pool,
+ * run directly on the calling thread.
+ * Loops must not be started from inside other loops.
+ *
+ * @param pool a pointer to a pool returned from thread_pool_init(), or NULL
+ * @param count the number of indices
+ * @param grain the number of indices handed out at a time, at least 1
+ * @param func the loop body
+ * @param aux an auxiliary value to pass to func
+ */
+void thread_pool_for(thread_pool_t *pool, size_t count, size_t grain,
+                     parallel_func_t func, void *aux);
+
+#endif // #ifndef __THREAD_POOL_H__
@@ -3,12 +3,12 @@
 #include "graphics.h"
 #include "ids.h"
 #include "pool_table.h"
+#include "rng.h"
 #include "shape_utility.h"
 #include <assert.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
 
 const double MAX_HIT_IMPULSE = 1000;
 const double HIT_MOMENTUM = 500;
@@ -23,10 +23,10 @@ const double CUEBALL_TARGET_DIST = 5;
 void ai_random_move(scene_t *scene) {
     assert(cueball_in_play(scene));
     body_t *cueball = get_cueball_body(scene);
-    srand((size_t)time(NULL));
-    double phi = ((double)rand() / (double)(RAND_MAX)) * 2 * M_PI;
+    rng_t *rng = scene_rng(scene);
+    double phi = rng_uniform(rng) * 2 * M_PI;
     vector_t dir = vec_rotate((vector_t){1, 0}, phi);
-    double mag = ((double)rand() / (double)(RAND_MAX)) * MAX_HIT_IMPULSE;
+    double mag = rng_uniform(rng) * MAX_HIT_IMPULSE;
     body_add_impulse(cueball, vec_multiply(mag, dir));
 }
 
@@ -81,7 +81,7 @@ void find_balls(scene_t *scene, size_t side,
     else if (list_size(my_balls) > 0 && eightball != NULL) {
         list_add(enemy_balls, eightball);
     }
-    list_shuffle(my_balls);
+    list_shuffle(my_balls, scene_rng(scene));
 }
 
 /**
@@ -156,11 +156,12 @@ bool segments_intersect(vector_t s, vector_t sdir, vector_t a, vector_t adir) {
             0 <= beta && beta <= vec_magnitude(adir));
 }
 
-bool segment_intersects_polygon(vector_t s, vector_t dir, list_t *shape) {
-    size_t n_points = list_size(shape);
+bool segment_intersects_polygon(vector_t s, vector_t dir, polygon_t *shape) {
+    size_t n_points = polygon_size(shape);
+    vector_t *points = polygon_vertices(shape);
     for (size_t i = 0; i < n_points; i++) {
-        vector_t a = *((vector_t *)list_get(shape, i));
-        vector_t b = *((vector_t *)list_get(shape, i));
+        vector_t a = points[i];
+        vector_t b = points[i];
         if (segments_intersect(s, dir, a, vec_subtract(b, a))) {
             return true;
         }
@@ -168,12 +169,6 @@ bool segment_intersects_polygon(vector_t s, vector_t dir, list_t *shape) {
     return false;
 }
 
-vector_t *ampersand(vector_t v) {
-    vector_t *ans = malloc(sizeof(vector_t));
-    *ans = v;
-    return ans;
-}
-
 vector_t shorten_vector(vector_t v, double dl) {
     double mag = vec_magnitude(v);
     v = vec_unit(v);
@@ -183,27 +178,39 @@ vector_t shorten_vector(vector_t v, double dl) {
     return vec_multiply(mag, v);
 }
 
-bool clear_path(body_t *ball, vector_t dir, list_t *obs) {
+/**
+ * Allocates the scratch rectangle that clear_path() fills in, so a whole
+ * move can test many paths without allocating per query.
+ *
+ * @return a polygon of 4 vertices, all at the origin until clear_path()
+ *   places them
+ */
+polygon_t *path_rectangle_init(void) {
+    polygon_t *rectangle = polygon_init(4); // 4 cuz it's a rectangle
+    for (size_t i = 0; i < 4; i++) {
+        polygon_add(rectangle, VEC_ZERO);
+    }
+    return rectangle;
+}
+
+bool clear_path(body_t *ball, vector_t dir, list_t *obs, polygon_t *path_rectangle) {
     const double BALL_RADIUS = get_ball_radius();
     vector_t perp = vec_unit(vec_rotate(dir, M_PI / 2));
     vector_t c = body_get_centroid(ball);
     vector_t a = vec_add(c, vec_multiply(BALL_RADIUS, perp));
     vector_t b = vec_add(c, vec_multiply(-BALL_RADIUS, perp));
 
-    list_t *path_rectangle = list_init(4, free); // 4 cuz it's a rectangle
-    list_add(path_rectangle, ampersand(b));      // this order gurantees ccw order
+    polygon_set(path_rectangle, 0, b); // this order gurantees ccw order
     dir = shorten_vector(dir, COLLISION_EXEMPTION);
-    list_add(path_rectangle, ampersand(vec_add(b, dir)));
-    list_add(path_rectangle, ampersand(vec_add(a, dir)));
-    list_add(path_rectangle, ampersand(a));
+    polygon_set(path_rectangle, 1, vec_add(b, dir));
+    polygon_set(path_rectangle, 2, vec_add(a, dir));
+    polygon_set(path_rectangle, 3, a);
     for (size_t i = 0; i < list_size(obs); i++) {
-        list_t *obstacle = body_get_shape(list_get(obs, i));
+        polygon_t *obstacle = body_get_shape(list_get(obs, i));
         if (find_collision(path_rectangle, obstacle).collided) {
-            list_free(path_rectangle);
             return false;
         }
     }
-    list_free(path_rectangle);
     return true;
 }
 
@@ -214,12 +221,14 @@ bool clear_path(body_t *ball, vector_t dir, list_t *obs) {
  * @param target the target ball body
  * @param pocket the target pocket baody
  * @param obs the list of obstacle bodies (should not include cue and target)
+ * @param path_rectangle scratch space from path_rectangle_init()
  *
  * @return if true, then the hit direction is given, otherwise returns NULL
  *
  * NOTE: the output will have to be deallocated if not NULL!
  */
-vector_t *clear_pocket_shot(body_t *cue, body_t *target, body_t *pocket, list_t *obs) {
+vector_t *clear_pocket_shot(body_t *cue, body_t *target, body_t *pocket, list_t *obs,
+                            polygon_t *path_rectangle) {
     const double BALL_RADIUS = get_ball_radius() - RADIUS_OFFSET;
     vector_t c = body_get_centroid(cue);
     vector_t t = body_get_centroid(target);
@@ -231,7 +240,8 @@ vector_t *clear_pocket_shot(body_t *cue, body_t *target, body_t *pocket, list_t
     }
     vector_t contact_pos = vec_add(t, vec_multiply(-2 * BALL_RADIUS, vec_unit(tp)));
     vector_t dir = vec_subtract(contact_pos, c); // dir we'd want to hit the cueball
-    if (clear_path(cue, dir, obs) && clear_path(target, tp, obs)) {
+    if (clear_path(cue, dir, obs, path_rectangle) &&
+        clear_path(target, tp, obs, path_rectangle)) {
         vector_t *ans = malloc(sizeof(vector_t));
         assert(ans != NULL);
         *ans = vec_unit(dir);
@@ -266,10 +276,15 @@ vector_t *clear_pocketing_shot(scene_t *scene, body_t *cue, body_t *target) {
             list_add(pockets, b);
         }
     }
+    polygon_t *path_rectangle = path_rectangle_init();
     vector_t *dir = NULL;
     for (size_t p = 0; p < list_size(pockets) && dir == NULL; p++) {
-        dir = clear_pocket_shot(cue, target, list_get(pockets, p), obstacles);
+        dir = clear_pocket_shot(cue, target, list_get(pockets, p), obstacles,
+                                path_rectangle);
     }
+    polygon_free(path_rectangle);
+    list_free(obstacles);
+    list_free(pockets);
     return dir;
 }
 
@@ -323,7 +338,7 @@ void ai_medium_make_move(scene_t *scene, size_t side) {
     }
 }
 
-bool cueball_ok(scene_t *scene, list_t *tentative_cue) {
+bool cueball_ok(scene_t *scene, polygon_t *tentative_cue) {
     bool collided = false;
     size_t bodies = scene_bodies(scene);
     for (size_t i = 0; i < bodies && !collided; i++) {
@@ -334,24 +349,24 @@ bool cueball_ok(scene_t *scene, list_t *tentative_cue) {
     return !collided;
 }
 
-list_t *ai_easy_put_cue(scene_t *scene, size_t side) {
-    srand(time(NULL));
+polygon_t *ai_easy_put_cue(scene_t *scene, size_t side) {
+    rng_t *rng = scene_rng(scene);
     while (true) {
-        double rand_x = rand() % (int32_t)CUEBALL_UP_RANGE.x + CUEBALL_UP_MIN.x;
-        double rand_y = rand() % (int32_t)CUEBALL_UP_RANGE.y + CUEBALL_UP_MIN.y;
-        list_t *tentative_cue = generate_ball(rand_x, rand_y,
-                                              get_ball_radius());
+        double rand_x = rng_below(rng, CUEBALL_UP_RANGE.x) + CUEBALL_UP_MIN.x;
+        double rand_y = rng_below(rng, CUEBALL_UP_RANGE.y) + CUEBALL_UP_MIN.y;
+        polygon_t *tentative_cue = generate_ball(rand_x, rand_y,
+                                                 get_ball_radius());
         // so cueball position is valid, didn't collide
         if (cueball_ok(scene, tentative_cue)) {
             return tentative_cue;
         } 
         else {
-            list_free(tentative_cue); // retry
+            polygon_free(tentative_cue); // retry
         }
     }
 }
 
-list_t *ai_medium_put_cue(scene_t *scene, size_t side) {
+polygon_t *ai_medium_put_cue(scene_t *scene, size_t side) {
     list_t *my_balls = list_init(7, NULL);    // 7 = # of striped/solid balls
     list_t *enemy_balls = list_init(8, NULL); // 8 cuz eightball is enemy
     find_balls(scene, side, my_balls, enemy_balls);
@@ -362,6 +377,7 @@ list_t *ai_medium_put_cue(scene_t *scene, size_t side) {
             list_add(pockets, body);
         }
     }
+    polygon_t *path_rectangle = path_rectangle_init();
 
     for (size_t j = 0; j < list_size(my_balls); j++) {
         list_t *obstacles = list_init(20, NULL);
@@ -381,23 +397,24 @@ list_t *ai_medium_put_cue(scene_t *scene, size_t side) {
             body_t *pocket = list_get(pockets, i);
             vector_t dir = vec_subtract(body_get_centroid(pocket),
                                         body_get_centroid(target));
-            if (!clear_path(target, dir, obstacles)) {
+            if (!clear_path(target, dir, obstacles, path_rectangle)) {
                 continue;
             }
             vector_t dir_hat = vec_unit(dir);
             vector_t cue_centroid = vec_subtract(body_get_centroid(target),
                      vec_multiply(2 * get_ball_radius() + CUEBALL_TARGET_DIST, dir_hat));
-            list_t *tentative_cue = generate_ball(cue_centroid.x, cue_centroid.y,
-                                                  get_ball_radius());
+            polygon_t *tentative_cue = generate_ball(cue_centroid.x, cue_centroid.y,
+                                                     get_ball_radius());
             if (cueball_ok(scene, tentative_cue)) {
                 list_free(obstacles);
                 list_free(my_balls);
                 list_free(enemy_balls);
                 list_free(pockets);
+                polygon_free(path_rectangle);
                 return tentative_cue;
             } 
             else {
-                list_free(tentative_cue); // retry
+                polygon_free(tentative_cue); // retry
             }
         }
         list_free(obstacles);
@@ -405,5 +422,6 @@ list_t *ai_medium_put_cue(scene_t *scene, size_t side) {
     list_free(my_balls);
     list_free(enemy_balls);
     list_free(pockets);
+    polygon_free(path_rectangle);
     return ai_easy_put_cue(scene, side); // summon the dumb dumb
 }
\ No newline at end of file
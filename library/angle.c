@@ -18,37 +18,20 @@ const double LINE_WIDTH = 2;
 const double LINE_MASS = 100;
 const double GAP = 1;
 
-list_t *line_shape(vector_t start_position, vector_t end_position, double width) {
+polygon_t *line_shape(vector_t start_position, vector_t end_position, double width) {
     vector_t vector_of_attack = vec_unit(vec_subtract(end_position, start_position));
     vector_t orthogonal_vector_of_attack = (vector_t){vector_of_attack.y,
                                                       -vector_of_attack.x};
 
-    list_t *ans = list_init(RECTANGLE_RESOLUTION, free);
-
-    vector_t *line_point_vec = malloc(sizeof(vector_t));
-    assert(line_point_vec != NULL);
-    *line_point_vec = vec_add(vec_multiply(width / 2, orthogonal_vector_of_attack),
-                              end_position);
-    list_add(ans, line_point_vec);
-
-    line_point_vec = malloc(sizeof(vector_t));
-    assert(line_point_vec != NULL);
-    *line_point_vec = vec_add(vec_multiply(width / 2, orthogonal_vector_of_attack),
-                              start_position);
-    list_add(ans, line_point_vec);
-
-    line_point_vec = malloc(sizeof(vector_t));
-    assert(line_point_vec != NULL);
-    *line_point_vec = vec_subtract(start_position, vec_multiply(width / 2,
-                                    orthogonal_vector_of_attack));
-    list_add(ans, line_point_vec);
-
-    line_point_vec = malloc(sizeof(vector_t));
-    assert(line_point_vec != NULL);
-    *line_point_vec = vec_subtract(end_position, vec_multiply(width / 2,
-                                    orthogonal_vector_of_attack));
-    list_add(ans, line_point_vec);
-
+    polygon_t *ans = polygon_init(RECTANGLE_RESOLUTION);
+    polygon_add(ans, vec_add(vec_multiply(width / 2, orthogonal_vector_of_attack),
+                             end_position));
+    polygon_add(ans, vec_add(vec_multiply(width / 2, orthogonal_vector_of_attack),
+                             start_position));
+    polygon_add(ans, vec_subtract(start_position, vec_multiply(width / 2,
+                                  orthogonal_vector_of_attack)));
+    polygon_add(ans, vec_subtract(end_position, vec_multiply(width / 2,
+                                  orthogonal_vector_of_attack)));
     return ans;
 }
 
@@ -67,7 +50,7 @@ void generate_angle_predictor(scene_t *scene) {
     vector_t start = vec_add(vec_multiply(BALL_RADIUS, vector_of_attack),
                              body_get_centroid(cueball));
     vector_t end = vec_add(vec_multiply(GAP, vector_of_attack), start);
-    list_t *shape = line_shape(start, end, BALL_RADIUS * 2);
+    polygon_t *shape = line_shape(start, end, BALL_RADIUS * 2);
     bool exist = false;
 
     if (get_specified_body(scene, ANGLE_LINE_ID) != NULL) {
@@ -77,7 +60,8 @@ void generate_angle_predictor(scene_t *scene) {
     } else {
         size_t *angle_ID = generate_ID(ANGLE_LINE_ID);
         sprite_info_t sprite = line_texture();
-        my_angle_line = body_init_with_info(shape, sprite, LINE_MASS, angle_ID, free);
+        my_angle_line = body_init_with_info(shape, sprite, LINE_MASS, angle_ID,
+                                            (free_func_t)free_ID);
     }
 
     bool collision = false;
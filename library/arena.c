@@ -0,0 +1,75 @@
+#include "arena.h"
+#include <assert.h>
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+const size_t ARENA_GROWTH_FACTOR = 2;
+
+typedef struct arena_block {
+  struct arena_block *next; // the block filled before this one
+  size_t capacity;
+  size_t used;
+  max_align_t data[];
+} arena_block_t;
+
+typedef struct arena {
+  arena_block_t *block; // the block being filled
+  size_t capacity;      // of all blocks
+} arena_t;
+
+arena_block_t *block_init(size_t capacity, arena_block_t *next) {
+  arena_block_t *block = malloc(sizeof(arena_block_t) + capacity);
+  assert(block != NULL);
+  block->next = next;
+  block->capacity = capacity;
+  block->used = 0;
+  return block;
+}
+
+void free_blocks(arena_block_t *block) {
+  while (block != NULL) {
+    arena_block_t *next = block->next;
+    free(block);
+    block = next;
+  }
+}
+
+arena_t *arena_init(size_t capacity) {
+  arena_t *arena = malloc(sizeof(arena_t));
+  assert(arena != NULL);
+  arena->block = block_init(capacity, NULL);
+  arena->capacity = capacity;
+  return arena;
+}
+
+void arena_free(arena_t *arena) {
+  free_blocks(arena->block);
+  free(arena);
+}
+
+void *arena_alloc(arena_t *arena, size_t size) {
+  // round up so the next allocation stays aligned
+  size_t align = alignof(max_align_t);
+  size = (size + align - 1) / align * align;
+  arena_block_t *block = arena->block;
+  if (block->capacity - block->used < size) {
+    size_t capacity = arena->capacity * ARENA_GROWTH_FACTOR;
+    block = block_init(capacity > size ? capacity : size, block);
+    arena->block = block;
+    arena->capacity += block->capacity;
+  }
+  void *memory = (char *)block->data + block->used;
+  block->used += size;
+  return memory;
+}
+
+void arena_reset(arena_t *arena) {
+  if (arena->block->next != NULL) {
+    free_blocks(arena->block);
+    arena->block = block_init(arena->capacity, NULL);
+  }
+  arena->block->used = 0;
+}
+
+size_t arena_capacity(arena_t *arena) { return arena->capacity; }
@@ -1,101 +1,429 @@
 #include "body.h"
+#include "kinematics.h"
 #include "list.h"
+#include "mesh.h"
 #include "polygon.h"
-#include "sdl_wrapper.h"
+#include "slab.h"
 #include "vector.h"
-#include "graphics.h"
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
 
+const size_t BODIES_PER_PAGE = 64;
+
+// One-slot kinematic storage embedded in the body, so a standalone body
+// needs no allocations besides the body itself
+typedef struct home_kinematics
+{
+  kinematics_t kin;
+  vector_t centroid;
+  vector_t velocity;
+  vector_t force;
+  vector_t impulse;
+  double inv_mass;
+  void *owner;
+  bool asleep;
+  double rest_time;
+  double drag;
+  double constant_drag;
+  vector_t gravity;
+  double constant_drag_min_speed;
+  bool gravitating;
+} home_kinematics_t;
+
 typedef struct body
 {
-  list_t *shape;
+  shape_kind_t kind;
+  // The outline relative to the centroid, possibly shared with other bodies.
+  // NULL for circles until the outline is first requested.
+  mesh_t *mesh;
+  // World-space vertices, placed from the mesh only when requested,
+  // and where and how they were placed
+  polygon_t *shape;
+  vector_t shape_centroid;
+  double shape_angle;
+  double radius;
+  // Bounds relative to the centroid, so moving the body keeps them valid.
+  // The box is for bounds_angle and is redone when the angle changes.
+  double bounding_radius;
+  aabb_t local_bounds;
+  double bounds_angle;
   sprite_info_t sprite;
-  vector_t velocity;
   double angle;
+  vector_t rotation; // (cos, sin) of angle
   double ang_vel;
   double mass;
-  vector_t centroid;
-  vector_t force;
-  vector_t impulse;
+  // Hot per-tick state lives in kin at index slot (see kinematics.h).
+  // Standalone bodies use their home storage until added to a scene.
+  kinematics_t *kin;
+  size_t slot;
+  home_kinematics_t home;
+  // Where the sprite was last placed; it catches up with the centroid lazily
+  // so integration does not have to touch the body each tick.
+  vector_t synced_centroid;
   void *info;
   free_func_t info_freer;
   bool is_removed;
+  list_t *removal_queue; // where body_remove() reports to, if anywhere
+  body_handle_t handle;
+  list_t *forcers; // maintained by scene.c, NULL until first requested
+  size_t restore_mark; // see body_set_restore_mark()
 } body_t;
 
-body_t *body_init(list_t *shape, sprite_info_t sprite, double mass)
+_Thread_local slab_t *body_slab = NULL;
+
+slab_t *body_get_slab()
 {
-  return body_init_with_info(shape, sprite, mass, NULL, NULL);
+  if (body_slab == NULL)
+  {
+    body_slab = slab_init("body", sizeof(body_t), BODIES_PER_PAGE);
+  }
+  return body_slab;
 }
 
-body_t *body_init_with_info(list_t *shape, sprite_info_t sprite, double mass, void *info,
-                            free_func_t info_freer)
+void body_init_home(body_t *body)
+{
+  home_kinematics_t *home = &body->home;
+  home->kin = (kinematics_t){
+      .size = 0,
+      .capacity = 1,
+      .centroid = &home->centroid,
+      .velocity = &home->velocity,
+      .force = &home->force,
+      .impulse = &home->impulse,
+      .inv_mass = &home->inv_mass,
+      .owner = &home->owner,
+      .asleep = &home->asleep,
+      .rest_time = &home->rest_time,
+      .drag = &home->drag,
+      .constant_drag = &home->constant_drag,
+      .gravity = &home->gravity,
+      .constant_drag_min_speed = &home->constant_drag_min_speed,
+      .gravitating = &home->gravitating,
+      .awake = 0,
+  };
+  body->kin = &home->kin;
+}
+
+// Rotates a local-space vector by the body's angle
+vector_t body_rotate(body_t *body, vector_t v)
+{
+  vector_t r = body->rotation;
+  return (vector_t){v.x * r.x - v.y * r.y, v.x * r.y + v.y * r.x};
+}
+
+// Recomputes the cached bounds for the current angle
+void body_update_bounds(body_t *body)
+{
+  body->bounds_angle = body->angle;
+  if (body->kind == SHAPE_CIRCLE)
+  {
+    body->bounding_radius = body->radius;
+    body->local_bounds = (aabb_t){{-body->radius, -body->radius},
+                                  {body->radius, body->radius}};
+    return;
+  }
+  body->bounding_radius = mesh_radius(body->mesh);
+  if (body->angle == 0)
+  {
+    body->local_bounds = mesh_bounds(body->mesh);
+    return;
+  }
+  size_t n_vertices = mesh_size(body->mesh);
+  vector_t *vertices = mesh_vertices(body->mesh);
+  vector_t first = body_rotate(body, vertices[0]);
+  aabb_t bounds = {first, first};
+  for (size_t i = 1; i < n_vertices; i++)
+  {
+    vector_t offset = body_rotate(body, vertices[i]);
+    bounds.min.x = fmin(bounds.min.x, offset.x);
+    bounds.min.y = fmin(bounds.min.y, offset.y);
+    bounds.max.x = fmax(bounds.max.x, offset.x);
+    bounds.max.y = fmax(bounds.max.y, offset.y);
+  }
+  body->local_bounds = bounds;
+}
+
+// Places the world-space vertices from the mesh at the current centroid
+// and angle, reusing the polygon if there already is one
+void body_place_shape(body_t *body)
+{
+  vector_t centroid = body_get_centroid(body);
+  size_t n_vertices = mesh_size(body->mesh);
+  vector_t *local = mesh_vertices(body->mesh);
+  if (body->shape == NULL)
+  {
+    body->shape = polygon_init(n_vertices);
+    for (size_t i = 0; i < n_vertices; i++)
+    {
+      polygon_add(body->shape, VEC_ZERO);
+    }
+  }
+  assert(polygon_size(body->shape) == n_vertices);
+  vector_t *vertices = polygon_vertices(body->shape);
+  for (size_t i = 0; i < n_vertices; i++)
+  {
+    vertices[i] = vec_add(centroid, body_rotate(body, local[i]));
+  }
+  body->shape_centroid = centroid;
+  body->shape_angle = body->angle;
+}
+
+// Makes a mesh from a world-space outline of the body at its current
+// centroid and angle
+mesh_t *body_local_mesh(body_t *body, polygon_t *shape, vector_t centroid)
+{
+  polygon_t *local = polygon_copy(shape);
+  polygon_translate(local, vec_negate(centroid));
+  polygon_rotate(local, -body->angle, VEC_ZERO);
+  return mesh_init(local);
+}
+
+// Shared by the polygon and circle constructors
+body_t *body_init_kind(shape_kind_t kind, mesh_t *mesh, double radius,
+                       vector_t centroid, sprite_info_t sprite, double mass,
+                       void *info, free_func_t info_freer)
 {
-  body_t *new_body = malloc(sizeof(body_t));
-  assert(new_body != NULL);
+  body_t *new_body = slab_alloc(body_get_slab());
   assert(mass > 0);
 
-  new_body->shape = shape;
+  new_body->kind = kind;
+  new_body->mesh = mesh;
+  new_body->shape = NULL;
+  new_body->radius = radius;
   new_body->sprite = sprite;
   new_body->mass = mass;
-  new_body->centroid = polygon_centroid(shape);
-  new_body->velocity = VEC_ZERO; // initially at rest
   new_body->angle = new_body->ang_vel = 0;
-  new_body->force = VEC_ZERO;
-  new_body->impulse = VEC_ZERO;
+  new_body->rotation = (vector_t){1, 0};
+  new_body->synced_centroid = centroid;
+  body_init_home(new_body);
+  // initially at rest
+  new_body->slot = kinematics_add(new_body->kin, new_body,
+                                  new_body->synced_centroid, 1 / mass);
   new_body->info = info;
   new_body->info_freer = info_freer;
   new_body->is_removed = false;
+  new_body->removal_queue = NULL;
+  new_body->handle = (body_handle_t){0, 0};
+  new_body->forcers = NULL;
+  new_body->restore_mark = 0;
+  if (mesh != NULL || kind == SHAPE_CIRCLE)
+  {
+    body_update_bounds(new_body);
+  }
   return new_body;
 }
 
+body_t *body_init(polygon_t *shape, sprite_info_t sprite, double mass)
+{
+  return body_init_with_info(shape, sprite, mass, NULL, NULL);
+}
+
+body_t *body_init_with_info(polygon_t *shape, sprite_info_t sprite, double mass, void *info,
+                            free_func_t info_freer)
+{
+  vector_t centroid = polygon_centroid(shape);
+  body_t *body = body_init_kind(SHAPE_POLYGON, NULL, 0, centroid, sprite, mass,
+                                info, info_freer);
+  body->mesh = body_local_mesh(body, shape, centroid);
+  body_update_bounds(body);
+  // the shape stays the body's world-space outline, as callers may keep it
+  body->shape = shape;
+  body->shape_centroid = centroid;
+  body->shape_angle = 0;
+  return body;
+}
+
+body_t *body_init_with_mesh(mesh_t *mesh, vector_t centroid,
+                            sprite_info_t sprite, double mass, void *info,
+                            free_func_t info_freer)
+{
+  return body_init_kind(SHAPE_POLYGON, mesh_retain(mesh), 0, centroid, sprite,
+                        mass, info, info_freer);
+}
+
+body_t *body_init_circle(vector_t center, double radius, sprite_info_t sprite,
+                         double mass)
+{
+  return body_init_circle_with_info(center, radius, sprite, mass, NULL, NULL);
+}
+
+body_t *body_init_circle_with_info(vector_t center, double radius,
+                                   sprite_info_t sprite, double mass,
+                                   void *info, free_func_t info_freer)
+{
+  assert(radius > 0);
+  return body_init_kind(SHAPE_CIRCLE, NULL, radius, center, sprite, mass, info,
+                        info_freer);
+}
+
 void body_free(body_t *body)
 {
-  list_free(body->shape);
+  if (body->shape != NULL)
+  {
+    polygon_free(body->shape);
+  }
+  if (body->mesh != NULL)
+  {
+    mesh_release(body->mesh);
+  }
   if (body->info_freer != NULL)
   {
     body->info_freer(body->info);
   }
-  free(body);
+  if (body->forcers != NULL)
+  {
+    list_free(body->forcers);
+  }
+  slab_release(body);
+}
+
+void body_move_to_kinematics(body_t *body, kinematics_t *kin)
+{
+  kinematics_t *old = body->kin;
+  size_t old_slot = body->slot;
+  size_t slot = kinematics_add(kin, body, old->centroid[old_slot],
+                               old->inv_mass[old_slot]);
+  kin->velocity[slot] = old->velocity[old_slot];
+  kin->force[slot] = old->force[old_slot];
+  kin->impulse[slot] = old->impulse[old_slot];
+  kin->rest_time[slot] = old->rest_time[old_slot];
+  kin->drag[slot] = old->drag[old_slot];
+  kin->constant_drag[slot] = old->constant_drag[old_slot];
+  kin->gravity[slot] = old->gravity[old_slot];
+  kin->constant_drag_min_speed[slot] = old->constant_drag_min_speed[old_slot];
+  kin->gravitating[slot] = old->gravitating[old_slot];
+  if (old->asleep[old_slot])
+  {
+    kinematics_sleep(kin, slot);
+  }
+  body->kin = kin;
+  body->slot = slot;
+}
+
+kinematics_t *body_get_kinematics(body_t *body) { return body->kin; }
+
+size_t body_get_slot(body_t *body) { return body->slot; }
+
+void body_set_slot(body_t *body, size_t slot) { body->slot = slot; }
+
+body_handle_t body_get_handle(body_t *body) { return body->handle; }
+
+void body_set_handle(body_t *body, body_handle_t handle)
+{
+  body->handle = handle;
+}
+
+void body_set_removal_queue(body_t *body, list_t *queue)
+{
+  body->removal_queue = queue;
 }
 
-list_t *body_get_deepcopied_shape(body_t *body)
+size_t body_get_restore_mark(body_t *body) { return body->restore_mark; }
+
+void body_set_restore_mark(body_t *body, size_t mark)
 {
-  size_t num_vertices = list_size(body->shape);
-  list_t *ans = list_init(num_vertices, free);
-  for (size_t i = 0; i < num_vertices; i++)
+  body->restore_mark = mark;
+}
+
+void body_sync(body_t *body)
+{
+  vector_t centroid = body->kin->centroid[body->slot];
+  if (centroid.x != body->synced_centroid.x ||
+      centroid.y != body->synced_centroid.y)
   {
-    vector_t *vertex = malloc(sizeof(vector_t));
-    assert(vertex != NULL);
-    *vertex = *(vector_t *)list_get(body->shape, i);
-    list_add(ans, vertex);
+    vector_t shift = vec_subtract(centroid, body->synced_centroid);
+    body->sprite.img_pos = vec_add(body->sprite.img_pos, shift);
+    body->synced_centroid = centroid;
   }
-  return ans;
 }
 
-list_t *body_get_shape(body_t *body)
+polygon_t *body_get_deepcopied_shape(body_t *body)
+{
+  return polygon_copy(body_get_shape(body));
+}
+
+polygon_t *body_get_shape(body_t *body)
 {
+  body_sync(body);
+  body_get_mesh(body);
+  vector_t centroid = body_get_centroid(body);
+  if (body->shape == NULL || centroid.x != body->shape_centroid.x ||
+      centroid.y != body->shape_centroid.y || body->angle != body->shape_angle)
+  {
+    body_place_shape(body);
+  }
   return body->shape;
 }
 
-vector_t body_get_centroid(body_t *body) { return body->centroid; }
+mesh_t *body_get_mesh(body_t *body)
+{
+  if (body->mesh == NULL)
+  {
+    body->mesh = mesh_circle(body->radius);
+  }
+  return body->mesh;
+}
 
-vector_t body_get_velocity(body_t *body) { return body->velocity; }
+shape_kind_t body_get_shape_kind(body_t *body) { return body->kind; }
+
+double body_get_radius(body_t *body)
+{
+  assert(body->kind == SHAPE_CIRCLE);
+  return body->radius;
+}
+
+double body_get_bounding_radius(body_t *body) { return body->bounding_radius; }
+
+aabb_t body_get_aabb(body_t *body)
+{
+  if (body->bounds_angle != body->angle)
+  {
+    body_update_bounds(body);
+  }
+  vector_t centroid = body_get_centroid(body);
+  return (aabb_t){vec_add(centroid, body->local_bounds.min),
+                  vec_add(centroid, body->local_bounds.max)};
+}
+
+vector_t body_get_centroid(body_t *body)
+{
+  return body->kin->centroid[body->slot];
+}
+
+vector_t body_get_velocity(body_t *body)
+{
+  return body->kin->velocity[body->slot];
+}
 
 double body_get_mass(body_t *body) { return body->mass; }
 
 void *body_get_info(body_t *body) { return body->info; }
 
-sprite_info_t body_get_sprite(body_t *body) { return body->sprite; }
+sprite_info_t body_get_sprite(body_t *body)
+{
+  body_sync(body);
+  return body->sprite;
+}
 
 void body_set_centroid(body_t *body, vector_t x)
 {
-  polygon_translate(body->shape, vec_subtract(x, body_get_centroid(body)));
-  body->centroid = x;
+  // the sprite follows integration but not teleports, so sync it first
+  body_sync(body);
+  body->kin->centroid[body->slot] = x;
+  body->synced_centroid = x;
+  // it may have been dropped onto other sleeping bodies
+  body_wake(body);
 }
 
-void body_set_velocity(body_t *body, vector_t v) { body->velocity = v; }
+void body_set_velocity(body_t *body, vector_t v)
+{
+  body->kin->velocity[body->slot] = v;
+  if (v.x != 0 || v.y != 0)
+  {
+    body_wake(body);
+  }
+}
 
 void body_set_ang_velocity(body_t *body, double omega)
 {
@@ -104,18 +432,28 @@ void body_set_ang_velocity(body_t *body, double omega)
 
 void body_set_rotation(body_t *body, double angle)
 {
-  polygon_rotate(body->shape, angle - body->angle, body_get_centroid(body));
+  // the outline and bounding box follow when next requested
   body->angle = angle;
+  body->rotation = (vector_t){cos(angle), sin(angle)};
 }
 
-void body_set_img_pos(body_t *body, vector_t x)
-{
-  body->sprite.img_pos = x;
-}
-
-void body_set_shape(body_t *body, list_t *shape){
-  list_free(body->shape);
+void body_set_shape(body_t *body, polygon_t *shape){
+  body_sync(body);
+  if (body->shape != NULL)
+  {
+    polygon_free(body->shape);
+  }
+  if (body->mesh != NULL)
+  {
+    mesh_release(body->mesh);
+  }
+  vector_t centroid = body_get_centroid(body);
+  body->kind = SHAPE_POLYGON;
+  body->mesh = body_local_mesh(body, shape, centroid);
   body->shape = shape;
+  body->shape_centroid = centroid;
+  body->shape_angle = body->angle;
+  body_update_bounds(body);
 }
 
 void body_set_color(body_t *body, rgb_color_t color){
@@ -124,38 +462,87 @@ void body_set_color(body_t *body, rgb_color_t color){
 
 void body_add_force(body_t *body, vector_t force)
 {
-  body->force = vec_add(body->force, force);
+  vector_t *total = &body->kin->force[body->slot];
+  *total = vec_add(*total, force);
 }
 
 void body_add_impulse(body_t *body, vector_t impulse)
 {
-  body->impulse = vec_add(body->impulse, impulse);
+  vector_t *total = &body->kin->impulse[body->slot];
+  *total = vec_add(*total, impulse);
+  body_wake(body);
+}
+
+void body_add_drag(body_t *body, double gamma)
+{
+  body->kin->drag[body->slot] += gamma;
+}
+
+void body_add_constant_drag(body_t *body, double force)
+{
+  body->kin->constant_drag[body->slot] += force;
+}
+
+void body_set_constant_drag_min_speed(body_t *body, double min_speed)
+{
+  assert(min_speed >= 0);
+  body->kin->constant_drag_min_speed[body->slot] = min_speed;
+}
+
+void body_add_gravity(body_t *body, vector_t acceleration)
+{
+  vector_t *gravity = &body->kin->gravity[body->slot];
+  *gravity = vec_add(*gravity, acceleration);
+}
+
+void body_set_gravitating(body_t *body, bool gravitating)
+{
+  body->kin->gravitating[body->slot] = gravitating;
+}
+
+bool body_is_gravitating(body_t *body)
+{
+  return body->kin->gravitating[body->slot];
 }
 
 void body_tick(body_t *body, double dt)
 {
-  vector_t avg_velocity = body->velocity;
-  vector_t new_velocity = vec_add(body_get_velocity(body),
-                                  vec_multiply(1 / body->mass, body->impulse));
-  new_velocity =
-      vec_add(new_velocity, vec_multiply(dt / body->mass, body->force));
-  body_set_velocity(body, new_velocity);
-  avg_velocity = vec_multiply(0.5, vec_add(avg_velocity, new_velocity));
-  body->force = VEC_ZERO;
-  body->impulse = VEC_ZERO;
-  body_set_centroid(
-      body, vec_add(body_get_centroid(body), vec_multiply(dt, avg_velocity)));
-  sprite_info_t sprite = body_get_sprite(body);
-  body_set_img_pos(body, vec_add(sprite.img_pos, vec_multiply(dt, avg_velocity)));
+  kinematics_integrate(body->kin, body->slot, body->slot + 1, dt);
 }
 
 void body_update(body_t *body, double dt)
 {
-  vector_t translation = vec_multiply(dt, body->velocity);
+  vector_t translation = vec_multiply(dt, body_get_velocity(body));
   body_set_centroid(body, vec_add(body_get_centroid(body), translation));
   body_set_rotation(body, body->ang_vel * dt + body->angle);
 }
 
-void body_remove(body_t *body) { body->is_removed = true; }
+void body_remove(body_t *body)
+{
+  if (body->is_removed)
+  {
+    return;
+  }
+  body->is_removed = true;
+  if (body->removal_queue != NULL)
+  {
+    list_add(body->removal_queue, body);
+  }
+}
+
+void body_revive(body_t *body) { body->is_removed = false; }
 
 bool body_is_removed(body_t *body) { return body->is_removed; }
+
+list_t *body_get_forcers(body_t *body)
+{
+  if (body->forcers == NULL)
+  {
+    body->forcers = list_init(1, NULL);
+  }
+  return body->forcers;
+}
+
+bool body_is_asleep(body_t *body) { return body->kin->asleep[body->slot]; }
+
+void body_wake(body_t *body) { kinematics_wake(body->kin, body->slot); }
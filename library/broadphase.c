@@ -0,0 +1,439 @@
+#include "broadphase.h"
+#include "body.h"
+#include "collision.h"
+#include "contact.h"
+#include "list.h"
+#include "vector.h"
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+const size_t INIT_COLLIDER_COUNT = 16;
+const size_t INIT_RULE_COUNT = 4;
+const size_t BROADPHASE_RESIZE_FACTOR = 2;
+
+typedef struct collider {
+  body_t *body;
+  size_t categories;
+  // bounding box as of the current tick
+  double min_x;
+  double max_x;
+  double min_y;
+  double max_y;
+} collider_t;
+
+typedef struct collision_rule {
+  size_t categories1;
+  size_t categories2;
+  collision_handler_t handler;
+  void *aux;
+  free_func_t freer;
+  bool contact; // contacts go to the contact solver (see contact.h)
+  double elasticity; // for contact rules
+} collision_rule_t;
+
+typedef struct touching { // a pair in contact as of the last tick
+  body_t *body1;          // the body with the lower address
+  body_t *body2;
+  bool seen; // still in contact this tick
+} touching_t;
+
+typedef struct broadphase {
+  collider_t *colliders; // sorted by min_x
+  size_t collider_count;
+  size_t collider_capacity;
+  list_t *rules;
+  touching_t *touching; // sorted by (body1, body2)
+  size_t touching_count;
+  size_t touching_capacity;
+  collision_event_t *events; // contacts found in the last tick
+  size_t event_count;
+  size_t event_capacity;
+  size_t candidates;
+} broadphase_t;
+
+typedef struct broadphase_state {
+  collider_t *colliders;
+  size_t collider_count;
+  size_t collider_capacity;
+  touching_t *touching;
+  size_t touching_count;
+  size_t touching_capacity;
+  collision_event_t *events;
+  size_t event_count;
+  size_t event_capacity;
+  size_t candidates;
+} broadphase_state_t;
+
+void collision_rule_freer(collision_rule_t *rule) {
+  if (rule->freer != NULL) {
+    rule->freer(rule->aux);
+  }
+  free(rule);
+}
+
+broadphase_t *broadphase_init(void) {
+  broadphase_t *broadphase = malloc(sizeof(broadphase_t));
+  assert(broadphase != NULL);
+  broadphase->colliders = malloc(sizeof(collider_t) * INIT_COLLIDER_COUNT);
+  broadphase->touching = malloc(sizeof(touching_t) * INIT_COLLIDER_COUNT);
+  broadphase->events =
+      malloc(sizeof(collision_event_t) * INIT_COLLIDER_COUNT);
+  assert(broadphase->colliders != NULL && broadphase->touching != NULL &&
+         broadphase->events != NULL);
+  broadphase->collider_count = broadphase->touching_count = 0;
+  broadphase->event_count = 0;
+  broadphase->collider_capacity = INIT_COLLIDER_COUNT;
+  broadphase->touching_capacity = INIT_COLLIDER_COUNT;
+  broadphase->event_capacity = INIT_COLLIDER_COUNT;
+  broadphase->rules =
+      list_init(INIT_RULE_COUNT, (free_func_t)collision_rule_freer);
+  broadphase->candidates = 0;
+  return broadphase;
+}
+
+void broadphase_free(broadphase_t *broadphase) {
+  free(broadphase->colliders);
+  free(broadphase->touching);
+  free(broadphase->events);
+  list_free(broadphase->rules);
+  free(broadphase);
+}
+
+void broadphase_add_body(broadphase_t *broadphase, body_t *body,
+                         size_t categories) {
+  assert(categories != 0);
+  if (broadphase->collider_count >= broadphase->collider_capacity) {
+    broadphase->collider_capacity *= BROADPHASE_RESIZE_FACTOR;
+    broadphase->colliders =
+        realloc(broadphase->colliders,
+                sizeof(collider_t) * broadphase->collider_capacity);
+    assert(broadphase->colliders != NULL);
+  }
+  // the box is computed and the collider sorted into place on the next tick
+  broadphase->colliders[broadphase->collider_count++] =
+      (collider_t){.body = body, .categories = categories};
+}
+
+void broadphase_add_rule(broadphase_t *broadphase, size_t categories1,
+                         size_t categories2, collision_handler_t handler,
+                         void *aux, free_func_t freer) {
+  collision_rule_t *rule = malloc(sizeof(collision_rule_t));
+  assert(rule != NULL);
+  *rule = (collision_rule_t){categories1, categories2, handler, aux, freer,
+                             false, 0};
+  list_add(broadphase->rules, rule);
+}
+
+void broadphase_add_contact_rule(broadphase_t *broadphase, size_t categories1,
+                                 size_t categories2, double elasticity) {
+  collision_rule_t *rule = malloc(sizeof(collision_rule_t));
+  assert(rule != NULL);
+  *rule = (collision_rule_t){categories1, categories2, NULL, NULL, NULL,
+                             true, elasticity};
+  list_add(broadphase->rules, rule);
+}
+
+void broadphase_prune(broadphase_t *broadphase) {
+  size_t kept = 0;
+  for (size_t i = 0; i < broadphase->collider_count; i++) {
+    if (!body_is_removed(broadphase->colliders[i].body)) {
+      broadphase->colliders[kept++] = broadphase->colliders[i];
+    }
+  }
+  broadphase->collider_count = kept;
+  // order is preserved, so the touching pairs stay sorted
+  kept = 0;
+  for (size_t i = 0; i < broadphase->touching_count; i++) {
+    touching_t pair = broadphase->touching[i];
+    if (!body_is_removed(pair.body1) && !body_is_removed(pair.body2)) {
+      broadphase->touching[kept++] = pair;
+    }
+  }
+  broadphase->touching_count = kept;
+  kept = 0;
+  for (size_t i = 0; i < broadphase->event_count; i++) {
+    collision_event_t event = broadphase->events[i];
+    if (!body_is_removed(event.body1) && !body_is_removed(event.body2)) {
+      broadphase->events[kept++] = event;
+    }
+  }
+  broadphase->event_count = kept;
+}
+
+// Grows an array to hold at least count elements
+void *reserve(void *array, size_t *capacity, size_t count, size_t size) {
+  if (*capacity < count) {
+    *capacity = count;
+    array = realloc(array, size * count);
+    assert(array != NULL);
+  }
+  return array;
+}
+
+broadphase_state_t *broadphase_save(broadphase_t *broadphase,
+                                    broadphase_state_t *state) {
+  if (state == NULL) {
+    state = calloc(1, sizeof(broadphase_state_t));
+    assert(state != NULL);
+  }
+  state->colliders =
+      reserve(state->colliders, &state->collider_capacity,
+              broadphase->collider_count + 1, sizeof(collider_t));
+  state->touching =
+      reserve(state->touching, &state->touching_capacity,
+              broadphase->touching_count + 1, sizeof(touching_t));
+  state->events =
+      reserve(state->events, &state->event_capacity,
+              broadphase->event_count + 1, sizeof(collision_event_t));
+  state->collider_count = broadphase->collider_count;
+  state->touching_count = broadphase->touching_count;
+  state->event_count = broadphase->event_count;
+  state->candidates = broadphase->candidates;
+  memcpy(state->colliders, broadphase->colliders,
+         sizeof(collider_t) * state->collider_count);
+  memcpy(state->touching, broadphase->touching,
+         sizeof(touching_t) * state->touching_count);
+  memcpy(state->events, broadphase->events,
+         sizeof(collision_event_t) * state->event_count);
+  return state;
+}
+
+void broadphase_restore(broadphase_t *broadphase, broadphase_state_t *state) {
+  broadphase->colliders =
+      reserve(broadphase->colliders, &broadphase->collider_capacity,
+              state->collider_count, sizeof(collider_t));
+  broadphase->touching =
+      reserve(broadphase->touching, &broadphase->touching_capacity,
+              state->touching_count, sizeof(touching_t));
+  broadphase->events =
+      reserve(broadphase->events, &broadphase->event_capacity,
+              state->event_count, sizeof(collision_event_t));
+  memcpy(broadphase->colliders, state->colliders,
+         sizeof(collider_t) * state->collider_count);
+  memcpy(broadphase->touching, state->touching,
+         sizeof(touching_t) * state->touching_count);
+  memcpy(broadphase->events, state->events,
+         sizeof(collision_event_t) * state->event_count);
+  broadphase->collider_count = state->collider_count;
+  broadphase->touching_count = state->touching_count;
+  broadphase->event_count = state->event_count;
+  broadphase->candidates = state->candidates;
+}
+
+void broadphase_state_free(broadphase_state_t *state) {
+  free(state->colliders);
+  free(state->touching);
+  free(state->events);
+  free(state);
+}
+
+size_t broadphase_collisions(broadphase_t *broadphase) {
+  return broadphase->event_count;
+}
+
+collision_event_t broadphase_get_collision(broadphase_t *broadphase,
+                                           size_t index) {
+  assert(index < broadphase->event_count);
+  return broadphase->events[index];
+}
+
+size_t broadphase_candidates(broadphase_t *broadphase) {
+  return broadphase->candidates;
+}
+
+// The box covers everywhere the body goes during the tick
+void collider_update_bounds(collider_t *collider, double dt) {
+  body_t *body = collider->body;
+  vector_t motion = vec_multiply(dt, body_get_velocity(body));
+  // cached relative to the centroid, so no vertices are visited
+  aabb_t bounds = body_get_aabb(body);
+  collider->min_x = bounds.min.x + fmin(motion.x, 0);
+  collider->max_x = bounds.max.x + fmax(motion.x, 0);
+  collider->min_y = bounds.min.y + fmin(motion.y, 0);
+  collider->max_y = bounds.max.y + fmax(motion.y, 0);
+}
+
+// Insertion sort: the order barely changes between ticks
+void sort_colliders(broadphase_t *broadphase) {
+  collider_t *colliders = broadphase->colliders;
+  for (size_t i = 1; i < broadphase->collider_count; i++) {
+    collider_t collider = colliders[i];
+    size_t j = i;
+    while (j > 0 && colliders[j - 1].min_x > collider.min_x) {
+      colliders[j] = colliders[j - 1];
+      j--;
+    }
+    colliders[j] = collider;
+  }
+}
+
+int touching_compare(const void *a, const void *b) {
+  const touching_t *pair1 = a;
+  const touching_t *pair2 = b;
+  uintptr_t key1 = (uintptr_t)pair1->body1;
+  uintptr_t key2 = (uintptr_t)pair2->body1;
+  if (key1 == key2) {
+    key1 = (uintptr_t)pair1->body2;
+    key2 = (uintptr_t)pair2->body2;
+  }
+  return (key1 > key2) - (key1 < key2);
+}
+
+touching_t touching_key(body_t *body1, body_t *body2) {
+  if ((uintptr_t)body2 < (uintptr_t)body1) {
+    return (touching_t){body2, body1, true};
+  }
+  return (touching_t){body1, body2, true};
+}
+
+void add_touching(broadphase_t *broadphase, body_t *body1, body_t *body2) {
+  if (broadphase->touching_count >= broadphase->touching_capacity) {
+    broadphase->touching_capacity *= BROADPHASE_RESIZE_FACTOR;
+    broadphase->touching =
+        realloc(broadphase->touching,
+                sizeof(touching_t) * broadphase->touching_capacity);
+    assert(broadphase->touching != NULL);
+  }
+  broadphase->touching[broadphase->touching_count++] =
+      touching_key(body1, body2);
+}
+
+// Keeps the pairs still in contact, last tick's and new ones, for next tick
+void update_touching(broadphase_t *broadphase) {
+  size_t kept = 0;
+  for (size_t i = 0; i < broadphase->touching_count; i++) {
+    touching_t pair = broadphase->touching[i];
+    if (pair.seen) {
+      pair.seen = false;
+      broadphase->touching[kept++] = pair;
+    }
+  }
+  broadphase->touching_count = kept;
+  qsort(broadphase->touching, kept, sizeof(touching_t), touching_compare);
+}
+
+void add_event(broadphase_t *broadphase, collision_event_t event) {
+  if (broadphase->event_count >= broadphase->event_capacity) {
+    broadphase->event_capacity *= BROADPHASE_RESIZE_FACTOR;
+    broadphase->events =
+        realloc(broadphase->events,
+                sizeof(collision_event_t) * broadphase->event_capacity);
+    assert(broadphase->events != NULL);
+  }
+  broadphase->events[broadphase->event_count++] = event;
+}
+
+bool rule_matches(collision_rule_t *rule, size_t categories1,
+                  size_t categories2) {
+  return (categories1 & rule->categories1) &&
+         (categories2 & rule->categories2);
+}
+
+void broadphase_test_pair(broadphase_t *broadphase, size_t index1,
+                          size_t index2, size_t old_touching, double dt,
+                          contact_solver_t *contacts) {
+  body_t *body1 = broadphase->colliders[index1].body;
+  body_t *body2 = broadphase->colliders[index2].body;
+  size_t categories1 = broadphase->colliders[index1].categories;
+  size_t categories2 = broadphase->colliders[index2].categories;
+  size_t rule_count = list_size(broadphase->rules);
+  bool has_rule = false;
+  collision_rule_t *contact_rule = NULL;
+  for (size_t i = 0; i < rule_count && contact_rule == NULL; i++) {
+    collision_rule_t *rule = list_get(broadphase->rules, i);
+    if (rule_matches(rule, categories1, categories2) ||
+        rule_matches(rule, categories2, categories1)) {
+      has_rule = true;
+      contact_rule = rule->contact ? rule : NULL;
+    }
+  }
+  if (!has_rule) {
+    return;
+  }
+  // A pair that was already touching only calls its handlers again once it
+  // moves back towards each other, e.g. a ball knocked back into the
+  // cushion it just bounced off. Otherwise the contact is still the old one,
+  // and unless the contact solver needs it, it is not even tested again.
+  touching_t key = touching_key(body1, body2);
+  touching_t *touching =
+      bsearch(&key, broadphase->touching, old_touching, sizeof(touching_t),
+              touching_compare);
+  vector_t closing =
+      vec_subtract(body_get_velocity(body2), body_get_velocity(body1));
+  if (touching != NULL && contact_rule == NULL && closing.x == 0 &&
+      closing.y == 0) {
+    touching->seen = true;
+    return;
+  }
+  broadphase->candidates++;
+  collision_info_t info = find_body_swept_collision(body1, body2, dt);
+  if (!info.collided) {
+    return;
+  }
+  if (touching != NULL) {
+    touching->seen = true;
+  } else {
+    add_touching(broadphase, body1, body2);
+  }
+  if (contact_rule != NULL) {
+    assert(contacts != NULL);
+    contact_solver_add(contacts,
+                       (contact_t){body1, body2, info.axis, info.depth,
+                                   contact_rule->elasticity});
+  }
+  if (touching != NULL && vec_dot(closing, info.axis) >= 0) {
+    return;
+  }
+  body_wake(body1);
+  body_wake(body2);
+  add_event(broadphase, (collision_event_t){body1, body2, info.axis});
+  // Handlers may add bodies (reallocating the colliders), so only the
+  // locals above are used from here on
+  for (size_t i = 0; i < rule_count; i++) {
+    collision_rule_t *rule = list_get(broadphase->rules, i);
+    if (rule->handler == NULL) {
+      continue;
+    } else if (rule_matches(rule, categories1, categories2)) {
+      rule->handler(body1, body2, info.axis, rule->aux);
+    } else if (rule_matches(rule, categories2, categories1)) {
+      rule->handler(body2, body1, vec_negate(info.axis), rule->aux);
+    }
+  }
+}
+
+void broadphase_tick(broadphase_t *broadphase, double dt,
+                     contact_solver_t *contacts) {
+  size_t count = broadphase->collider_count;
+  for (size_t i = 0; i < count; i++) {
+    collider_update_bounds(&broadphase->colliders[i], dt);
+  }
+  sort_colliders(broadphase);
+  broadphase->candidates = 0;
+  broadphase->event_count = 0;
+  size_t old_touching = broadphase->touching_count;
+  // Bodies added by handlers during the sweep are past count,
+  // so they only take part from the next tick on
+  for (size_t i = 0; i < count; i++) {
+    for (size_t j = i + 1; j < count; j++) {
+      collider_t *collider1 = &broadphase->colliders[i];
+      collider_t *collider2 = &broadphase->colliders[j];
+      if (collider2->min_x > collider1->max_x) {
+        break;
+      }
+      if (collider2->min_y > collider1->max_y ||
+          collider2->max_y < collider1->min_y) {
+        continue;
+      }
+      // sleeping bodies stay where they came to rest against each other
+      if (body_is_asleep(collider1->body) && body_is_asleep(collider2->body)) {
+        continue;
+      }
+      broadphase_test_pair(broadphase, i, j, old_touching, dt, contacts);
+    }
+  }
+  update_touching(broadphase);
+}
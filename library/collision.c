@@ -1,7 +1,7 @@
 #include "collision.h"
-#include "list.h"
+#include "body.h"
 #include "polygon.h"
-#include "vec_list.h"
+#include "sat.h"
 #include "vector.h"
 #include <assert.h>
 #include <limits.h>
@@ -9,19 +9,21 @@
 #include <stdbool.h>
 #include <stdlib.h>
 
-collision_info_t find_collision(list_t *shape1, list_t *shape2) {
-  collision_info_t *info = malloc(sizeof(collision_info_t));
-  assert(info != NULL);
-  info->collided = true;
-  double *overlap = malloc(sizeof(double));
-  assert(overlap != NULL);
-  *overlap = INT_MAX;
-  find_collision_projs(shape1, shape2, info, overlap);
-  find_collision_projs(shape2, shape1, info, overlap);
-  collision_info_t result = *info;
-  free(overlap);
-  free(info);
+// Edge normals are projected in batches of this many (see sat.h),
+// so a separating axis still ends the test after one batch
+enum { SAT_BATCH = 8 };
+
+collision_stats_t collision_stats = {0};
+
+collision_info_t find_collision(polygon_t *shape1, polygon_t *shape2) {
+  collision_info_t result = {.collided = true};
+  double overlap = INT_MAX;
+  find_collision_projs(shape1, shape2, &result, &overlap);
+  if (result.collided) {
+    find_collision_projs(shape2, shape1, &result, &overlap);
+  }
   if (result.collided) {
+    result.depth = overlap;
     if (vec_dot(result.axis, vec_subtract(polygon_centroid(shape2),
                                           polygon_centroid(shape1))) < 0) {
       result.axis = vec_negate(result.axis);
@@ -34,47 +36,323 @@ double dmax(double a, double b) { return a > b ? a : b; }
 
 double dmin(double a, double b) { return a < b ? a : b; }
 
-void find_collision_projs(list_t *shape1, list_t *shape2,
+void find_collision_projs(polygon_t *shape1, polygon_t *shape2,
                           collision_info_t *info, double *overlap) {
-  size_t n_edges = list_size(shape1);
-  for (int i = 0; i < n_edges; i++) {
-    vector_t axis =
-        vec_subtract(*(vector_t *)list_get(shape1, (i + 1) % n_edges),
-                     *(vector_t *)list_get(shape1, i));
-    axis = vec_unit(vec_rotate(axis, -M_PI / 2));
-    vector_t shape1_projs = find_shape_projs(shape1, axis);
-    vector_t shape2_projs = find_shape_projs(shape2, axis);
-    double s1_min = shape1_projs.x;
-    double s1_max = shape1_projs.y;
-    double s2_min = shape2_projs.x;
-    double s2_max = shape2_projs.y;
-    double temp_overlap = dmin(s1_max, s2_max) - dmax(s1_min, s2_min);
-    if (temp_overlap < 0) {
-      info->collided = false;
-      return;
-    } else {
-      if (temp_overlap < *overlap) {
+  size_t n_edges = polygon_size(shape1);
+  vector_t *vertices1 = polygon_vertices(shape1);
+  size_t n_vertices2 = polygon_size(shape2);
+  vector_t *vertices2 = polygon_vertices(shape2);
+  vector_t axes[SAT_BATCH];
+  vector_t shape1_projs[SAT_BATCH];
+  vector_t shape2_projs[SAT_BATCH];
+  size_t edge = 0;
+  while (edge < n_edges) {
+    // the outward normals of the next edges, each normalized once
+    size_t n_axes = 0;
+    for (; edge < n_edges && n_axes < SAT_BATCH; edge++) {
+      vector_t side =
+          vec_subtract(vertices1[(edge + 1) % n_edges], vertices1[edge]);
+      double length = vec_magnitude(side);
+      // repeated vertices have no normal to separate along
+      if (length > 0) {
+        axes[n_axes++] = (vector_t){side.y / length, -side.x / length};
+      }
+    }
+    if (n_axes == 0) {
+      continue;
+    }
+    sat_project_axes(vertices1, n_edges, axes, n_axes, shape1_projs);
+    sat_project_axes(vertices2, n_vertices2, axes, n_axes, shape2_projs);
+    for (size_t i = 0; i < n_axes; i++) {
+      double temp_overlap = dmin(shape1_projs[i].y, shape2_projs[i].y) -
+                            dmax(shape1_projs[i].x, shape2_projs[i].x);
+      if (temp_overlap < 0) {
+        info->collided = false;
+        return;
+      } else if (temp_overlap < *overlap) {
         *overlap = temp_overlap;
         info->collided = true;
-        info->axis = axis;
+        info->axis = axes[i];
       }
     }
   }
 }
 
-vector_t find_shape_projs(list_t *shape, vector_t line) {
-  double min = vec_proj(*(vector_t *)list_get(shape, 0), line);
-  ;
-  double max = min;
-  for (int i = 1; i < list_size(shape); i++) {
-    double proj = vec_proj(*(vector_t *)list_get(shape, i), line);
-    if (proj < min) {
-      min = proj;
+vector_t find_shape_projs(polygon_t *shape, vector_t line) {
+  return sat_project(polygon_vertices(shape), polygon_size(shape),
+                     vec_unit(line));
+}
+
+collision_info_t find_circle_collision(vector_t center1, double radius1,
+                                       vector_t center2, double radius2) {
+  collision_info_t result = {.collided = false};
+  vector_t between = vec_subtract(center2, center1);
+  double reach = radius1 + radius2;
+  double dist_sq = vec_dot(between, between);
+  // touching counts as colliding, like a zero overlap in find_collision()
+  if (dist_sq > reach * reach) {
+    return result;
+  }
+  result.collided = true;
+  result.depth = reach - sqrt(dist_sq);
+  if (dist_sq > 0) {
+    result.axis = vec_multiply(1 / sqrt(dist_sq), between);
+  } else {
+    result.axis = (vector_t){1, 0};
+  }
+  return result;
+}
+
+// The point of a polygon's boundary closest to a point, and whether the
+// point is inside the polygon
+vector_t closest_boundary_point(vector_t center, polygon_t *shape,
+                                bool *inside) {
+  size_t n_edges = polygon_size(shape);
+  vector_t *vertices = polygon_vertices(shape);
+  // The center is inside iff it is on the same side of every edge
+  bool left_of_all = true;
+  bool right_of_all = true;
+  double closest_dist_sq = INFINITY;
+  vector_t closest = VEC_ZERO;
+  for (size_t i = 0; i < n_edges; i++) {
+    vector_t start = vertices[i];
+    vector_t edge = vec_subtract(vertices[(i + 1) % n_edges], start);
+    vector_t to_center = vec_subtract(center, start);
+    double side = vec_cross(edge, to_center);
+    left_of_all = left_of_all && side >= 0;
+    right_of_all = right_of_all && side <= 0;
+    double t = vec_dot(to_center, edge) / vec_dot(edge, edge);
+    t = t < 0 ? 0 : (t > 1 ? 1 : t);
+    vector_t point = vec_add(start, vec_multiply(t, edge));
+    vector_t offset = vec_subtract(point, center);
+    double dist_sq = vec_dot(offset, offset);
+    if (dist_sq < closest_dist_sq) {
+      closest_dist_sq = dist_sq;
+      closest = point;
     }
-    if (proj > max) {
-      max = proj;
+  }
+  *inside = left_of_all || right_of_all;
+  return closest;
+}
+
+// The axis from a circle's center towards a polygon, given the closest
+// point of the polygon's boundary
+vector_t closest_feature_axis(vector_t center, polygon_t *shape,
+                              vector_t closest, bool inside) {
+  if (closest.x == center.x && closest.y == center.y) {
+    // center exactly on the boundary
+    return vec_unit(vec_subtract(polygon_centroid(shape), center));
+  } else if (inside) {
+    // the circle has to leave through the closest edge,
+    // so the polygon lies on the opposite side
+    return vec_unit(vec_subtract(center, closest));
+  }
+  return vec_unit(vec_subtract(closest, center));
+}
+
+collision_info_t find_circle_polygon_collision(vector_t center, double radius,
+                                               polygon_t *shape) {
+  collision_info_t result = {.collided = false};
+  bool inside;
+  vector_t closest = closest_boundary_point(center, shape, &inside);
+  vector_t offset = vec_subtract(closest, center);
+  double closest_dist_sq = vec_dot(offset, offset);
+  if (!inside && closest_dist_sq > radius * radius) {
+    return result;
+  }
+  result.collided = true;
+  double closest_dist = sqrt(closest_dist_sq);
+  result.depth = inside ? radius + closest_dist : radius - closest_dist;
+  result.axis = closest_feature_axis(center, shape, closest, inside);
+  return result;
+}
+
+vector_t find_circle_polygon_axis(vector_t center, polygon_t *shape) {
+  bool inside;
+  vector_t closest = closest_boundary_point(center, shape, &inside);
+  return closest_feature_axis(center, shape, closest, inside);
+}
+
+// Whether the cached bounds of two bodies overlap, with the given slack
+// added to the bounding circles. Touching bounds count as overlapping.
+bool bounds_overlap(body_t *body1, body_t *body2, double slack) {
+  vector_t between =
+      vec_subtract(body_get_centroid(body2), body_get_centroid(body1));
+  double reach =
+      body_get_bounding_radius(body1) + body_get_bounding_radius(body2) + slack;
+  if (vec_dot(between, between) > reach * reach) {
+    return false;
+  }
+  if (slack > 0) {
+    return true;
+  }
+  // long walls have loose bounding circles, so check the boxes too
+  aabb_t box1 = body_get_aabb(body1);
+  aabb_t box2 = body_get_aabb(body2);
+  return box1.min.x <= box2.max.x && box2.min.x <= box1.max.x &&
+         box1.min.y <= box2.max.y && box2.min.y <= box1.max.y;
+}
+
+collision_info_t find_shape_collision(body_t *body1, body_t *body2) {
+  bool circle1 = body_get_shape_kind(body1) == SHAPE_CIRCLE;
+  bool circle2 = body_get_shape_kind(body2) == SHAPE_CIRCLE;
+  if (circle1 && circle2) {
+    return find_circle_collision(body_get_centroid(body1),
+                                 body_get_radius(body1),
+                                 body_get_centroid(body2),
+                                 body_get_radius(body2));
+  } else if (circle1) {
+    return find_circle_polygon_collision(body_get_centroid(body1),
+                                         body_get_radius(body1),
+                                         body_get_shape(body2));
+  } else if (circle2) {
+    collision_info_t result = find_circle_polygon_collision(
+        body_get_centroid(body2), body_get_radius(body2),
+        body_get_shape(body1));
+    result.axis = vec_negate(result.axis);
+    return result;
+  }
+  return find_collision(body_get_shape(body1), body_get_shape(body2));
+}
+
+collision_info_t find_body_collision(body_t *body1, body_t *body2) {
+  collision_stats.tests++;
+  // a circle is its own bounding circle, so the exact test is just as cheap
+  bool circles = body_get_shape_kind(body1) == SHAPE_CIRCLE &&
+                 body_get_shape_kind(body2) == SHAPE_CIRCLE;
+  if (!circles && !bounds_overlap(body1, body2, 0)) {
+    collision_stats.rejects++;
+    return (collision_info_t){.collided = false};
+  }
+  collision_info_t result = find_shape_collision(body1, body2);
+  if (result.collided) {
+    collision_stats.hits++;
+  } else if (circles) {
+    collision_stats.rejects++;
+  }
+  return result;
+}
+
+collision_stats_t collision_get_stats() { return collision_stats; }
+
+void collision_reset_stats() { collision_stats = (collision_stats_t){0}; }
+
+double circle_time_of_impact(vector_t center1, vector_t velocity1,
+                             double radius1, vector_t center2,
+                             vector_t velocity2, double radius2, double dt) {
+  // Solve |between + closing * t| = radius1 + radius2 for the first t
+  vector_t between = vec_subtract(center2, center1);
+  vector_t closing = vec_subtract(velocity2, velocity1);
+  double reach = radius1 + radius2;
+  double c = vec_dot(between, between) - reach * reach;
+  if (c <= 0) {
+    return 0;
+  }
+  double a = vec_dot(closing, closing);
+  double b = 2 * vec_dot(between, closing);
+  if (a == 0 || b >= 0) { // not approaching
+    return INFINITY;
+  }
+  double discriminant = b * b - 4 * a * c;
+  if (discriminant < 0) {
+    return INFINITY;
+  }
+  double t = (-b - sqrt(discriminant)) / (2 * a);
+  return t <= dt ? t : INFINITY;
+}
+
+double circle_polygon_time_of_impact(vector_t center, vector_t velocity,
+                                     double radius, polygon_t *shape, double dt) {
+  if (find_circle_polygon_collision(center, radius, shape).collided) {
+    return 0;
+  }
+  double first = INFINITY;
+  size_t n_edges = polygon_size(shape);
+  vector_t *vertices = polygon_vertices(shape);
+  for (size_t i = 0; i < n_edges; i++) {
+    vector_t start = vertices[i];
+    vector_t end = vertices[(i + 1) % n_edges];
+    // the circle first touches either a vertex...
+    double t = circle_time_of_impact(center, velocity, radius, start, VEC_ZERO,
+                                     0, dt);
+    if (t < first) {
+      first = t;
+    }
+    // ...or the inside of an edge
+    vector_t edge = vec_subtract(end, start);
+    vector_t normal = vec_unit((vector_t){-edge.y, edge.x});
+    double dist = vec_dot(vec_subtract(center, start), normal);
+    if (dist < 0) {
+      normal = vec_negate(normal);
+      dist = -dist;
+    }
+    double speed = vec_dot(velocity, normal);
+    if (speed >= 0) {
+      continue;
+    }
+    t = (dist - radius) / -speed;
+    if (t > dt || t >= first) {
+      continue;
     }
+    vector_t contact = vec_add(center, vec_multiply(t, velocity));
+    double along = vec_dot(vec_subtract(contact, start), edge) /
+                   vec_dot(edge, edge);
+    if (along >= 0 && along <= 1) {
+      first = t;
+    }
+  }
+  return first;
+}
+
+collision_info_t find_body_swept_collision(body_t *body1, body_t *body2,
+                                           double dt) {
+  collision_info_t result = find_body_collision(body1, body2);
+  bool circle1 = body_get_shape_kind(body1) == SHAPE_CIRCLE;
+  bool circle2 = body_get_shape_kind(body2) == SHAPE_CIRCLE;
+  if (result.collided || dt <= 0 || !(circle1 || circle2)) {
+    return result;
   }
-  vector_t values = (vector_t){.x = min, .y = max};
-  return values;
+  vector_t center1 = body_get_centroid(body1);
+  vector_t center2 = body_get_centroid(body2);
+  vector_t velocity1 = body_get_velocity(body1);
+  vector_t velocity2 = body_get_velocity(body2);
+  // the bodies cannot close more of the gap than this within dt
+  double travel = vec_magnitude(vec_subtract(velocity2, velocity1)) * dt;
+  if (!bounds_overlap(body1, body2, travel)) {
+    return result;
+  }
+  if (circle1 && circle2) {
+    double t = circle_time_of_impact(center1, velocity1, body_get_radius(body1),
+                                     center2, velocity2, body_get_radius(body2),
+                                     dt);
+    if (t != INFINITY) {
+      vector_t contact1 = vec_add(center1, vec_multiply(t, velocity1));
+      vector_t contact2 = vec_add(center2, vec_multiply(t, velocity2));
+      result.collided = true;
+      result.axis = vec_unit(vec_subtract(contact2, contact1));
+      result.depth = -t * vec_dot(vec_subtract(velocity1, velocity2),
+                                  result.axis);
+    }
+    return result;
+  }
+  // Move the circle relative to the polygon, which then stays put
+  body_t *circle = circle1 ? body1 : body2;
+  polygon_t *shape = body_get_shape(circle1 ? body2 : body1);
+  vector_t center = circle1 ? center1 : center2;
+  vector_t velocity = circle1 ? vec_subtract(velocity1, velocity2)
+                              : vec_subtract(velocity2, velocity1);
+  double t = circle_polygon_time_of_impact(center, velocity,
+                                           body_get_radius(circle), shape, dt);
+  if (t != INFINITY) {
+    vector_t contact = vec_add(center, vec_multiply(t, velocity));
+    result.collided = true;
+    result.axis = find_circle_polygon_axis(contact, shape);
+    if (!circle1) {
+      result.axis = vec_negate(result.axis);
+    }
+    // the gap along the axis that closes by the time of impact
+    result.depth = -t * vec_dot(vec_subtract(velocity1, velocity2),
+                                result.axis);
+  }
+  return result;
 }
@@ -0,0 +1,442 @@
+#include "contact.h"
+#include "body.h"
+#include "kinematics.h"
+#include "vector.h"
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+const size_t CONTACT_SOLVER_ITERATIONS = 64;
+const double CONTACT_SOLVER_TOLERANCE = 1e-6;
+// The fraction of an overlap corrected per solve, and the overlap left alone
+// so resting contacts are not pushed back and forth
+const double CONTACT_CORRECTION = 0.8;
+const double CONTACT_SLOP = 1e-3;
+// Most passes moving overlapping bodies apart per solve
+const size_t CONTACT_CORRECTION_ITERATIONS = 16;
+const size_t INIT_CONTACT_COUNT = 16;
+const size_t CONTACT_RESIZE_FACTOR = 2;
+
+// A contact being solved
+typedef struct contact_row {
+  contact_t *contact;
+  size_t slot1;
+  size_t slot2;
+  double inv_mass1;
+  double inv_mass2;
+  double mass; // the mass the contact's impulse acts on, 0 if neither moves
+  double target; // the separating speed restitution asks for
+  double arrival; // when a speculative contact's bodies meet and bounce, or 0
+  double impulse; // the total so far along the axis, never negative
+  vector_t start1; // where the bodies were before the tick
+  vector_t start2;
+} contact_row_t;
+
+// The impulse a pair of bodies ended the last solve with. A contact that
+// lasts, like a body resting on another, needs about the same impulse every
+// tick, so solving starts from it instead of from nothing.
+typedef struct contact_warm {
+  body_t *body1; // the lower address of the two
+  body_t *body2;
+  double impulse;
+} contact_warm_t;
+
+typedef struct contact_solver {
+  contact_t *contacts;
+  contact_row_t *rows;
+  size_t count;
+  size_t solved; // rows set up by the last solve
+  size_t capacity;
+  contact_warm_t *warm; // sorted by (body1, body2)
+  size_t warm_count;
+  size_t warm_capacity;
+  vector_t *velocity; // by slot, for the slots in contacts
+  vector_t *shift;    // by slot, how far the correction has moved a body
+  size_t velocity_capacity;
+  size_t max_iterations;
+  double tolerance;
+} contact_solver_t;
+
+contact_solver_t *contact_solver_init(void) {
+  contact_solver_t *solver = malloc(sizeof(contact_solver_t));
+  assert(solver != NULL);
+  solver->contacts = malloc(sizeof(contact_t) * INIT_CONTACT_COUNT);
+  solver->rows = malloc(sizeof(contact_row_t) * INIT_CONTACT_COUNT);
+  solver->warm = malloc(sizeof(contact_warm_t) * INIT_CONTACT_COUNT);
+  solver->velocity = malloc(sizeof(vector_t) * INIT_CONTACT_COUNT);
+  solver->shift = malloc(sizeof(vector_t) * INIT_CONTACT_COUNT);
+  assert(solver->contacts != NULL && solver->rows != NULL &&
+         solver->warm != NULL && solver->velocity != NULL &&
+         solver->shift != NULL);
+  solver->count = solver->solved = solver->warm_count = 0;
+  solver->capacity = solver->warm_capacity = INIT_CONTACT_COUNT;
+  solver->velocity_capacity = INIT_CONTACT_COUNT;
+  solver->max_iterations = CONTACT_SOLVER_ITERATIONS;
+  solver->tolerance = CONTACT_SOLVER_TOLERANCE;
+  return solver;
+}
+
+void contact_solver_free(contact_solver_t *solver) {
+  free(solver->contacts);
+  free(solver->rows);
+  free(solver->warm);
+  free(solver->velocity);
+  free(solver->shift);
+  free(solver);
+}
+
+void contact_solver_set_iterations(contact_solver_t *solver,
+                                   size_t max_iterations, double tolerance) {
+  assert(max_iterations >= 1 && tolerance >= 0);
+  solver->max_iterations = max_iterations;
+  solver->tolerance = tolerance;
+}
+
+void contact_solver_add(contact_solver_t *solver, contact_t contact) {
+  if (solver->count >= solver->capacity) {
+    solver->capacity *= CONTACT_RESIZE_FACTOR;
+    solver->contacts =
+        realloc(solver->contacts, sizeof(contact_t) * solver->capacity);
+    solver->rows = realloc(solver->rows, sizeof(contact_row_t) * solver->capacity);
+    assert(solver->contacts != NULL && solver->rows != NULL);
+  }
+  solver->contacts[solver->count++] = contact;
+}
+
+size_t contact_solver_contacts(contact_solver_t *solver) {
+  return solver->count;
+}
+
+// The velocity a slot would leave the tick with, before any contacts, if
+// forces act on it for dt
+vector_t contact_velocity(kinematics_t *kin, size_t slot, double dt) {
+  if (kin->asleep[slot]) {
+    return kin->velocity[slot];
+  }
+  vector_t push = vec_add(kin->impulse[slot], vec_multiply(dt, kin->force[slot]));
+  return vec_add(kin->velocity[slot], vec_multiply(kin->inv_mass[slot], push));
+}
+
+size_t contact_slot(kinematics_t *kin, body_t *body) {
+  size_t slot = body_get_slot(body);
+  assert(slot < kin->size && kin->owner[slot] == body);
+  return slot;
+}
+
+int contact_warm_compare(const void *a, const void *b) {
+  const contact_warm_t *warm1 = a;
+  const contact_warm_t *warm2 = b;
+  if (warm1->body1 != warm2->body1) {
+    return (uintptr_t)warm1->body1 < (uintptr_t)warm2->body1 ? -1 : 1;
+  }
+  if (warm1->body2 != warm2->body2) {
+    return (uintptr_t)warm1->body2 < (uintptr_t)warm2->body2 ? -1 : 1;
+  }
+  return 0;
+}
+
+contact_warm_t contact_warm_key(body_t *body1, body_t *body2,
+                                double impulse) {
+  if ((uintptr_t)body2 < (uintptr_t)body1) {
+    return (contact_warm_t){body2, body1, impulse};
+  }
+  return (contact_warm_t){body1, body2, impulse};
+}
+
+// The impulse a pair ended the last solve with, or 0. The impulse acts
+// along the axis from body1 to body2 either way round, so it does not
+// depend on the order.
+double contact_warm_impulse(contact_solver_t *solver, contact_t *contact) {
+  contact_warm_t key = contact_warm_key(contact->body1, contact->body2, 0);
+  contact_warm_t *warm =
+      bsearch(&key, solver->warm, solver->warm_count, sizeof(contact_warm_t),
+              contact_warm_compare);
+  return warm == NULL ? 0 : warm->impulse;
+}
+
+// Sets up a row per contact between bodies that are still in the scene,
+// returning the number of rows and the fastest approach
+size_t contact_solver_setup(contact_solver_t *solver, kinematics_t *kin,
+                            double dt, double *fastest) {
+  if (solver->velocity_capacity < kin->size) {
+    solver->velocity_capacity = kin->size;
+    solver->velocity =
+        realloc(solver->velocity, sizeof(vector_t) * kin->size);
+    solver->shift = realloc(solver->shift, sizeof(vector_t) * kin->size);
+    assert(solver->velocity != NULL && solver->shift != NULL);
+  }
+  vector_t *velocity = solver->velocity;
+  size_t rows = 0;
+  for (size_t i = 0; i < solver->count; i++) {
+    contact_t *contact = &solver->contacts[i];
+    if (body_is_removed(contact->body1) || body_is_removed(contact->body2)) {
+      continue;
+    }
+    size_t slot1 = contact_slot(kin, contact->body1);
+    size_t slot2 = contact_slot(kin, contact->body2);
+    velocity[slot1] = contact_velocity(kin, slot1, dt);
+    velocity[slot2] = contact_velocity(kin, slot2, dt);
+    double inv_mass = kin->inv_mass[slot1] + kin->inv_mass[slot2];
+    solver->rows[rows++] = (contact_row_t){
+        contact, slot1, slot2, kin->inv_mass[slot1], kin->inv_mass[slot2],
+        inv_mass == 0 ? 0 : 1 / inv_mass, 0, 0,
+        inv_mass == 0 ? 0 : contact_warm_impulse(solver, contact),
+        body_get_centroid(contact->body1), body_get_centroid(contact->body2)};
+  }
+  // only once every velocity is set, as bodies can share contacts
+  *fastest = 0;
+  for (size_t i = 0; i < rows; i++) {
+    contact_row_t *row = &solver->rows[i];
+    vector_t axis = row->contact->axis;
+    double approach = vec_dot(
+        vec_subtract(velocity[row->slot1], velocity[row->slot2]), axis);
+    *fastest = fmax(*fastest, approach);
+    // Bounce off the approach the bodies come in with, not the one this
+    // tick's forces add, or a body resting under gravity would hop.
+    // A contact that was already pressing can be left approaching by as
+    // much as its last impulse changes the velocities, when the solve before
+    // stopped short; that is not an impact either, and bouncing it would
+    // jostle a stack apart.
+    double bounce = vec_dot(vec_subtract(contact_velocity(kin, row->slot1, 0),
+                                         contact_velocity(kin, row->slot2, 0)),
+                            axis);
+    double resting = approach - bounce;
+    if (row->mass > 0) {
+      resting += row->impulse / row->mass;
+    }
+    bool impact = bounce > 0 && bounce > resting;
+    // A speculative contact (see collision_info_t) may close its gap within
+    // the tick, but no more. Only bodies that get there bounce, and
+    // contact_solver_arrive() then moves them back to where they met.
+    double gap = -row->contact->depth;
+    if (gap > 0 && (!impact || approach * dt <= gap)) {
+      row->target = -gap / dt;
+    } else if (impact) {
+      row->target = row->contact->elasticity * bounce;
+      if (gap > 0) {
+        row->arrival = gap / approach;
+      }
+    }
+  }
+  // then start from the last solve's impulses
+  for (size_t i = 0; i < rows; i++) {
+    contact_row_t *row = &solver->rows[i];
+    vector_t impulse = vec_multiply(row->impulse, row->contact->axis);
+    velocity[row->slot1] = vec_subtract(
+        velocity[row->slot1], vec_multiply(row->inv_mass1, impulse));
+    velocity[row->slot2] =
+        vec_add(velocity[row->slot2], vec_multiply(row->inv_mass2, impulse));
+  }
+  return rows;
+}
+
+// One pass over the contacts, returning the largest change in velocity.
+// Each contact shares bodies with the ones before it, so the passes are a
+// chain of dependent updates; the arithmetic is spelled out to keep it short.
+double contact_solver_pass(contact_solver_t *solver, size_t rows,
+                           bool backwards) {
+  vector_t *velocity = solver->velocity;
+  double largest = 0;
+  for (size_t i = 0; i < rows; i++) {
+    contact_row_t *row = &solver->rows[backwards ? rows - 1 - i : i];
+    if (row->mass == 0) {
+      continue;
+    }
+    vector_t axis = row->contact->axis;
+    vector_t *v1 = &velocity[row->slot1];
+    vector_t *v2 = &velocity[row->slot2];
+    double separation = (v2->x - v1->x) * axis.x + (v2->y - v1->y) * axis.y;
+    double total = row->impulse + (row->target - separation) * row->mass;
+    if (total < 0) {
+      total = 0;
+    }
+    double impulse = total - row->impulse;
+    row->impulse = total;
+    double dv1 = row->inv_mass1 * impulse;
+    double dv2 = row->inv_mass2 * impulse;
+    v1->x -= dv1 * axis.x;
+    v1->y -= dv1 * axis.y;
+    v2->x += dv2 * axis.x;
+    v2->y += dv2 * axis.y;
+    double change = fabs(dv1 + dv2);
+    if (change > largest) {
+      largest = change;
+    }
+  }
+  return largest;
+}
+
+// Remembers the impulses for the next solve to start from
+void contact_solver_keep_impulses(contact_solver_t *solver, size_t rows) {
+  if (solver->warm_capacity < rows) {
+    solver->warm_capacity = rows;
+    solver->warm = realloc(solver->warm, sizeof(contact_warm_t) * rows);
+    assert(solver->warm != NULL);
+  }
+  size_t kept = 0;
+  for (size_t i = 0; i < rows; i++) {
+    contact_row_t *row = &solver->rows[i];
+    if (row->impulse > 0) {
+      solver->warm[kept++] = contact_warm_key(
+          row->contact->body1, row->contact->body2, row->impulse);
+    }
+  }
+  solver->warm_count = kept;
+  qsort(solver->warm, kept, sizeof(contact_warm_t), contact_warm_compare);
+}
+
+// Moves overlapping bodies most of the way apart. Each pass measures the
+// overlaps left by the moves so far, so in a stack the push on one contact
+// carries on through the contacts it presses together.
+void contact_solver_correct(contact_solver_t *solver, size_t rows) {
+  vector_t *shift = solver->shift;
+  for (size_t i = 0; i < rows; i++) {
+    shift[solver->rows[i].slot1] = shift[solver->rows[i].slot2] = VEC_ZERO;
+  }
+  for (size_t pass = 0; pass < CONTACT_CORRECTION_ITERATIONS; pass++) {
+    double largest = 0;
+    for (size_t i = 0; i < rows; i++) {
+      contact_row_t *row = &solver->rows[i];
+      contact_t *contact = row->contact;
+      // speculative contacts did not overlap to begin with
+      if (row->mass == 0 || contact->depth < 0) {
+        continue;
+      }
+      vector_t axis = contact->axis;
+      vector_t *shift1 = &shift[row->slot1];
+      vector_t *shift2 = &shift[row->slot2];
+      double depth = contact->depth - (shift2->x - shift1->x) * axis.x -
+                     (shift2->y - shift1->y) * axis.y;
+      if (depth <= CONTACT_SLOP) {
+        continue;
+      }
+      double push = CONTACT_CORRECTION * (depth - CONTACT_SLOP) * row->mass;
+      shift1->x -= row->inv_mass1 * push * axis.x;
+      shift1->y -= row->inv_mass1 * push * axis.y;
+      shift2->x += row->inv_mass2 * push * axis.x;
+      shift2->y += row->inv_mass2 * push * axis.y;
+      largest = fmax(largest, depth - CONTACT_SLOP);
+    }
+    if (largest <= CONTACT_SLOP) {
+      break;
+    }
+  }
+  // each body moves once, however many contacts it has
+  for (size_t i = 0; i < rows; i++) {
+    contact_row_t *row = &solver->rows[i];
+    body_t *bodies[] = {row->contact->body1, row->contact->body2};
+    size_t slots[] = {row->slot1, row->slot2};
+    for (size_t b = 0; b < 2; b++) {
+      vector_t *moved = &shift[slots[b]];
+      if (moved->x != 0 || moved->y != 0) {
+        body_set_centroid(bodies[b],
+                          vec_add(body_get_centroid(bodies[b]), *moved));
+        *moved = VEC_ZERO;
+      }
+    }
+  }
+}
+
+size_t contact_solver_solve(contact_solver_t *solver, kinematics_t *kin,
+                            double dt) {
+  double fastest;
+  size_t rows = contact_solver_setup(solver, kin, dt, &fastest);
+  size_t passes = 0;
+  while (rows > 0 && passes < solver->max_iterations) {
+    passes++;
+    if (contact_solver_pass(solver, rows, passes % 2 == 0) <= solver->tolerance * fastest) {
+      break;
+    }
+  }
+  for (size_t i = 0; i < rows; i++) {
+    contact_row_t *row = &solver->rows[i];
+    if (row->impulse > 0) {
+      vector_t impulse = vec_multiply(row->impulse, row->contact->axis);
+      body_add_impulse(row->contact->body1, vec_negate(impulse));
+      body_add_impulse(row->contact->body2, impulse);
+    }
+  }
+  contact_solver_keep_impulses(solver, rows);
+  contact_solver_correct(solver, rows);
+  solver->solved = rows;
+  solver->count = 0;
+  return passes;
+}
+
+void contact_solver_arrive(contact_solver_t *solver, double dt) {
+  for (size_t i = 0; i < solver->solved; i++) {
+    contact_row_t *row = &solver->rows[i];
+    contact_t *contact = row->contact;
+    double gap = -contact->depth;
+    if (gap <= 0 || row->mass == 0 ||
+        (row->arrival == 0 && row->impulse == 0)) {
+      continue;
+    }
+    body_t *body1 = contact->body1;
+    body_t *body2 = contact->body2;
+    vector_t axis = contact->axis;
+    vector_t moved = vec_subtract(
+        vec_subtract(body_get_centroid(body2), row->start2),
+        vec_subtract(body_get_centroid(body1), row->start1));
+    double left = gap + vec_dot(moved, axis);
+    // Bodies that bounced separate only from the time of impact on; the
+    // others stop at the contact at the latest
+    double wanted = fmax(left, 0);
+    if (row->arrival > 0) {
+      double separation = vec_dot(
+          vec_subtract(body_get_velocity(body2), body_get_velocity(body1)),
+          axis);
+      wanted = fmax(separation, 0) * (dt - row->arrival);
+    }
+    vector_t push = vec_multiply((left - wanted) * row->mass, axis);
+    if (push.x != 0 || push.y != 0) {
+      body_set_centroid(body1, vec_add(body_get_centroid(body1),
+                                       vec_multiply(row->inv_mass1, push)));
+      body_set_centroid(body2, vec_subtract(body_get_centroid(body2),
+                                            vec_multiply(row->inv_mass2, push)));
+    }
+  }
+  solver->solved = 0;
+}
+
+typedef struct contact_solver_state {
+  contact_warm_t *warm;
+  size_t warm_count;
+  size_t warm_capacity;
+} contact_solver_state_t;
+
+contact_solver_state_t *contact_solver_save(contact_solver_t *solver,
+                                            contact_solver_state_t *state) {
+  if (state == NULL) {
+    state = calloc(1, sizeof(contact_solver_state_t));
+    assert(state != NULL);
+  }
+  if (state->warm_capacity < solver->warm_count + 1) {
+    state->warm_capacity = solver->warm_count + 1;
+    state->warm =
+        realloc(state->warm, sizeof(contact_warm_t) * state->warm_capacity);
+    assert(state->warm != NULL);
+  }
+  state->warm_count = solver->warm_count;
+  memcpy(state->warm, solver->warm, sizeof(contact_warm_t) * state->warm_count);
+  return state;
+}
+
+void contact_solver_restore(contact_solver_t *solver,
+                            contact_solver_state_t *state) {
+  if (solver->warm_capacity < state->warm_count) {
+    solver->warm_capacity = state->warm_count;
+    solver->warm =
+        realloc(solver->warm, sizeof(contact_warm_t) * state->warm_count);
+    assert(solver->warm != NULL);
+  }
+  memcpy(solver->warm, state->warm, sizeof(contact_warm_t) * state->warm_count);
+  solver->warm_count = state->warm_count;
+}
+
+void contact_solver_state_free(contact_solver_state_t *state) {
+  free(state->warm);
+  free(state);
+}
@@ -0,0 +1,802 @@
+#include "event_sim.h"
+#include "body.h"
+#include "list.h"
+#include "polygon.h"
+#include "vector.h"
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+const size_t INIT_SIM_BALL_COUNT = 16;
+const size_t INIT_EVENT_COUNT = 64;
+const size_t EVENT_SIM_RESIZE_FACTOR = 2;
+// how close two surfaces must be to count as touching
+const double CONTACT_TOLERANCE = 1e-6;
+// a ball-ball prediction that has not converged by then scans for the
+// contact instead
+const size_t MAX_ADVANCE_STEPS = 500;
+const size_t MAX_INVERT_STEPS = 100;
+const size_t NO_BALL = SIZE_MAX;
+
+typedef enum { EVENT_BALL, EVENT_CUSHION, EVENT_POCKET } event_kind_t;
+
+// An axis-aligned box, which rules out most predictions with a few
+// comparisons
+typedef struct sim_box {
+  vector_t low;
+  vector_t high;
+} sim_box_t;
+
+typedef struct sim_ball {
+  body_t *owner;
+  // The ball is on a leg of its path that started at origin at time start,
+  // heading along direction (a unit vector) at speed.
+  // It travels in a straight line until the next event.
+  vector_t origin;
+  vector_t direction;
+  double speed;
+  double start;
+  double slow_time; // how far into the leg the constant drag stops
+  double stop_time; // how far into the leg the ball stops
+  double slow_distance; // how far the ball has gone by slow_time
+  double stop_distance; // and by stop_time
+  // When the ball next hits a cushion or pocket. The leg ends there, so
+  // collisions with other balls only need to be searched for until then.
+  double horizon;
+  vector_t finish; // where the ball is at the horizon, or where it stops
+  sim_box_t path;  // around the segment from origin to finish
+  bool pocketed;
+  size_t version; // bumped by every event, which invalidates old predictions
+} sim_ball_t;
+
+typedef struct sim_event {
+  double time;
+  event_kind_t kind;
+  size_t ball;
+  size_t other; // a ball, cushion edge or pocket index, depending on kind
+  size_t version;
+  size_t other_version; // only for EVENT_BALL
+} sim_event_t;
+
+// A side of a cushion, kept apart from the outline so predictions need no
+// normalizing
+typedef struct sim_edge {
+  vector_t start;
+  vector_t edge; // from start to the next vertex
+  vector_t normal; // a unit vector, or 0 if the edge has no length
+  double length2; // the squared length of the edge
+  sim_box_t bounds;
+} sim_edge_t;
+
+typedef struct sim_pocket {
+  vector_t center;
+  double radius;
+} sim_pocket_t;
+
+typedef struct event_sim {
+  event_sim_params_t params;
+  double decay;  // drag / mass, the rate speeds decay at
+  double offset; // constant_drag / drag
+  sim_ball_t *balls;
+  size_t ball_count;
+  size_t ball_capacity;
+  sim_edge_t *edges;
+  size_t edge_count;
+  size_t edge_capacity;
+  list_t *pockets;  // sim_pocket_t *
+  sim_event_t *events; // binary min-heap on time
+  size_t event_count;
+  size_t event_capacity;
+  double time;
+  bool started;
+} event_sim_t;
+
+event_sim_t *event_sim_init(event_sim_params_t params) {
+  assert(params.drag > 0 && params.ball_mass > 0 && params.ball_radius > 0);
+  event_sim_t *sim = malloc(sizeof(event_sim_t));
+  assert(sim != NULL);
+  sim->params = params;
+  sim->decay = params.drag / params.ball_mass;
+  sim->offset = params.constant_drag / params.drag;
+  sim->balls = malloc(sizeof(sim_ball_t) * INIT_SIM_BALL_COUNT);
+  sim->events = malloc(sizeof(sim_event_t) * INIT_EVENT_COUNT);
+  sim->edges = malloc(sizeof(sim_edge_t) * INIT_SIM_BALL_COUNT);
+  assert(sim->balls != NULL && sim->events != NULL && sim->edges != NULL);
+  sim->edge_count = 0;
+  sim->edge_capacity = INIT_SIM_BALL_COUNT;
+  sim->ball_count = sim->event_count = 0;
+  sim->ball_capacity = INIT_SIM_BALL_COUNT;
+  sim->event_capacity = INIT_EVENT_COUNT;
+  sim->pockets = list_init(INIT_SIM_BALL_COUNT, free);
+  sim->time = 0;
+  sim->started = false;
+  return sim;
+}
+
+void event_sim_free(event_sim_t *sim) {
+  free(sim->balls);
+  free(sim->events);
+  free(sim->edges);
+  list_free(sim->pockets);
+  free(sim);
+}
+
+//------------------------------ Motion ----------------------------------------
+
+// Starts a new leg; the speed then follows
+//   s' = -decay * (s + offset)  while s >= constant_drag_min_speed,
+//   s' = -decay * s             below it,
+// until it drops to stop_speed.
+void set_leg(event_sim_t *sim, sim_ball_t *ball, vector_t position,
+             vector_t velocity, double time) {
+  double speed = vec_magnitude(velocity);
+  ball->origin = position;
+  ball->start = time;
+  ball->slow_time = ball->stop_time = 0;
+  ball->slow_distance = ball->stop_distance = 0;
+  if (speed <= sim->params.stop_speed) {
+    ball->speed = 0;
+    ball->direction = VEC_ZERO;
+    return;
+  }
+  ball->speed = speed;
+  ball->direction = vec_multiply(1 / speed, velocity);
+  double min_speed = sim->params.constant_drag_min_speed;
+  if (speed > min_speed) {
+    ball->slow_time =
+        log((speed + sim->offset) / (min_speed + sim->offset)) / sim->decay;
+  }
+  double slow_speed = fmin(speed, min_speed);
+  ball->slow_distance = -(speed + sim->offset) *
+                            expm1(-sim->decay * ball->slow_time) / sim->decay -
+                        sim->offset * ball->slow_time;
+  ball->stop_time = ball->slow_time;
+  ball->stop_distance = ball->slow_distance;
+  if (slow_speed > sim->params.stop_speed) {
+    ball->stop_time += log(slow_speed / sim->params.stop_speed) / sim->decay;
+    ball->stop_distance += (slow_speed - sim->params.stop_speed) / sim->decay;
+  }
+}
+
+// Where the ball is t seconds into the current leg.
+// The distance and speed share one exponential, since the pair predictions
+// ask for both at every step.
+typedef struct leg_motion {
+  double distance; // covered since the start of the leg
+  double speed;
+  double slowing; // how fast the speed drops
+} leg_motion_t;
+
+leg_motion_t leg_motion(event_sim_t *sim, sim_ball_t *ball, double t) {
+  if (t >= ball->stop_time) {
+    return (leg_motion_t){ball->stop_distance, 0, 0};
+  }
+  double decay = sim->decay;
+  if (t < ball->slow_time) {
+    double base = ball->speed + sim->offset;
+    double change = expm1(-decay * t);
+    double speed = ball->speed + base * change;
+    return (leg_motion_t){-base * change / decay - sim->offset * t, speed,
+                          decay * base * (1 + change)};
+  }
+  double slow_speed = fmin(ball->speed, sim->params.constant_drag_min_speed);
+  double change = expm1(-decay * (t - ball->slow_time));
+  double speed = slow_speed * (1 + change);
+  return (leg_motion_t){ball->slow_distance - slow_speed * change / decay,
+                        speed, decay * speed};
+}
+
+double leg_speed(event_sim_t *sim, sim_ball_t *ball, double t) {
+  return leg_motion(sim, ball, t).speed;
+}
+
+double leg_distance(event_sim_t *sim, sim_ball_t *ball, double t) {
+  return leg_motion(sim, ball, t).distance;
+}
+
+// The first time after t that the ball's constant drag stops or it comes to
+// rest, or INFINITY
+double leg_breakpoint(sim_ball_t *ball, double t) {
+  if (t < ball->start + ball->slow_time) {
+    return ball->start + ball->slow_time;
+  }
+  if (t < ball->start + ball->stop_time) {
+    return ball->start + ball->stop_time;
+  }
+  return INFINITY;
+}
+
+// How far into the current leg the ball has covered distance.
+// The distance is increasing, so Newton's method with bisection as a
+// fallback converges in a few steps.
+double leg_time_at(event_sim_t *sim, sim_ball_t *ball, double distance) {
+  double low = 0;
+  double high = ball->stop_time;
+  double t = fmin(distance / ball->speed, high);
+  for (size_t i = 0; i < MAX_INVERT_STEPS; i++) {
+    leg_motion_t motion = leg_motion(sim, ball, t);
+    double error = motion.distance - distance;
+    if (fabs(error) < CONTACT_TOLERANCE) {
+      break;
+    }
+    if (error > 0) {
+      high = t;
+    } else {
+      low = t;
+    }
+    double next = motion.speed > 0 ? t - error / motion.speed : low;
+    t = next > low && next < high ? next : (low + high) / 2;
+  }
+  return t;
+}
+
+vector_t ball_position(event_sim_t *sim, sim_ball_t *ball, double time) {
+  double distance = leg_distance(sim, ball, time - ball->start);
+  return vec_add(ball->origin, vec_multiply(distance, ball->direction));
+}
+
+vector_t ball_velocity(event_sim_t *sim, sim_ball_t *ball, double time) {
+  return vec_multiply(leg_speed(sim, ball, time - ball->start),
+                      ball->direction);
+}
+
+double ball_stop(sim_ball_t *ball) { return ball->start + ball->stop_time; }
+
+// The distance travelled between two times on the current leg
+double ball_travel(event_sim_t *sim, sim_ball_t *ball, double from,
+                   double to) {
+  return leg_distance(sim, ball, to - ball->start) -
+         leg_distance(sim, ball, from - ball->start);
+}
+
+//---------------------------- Event queue -------------------------------------
+
+void event_swap(sim_event_t *events, size_t i, size_t j) {
+  sim_event_t temp = events[i];
+  events[i] = events[j];
+  events[j] = temp;
+}
+
+void push_event(event_sim_t *sim, sim_event_t event) {
+  if (sim->event_count >= sim->event_capacity) {
+    sim->event_capacity *= EVENT_SIM_RESIZE_FACTOR;
+    sim->events =
+        realloc(sim->events, sizeof(sim_event_t) * sim->event_capacity);
+    assert(sim->events != NULL);
+  }
+  size_t i = sim->event_count++;
+  sim->events[i] = event;
+  while (i > 0 && sim->events[(i - 1) / 2].time > sim->events[i].time) {
+    event_swap(sim->events, i, (i - 1) / 2);
+    i = (i - 1) / 2;
+  }
+}
+
+sim_event_t pop_event(event_sim_t *sim) {
+  sim_event_t first = sim->events[0];
+  sim->events[0] = sim->events[--sim->event_count];
+  size_t i = 0;
+  while (true) {
+    size_t smallest = i;
+    for (size_t child = 2 * i + 1; child <= 2 * i + 2; child++) {
+      if (child < sim->event_count &&
+          sim->events[child].time < sim->events[smallest].time) {
+        smallest = child;
+      }
+    }
+    if (smallest == i) {
+      return first;
+    }
+    event_swap(sim->events, i, smallest);
+    i = smallest;
+  }
+}
+
+bool event_is_stale(event_sim_t *sim, sim_event_t *event) {
+  sim_ball_t *ball = &sim->balls[event->ball];
+  if (ball->pocketed || ball->version != event->version) {
+    return true;
+  }
+  if (event->kind != EVENT_BALL) {
+    return false;
+  }
+  sim_ball_t *other = &sim->balls[event->other];
+  return other->pocketed || other->version != event->other_version;
+}
+
+//---------------------------- Predictions -------------------------------------
+
+// The predictions run for every ball or pair after every event, so they
+// spell out their vector arithmetic rather than calling into vector.c.
+
+// The box around a segment, grown by margin on every side
+sim_box_t segment_box(vector_t start, vector_t end, double margin) {
+  return (sim_box_t){{fmin(start.x, end.x) - margin,
+                      fmin(start.y, end.y) - margin},
+                     {fmax(start.x, end.x) + margin,
+                      fmax(start.y, end.y) + margin}};
+}
+
+bool boxes_overlap(sim_box_t *box1, sim_box_t *box2) {
+  return box1->low.x <= box2->high.x && box2->low.x <= box1->high.x &&
+         box1->low.y <= box2->high.y && box2->low.y <= box1->high.y;
+}
+
+bool box_contains(sim_box_t *box, vector_t point, double margin) {
+  return point.x >= box->low.x - margin && point.x <= box->high.x + margin &&
+         point.y >= box->low.y - margin && point.y <= box->high.y + margin;
+}
+
+// How far a circle moving along a unit direction travels before it touches
+// a point at distance reach while moving towards it, or INFINITY
+double point_distance(vector_t center, vector_t direction, vector_t point,
+                      double reach) {
+  double bx = point.x - center.x;
+  double by = point.y - center.y;
+  double along = bx * direction.x + by * direction.y;
+  if (along <= 0) {
+    return INFINITY;
+  }
+  double discriminant = along * along - (bx * bx + by * by - reach * reach);
+  if (discriminant < 0) {
+    return INFINITY;
+  }
+  double distance = along - sqrt(discriminant);
+  return distance > 0 ? distance : 0;
+}
+
+// Like point_distance(), against the flat side of a cushion edge
+double edge_distance(vector_t center, vector_t direction, double radius,
+                     sim_edge_t *edge) {
+  if (edge->length2 == 0) {
+    return INFINITY;
+  }
+  double ox = center.x - edge->start.x;
+  double oy = center.y - edge->start.y;
+  vector_t normal = edge->normal;
+  double gap = ox * normal.x + oy * normal.y;
+  if (gap < 0) {
+    normal = (vector_t){-normal.x, -normal.y};
+    gap = -gap;
+  }
+  double approach = -(direction.x * normal.x + direction.y * normal.y);
+  if (approach <= 0 || gap < radius - CONTACT_TOLERANCE) {
+    return INFINITY;
+  }
+  double distance = gap > radius ? (gap - radius) / approach : 0;
+  double cx = ox + distance * direction.x;
+  double cy = oy + distance * direction.y;
+  double along = (cx * edge->edge.x + cy * edge->edge.y) / edge->length2;
+  return along >= 0 && along <= 1 ? distance : INFINITY;
+}
+
+// Converts a distance ahead of the ball into the time it gets there
+double time_at_distance_ahead(event_sim_t *sim, sim_ball_t *ball, double now,
+                              double ahead) {
+  double covered = leg_distance(sim, ball, now - ball->start);
+  return ball->start + leg_time_at(sim, ball, covered + ahead);
+}
+
+void set_finish(sim_ball_t *ball, vector_t finish, double radius) {
+  ball->finish = finish;
+  // half the tolerance on each ball keeps touching pairs' boxes overlapping
+  ball->path =
+      segment_box(ball->origin, finish, radius + CONTACT_TOLERANCE / 2);
+}
+
+void predict_table(event_sim_t *sim, size_t index, double now) {
+  sim_ball_t *ball = &sim->balls[index];
+  double radius = sim->params.ball_radius;
+  double margin = radius + CONTACT_TOLERANCE;
+  ball->horizon = INFINITY;
+  set_finish(ball, ball_position(sim, ball, ball_stop(ball)), radius);
+  if (ball_stop(ball) <= now) {
+    return;
+  }
+  vector_t center = ball_position(sim, ball, now);
+  double remaining = ball_travel(sim, ball, now, ball_stop(ball));
+  sim_box_t reach = segment_box(center, ball->finish, margin);
+  sim_event_t event = {.ball = index, .version = ball->version};
+  double nearest = INFINITY;
+  for (size_t i = 0; i < sim->edge_count; i++) {
+    sim_edge_t *edge = &sim->edges[i];
+    if (!boxes_overlap(&reach, &edge->bounds)) {
+      continue;
+    }
+    double distance =
+        fmin(point_distance(center, ball->direction, edge->start, radius),
+             edge_distance(center, ball->direction, radius, edge));
+    if (distance < nearest) {
+      nearest = distance;
+      event.kind = EVENT_CUSHION;
+      event.other = i;
+    }
+  }
+  for (size_t i = 0; i < list_size(sim->pockets); i++) {
+    sim_pocket_t *pocket = list_get(sim->pockets, i);
+    if (!box_contains(&reach, pocket->center, pocket->radius)) {
+      continue;
+    }
+    double distance = point_distance(center, ball->direction, pocket->center,
+                                     radius + pocket->radius);
+    if (distance < nearest) {
+      nearest = distance;
+      event.kind = EVENT_POCKET;
+      event.other = i;
+    }
+  }
+  if (nearest <= remaining) {
+    event.time = time_at_distance_ahead(sim, ball, now, nearest);
+    ball->horizon = event.time;
+    set_finish(ball, vec_add(center, vec_multiply(nearest, ball->direction)),
+               radius);
+    push_event(sim, event);
+  }
+}
+
+// The squared distance from a point to a segment
+double point_segment_distance2(vector_t point, vector_t start, vector_t end) {
+  double dx = end.x - start.x;
+  double dy = end.y - start.y;
+  double ox = point.x - start.x;
+  double oy = point.y - start.y;
+  double length = dx * dx + dy * dy;
+  double along = length == 0 ? 0 : (ox * dx + oy * dy) / length;
+  along = along < 0 ? 0 : (along > 1 ? 1 : along);
+  ox -= along * dx;
+  oy -= along * dy;
+  return ox * ox + oy * oy;
+}
+
+// The squared distance between two segments, so the closest two balls'
+// centers come if each only moves along its own
+double path_distance2(vector_t start1, vector_t end1, vector_t start2,
+                      vector_t end2) {
+  double dx1 = end1.x - start1.x;
+  double dy1 = end1.y - start1.y;
+  double dx2 = end2.x - start2.x;
+  double dy2 = end2.y - start2.y;
+  double denominator = dx1 * dy2 - dy1 * dx2;
+  if (denominator != 0) {
+    double bx = start2.x - start1.x;
+    double by = start2.y - start1.y;
+    double along1 = (bx * dy2 - by * dx2) / denominator;
+    double along2 = (bx * dy1 - by * dx1) / denominator;
+    if (along1 >= 0 && along1 <= 1 && along2 >= 0 && along2 <= 1) {
+      return 0;
+    }
+  }
+  double closest = point_segment_distance2(start1, start2, end2);
+  double other = point_segment_distance2(end1, start2, end2);
+  closest = other < closest ? other : closest;
+  other = point_segment_distance2(start2, start1, end1);
+  closest = other < closest ? other : closest;
+  other = point_segment_distance2(end2, start1, end1);
+  return other < closest ? other : closest;
+}
+
+// The gap between two balls' surfaces at a time, how fast it grows, and
+// the most that rate can drop per second until the next breakpoint
+typedef struct pair_gap {
+  double gap;
+  double rate;
+  double curvature;
+} pair_gap_t;
+
+// Both balls slow down along straight lines by the same exponential factor
+// between breakpoints, so their relative acceleration only shrinks there
+// and its size now bounds how fast the rate can drop. (The rate drops by
+// at most the relative acceleration, since turning around each other only
+// pushes the surfaces apart.)
+pair_gap_t pair_gap(event_sim_t *sim, sim_ball_t *ball1, sim_ball_t *ball2,
+                    double time) {
+  leg_motion_t motion1 = leg_motion(sim, ball1, time - ball1->start);
+  leg_motion_t motion2 = leg_motion(sim, ball2, time - ball2->start);
+  vector_t d1 = ball1->direction;
+  vector_t d2 = ball2->direction;
+  double bx = ball2->origin.x + motion2.distance * d2.x - ball1->origin.x -
+              motion1.distance * d1.x;
+  double by = ball2->origin.y + motion2.distance * d2.y - ball1->origin.y -
+              motion1.distance * d1.y;
+  double between = sqrt(bx * bx + by * by);
+  double vx = motion2.speed * d2.x - motion1.speed * d1.x;
+  double vy = motion2.speed * d2.y - motion1.speed * d1.y;
+  double ax = motion2.slowing * d2.x - motion1.slowing * d1.x;
+  double ay = motion2.slowing * d2.y - motion1.slowing * d1.y;
+  return (pair_gap_t){between - 2 * sim->params.ball_radius,
+                      (vx * bx + vy * by) / between, sqrt(ax * ax + ay * ay)};
+}
+
+// How long the gap is sure to stay above zero: the smallest positive root
+// of gap + rate * h - curvature * h^2 / 2, or INFINITY
+double safe_advance(pair_gap_t pair) {
+  double gap = fmax(pair.gap, CONTACT_TOLERANCE);
+  if (pair.curvature == 0) {
+    return pair.rate < 0 ? gap / -pair.rate : INFINITY;
+  }
+  double root = sqrt(pair.rate * pair.rate + 2 * pair.curvature * gap);
+  // the two forms avoid cancellation for either sign of the rate
+  return pair.rate < 0 ? 2 * gap / (root - pair.rate)
+                       : (pair.rate + root) / pair.curvature;
+}
+
+// Only reached if the advancing steps keep shrinking: scans the rest of the
+// interval for the balls overlapping and bisects back to the contact, so a
+// collision is never dropped
+void bisect_pair(event_sim_t *sim, size_t index1, size_t index2, double from,
+                 double end) {
+  sim_ball_t *ball1 = &sim->balls[index1];
+  sim_ball_t *ball2 = &sim->balls[index2];
+  double low = from;
+  double high = from;
+  double step = (end - from) / MAX_ADVANCE_STEPS;
+  for (size_t i = 1; i <= MAX_ADVANCE_STEPS; i++) {
+    high = from + i * step;
+    if (pair_gap(sim, ball1, ball2, high).gap <= 0) {
+      break;
+    }
+    low = high;
+  }
+  if (low == high) {
+    return;
+  }
+  for (size_t i = 0; i < MAX_INVERT_STEPS; i++) {
+    double gap = pair_gap(sim, ball1, ball2, low).gap;
+    if (gap <= CONTACT_TOLERANCE) {
+      break;
+    }
+    double middle = (low + high) / 2;
+    if (pair_gap(sim, ball1, ball2, middle).gap <= 0) {
+      high = middle;
+    } else {
+      low = middle;
+    }
+  }
+  push_event(sim, (sim_event_t){low, EVENT_BALL, index1, index2,
+                                ball1->version, ball2->version});
+}
+
+// Advances to the first contact with steps that can never pass it: the gap
+// stays above the parabola from pair_gap() until the next breakpoint.
+// Steps shrink quadratically onto a contact, and balls that graze or roll
+// side by side are crossed in a few steps.
+void predict_pair(event_sim_t *sim, size_t index1, size_t index2, double now) {
+  sim_ball_t *ball1 = &sim->balls[index1];
+  sim_ball_t *ball2 = &sim->balls[index2];
+  double end = fmin(fmax(ball_stop(ball1), ball_stop(ball2)),
+                    fmin(ball1->horizon, ball2->horizon));
+  if (end <= now) {
+    return;
+  }
+  // until the end each ball stays on its leg's segment to its finish
+  if (!boxes_overlap(&ball1->path, &ball2->path)) {
+    return;
+  }
+  double reach = 2 * sim->params.ball_radius + CONTACT_TOLERANCE;
+  if (path_distance2(ball1->origin, ball1->finish, ball2->origin,
+                     ball2->finish) > reach * reach) {
+    return;
+  }
+  double t = now;
+  for (size_t i = 0; i < MAX_ADVANCE_STEPS; i++) {
+    pair_gap_t pair = pair_gap(sim, ball1, ball2, t);
+    if (pair.gap <= CONTACT_TOLERANCE && pair.rate < 0) {
+      push_event(sim, (sim_event_t){t, EVENT_BALL, index1, index2,
+                                    ball1->version, ball2->version});
+      return;
+    }
+    double breakpoint =
+        fmin(leg_breakpoint(ball1, t), leg_breakpoint(ball2, t));
+    double next = t + safe_advance(pair);
+    if (next >= breakpoint) {
+      next = breakpoint;
+    }
+    if (next > end) {
+      return;
+    }
+    t = next;
+  }
+  bisect_pair(sim, index1, index2, t, end);
+}
+
+// Predicts collisions with every other ball except skip.
+// The horizons must be up to date, so predict_table() comes first.
+void predict_pairs(event_sim_t *sim, size_t index, double now, size_t skip) {
+  for (size_t i = 0; i < sim->ball_count; i++) {
+    if (i != index && i != skip && !sim->balls[i].pocketed) {
+      predict_pair(sim, index, i, now);
+    }
+  }
+}
+
+//------------------------------ Responses -------------------------------------
+
+void collide_balls(event_sim_t *sim, sim_event_t *event) {
+  double t = event->time;
+  sim_ball_t *ball1 = &sim->balls[event->ball];
+  sim_ball_t *ball2 = &sim->balls[event->other];
+  vector_t position1 = ball_position(sim, ball1, t);
+  vector_t position2 = ball_position(sim, ball2, t);
+  vector_t velocity1 = ball_velocity(sim, ball1, t);
+  vector_t velocity2 = ball_velocity(sim, ball2, t);
+  // the same impulse as elastic_collision() along the line of centers
+  vector_t axis = vec_unit(vec_subtract(position2, position1));
+  double ua = vec_dot(velocity1, axis);
+  double ub = vec_dot(velocity2, axis);
+  if (ub - ua < 0) {
+    double mass = sim->params.ball_mass;
+    double mu = mass / 2;
+    vector_t dv = vec_multiply(
+        (1 + sim->params.ball_elasticity) * mu * (ub - ua) / mass, axis);
+    velocity1 = vec_add(velocity1, dv);
+    velocity2 = vec_subtract(velocity2, dv);
+  }
+  set_leg(sim, ball1, position1, velocity1, t);
+  set_leg(sim, ball2, position2, velocity2, t);
+  ball1->version++;
+  ball2->version++;
+  predict_table(sim, event->ball, t);
+  predict_table(sim, event->other, t);
+  predict_pairs(sim, event->ball, t, NO_BALL);
+  predict_pairs(sim, event->other, t, event->ball);
+}
+
+void collide_cushion(event_sim_t *sim, sim_event_t *event) {
+  double t = event->time;
+  sim_ball_t *ball = &sim->balls[event->ball];
+  vector_t position = ball_position(sim, ball, t);
+  vector_t velocity = ball_velocity(sim, ball, t);
+  // the ball touches the edge's side or one of its ends, whichever is closer
+  sim_edge_t *edge = &sim->edges[event->other];
+  vector_t offset = vec_subtract(position, edge->start);
+  double along =
+      edge->length2 == 0 ? 0 : vec_dot(offset, edge->edge) / edge->length2;
+  along = along < 0 ? 0 : (along > 1 ? 1 : along);
+  vector_t touch = vec_add(edge->start, vec_multiply(along, edge->edge));
+  vector_t axis = vec_unit(vec_subtract(touch, position));
+  double into = vec_dot(velocity, axis);
+  if (into > 0) {
+    velocity = vec_subtract(
+        velocity,
+        vec_multiply((1 + sim->params.cushion_elasticity) * into, axis));
+  }
+  set_leg(sim, ball, position, velocity, t);
+  ball->version++;
+  predict_table(sim, event->ball, t);
+  predict_pairs(sim, event->ball, t, NO_BALL);
+}
+
+void sink_ball(event_sim_t *sim, sim_event_t *event) {
+  sim_ball_t *ball = &sim->balls[event->ball];
+  set_leg(sim, ball, ball_position(sim, ball, event->time), VEC_ZERO,
+          event->time);
+  ball->pocketed = true;
+  ball->version++;
+}
+
+//------------------------------- Public ---------------------------------------
+
+size_t event_sim_add_ball(event_sim_t *sim, body_t *owner, vector_t center,
+                          vector_t velocity) {
+  assert(!sim->started);
+  if (sim->ball_count >= sim->ball_capacity) {
+    sim->ball_capacity *= EVENT_SIM_RESIZE_FACTOR;
+    sim->balls = realloc(sim->balls, sizeof(sim_ball_t) * sim->ball_capacity);
+    assert(sim->balls != NULL);
+  }
+  sim_ball_t *ball = &sim->balls[sim->ball_count];
+  ball->owner = owner;
+  ball->pocketed = false;
+  ball->horizon = INFINITY;
+  ball->version = 0;
+  set_leg(sim, ball, center, velocity, 0);
+  return sim->ball_count++;
+}
+
+void event_sim_add_cushion(event_sim_t *sim, polygon_t *shape) {
+  assert(!sim->started);
+  size_t n_edges = polygon_size(shape);
+  vector_t *vertices = polygon_vertices(shape);
+  for (size_t i = 0; i < n_edges; i++) {
+    if (sim->edge_count >= sim->edge_capacity) {
+      sim->edge_capacity *= EVENT_SIM_RESIZE_FACTOR;
+      sim->edges =
+          realloc(sim->edges, sizeof(sim_edge_t) * sim->edge_capacity);
+      assert(sim->edges != NULL);
+    }
+    vector_t edge = vec_subtract(vertices[(i + 1) % n_edges], vertices[i]);
+    double length2 = vec_dot(edge, edge);
+    vector_t normal =
+        length2 == 0 ? VEC_ZERO : vec_unit((vector_t){-edge.y, edge.x});
+    sim->edges[sim->edge_count++] = (sim_edge_t){
+        vertices[i], edge, normal, length2,
+        segment_box(vertices[i], vec_add(vertices[i], edge), 0)};
+  }
+}
+
+void event_sim_add_pocket(event_sim_t *sim, vector_t center, double radius) {
+  assert(!sim->started);
+  sim_pocket_t *pocket = malloc(sizeof(sim_pocket_t));
+  assert(pocket != NULL);
+  *pocket = (sim_pocket_t){center, radius};
+  list_add(sim->pockets, pocket);
+}
+
+size_t event_sim_run(event_sim_t *sim, double max_time) {
+  if (!sim->started) {
+    sim->started = true;
+    for (size_t i = 0; i < sim->ball_count; i++) {
+      predict_table(sim, i, 0);
+    }
+    for (size_t i = 0; i < sim->ball_count; i++) {
+      for (size_t j = i + 1; j < sim->ball_count; j++) {
+        predict_pair(sim, i, j, 0);
+      }
+    }
+  }
+  size_t processed = 0;
+  while (sim->event_count > 0 && sim->events[0].time <= max_time) {
+    sim_event_t event = pop_event(sim);
+    if (event_is_stale(sim, &event)) {
+      continue;
+    }
+    if (event.kind == EVENT_BALL) {
+      collide_balls(sim, &event);
+    } else if (event.kind == EVENT_CUSHION) {
+      collide_cushion(sim, &event);
+    } else {
+      sink_ball(sim, &event);
+    }
+    processed++;
+  }
+  double end = 0;
+  for (size_t i = 0; i < sim->ball_count; i++) {
+    end = fmax(end, ball_stop(&sim->balls[i]));
+  }
+  sim->time = fmin(end, max_time);
+  return processed;
+}
+
+double event_sim_time(event_sim_t *sim) { return sim->time; }
+
+bool event_sim_settled(event_sim_t *sim) {
+  for (size_t i = 0; i < sim->ball_count; i++) {
+    if (ball_stop(&sim->balls[i]) > sim->time) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t event_sim_balls(event_sim_t *sim) { return sim->ball_count; }
+
+vector_t event_sim_ball_position(event_sim_t *sim, size_t index) {
+  assert(index < sim->ball_count);
+  return ball_position(sim, &sim->balls[index], sim->time);
+}
+
+vector_t event_sim_ball_velocity(event_sim_t *sim, size_t index) {
+  assert(index < sim->ball_count);
+  return ball_velocity(sim, &sim->balls[index], sim->time);
+}
+
+bool event_sim_ball_pocketed(event_sim_t *sim, size_t index) {
+  assert(index < sim->ball_count);
+  return sim->balls[index].pocketed;
+}
+
+void event_sim_apply(event_sim_t *sim) {
+  for (size_t i = 0; i < sim->ball_count; i++) {
+    body_t *owner = sim->balls[i].owner;
+    if (owner == NULL) {
+      continue;
+    }
+    if (sim->balls[i].pocketed) {
+      body_remove(owner);
+    } else {
+      body_set_centroid(owner, event_sim_ball_position(sim, i));
+      body_set_velocity(owner, event_sim_ball_velocity(sim, i));
+    }
+  }
+}
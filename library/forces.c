@@ -1,10 +1,11 @@
 #include "forces.h"
 #include "body.h"
 #include "collision.h"
+#include "contact.h"
 #include "list.h"
 #include "polygon.h"
 #include "scene.h"
-#include "sdl_wrapper.h"
+#include "slab.h"
 #include "vector.h"
 #include <assert.h>
 #include <math.h>
@@ -15,6 +16,22 @@
 const double GRAVITY_THRESHOLD = 5;
 const double ZERO = 0;
 const double VEL_THRESH = 0.1;
+const size_t FORCE_PARAMS_PER_PAGE = 64;
+
+// Force creators come and go with every shot, so their aux parameters are
+// recycled through one slab per parameter type and thread
+_Thread_local slab_t *two_body_params_slab = NULL;
+_Thread_local slab_t *collision_params_slab = NULL;
+_Thread_local slab_t *chaos_collision_params_slab = NULL;
+_Thread_local slab_t *elasticity_slab = NULL;
+_Thread_local slab_t *contact_params_slab = NULL;
+
+slab_t *force_params_slab(slab_t **slab, const char *name, size_t size) {
+  if (*slab == NULL) {
+    *slab = slab_init(name, size, FORCE_PARAMS_PER_PAGE);
+  }
+  return *slab;
+}
 
 typedef struct two_body_params {
   body_t *body1;
@@ -22,6 +39,19 @@ typedef struct two_body_params {
   double constant;
 } two_body_params_t;
 
+two_body_params_t *two_body_params_init(body_t *body1, body_t *body2,
+                                        double constant) {
+  two_body_params_t *aux =
+      slab_alloc(force_params_slab(&two_body_params_slab, "two_body_params",
+                                   sizeof(two_body_params_t)));
+  *aux = (two_body_params_t){body1, body2, constant};
+  return aux;
+}
+
+void two_body_params_free(two_body_params_t *aux) {
+  slab_release(aux);
+}
+
 void newtonian_gravity(two_body_params_t *aux) {
   vector_t r21 = vec_subtract(body_get_centroid(aux->body2),
                               body_get_centroid(aux->body1));
@@ -38,16 +68,18 @@ void newtonian_gravity(two_body_params_t *aux) {
 
 void create_newtonian_gravity(scene_t *scene, double G, body_t *body1,
                               body_t *body2) {
-  two_body_params_t *aux = malloc(sizeof(two_body_params_t));
-  assert(aux != NULL);
-  *aux = (two_body_params_t){body1, body2, G};
+  two_body_params_t *aux = two_body_params_init(body1, body2, G);
   // scene_add_force_creator(scene, (force_creator_t)newtonian_gravity, aux,
   // free);
   list_t *bodies = list_init(2, NULL);
   list_add(bodies, body1);
   list_add(bodies, body2);
-  scene_add_bodies_force_creator(scene, (force_creator_t)newtonian_gravity,
-                                 aux, bodies, free);
+  scene_add_pure_force_creator(scene, (force_creator_t)newtonian_gravity, aux,
+                               bodies, (free_func_t)two_body_params_free);
+}
+
+void create_mutual_gravity(scene_t *scene, double G, double theta) {
+  scene_set_gravity(scene, gravity_init(G, theta, GRAVITY_THRESHOLD));
 }
 
 //------------------------------------------------------------------------------
@@ -60,114 +92,121 @@ void elastic_force(two_body_params_t *aux) {
 }
 
 void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2) {
-  two_body_params_t *aux = malloc(sizeof(two_body_params_t));
-  assert(aux != NULL);
-  *aux = (two_body_params_t){body1, body2, k};
+  two_body_params_t *aux = two_body_params_init(body1, body2, k);
   list_t *bodies = list_init(2, NULL);
   list_add(bodies, body1);
   list_add(bodies, body2);
-  scene_add_bodies_force_creator(scene, (force_creator_t)elastic_force,
-                                 aux, bodies, free);
+  scene_add_pure_force_creator(scene, (force_creator_t)elastic_force, aux,
+                               bodies, (free_func_t)two_body_params_free);
 }
 
 //------------------------------------------------------------------------------
 
-typedef struct drag_params {
-  body_t *body;
-  double gamma;
-} drag_params_t;
-
-void drag(drag_params_t *aux) {
-  vector_t vel = body_get_velocity(aux->body);
-  body_add_force(aux->body, vec_multiply(-(aux->gamma), vel));
-}
+// Drags are field forces: scene_tick() applies all of them in one loop
 
 void create_drag(scene_t *scene, double gamma, body_t *body) {
-  drag_params_t *aux = malloc(sizeof(drag_params_t));
-  assert(aux != NULL);
-  *aux = (drag_params_t){body, gamma};
-  list_t *bodies = list_init(1, NULL);
-  list_add(bodies, body);
-  scene_add_bodies_force_creator(scene, (force_creator_t)drag, aux, bodies, free);
+  body_add_drag(body, gamma);
 }
 
-void constant_drag(drag_params_t *aux) {
-  vector_t vel = body_get_velocity(aux->body);
-  if (vec_magnitude(vel) >= VEL_THRESH) {
-    body_add_force(aux->body, vec_multiply(-aux->gamma, vec_unit(vel)));
-  }
+void create_constant_drag_force(scene_t *scene, double force, body_t *body) {
+  body_add_constant_drag(body, force);
+  body_set_constant_drag_min_speed(body, VEL_THRESH);
 }
 
-void create_constant_drag_force(scene_t *scene, double force, body_t *body) {
-  drag_params_t *aux = malloc(sizeof(drag_params_t));
-  assert(aux != NULL);
-  *aux = (drag_params_t){body, force};
-  // scene_add_force_creator(scene, (force_creator_t)drag, aux, free);
-  list_t *bodies = list_init(1, NULL);
-  list_add(bodies, body);
-  scene_add_bodies_force_creator(scene, (force_creator_t)constant_drag,
-                                   aux, bodies, free);
+void create_uniform_gravity(scene_t *scene, vector_t acceleration,
+                            body_t *body) {
+  body_add_gravity(body, acceleration);
 }
 
 //-----------------------------------------------------------------------------
 
 void destroy_upon_collision(two_body_params_t *aux) {
-  list_t *shape1 = body_get_shape(aux->body1);
-  list_t *shape2 = body_get_shape(aux->body2);
-  if (find_collision(shape1, shape2).collided) {
+  if (find_body_collision(aux->body1, aux->body2).collided) {
     body_remove(aux->body1);
     body_remove(aux->body2);
-    free(shape1);
-    free(shape2);
   }
 }
 
 void create_destructive_collision(scene_t *scene, body_t *body1,
                                   body_t *body2) {
-  two_body_params_t *aux = malloc(sizeof(two_body_params_t));
-  assert(aux != NULL);
-  *aux = (two_body_params_t){body1, body2, ZERO};
+  two_body_params_t *aux = two_body_params_init(body1, body2, ZERO);
   list_t *bodies = list_init(2, NULL);
   list_add(bodies, body1);
   list_add(bodies, body2);
   scene_add_bodies_force_creator(scene, (force_creator_t)destroy_upon_collision,
-                                 aux, bodies, free);
+                                 aux, bodies,
+                                 (free_func_t)two_body_params_free);
 }
 
 //------------------------------------------------------------------------------
 
-//minimum number of ticks before next collision detection
-const size_t COLLISION_COOLDOWN = 6; 
-
 typedef struct collision_params {
   body_t *body1;
   body_t *body2;
   collision_handler_t handler;
   void *aux;
   free_func_t freer;
-  size_t previously_collided;
+  bool touching; // as of the last tick
 } collision_params_t;
 
+typedef struct contact_params {
+  scene_t *scene;
+  body_t *body1;
+  body_t *body2;
+  double elasticity;
+} contact_params_t;
+
+// Chaos collisions subscribe to the scene's collision events, so the
+// pipeline decides when they fire and no narrowphase runs here
 typedef struct chaos_collision_params {
+  scene_t *scene;
   body_t *body1;
   body_t *body2;
   body_t *body3;
   collision_handler_t handler;
   void *aux;
   free_func_t freer;
-  size_t previously_collided;
 } chaos_collision_params_t;
 
+// Also frees the handler's aux, which the params own
+void collision_params_free(collision_params_t *params) {
+  if (params->freer != NULL) {
+    params->freer(params->aux);
+  }
+  slab_release(params);
+}
+
+void chaos_collision_params_free(chaos_collision_params_t *params) {
+  if (params->freer != NULL) {
+    params->freer(params->aux);
+  }
+  slab_release(params);
+}
+
+double *elasticity_init(double elasticity) {
+  double *aux = slab_alloc(
+      force_params_slab(&elasticity_slab, "elasticity", sizeof(double)));
+  *aux = elasticity;
+  return aux;
+}
+
+void elasticity_free(double *aux) { slab_release(aux); }
+
+// Like the collision pipeline, a contact that carries on from the last tick
+// only fires again if the bodies move towards each other again
 void collision_forcer(collision_params_t *params) {
-  if (params->previously_collided > 0) {
-    params->previously_collided = (params->previously_collided) - 1;
+  collision_info_t collision_info =
+      find_body_collision(params->body1, params->body2);
+  if (!collision_info.collided) {
+    params->touching = false;
     return;
   }
-  list_t *shape1 = body_get_shape(params->body1);
-  list_t *shape2 = body_get_shape(params->body2);
-  collision_info_t collision_info = find_collision(shape1, shape2);
-  if (collision_info.collided) {
-    params->previously_collided = COLLISION_COOLDOWN;
+  vector_t closing = vec_subtract(body_get_velocity(params->body2),
+                                  body_get_velocity(params->body1));
+  bool fires =
+      !params->touching || vec_dot(closing, collision_info.axis) < 0;
+  params->touching = true;
+  if (fires) {
     params->handler(params->body1, params->body2, collision_info.axis,
                     params->aux);
   }
@@ -179,11 +218,15 @@ void create_collision(scene_t *scene, body_t *body1, body_t *body2,
   list_t *bodies = list_init(2, NULL);
   list_add(bodies, body1);
   list_add(bodies, body2);
-  collision_params_t *params = malloc(sizeof(collision_params_t));
-  assert(params != NULL);
-  *params = (collision_params_t){body1, body2, handler, aux, freer, 0};
-  scene_add_bodies_force_creator(scene, (force_creator_t)collision_forcer,
-                                 params, bodies, free);
+  collision_params_t *params =
+      slab_alloc(force_params_slab(&collision_params_slab, "collision_params",
+                                   sizeof(collision_params_t)));
+  *params = (collision_params_t){body1, body2, handler, aux, freer, false};
+  // a restored scene must know whether the bodies were already touching
+  scene_add_stateful_force_creator(scene, (force_creator_t)collision_forcer,
+                                   params, bodies,
+                                   (free_func_t)collision_params_free,
+                                   &params->touching, sizeof(bool));
 }
 
 void elastic_collision(body_t *body1, body_t *body2, vector_t axis,
@@ -207,15 +250,6 @@ void elastic_collision(body_t *body1, body_t *body2, vector_t axis,
   body_add_impulse(body2, vec_negate(dp1));
 }
 
-// special ball collision handler. Just makes axis = vec between centroids
-// for better precision.
-void ball_collision_handler(body_t *body1, body_t *body2, vector_t axis,
-                       void *elasticity) {
-  vector_t axis_true = vec_unit(vec_subtract(body_get_centroid(body2), 
-                                             body_get_centroid(body1)));
-  elastic_collision(body1, body2, axis_true, elasticity);
-}
-
 // special poolstick collision handler.
 void poolstick_collision_handler(body_t *cue, body_t *stick, void *elasticity) {
   double ma = body_get_mass(stick);
@@ -238,40 +272,72 @@ void destructive_elastic_collision(body_t *body1, body_t *body2, vector_t axis,
   body_remove(body2);
 }
 
+void contact_params_free(contact_params_t *params) {
+  slab_release(params);
+}
+
+// Hands the pair's contact to the scene's contact solver every tick
+void contact_forcer(contact_params_t *params) {
+  collision_info_t collision_info =
+      find_body_collision(params->body1, params->body2);
+  if (!collision_info.collided) {
+    return;
+  }
+  scene_add_contact(params->scene,
+                    (contact_t){params->body1, params->body2,
+                                collision_info.axis, collision_info.depth,
+                                params->elasticity});
+}
+
 void create_physics_collision(scene_t *scene, double elasticity, body_t *body1,
                               body_t *body2) {
-  double *aux = malloc(sizeof(double));
-  *aux = elasticity;
-  if (is_ball(body1) && is_ball(body2)) {
-    create_collision(scene, body1, body2, ball_collision_handler, aux, free);
-  }
-  else {
-    create_collision(scene, body1, body2, elastic_collision, aux, free);
-  }
+  list_t *bodies = list_init(2, NULL);
+  list_add(bodies, body1);
+  list_add(bodies, body2);
+  contact_params_t *params =
+      slab_alloc(force_params_slab(&contact_params_slab, "contact_params",
+                                   sizeof(contact_params_t)));
+  *params = (contact_params_t){scene, body1, body2, elasticity};
+  scene_add_bodies_force_creator(scene, (force_creator_t)contact_forcer,
+                                 params, bodies,
+                                 (free_func_t)contact_params_free);
 }
 
 void create_destructive_physics_collision(scene_t *scene, double elasticity,
                                           body_t *body1, body_t *body2) {
-  double *aux = malloc(sizeof(double));
-  *aux = elasticity;
+  double *aux = elasticity_init(elasticity);
   create_collision(scene, body1, body2, destructive_elastic_collision, aux,
-                   free);
+                   (free_func_t)elasticity_free);
+}
+
+void create_physics_collision_rule(scene_t *scene, double elasticity,
+                                   size_t categories1, size_t categories2) {
+  // circles already collide along the line between their centers,
+  // so balls need no special axis here
+  scene_add_contact_rule(scene, categories1, categories2, elasticity);
+}
+
+void create_destructive_physics_collision_rule(scene_t *scene,
+                                               double elasticity,
+                                               size_t categories1,
+                                               size_t categories2) {
+  double *aux = elasticity_init(elasticity);
+  scene_add_collision_rule(scene, categories1, categories2,
+                           destructive_elastic_collision, aux,
+                           (free_func_t)elasticity_free);
 }
 
 void chaos_collision_forcer(chaos_collision_params_t *params) {
-  if (params->previously_collided > 0) {
-    params->previously_collided = (params->previously_collided) - 1;
-    return;
-  }
-    list_t *shape1 = body_get_shape(params->body1);
-    list_t *shape2 = body_get_shape(params->body2);
-    collision_info_t collision_info = find_collision(shape1, shape2);
-    if (collision_info.collided) {
-      params->previously_collided = COLLISION_COOLDOWN;
-      params->handler(params->body1, params->body3, collision_info.axis,
-                        params->aux);
+  for (size_t i = 0; i < scene_collisions(params->scene); i++) {
+    collision_event_t event = scene_get_collision(params->scene, i);
+    if (event.body1 == params->body1 && event.body2 == params->body2) {
+      params->handler(params->body1, params->body3, event.axis, params->aux);
+    } else if (event.body1 == params->body2 && event.body2 == params->body1) {
+      params->handler(params->body1, params->body3, vec_negate(event.axis),
+                      params->aux);
     }
   }
+}
 
 void create_chaos_collision(scene_t *scene, body_t *body1, body_t *body2, body_t *body3,
                       collision_handler_t handler, void *aux,
@@ -280,16 +346,19 @@ void create_chaos_collision(scene_t *scene, body_t *body1, body_t *body2, body_t
   list_add(bodies, body1);
   list_add(bodies, body2);
   list_add(bodies, body3);
-  chaos_collision_params_t *params = malloc(sizeof(chaos_collision_params_t));
-  assert(params != NULL);
-  *params = (chaos_collision_params_t){body1, body2, body3, handler, aux, freer, 0};
+  chaos_collision_params_t *params = slab_alloc(
+      force_params_slab(&chaos_collision_params_slab, "chaos_collision_params",
+                        sizeof(chaos_collision_params_t)));
+  *params = (chaos_collision_params_t){scene, body1, body2, body3,
+                                      handler, aux, freer};
   scene_add_bodies_force_creator(scene, (force_creator_t)chaos_collision_forcer,
-                                 params, bodies, free);
+                                 params, bodies,
+                                 (free_func_t)chaos_collision_params_free);
 }
 
 void create_chaos_physics_collision(scene_t *scene, double elasticity, body_t *body1,
                               body_t *body2, body_t *body3) {
-  double *aux = malloc(sizeof(double));
-  *aux = elasticity;
-  create_chaos_collision(scene, body1, body2, body3, elastic_collision, aux, free);
+  double *aux = elasticity_init(elasticity);
+  create_chaos_collision(scene, body1, body2, body3, elastic_collision, aux,
+                         (free_func_t)elasticity_free);
 }
\ No newline at end of file
@@ -7,11 +7,8 @@
 #include "list.h"
 #include "polygon.h"
 #include "scene.h"
-#include "sdl_wrapper.h"
 #include "shape_utility.h"
 #include "vector.h"
-#include <SDL2/SDL.h>
-#include <SDL2/SDL2_gfxPrimitives.h>
 #include <assert.h>
 #include <math.h>
 #include <stdint.h>
@@ -93,6 +90,20 @@ const double MENU_BUTTON_SPACING = 195;
 const vector_t POOLSTICK_DIMENSION = (vector_t){.x = 290, .y = 10};
 const vector_t POWER_UP_DIMENSIONS = (vector_t){.x = 20, .y = 20};
 
+// Looks up image sizes for sprites; NULL in headless builds
+image_dimensions_handler_t image_dimensions_handler = NULL;
+
+void graphics_on_image_dimensions(image_dimensions_handler_t handler) {
+    image_dimensions_handler = handler;
+}
+
+vector_t get_image_dimensions(char *img_path) {
+    if (image_dimensions_handler == NULL) {
+        return VEC_ZERO;
+    }
+    return image_dimensions_handler(img_path);
+}
+
 //-----------------------Ball Body Generation------------------------------
 
 list_t *generate_rack_pos() {
@@ -135,7 +146,7 @@ list_t *generate_rack_pos() {
 }
 
 list_t *generate_ball_img_list() {
-    list_t *img_list = list_init(NUM_BALLS, free);
+    list_t *img_list = list_init(NUM_BALLS, NULL);
     list_add(img_list, (char *)("assets/one.png"));
     list_add(img_list, (char *)("assets/two.png"));
     list_add(img_list, (char *)("assets/three.png"));
@@ -162,7 +173,7 @@ sprite_info_t striped_balls_textures(list_t *img_list, list_t *rack_pos, size_t
         .is_sprite = STRIPED_BALL_IS_SPRITE,
         .color = STRIPED_BALL_COLOR,
         .texture = NULL,
-        .img_dim = sdl_get_image_dimensions((char *)list_get(img_list,
+        .img_dim = get_image_dimensions((char *)list_get(img_list,
                                                              index + NUM_BALLS / 2))};
 }
 
@@ -175,7 +186,7 @@ sprite_info_t solid_balls_textures(list_t *img_list, list_t *rack_pos, size_t in
         .is_sprite = SOLID_BALL_IS_SPRITE,
         .color = SOLID_BALL_COLOR,
         .texture = NULL,
-        .img_dim = sdl_get_image_dimensions((char *)list_get(img_list, index))};
+        .img_dim = get_image_dimensions((char *)list_get(img_list, index))};
 }
 
 sprite_info_t eightball_texture() {
@@ -186,7 +197,7 @@ sprite_info_t eightball_texture() {
         .is_sprite = EIGHT_BALL_IS_SPRITE,
         .color = EIGHT_BALL_COLOR,
         .texture = NULL,
-        .img_dim = sdl_get_image_dimensions("assets/eight.png")};
+        .img_dim = get_image_dimensions("assets/eight.png")};
 }
 
 sprite_info_t ball_sprite(vector_t pos, char *img_path) {
@@ -197,7 +208,7 @@ sprite_info_t ball_sprite(vector_t pos, char *img_path) {
         .is_sprite = SOLID_BALL_IS_SPRITE,
         .color = SOLID_BALL_COLOR,
         .texture = NULL,
-        .img_dim = sdl_get_image_dimensions(img_path)};
+        .img_dim = get_image_dimensions(img_path)};
 }
 
 sprite_info_t cueball_texture(vector_t pos) {
@@ -208,65 +219,65 @@ sprite_info_t cueball_texture(vector_t pos) {
         .is_sprite = CUE_BALL_IS_SPRITE,
         .color = CUE_BALL_COLOR,
         .texture = NULL,
-        .img_dim = sdl_get_image_dimensions("assets/cue.png")};
+        .img_dim = get_image_dimensions("assets/cue.png")};
 }
 
 //-----------------------Table Body Generation------------------------------
 
 /* Table shapes are hard-coded in to match the table graphics. */
-list_t *generate_table_top_shape() {
-    list_t *wall_shape_top = list_init(WALL_LIST_CAPACITY, free);
-    list_add(wall_shape_top, gen_pos_vec(224, 405));
-    list_add(wall_shape_top, gen_pos_vec(478, 405));
-    list_add(wall_shape_top, gen_pos_vec(483, 415));
-    list_add(wall_shape_top, gen_pos_vec(483, 440));
-    list_add(wall_shape_top, gen_pos_vec(518, 440));
-    list_add(wall_shape_top, gen_pos_vec(518, 415));
-    list_add(wall_shape_top, gen_pos_vec(522, 405));
-    list_add(wall_shape_top, gen_pos_vec(776, 405));
-    list_add(wall_shape_top, gen_pos_vec(850, 450));
-    list_add(wall_shape_top, gen_pos_vec(150, 450));
-    list_add(wall_shape_top, gen_pos_vec(224, 405));
+polygon_t *generate_table_top_shape() {
+    polygon_t *wall_shape_top = polygon_init(WALL_LIST_CAPACITY);
+    polygon_add(wall_shape_top, (vector_t){224, 405});
+    polygon_add(wall_shape_top, (vector_t){478, 405});
+    polygon_add(wall_shape_top, (vector_t){483, 415});
+    polygon_add(wall_shape_top, (vector_t){483, 440});
+    polygon_add(wall_shape_top, (vector_t){518, 440});
+    polygon_add(wall_shape_top, (vector_t){518, 415});
+    polygon_add(wall_shape_top, (vector_t){522, 405});
+    polygon_add(wall_shape_top, (vector_t){776, 405});
+    polygon_add(wall_shape_top, (vector_t){850, 450});
+    polygon_add(wall_shape_top, (vector_t){150, 450});
+    polygon_add(wall_shape_top, (vector_t){224, 405});
     return wall_shape_top;
 }
 
-list_t *generate_table_left_shape() {
-    list_t *wall_shape_left = list_init(WALL_LIST_CAPACITY, free);
-    list_add(wall_shape_left, gen_pos_vec(150, 390));
-    list_add(wall_shape_left, gen_pos_vec(181, 390));
-    list_add(wall_shape_left, gen_pos_vec(195, 377));
-    list_add(wall_shape_left, gen_pos_vec(195, 123));
-    list_add(wall_shape_left, gen_pos_vec(183, 110));
-    list_add(wall_shape_left, gen_pos_vec(150, 110));
-    list_add(wall_shape_left, gen_pos_vec(150, 390));
+polygon_t *generate_table_left_shape() {
+    polygon_t *wall_shape_left = polygon_init(WALL_LIST_CAPACITY);
+    polygon_add(wall_shape_left, (vector_t){150, 390});
+    polygon_add(wall_shape_left, (vector_t){181, 390});
+    polygon_add(wall_shape_left, (vector_t){195, 377});
+    polygon_add(wall_shape_left, (vector_t){195, 123});
+    polygon_add(wall_shape_left, (vector_t){183, 110});
+    polygon_add(wall_shape_left, (vector_t){150, 110});
+    polygon_add(wall_shape_left, (vector_t){150, 390});
     return wall_shape_left;
 }
 
-list_t *generate_table_right_shape() {
-    list_t *wall_shape_right = list_init(WALL_LIST_CAPACITY, free);
-    list_add(wall_shape_right, gen_pos_vec(820, 390));
-    list_add(wall_shape_right, gen_pos_vec(805, 377));
-    list_add(wall_shape_right, gen_pos_vec(805, 124));
-    list_add(wall_shape_right, gen_pos_vec(820, 110));
-    list_add(wall_shape_right, gen_pos_vec(850, 110));
-    list_add(wall_shape_right, gen_pos_vec(850, 390));
-    list_add(wall_shape_right, gen_pos_vec(820, 390));
+polygon_t *generate_table_right_shape() {
+    polygon_t *wall_shape_right = polygon_init(WALL_LIST_CAPACITY);
+    polygon_add(wall_shape_right, (vector_t){820, 390});
+    polygon_add(wall_shape_right, (vector_t){805, 377});
+    polygon_add(wall_shape_right, (vector_t){805, 124});
+    polygon_add(wall_shape_right, (vector_t){820, 110});
+    polygon_add(wall_shape_right, (vector_t){850, 110});
+    polygon_add(wall_shape_right, (vector_t){850, 390});
+    polygon_add(wall_shape_right, (vector_t){820, 390});
     return wall_shape_right;
 }
 
-list_t *generate_table_bottom_shape() {
-    list_t *wall_shape_bottom = list_init(WALL_LIST_CAPACITY, free);
-    list_add(wall_shape_bottom, gen_pos_vec(224, 95));
-    list_add(wall_shape_bottom, gen_pos_vec(180, 50));
-    list_add(wall_shape_bottom, gen_pos_vec(810, 50));
-    list_add(wall_shape_bottom, gen_pos_vec(783, 95));
-    list_add(wall_shape_bottom, gen_pos_vec(522, 95));
-    list_add(wall_shape_bottom, gen_pos_vec(517, 85));
-    list_add(wall_shape_bottom, gen_pos_vec(517, 60));
-    list_add(wall_shape_bottom, gen_pos_vec(483, 60));
-    list_add(wall_shape_bottom, gen_pos_vec(483, 85));
-    list_add(wall_shape_bottom, gen_pos_vec(478, 95));
-    list_add(wall_shape_bottom, gen_pos_vec(224, 95));
+polygon_t *generate_table_bottom_shape() {
+    polygon_t *wall_shape_bottom = polygon_init(WALL_LIST_CAPACITY);
+    polygon_add(wall_shape_bottom, (vector_t){224, 95});
+    polygon_add(wall_shape_bottom, (vector_t){180, 50});
+    polygon_add(wall_shape_bottom, (vector_t){810, 50});
+    polygon_add(wall_shape_bottom, (vector_t){783, 95});
+    polygon_add(wall_shape_bottom, (vector_t){522, 95});
+    polygon_add(wall_shape_bottom, (vector_t){517, 85});
+    polygon_add(wall_shape_bottom, (vector_t){517, 60});
+    polygon_add(wall_shape_bottom, (vector_t){483, 60});
+    polygon_add(wall_shape_bottom, (vector_t){483, 85});
+    polygon_add(wall_shape_bottom, (vector_t){478, 95});
+    polygon_add(wall_shape_bottom, (vector_t){224, 95});
     return wall_shape_bottom;
 }
 
@@ -282,7 +293,7 @@ list_t *generate_pocket_locations() {
 }
 
 sprite_info_t table_top_texture() {
-    vector_t img_dim = sdl_get_image_dimensions("assets/pooltable.png");
+    vector_t img_dim = get_image_dimensions("assets/pooltable.png");
     return (sprite_info_t){
         .img_path = "assets/pooltable.png",
         .img_pos = {GRAPHICS_WINDOW_SIZE.x / 2, GRAPHICS_WINDOW_SIZE.y / 2},
@@ -290,7 +301,7 @@ sprite_info_t table_top_texture() {
         .is_sprite = WALL_IS_SPRITE,
         .color = WALL_COLOR,
         .texture = NULL,
-        .img_dim = sdl_get_image_dimensions("assets/pooltable.png")};
+        .img_dim = get_image_dimensions("assets/pooltable.png")};
 }
 
 sprite_info_t wall_texture() {
@@ -317,40 +328,29 @@ sprite_info_t pocket_texture() {
 
 //-----------------------Poolstick Generation------------------------------
 
-list_t *poolstick_shape(vector_t tip_position, vector_t cueball_position) {
+polygon_t *poolstick_shape(vector_t tip_position, vector_t cueball_position) {
     vector_t vector_of_attack = vec_unit(vec_subtract(cueball_position, tip_position));
     vector_t orthogonal_vector_of_attack = (vector_t){vector_of_attack.y,
                                                       -vector_of_attack.x};
 
-    list_t *ans = list_init(RECTANGLE_RESOLUTION, free);
-
-    vector_t *stick_point_vec = malloc(sizeof(vector_t));
-    assert(stick_point_vec != NULL);
-    *stick_point_vec = vec_add(vec_multiply((double)POOLSTICK_DIMENSION.y / 2,
-                                            orthogonal_vector_of_attack),
-                               tip_position);
-    vector_t previous_stick_point_vec = *stick_point_vec;
-    list_add(ans, stick_point_vec);
-
-    stick_point_vec = malloc(sizeof(vector_t));
-    assert(stick_point_vec != NULL);
-    *stick_point_vec = vec_subtract(previous_stick_point_vec, vec_multiply(
-                            (double)POOLSTICK_DIMENSION.x, vector_of_attack));
-    previous_stick_point_vec = *stick_point_vec;
-    list_add(ans, stick_point_vec);
-
-    stick_point_vec = malloc(sizeof(vector_t));
-    assert(stick_point_vec != NULL);
-    *stick_point_vec = vec_subtract(previous_stick_point_vec, vec_multiply(
-                            (double)POOLSTICK_DIMENSION.y, orthogonal_vector_of_attack));
-    previous_stick_point_vec = *stick_point_vec;
-    list_add(ans, stick_point_vec);
-
-    stick_point_vec = malloc(sizeof(vector_t));
-    assert(stick_point_vec != NULL);
-    *stick_point_vec = vec_add(previous_stick_point_vec, vec_multiply(
-                            (double)POOLSTICK_DIMENSION.x, vector_of_attack));
-    list_add(ans, stick_point_vec);
+    polygon_t *ans = polygon_init(RECTANGLE_RESOLUTION);
+
+    vector_t stick_point_vec = vec_add(vec_multiply((double)POOLSTICK_DIMENSION.y / 2,
+                                                    orthogonal_vector_of_attack),
+                                       tip_position);
+    polygon_add(ans, stick_point_vec);
+
+    stick_point_vec = vec_subtract(stick_point_vec, vec_multiply(
+                          (double)POOLSTICK_DIMENSION.x, vector_of_attack));
+    polygon_add(ans, stick_point_vec);
+
+    stick_point_vec = vec_subtract(stick_point_vec, vec_multiply(
+                          (double)POOLSTICK_DIMENSION.y, orthogonal_vector_of_attack));
+    polygon_add(ans, stick_point_vec);
+
+    stick_point_vec = vec_add(stick_point_vec, vec_multiply(
+                          (double)POOLSTICK_DIMENSION.x, vector_of_attack));
+    polygon_add(ans, stick_point_vec);
 
     return ans;
 }
@@ -413,29 +413,29 @@ sprite_info_t line_texture()
 
 //-----------------------Menu Generation------------------------------
 
-list_t *generate_menu_background_shape() {
+polygon_t *generate_menu_background_shape() {
     return generate_rect_shape(MENU_POSITION.x, MENU_POSITION.y,
                                MENU_WINDOW_SIZE.x, MENU_WINDOW_SIZE.y);
 }
 
-list_t *generate_menu_button_shape(size_t index) {
+polygon_t *generate_menu_button_shape(size_t index) {
     return generate_rect_shape(FIRST_BUTTON_POSITION.x + (MENU_BUTTON_SPACING * index),
                                FIRST_BUTTON_POSITION.y, BUTTON_DIMENSION_SIZE.x,
                                BUTTON_DIMENSION_SIZE.y);
 }
 
-list_t *generate_menu_toggle_shape(size_t index) {
+polygon_t *generate_menu_toggle_shape(size_t index) {
     return generate_ball(FIRST_TOGGLE_POSITION.x + (TOGGLE_SPACING * index),
                          FIRST_TOGGLE_POSITION.y, TOGGLE_RADIUS);
 }
 
-list_t *generate_instructions_close_shape() {
+polygon_t *generate_instructions_close_shape() {
     return generate_ball(INSTRUCTIONS_CLOSE_POSITION.x, INSTRUCTIONS_CLOSE_POSITION.y,
                          INSTRUCTIONS_CLOSE_RADIUS);
 }
 
 sprite_info_t menu_background_texture() {
-    vector_t img_dim = sdl_get_image_dimensions("assets/menubackground.png");
+    vector_t img_dim = get_image_dimensions("assets/menubackground.png");
     return (sprite_info_t){
         .img_path = "assets/menubackground.png",
         .img_pos = {MENU_POSITION.x, MENU_POSITION.y},
@@ -447,7 +447,7 @@ sprite_info_t menu_background_texture() {
 }
 
 sprite_info_t menu_button_texture(size_t index) {
-    vector_t img_dim = sdl_get_image_dimensions("assets/menubutton.png");
+    vector_t img_dim = get_image_dimensions("assets/menubutton.png");
     return (sprite_info_t){
         .img_path = "assets/menubutton.png",
         .img_pos = {FIRST_BUTTON_POSITION.x + (MENU_BUTTON_SPACING * index),
@@ -472,7 +472,7 @@ sprite_info_t menu_toggle_texture() {
 }
 
 sprite_info_t instructions_close_texture() {
-    vector_t img_dim = sdl_get_image_dimensions("assets/close.png");
+    vector_t img_dim = get_image_dimensions("assets/close.png");
     return (sprite_info_t){
         .img_path = "assets/close.png",
         .img_pos = INSTRUCTIONS_CLOSE_POSITION,
@@ -487,7 +487,7 @@ sprite_info_t instructions_close_texture() {
 //-----------------------Power Up Generation------------------------------
 
 sprite_info_t power_up_texture(vector_t position) {
-    vector_t img_dim = sdl_get_image_dimensions("assets/powerup.png");
+    vector_t img_dim = get_image_dimensions("assets/powerup.png");
     return (sprite_info_t){
         .img_path = "assets/powerup.png",
         .img_pos = position,
@@ -0,0 +1,345 @@
+#include "gravity.h"
+#include "vector.h"
+#include <assert.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Bodies that are still together after this many halvings of the root cell
+// share a leaf. Traversal holds at most 3 cells per level plus 4 on a stack.
+enum { GRAVITY_MAX_DEPTH = 48, GRAVITY_STACK = 3 * GRAVITY_MAX_DEPTH + 4 };
+
+const size_t INIT_GRAVITY_CELLS = 64;
+const size_t GRAVITY_RESIZE_FACTOR = 2;
+const size_t GRAVITY_NO_BODY = SIZE_MAX;
+const size_t GRAVITY_GRAIN = 256; // bodies handed to a pool thread at a time
+
+typedef struct gravity_cell {
+  vector_t center;
+  double half; // half the width
+  double mass;
+  // The center of mass; the sum of mass * position while building
+  vector_t com;
+  size_t children; // the first of four consecutive children, or 0 for leaves
+  size_t first;    // the first body in a leaf, or GRAVITY_NO_BODY
+} gravity_cell_t;
+
+typedef struct gravity {
+  double G;
+  double theta;
+  double min_distance;
+  gravity_cell_t *cells;
+  size_t cell_count;
+  size_t cell_capacity;
+  // Per slot: the mass (0 for slots that do not gravitate), and the next
+  // body in the same leaf
+  double *mass;
+  size_t *next;
+  // The slots that gravitate, and the pull on each of them
+  size_t *members;
+  vector_t *pull;
+  size_t member_count;
+  size_t slot_capacity;
+  atomic_size_t interactions;
+} gravity_t;
+
+gravity_t *gravity_init(double G, double theta, double min_distance) {
+  assert(theta >= 0 && min_distance >= 0);
+  gravity_t *gravity = malloc(sizeof(gravity_t));
+  assert(gravity != NULL);
+  *gravity = (gravity_t){
+      .G = G,
+      .theta = theta,
+      .min_distance = min_distance,
+      .cells = malloc(sizeof(gravity_cell_t) * INIT_GRAVITY_CELLS),
+      .cell_count = 0,
+      .cell_capacity = INIT_GRAVITY_CELLS,
+      .mass = NULL,
+      .next = NULL,
+      .members = NULL,
+      .pull = NULL,
+      .member_count = 0,
+      .slot_capacity = 0,
+  };
+  atomic_init(&gravity->interactions, 0);
+  assert(gravity->cells != NULL);
+  return gravity;
+}
+
+void gravity_free(gravity_t *gravity) {
+  free(gravity->cells);
+  free(gravity->mass);
+  free(gravity->next);
+  free(gravity->members);
+  free(gravity->pull);
+  free(gravity);
+}
+
+double gravity_get_theta(gravity_t *gravity) { return gravity->theta; }
+
+void gravity_set_theta(gravity_t *gravity, double theta) {
+  assert(theta >= 0);
+  gravity->theta = theta;
+}
+
+size_t gravity_cells(gravity_t *gravity) { return gravity->cell_count; }
+
+size_t gravity_interactions(gravity_t *gravity) {
+  return atomic_load(&gravity->interactions);
+}
+
+size_t gravity_add_cell(gravity_t *gravity, vector_t center, double half) {
+  if (gravity->cell_count == gravity->cell_capacity) {
+    gravity->cell_capacity *= GRAVITY_RESIZE_FACTOR;
+    gravity->cells = realloc(gravity->cells,
+                             sizeof(gravity_cell_t) * gravity->cell_capacity);
+    assert(gravity->cells != NULL);
+  }
+  gravity->cells[gravity->cell_count] = (gravity_cell_t){
+      .center = center,
+      .half = half,
+      .mass = 0,
+      .com = VEC_ZERO,
+      .children = 0,
+      .first = GRAVITY_NO_BODY,
+  };
+  return gravity->cell_count++;
+}
+
+// Which child of a cell a point falls in: bit 0 for right, bit 1 for top
+size_t gravity_quadrant(gravity_cell_t *cell, vector_t point) {
+  return (point.x >= cell->center.x) + 2 * (point.y >= cell->center.y);
+}
+
+void gravity_split(gravity_t *gravity, size_t index) {
+  vector_t center = gravity->cells[index].center;
+  double quarter = gravity->cells[index].half / 2;
+  size_t children = gravity->cell_count;
+  for (size_t q = 0; q < 4; q++) {
+    vector_t offset = {q & 1 ? quarter : -quarter, q & 2 ? quarter : -quarter};
+    gravity_add_cell(gravity, vec_add(center, offset), quarter);
+  }
+  // cells may have moved
+  gravity->cells[index].children = children;
+}
+
+void gravity_add_mass(gravity_cell_t *cell, double mass, vector_t position) {
+  cell->mass += mass;
+  cell->com = vec_add(cell->com, vec_multiply(mass, position));
+}
+
+void gravity_insert(gravity_t *gravity, kinematics_t *kin, size_t slot) {
+  vector_t position = kin->centroid[slot];
+  double mass = gravity->mass[slot];
+  size_t index = 0;
+  for (size_t depth = 0;; depth++) {
+    gravity_add_mass(&gravity->cells[index], mass, position);
+    if (gravity->cells[index].children == 0) {
+      size_t resident = gravity->cells[index].first;
+      if (resident == GRAVITY_NO_BODY || depth == GRAVITY_MAX_DEPTH) {
+        gravity->next[slot] = resident;
+        gravity->cells[index].first = slot;
+        return;
+      }
+      // a leaf holds one body above the last level, so move it down
+      gravity_split(gravity, index);
+      gravity_cell_t *cell = &gravity->cells[index];
+      vector_t resident_position = kin->centroid[resident];
+      gravity_cell_t *child =
+          &gravity->cells[cell->children +
+                          gravity_quadrant(cell, resident_position)];
+      child->first = resident;
+      gravity_add_mass(child, gravity->mass[resident], resident_position);
+      cell->first = GRAVITY_NO_BODY;
+    }
+    gravity_cell_t *cell = &gravity->cells[index];
+    index = cell->children + gravity_quadrant(cell, position);
+  }
+}
+
+// Finds the gravitating slots with finite mass
+void gravity_gather(gravity_t *gravity, kinematics_t *kin) {
+  size_t n = kin->size;
+  if (gravity->slot_capacity < n) {
+    gravity->mass = realloc(gravity->mass, sizeof(double) * n);
+    gravity->next = realloc(gravity->next, sizeof(size_t) * n);
+    gravity->members = realloc(gravity->members, sizeof(size_t) * n);
+    gravity->pull = realloc(gravity->pull, sizeof(vector_t) * n);
+    assert(gravity->mass != NULL && gravity->next != NULL &&
+           gravity->members != NULL && gravity->pull != NULL);
+    gravity->slot_capacity = n;
+  }
+  gravity->member_count = 0;
+  for (size_t i = 0; i < n; i++) {
+    bool member = kin->gravitating[i] && kin->inv_mass[i] > 0;
+    gravity->mass[i] = member ? 1 / kin->inv_mass[i] : 0;
+    if (member) {
+      gravity->members[gravity->member_count++] = i;
+    }
+  }
+}
+
+void gravity_build(gravity_t *gravity, kinematics_t *kin) {
+  vector_t min = kin->centroid[gravity->members[0]];
+  vector_t max = min;
+  for (size_t k = 1; k < gravity->member_count; k++) {
+    vector_t c = kin->centroid[gravity->members[k]];
+    min = (vector_t){fmin(min.x, c.x), fmin(min.y, c.y)};
+    max = (vector_t){fmax(max.x, c.x), fmax(max.y, c.y)};
+  }
+  double half = fmax(max.x - min.x, max.y - min.y) / 2;
+  gravity->cell_count = 0;
+  gravity_add_cell(gravity, vec_multiply(0.5, vec_add(min, max)),
+                   half > 0 ? half : 1);
+  for (size_t k = 0; k < gravity->member_count; k++) {
+    gravity_insert(gravity, kin, gravity->members[k]);
+  }
+  for (size_t i = 0; i < gravity->cell_count; i++) {
+    gravity_cell_t *cell = &gravity->cells[i];
+    if (cell->mass > 0) {
+      cell->com = vec_multiply(1 / cell->mass, cell->com);
+    }
+  }
+}
+
+// The pull on a slot, without the factor G * mass of the slot, counting the
+// forces computed. Plain doubles rather than vector.h calls: this is the
+// inner loop.
+vector_t gravity_tree_pull(gravity_t *gravity, kinematics_t *kin, size_t slot,
+                           size_t *interactions) {
+  double x = kin->centroid[slot].x;
+  double y = kin->centroid[slot].y;
+  double min_squared = gravity->min_distance * gravity->min_distance;
+  double theta_squared = gravity->theta * gravity->theta;
+  double pull_x = 0;
+  double pull_y = 0;
+  size_t stack[GRAVITY_STACK];
+  size_t top = 0;
+  stack[top++] = 0;
+  while (top > 0) {
+    gravity_cell_t *cell = &gravity->cells[stack[--top]];
+    if (cell->children == 0) {
+      for (size_t j = cell->first; j != GRAVITY_NO_BODY; j = gravity->next[j]) {
+        double dx = kin->centroid[j].x - x;
+        double dy = kin->centroid[j].y - y;
+        double squared = dx * dx + dy * dy;
+        if (j != slot && squared > 0 && squared >= min_squared) {
+          double scale = gravity->mass[j] / (squared * sqrt(squared));
+          pull_x += scale * dx;
+          pull_y += scale * dy;
+        }
+        *interactions += j != slot;
+      }
+      continue;
+    }
+    // A cell acts as one point mass if width / distance < theta and all of
+    // it is at least min_distance away, so no body in it would be cut off
+    double gap_x = fmax(fabs(x - cell->center.x) - cell->half, 0);
+    double gap_y = fmax(fabs(y - cell->center.y) - cell->half, 0);
+    double gap_squared = gap_x * gap_x + gap_y * gap_y;
+    double dx = cell->com.x - x;
+    double dy = cell->com.y - y;
+    double squared = dx * dx + dy * dy;
+    double width = 2 * cell->half;
+    if (gap_squared > 0 && gap_squared >= min_squared &&
+        width * width < theta_squared * squared) {
+      double scale = cell->mass / (squared * sqrt(squared));
+      pull_x += scale * dx;
+      pull_y += scale * dy;
+      (*interactions)++;
+      continue;
+    }
+    for (size_t q = 0; q < 4; q++) {
+      if (gravity->cells[cell->children + q].mass > 0) {
+        assert(top < GRAVITY_STACK);
+        stack[top++] = cell->children + q;
+      }
+    }
+  }
+  return (vector_t){pull_x, pull_y};
+}
+
+typedef struct gravity_job {
+  gravity_t *gravity;
+  kinematics_t *kin;
+} gravity_job_t;
+
+// Each member's pull depends only on the tree, so members can be split
+// across threads
+void gravity_tree_pulls(void *aux, size_t start, size_t end) {
+  gravity_job_t *job = aux;
+  gravity_t *gravity = job->gravity;
+  size_t interactions = 0;
+  for (size_t k = start; k < end; k++) {
+    size_t i = gravity->members[k];
+    if (!job->kin->asleep[i]) {
+      gravity->pull[k] = gravity_tree_pull(gravity, job->kin, i,
+                                           &interactions);
+    }
+  }
+  atomic_fetch_add(&gravity->interactions, interactions);
+}
+
+// Theta = 0 approximates nothing, so the tree would only add overhead:
+// sum over the pairs directly, visiting each pair once
+void gravity_pairwise_pulls(gravity_t *gravity, kinematics_t *kin) {
+  size_t n = gravity->member_count;
+  size_t *members = gravity->members;
+  double *restrict pull = (double *)gravity->pull;
+  double min_squared = gravity->min_distance * gravity->min_distance;
+  for (size_t a = 0; a < 2 * n; a++) {
+    pull[a] = 0;
+  }
+  for (size_t a = 0; a < n; a++) {
+    size_t i = members[a];
+    double x = kin->centroid[i].x;
+    double y = kin->centroid[i].y;
+    double mass = gravity->mass[i];
+    double pull_x = 0;
+    double pull_y = 0;
+    for (size_t b = a + 1; b < n; b++) {
+      size_t j = members[b];
+      double dx = kin->centroid[j].x - x;
+      double dy = kin->centroid[j].y - y;
+      double squared = dx * dx + dy * dy;
+      if (squared > 0 && squared >= min_squared) {
+        double scale = 1 / (squared * sqrt(squared));
+        pull_x += gravity->mass[j] * scale * dx;
+        pull_y += gravity->mass[j] * scale * dy;
+        pull[2 * b] -= mass * scale * dx;
+        pull[2 * b + 1] -= mass * scale * dy;
+      }
+    }
+    pull[2 * a] += pull_x;
+    pull[2 * a + 1] += pull_y;
+  }
+  atomic_store(&gravity->interactions, n * (n - 1));
+}
+
+void gravity_apply(gravity_t *gravity, kinematics_t *kin,
+                   thread_pool_t *pool) {
+  atomic_store(&gravity->interactions, 0);
+  gravity->cell_count = 0;
+  gravity_gather(gravity, kin);
+  if (gravity->member_count == 0) {
+    return;
+  }
+  if (gravity->theta == 0) {
+    gravity_pairwise_pulls(gravity, kin);
+  } else {
+    gravity_build(gravity, kin);
+    gravity_job_t job = {gravity, kin};
+    thread_pool_for(pool, gravity->member_count, GRAVITY_GRAIN,
+                    gravity_tree_pulls, &job);
+  }
+  for (size_t k = 0; k < gravity->member_count; k++) {
+    size_t i = gravity->members[k];
+    if (!kin->asleep[i]) {
+      vector_t force = vec_multiply(gravity->G * gravity->mass[i],
+                                    gravity->pull[k]);
+      kin->force[i] = vec_add(kin->force[i], force);
+    }
+  }
+}
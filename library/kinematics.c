@@ -0,0 +1,319 @@
+#include "kinematics.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+const size_t KINEMATICS_RESIZE_FACTOR = 2;
+
+void kinematics_alloc(kinematics_t *kin, size_t capacity) {
+  kin->centroid = realloc(kin->centroid, sizeof(vector_t) * capacity);
+  kin->velocity = realloc(kin->velocity, sizeof(vector_t) * capacity);
+  kin->force = realloc(kin->force, sizeof(vector_t) * capacity);
+  kin->impulse = realloc(kin->impulse, sizeof(vector_t) * capacity);
+  kin->inv_mass = realloc(kin->inv_mass, sizeof(double) * capacity);
+  kin->owner = realloc(kin->owner, sizeof(void *) * capacity);
+  kin->asleep = realloc(kin->asleep, sizeof(bool) * capacity);
+  kin->rest_time = realloc(kin->rest_time, sizeof(double) * capacity);
+  kin->drag = realloc(kin->drag, sizeof(double) * capacity);
+  kin->constant_drag = realloc(kin->constant_drag, sizeof(double) * capacity);
+  kin->gravity = realloc(kin->gravity, sizeof(vector_t) * capacity);
+  kin->constant_drag_min_speed =
+      realloc(kin->constant_drag_min_speed, sizeof(double) * capacity);
+  kin->gravitating = realloc(kin->gravitating, sizeof(bool) * capacity);
+  assert(kin->centroid != NULL && kin->velocity != NULL &&
+         kin->force != NULL && kin->impulse != NULL &&
+         kin->inv_mass != NULL && kin->owner != NULL &&
+         kin->asleep != NULL && kin->rest_time != NULL &&
+         kin->drag != NULL && kin->constant_drag != NULL &&
+         kin->gravity != NULL && kin->constant_drag_min_speed != NULL &&
+         kin->gravitating != NULL);
+  kin->capacity = capacity;
+}
+
+kinematics_t *kinematics_init(size_t initial_capacity) {
+  kinematics_t *kin = calloc(1, sizeof(kinematics_t));
+  assert(kin != NULL);
+  kinematics_alloc(kin, initial_capacity > 0 ? initial_capacity : 1);
+  return kin;
+}
+
+void kinematics_free(kinematics_t *kin) {
+  free(kin->centroid);
+  free(kin->velocity);
+  free(kin->force);
+  free(kin->impulse);
+  free(kin->inv_mass);
+  free(kin->owner);
+  free(kin->asleep);
+  free(kin->rest_time);
+  free(kin->drag);
+  free(kin->constant_drag);
+  free(kin->gravity);
+  free(kin->constant_drag_min_speed);
+  free(kin->gravitating);
+  free(kin);
+}
+
+size_t kinematics_add(kinematics_t *kin, void *owner, vector_t centroid,
+                      double inv_mass) {
+  if (kin->size >= kin->capacity) {
+    kinematics_alloc(kin, kin->capacity * KINEMATICS_RESIZE_FACTOR);
+  }
+  size_t slot = kin->size++;
+  kin->centroid[slot] = centroid;
+  kin->velocity[slot] = VEC_ZERO;
+  kin->force[slot] = VEC_ZERO;
+  kin->impulse[slot] = VEC_ZERO;
+  kin->inv_mass[slot] = inv_mass;
+  kin->owner[slot] = owner;
+  kin->asleep[slot] = false;
+  kin->rest_time[slot] = 0;
+  kin->drag[slot] = 0;
+  kin->constant_drag[slot] = 0;
+  kin->gravity[slot] = VEC_ZERO;
+  kin->constant_drag_min_speed[slot] = 0;
+  kin->gravitating[slot] = false;
+  kin->awake++;
+  return slot;
+}
+
+void *kinematics_remove(kinematics_t *kin, size_t slot) {
+  assert(slot < kin->size);
+  if (!kin->asleep[slot]) {
+    kin->awake--;
+  }
+  size_t last = --kin->size;
+  if (slot == last) {
+    return NULL;
+  }
+  kin->centroid[slot] = kin->centroid[last];
+  kin->velocity[slot] = kin->velocity[last];
+  kin->force[slot] = kin->force[last];
+  kin->impulse[slot] = kin->impulse[last];
+  kin->inv_mass[slot] = kin->inv_mass[last];
+  kin->owner[slot] = kin->owner[last];
+  kin->asleep[slot] = kin->asleep[last];
+  kin->rest_time[slot] = kin->rest_time[last];
+  kin->drag[slot] = kin->drag[last];
+  kin->constant_drag[slot] = kin->constant_drag[last];
+  kin->gravity[slot] = kin->gravity[last];
+  kin->constant_drag_min_speed[slot] = kin->constant_drag_min_speed[last];
+  kin->gravitating[slot] = kin->gravitating[last];
+  return kin->owner[slot];
+}
+
+void kinematics_copy(kinematics_t *dst, kinematics_t *src) {
+  if (dst->capacity < src->size) {
+    kinematics_alloc(dst, src->size);
+  }
+  size_t n = src->size;
+  memcpy(dst->centroid, src->centroid, sizeof(vector_t) * n);
+  memcpy(dst->velocity, src->velocity, sizeof(vector_t) * n);
+  memcpy(dst->force, src->force, sizeof(vector_t) * n);
+  memcpy(dst->impulse, src->impulse, sizeof(vector_t) * n);
+  memcpy(dst->inv_mass, src->inv_mass, sizeof(double) * n);
+  memcpy(dst->owner, src->owner, sizeof(void *) * n);
+  memcpy(dst->asleep, src->asleep, sizeof(bool) * n);
+  memcpy(dst->rest_time, src->rest_time, sizeof(double) * n);
+  memcpy(dst->drag, src->drag, sizeof(double) * n);
+  memcpy(dst->constant_drag, src->constant_drag, sizeof(double) * n);
+  memcpy(dst->gravity, src->gravity, sizeof(vector_t) * n);
+  memcpy(dst->constant_drag_min_speed, src->constant_drag_min_speed,
+         sizeof(double) * n);
+  memcpy(dst->gravitating, src->gravitating, sizeof(bool) * n);
+  dst->size = n;
+  dst->awake = src->awake;
+}
+
+void kinematics_sleep(kinematics_t *kin, size_t slot) {
+  if (!kin->asleep[slot]) {
+    kin->asleep[slot] = true;
+    kin->velocity[slot] = VEC_ZERO;
+    kin->awake--;
+  }
+}
+
+void kinematics_wake(kinematics_t *kin, size_t slot) {
+  if (kin->asleep[slot]) {
+    kin->asleep[slot] = false;
+    kin->rest_time[slot] = 0;
+    kin->awake++;
+  }
+}
+
+void kinematics_settle(kinematics_t *kin, size_t start, size_t end,
+                       double max_speed, double rest_time, double dt) {
+  double max_speed_squared = max_speed * max_speed;
+  for (size_t i = start; i < end; i++) {
+    if (kin->asleep[i]) {
+      continue;
+    }
+    vector_t velocity = kin->velocity[i];
+    if (vec_dot(velocity, velocity) > max_speed_squared) {
+      kin->rest_time[i] = 0;
+    } else if ((kin->rest_time[i] += dt) >= rest_time) {
+      kinematics_sleep(kin, i);
+    }
+  }
+}
+
+void kinematics_apply_fields(kinematics_t *kin, size_t start, size_t end) {
+  // Branch-free arithmetic on plain arrays, like kinematics_integrate()
+  double *restrict force = (double *)kin->force;
+  const double *restrict velocity = (double *)kin->velocity;
+  const double *restrict gravity = (double *)kin->gravity;
+  const double *restrict drag = kin->drag;
+  const double *restrict constant_drag = kin->constant_drag;
+  const double *restrict min_speed = kin->constant_drag_min_speed;
+  const double *restrict inv_mass = kin->inv_mass;
+  const bool *restrict asleep = kin->asleep;
+  for (size_t i = start; i < end; i++) {
+    double vx = velocity[2 * i];
+    double vy = velocity[2 * i + 1];
+    double speed_squared = vx * vx + vy * vy;
+    // constant drag as a coefficient on the velocity, like linear drag
+    double push = speed_squared >= min_speed[i] * min_speed[i] &&
+                          speed_squared > 0
+                      ? constant_drag[i] / sqrt(speed_squared)
+                      : 0;
+    double resistance = drag[i] + push;
+    double mass = inv_mass[i] > 0 && !asleep[i] ? 1 / inv_mass[i] : 0;
+    force[2 * i] += mass * gravity[2 * i] - resistance * vx;
+    force[2 * i + 1] += mass * gravity[2 * i + 1] - resistance * vy;
+  }
+}
+
+void kinematics_integrate(kinematics_t *kin, size_t start, size_t end,
+                          double dt) {
+  // Plain arrays of doubles with restrict so the compiler can vectorize
+  double *restrict centroid = (double *)kin->centroid;
+  double *restrict velocity = (double *)kin->velocity;
+  double *restrict force = (double *)kin->force;
+  double *restrict impulse = (double *)kin->impulse;
+  const double *restrict inv_mass = kin->inv_mass;
+  const bool *restrict asleep = kin->asleep;
+  for (size_t i = start; i < end; i++) {
+    if (asleep[i]) {
+      force[2 * i] = force[2 * i + 1] = 0;
+      continue;
+    }
+    for (size_t c = 2 * i; c < 2 * i + 2; c++) {
+      double old_velocity = velocity[c];
+      double new_velocity =
+          old_velocity + inv_mass[i] * (impulse[c] + dt * force[c]);
+      velocity[c] = new_velocity;
+      centroid[c] += dt * 0.5 * (old_velocity + new_velocity);
+      force[c] = 0;
+      impulse[c] = 0;
+    }
+  }
+}
+
+size_t integrator_stages(integrator_t integrator) {
+  switch (integrator) {
+  case INTEGRATOR_VELOCITY_VERLET:
+    return 2;
+  case INTEGRATOR_RK4:
+    return 4;
+  default:
+    return 1;
+  }
+}
+
+void kinematics_integrate_euler(kinematics_t *kin, size_t start, size_t end,
+                                double dt) {
+  double *restrict centroid = (double *)kin->centroid;
+  double *restrict velocity = (double *)kin->velocity;
+  double *restrict force = (double *)kin->force;
+  double *restrict impulse = (double *)kin->impulse;
+  const double *restrict inv_mass = kin->inv_mass;
+  const bool *restrict asleep = kin->asleep;
+  for (size_t i = start; i < end; i++) {
+    if (asleep[i]) {
+      force[2 * i] = force[2 * i + 1] = 0;
+      continue;
+    }
+    for (size_t c = 2 * i; c < 2 * i + 2; c++) {
+      velocity[c] += inv_mass[i] * (impulse[c] + dt * force[c]);
+      centroid[c] += dt * velocity[c];
+      force[c] = 0;
+      impulse[c] = 0;
+    }
+  }
+}
+
+void kinematics_begin_stages(kinematics_t *kin, kinematics_stages_t *stages,
+                             size_t start, size_t end) {
+  for (size_t i = start; i < end; i++) {
+    if (!kin->asleep[i]) {
+      kin->velocity[i] = vec_add(kin->velocity[i],
+                                 vec_multiply(kin->inv_mass[i], kin->impulse[i]));
+      kin->impulse[i] = VEC_ZERO;
+    }
+    stages->held[i] = kin->force[i];
+    stages->centroid[i] = kin->centroid[i];
+    stages->velocity[i] = kin->velocity[i];
+  }
+}
+
+// Velocity Verlet: half the velocity change and the move, then once the
+// forces at the new centroids are in, the other half
+void verlet_stage(kinematics_t *kin, size_t stage, size_t i, double dt) {
+  vector_t acceleration = vec_multiply(kin->inv_mass[i], kin->force[i]);
+  kin->velocity[i] =
+      vec_add(kin->velocity[i], vec_multiply(dt / 2, acceleration));
+  if (stage == 0) {
+    kin->centroid[i] =
+        vec_add(kin->centroid[i], vec_multiply(dt, kin->velocity[i]));
+  }
+}
+
+// Classic RK4: each stage's derivatives (velocity, acceleration) set up the
+// next stage's state, and the last one finishes the weighted average
+void rk4_stage(kinematics_t *kin, size_t stage, kinematics_stages_t *stages,
+               size_t i, double dt) {
+  vector_t velocity = kin->velocity[i];
+  vector_t acceleration = vec_multiply(kin->inv_mass[i], kin->force[i]);
+  if (stage == 3) {
+    vector_t centroid_change = vec_add(stages->centroid_change[i], velocity);
+    vector_t velocity_change =
+        vec_add(stages->velocity_change[i], acceleration);
+    kin->centroid[i] = vec_add(stages->centroid[i],
+                               vec_multiply(dt / 6, centroid_change));
+    kin->velocity[i] = vec_add(stages->velocity[i],
+                               vec_multiply(dt / 6, velocity_change));
+    return;
+  }
+  if (stage == 0) {
+    stages->centroid_change[i] = velocity;
+    stages->velocity_change[i] = acceleration;
+  } else {
+    stages->centroid_change[i] =
+        vec_add(stages->centroid_change[i], vec_multiply(2, velocity));
+    stages->velocity_change[i] =
+        vec_add(stages->velocity_change[i], vec_multiply(2, acceleration));
+  }
+  double step = stage == 2 ? dt : dt / 2;
+  kin->centroid[i] = vec_add(stages->centroid[i], vec_multiply(step, velocity));
+  kin->velocity[i] =
+      vec_add(stages->velocity[i], vec_multiply(step, acceleration));
+}
+
+void kinematics_stage(kinematics_t *kin, integrator_t integrator, size_t stage,
+                      kinematics_stages_t *stages, size_t start, size_t end,
+                      double dt) {
+  size_t count = integrator_stages(integrator);
+  assert(count > 1 && stage < count);
+  bool last = stage + 1 == count;
+  for (size_t i = start; i < end; i++) {
+    if (!kin->asleep[i]) {
+      if (integrator == INTEGRATOR_VELOCITY_VERLET) {
+        verlet_stage(kin, stage, i, dt);
+      } else {
+        rk4_stage(kin, stage, stages, i, dt);
+      }
+    }
+    kin->force[i] = last ? VEC_ZERO : stages->held[i];
+  }
+}
@@ -2,7 +2,6 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 
 const size_t RESIZE_FACTOR = 2;
 
@@ -54,6 +53,12 @@ void *list_remove(list_t *list, size_t index) {
   return to_return;
 }
 
+void *list_swap_remove(list_t *list, size_t index) {
+  void *to_return = list_get(list, index);
+  list->my_list[index] = list->my_list[--list->size];
+  return to_return;
+}
+
 void list_add(list_t *list, void *value) {
   assert(value != NULL);
   size_t my_size = list_size(list);
@@ -86,12 +91,24 @@ void *list_dequeue(list_t *list) { return list_remove(list, 0); }
 
 void *list_pop(list_t *list) { return list_remove(list, list_size(list) - 1); }
 
-void list_shuffle(list_t *list) {
-  srand(time(NULL));
-  for (size_t i = list_size(list)-1; i > 0; i--) {
-    size_t j = rand() % (i+1);
-    void *aux = list->my_list[i];
-    list->my_list[i] = list->my_list[j];
+void list_assign(list_t *list, void **values, size_t count) {
+  if (count > list->capacity) {
+    list->size = 0;
+    list_resize(list, count);
+  }
+  for (size_t i = 0; i < count; i++) {
+    assert(values[i] != NULL);
+  }
+  memcpy(list->my_list, values, sizeof(void *) * count);
+  list->size = count;
+}
+
+void list_shuffle(list_t *list, rng_t *rng) {
+  // counting down from the size also handles empty lists
+  for (size_t i = list_size(list); i > 1; i--) {
+    size_t j = rng_below(rng, i);
+    void *aux = list->my_list[i - 1];
+    list->my_list[i - 1] = list->my_list[j];
     list->my_list[j] = aux;
   }
 }
\ No newline at end of file
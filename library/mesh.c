@@ -0,0 +1,122 @@
+#include "mesh.h"
+#include "polygon.h"
+#include "shape_utility.h"
+#include "slab.h"
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+const size_t MESHES_PER_PAGE = 64;
+
+typedef struct mesh {
+  polygon_t *local;
+  double radius;
+  aabb_t bounds;
+  atomic_size_t refs; // bodies on any thread can share a circle
+  // circles are shared through circle_meshes; 0 for other meshes
+  double circle_radius;
+  struct mesh *next_circle;
+} mesh_t;
+
+_Thread_local slab_t *mesh_slab = NULL;
+
+// Circle outlines currently in use, looked up by radius. They are shared
+// by every thread, so the list and the last release of a circle go through
+// the lock.
+mesh_t *circle_meshes = NULL;
+pthread_mutex_t circle_meshes_lock = PTHREAD_MUTEX_INITIALIZER;
+
+slab_t *mesh_get_slab() {
+  if (mesh_slab == NULL) {
+    mesh_slab = slab_init("mesh", sizeof(mesh_t), MESHES_PER_PAGE);
+  }
+  return mesh_slab;
+}
+
+mesh_t *mesh_init(polygon_t *local) {
+  size_t n_vertices = polygon_size(local);
+  assert(n_vertices > 0);
+  mesh_t *mesh = slab_alloc(mesh_get_slab());
+  vector_t *vertices = polygon_vertices(local);
+  double radius_sq = 0;
+  aabb_t bounds = {vertices[0], vertices[0]};
+  for (size_t i = 0; i < n_vertices; i++) {
+    vector_t vertex = vertices[i];
+    radius_sq = fmax(radius_sq, vec_dot(vertex, vertex));
+    bounds.min.x = fmin(bounds.min.x, vertex.x);
+    bounds.min.y = fmin(bounds.min.y, vertex.y);
+    bounds.max.x = fmax(bounds.max.x, vertex.x);
+    bounds.max.y = fmax(bounds.max.y, vertex.y);
+  }
+  mesh->local = local;
+  mesh->radius = sqrt(radius_sq);
+  mesh->bounds = bounds;
+  atomic_init(&mesh->refs, 1);
+  mesh->circle_radius = 0;
+  mesh->next_circle = NULL;
+  return mesh;
+}
+
+mesh_t *mesh_circle(double radius) {
+  assert(radius > 0);
+  pthread_mutex_lock(&circle_meshes_lock);
+  mesh_t *mesh = circle_meshes;
+  while (mesh != NULL && mesh->circle_radius != radius) {
+    mesh = mesh->next_circle;
+  }
+  if (mesh != NULL) {
+    mesh_retain(mesh);
+  } else {
+    mesh = mesh_init(generate_ball(0, 0, radius));
+    mesh->circle_radius = radius;
+    mesh->next_circle = circle_meshes;
+    circle_meshes = mesh;
+  }
+  pthread_mutex_unlock(&circle_meshes_lock);
+  return mesh;
+}
+
+mesh_t *mesh_retain(mesh_t *mesh) {
+  atomic_fetch_add(&mesh->refs, 1);
+  return mesh;
+}
+
+void mesh_release(mesh_t *mesh) {
+  if (mesh->circle_radius == 0) {
+    size_t refs = atomic_fetch_sub(&mesh->refs, 1);
+    assert(refs > 0);
+    if (refs > 1) {
+      return;
+    }
+  } else {
+    // under the lock, so mesh_circle() cannot find it on its way out
+    pthread_mutex_lock(&circle_meshes_lock);
+    size_t refs = atomic_fetch_sub(&mesh->refs, 1);
+    assert(refs > 0);
+    if (refs == 1) {
+      mesh_t **link = &circle_meshes;
+      while (*link != mesh) {
+        link = &(*link)->next_circle;
+      }
+      *link = mesh->next_circle;
+    }
+    pthread_mutex_unlock(&circle_meshes_lock);
+    if (refs > 1) {
+      return;
+    }
+  }
+  polygon_free(mesh->local);
+  slab_release(mesh);
+}
+
+size_t mesh_refs(mesh_t *mesh) { return atomic_load(&mesh->refs); }
+
+size_t mesh_size(mesh_t *mesh) { return polygon_size(mesh->local); }
+
+vector_t *mesh_vertices(mesh_t *mesh) { return polygon_vertices(mesh->local); }
+
+double mesh_radius(mesh_t *mesh) { return mesh->radius; }
+
+aabb_t mesh_bounds(mesh_t *mesh) { return mesh->bounds; }
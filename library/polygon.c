@@ -1,35 +1,91 @@
 #include "polygon.h"
+#include <assert.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-double polygon_area(list_t *polygon) {
-  size_t poly_size = list_size(polygon);
+const size_t POLYGON_GROWTH_FACTOR = 2;
+
+typedef struct polygon {
+  size_t size;
+  size_t capacity;
+  vector_t *vertices;
+} polygon_t;
+
+polygon_t *polygon_init(size_t initial_size) {
+  polygon_t *polygon = malloc(sizeof(polygon_t));
+  assert(polygon != NULL);
+  polygon->size = 0;
+  polygon->capacity = initial_size;
+  polygon->vertices = malloc(sizeof(vector_t) * initial_size);
+  assert(polygon->vertices != NULL || initial_size == 0);
+  return polygon;
+}
+
+void polygon_free(polygon_t *polygon) {
+  free(polygon->vertices);
+  free(polygon);
+}
+
+polygon_t *polygon_copy(polygon_t *polygon) {
+  polygon_t *copy = polygon_init(polygon->size);
+  memcpy(copy->vertices, polygon->vertices, sizeof(vector_t) * polygon->size);
+  copy->size = polygon->size;
+  return copy;
+}
+
+size_t polygon_size(polygon_t *polygon) { return polygon->size; }
+
+vector_t polygon_get(polygon_t *polygon, size_t index) {
+  assert(index < polygon->size);
+  return polygon->vertices[index];
+}
+
+void polygon_set(polygon_t *polygon, size_t index, vector_t vertex) {
+  assert(index < polygon->size);
+  polygon->vertices[index] = vertex;
+}
+
+void polygon_add(polygon_t *polygon, vector_t vertex) {
+  if (polygon->size == polygon->capacity) {
+    polygon->capacity = (polygon->capacity + 1) * POLYGON_GROWTH_FACTOR;
+    polygon->vertices =
+        realloc(polygon->vertices, sizeof(vector_t) * polygon->capacity);
+    assert(polygon->vertices != NULL);
+  }
+  polygon->vertices[polygon->size++] = vertex;
+}
+
+vector_t *polygon_vertices(polygon_t *polygon) { return polygon->vertices; }
+
+double polygon_area(polygon_t *polygon) {
+  size_t poly_size = polygon->size;
+  vector_t *vertices = polygon->vertices;
   double area = 0;
 
   for (size_t i = 0; i < poly_size; i++) {
-    vector_t *vi = list_get(polygon, i % poly_size);
-    vector_t *vj = list_get(polygon, (i + 1) % poly_size);
-    area += vec_cross(vi[0], vj[0]);
+    area += vec_cross(vertices[i], vertices[(i + 1) % poly_size]);
   }
 
   area /= 2;
   return area;
 }
 
-vector_t polygon_centroid(list_t *polygon) {
-  size_t poly_size = list_size(polygon);
+vector_t polygon_centroid(polygon_t *polygon) {
+  size_t poly_size = polygon->size;
+  vector_t *vertices = polygon->vertices;
   double c_x = 0;
   double c_y = 0;
   double six_area = 6 * polygon_area(polygon);
 
   for (size_t i = 0; i < poly_size; i++) {
-    vector_t *vi = list_get(polygon, i % poly_size);
-    vector_t *vj = list_get(polygon, (i + 1) % poly_size);
-    double xi = vi->x;
-    double xj = vj->x;
-    double yi = vi->y;
-    double yj = vj->y;
+    vector_t vi = vertices[i];
+    vector_t vj = vertices[(i + 1) % poly_size];
+    double xi = vi.x;
+    double xj = vj.x;
+    double yi = vi.y;
+    double yj = vj.y;
 
     c_x += (xi + xj) * ((xi * yj) - (xj * yi));
     c_y += (yi + yj) * ((xi * yj) - (xj * yi));
@@ -42,28 +98,27 @@ vector_t polygon_centroid(list_t *polygon) {
   return centroid;
 }
 
-void polygon_translate(list_t *polygon, vector_t translation) {
-  size_t poly_size = list_size(polygon);
+void polygon_translate(polygon_t *polygon, vector_t translation) {
+  size_t poly_size = polygon->size;
+  vector_t *vertices = polygon->vertices;
 
   for (size_t i = 0; i < poly_size; i++) {
-    vector_t *vi = list_get(polygon, i);
-    *vi = vec_add(vi[0], translation);
+    vertices[i] = vec_add(vertices[i], translation);
   }
 }
 
-void polygon_rotate(list_t *polygon, double angle, vector_t point) {
-  size_t poly_size = list_size(polygon);
+void polygon_rotate(polygon_t *polygon, double angle, vector_t point) {
+  size_t poly_size = polygon->size;
+  vector_t *vertices = polygon->vertices;
+  // one sin and cos for the whole polygon instead of one per vertex
+  double c = cos(angle);
+  double s = sin(angle);
   for (size_t i = 0; i < poly_size; i++) {
-    vector_t *vi = list_get(polygon, i);
-
     // axis shift as rotation matrix around origin
-    vi->x -= point.x;
-    vi->y -= point.y;
-
-    *vi = vec_rotate(vi[0], angle);
+    vector_t v = vec_subtract(vertices[i], point);
+    v = (vector_t){v.x * c - v.y * s, v.x * s + v.y * c};
 
     // shift axis back
-    vi->x += point.x;
-    vi->y += point.y;
+    vertices[i] = vec_add(v, point);
   }
 }
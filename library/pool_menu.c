@@ -64,14 +64,12 @@ body_t *get_instructions_close_body(scene_t *scene)
 
 void menu_generate_background(scene_t *scene)
 {
-    size_t *menu_background_ID = malloc(sizeof(size_t));
-    assert(menu_background_ID != NULL);
-    *menu_background_ID = MENU_BACKGROUND_ID;
-    list_t *menu_background_shape = generate_menu_background_shape();
+    size_t *menu_background_ID = generate_ID(MENU_BACKGROUND_ID);
+    polygon_t *menu_background_shape = generate_menu_background_shape();
     sprite_info_t menu_background_sprite = menu_background_texture();
     body_t *my_menu =
         body_init_with_info(menu_background_shape, menu_background_sprite, INFINITY,
-                            menu_background_ID, free);
+                            menu_background_ID, (free_func_t)free_ID);
 
     scene_add_body(scene, my_menu);
 }
@@ -80,8 +78,7 @@ void menu_generate_buttons(scene_t *scene, size_t num_buttons)
 {
     for (size_t i = 0; i < num_buttons; i++)
     {
-        size_t *menu_button_ID = malloc(sizeof(size_t));
-        assert(menu_button_ID != NULL);
+        size_t *menu_button_ID = generate_ID(0);
         if (i == 0)
         {
             *menu_button_ID = MENU_BUTTON_2P_ID;
@@ -94,10 +91,11 @@ void menu_generate_buttons(scene_t *scene, size_t num_buttons)
         {
             *menu_button_ID = MENU_BUTTON_HARD_AI_ID;
         }
-        list_t *menu_button_shape = generate_menu_button_shape(i);
+        polygon_t *menu_button_shape = generate_menu_button_shape(i);
         sprite_info_t menu_button_sprite = menu_button_texture(i);
         body_t *my_button = body_init_with_info(menu_button_shape, 
-                            menu_button_sprite, INFINITY, menu_button_ID, free);
+                            menu_button_sprite, INFINITY, menu_button_ID,
+                            (free_func_t)free_ID);
 
         scene_add_body(scene, my_button);
     }
@@ -107,8 +105,7 @@ void menu_generate_toggles(scene_t *scene, size_t num_toggles)
 {
     for (size_t i = 0; i < num_toggles; i++)
     {
-        size_t *menu_toggle_ID = malloc(sizeof(size_t));
-        assert(menu_toggle_ID != NULL);
+        size_t *menu_toggle_ID = generate_ID(0);
         if (i == 0)
         {
             *menu_toggle_ID = MENU_BUTTON_CHAOS_ID;
@@ -120,29 +117,31 @@ void menu_generate_toggles(scene_t *scene, size_t num_toggles)
         else if (i == 2) {
             *menu_toggle_ID = MENU_BUTTON_POWERUP_ID;
         }
-        list_t *menu_toggle_shape = generate_menu_toggle_shape(i);
+        polygon_t *menu_toggle_shape = generate_menu_toggle_shape(i);
         sprite_info_t menu_toggle_sprite = menu_toggle_texture();
         body_t *my_toggle = body_init_with_info(menu_toggle_shape, 
-                            menu_toggle_sprite, INFINITY, menu_toggle_ID, free);
+                            menu_toggle_sprite, INFINITY, menu_toggle_ID,
+                            (free_func_t)free_ID);
 
         scene_add_body(scene, my_toggle);
     }
 }
 
 void generate_instructions_close(scene_t *scene) {
-    size_t *instructions_close_ID = malloc(sizeof(size_t));
-    assert(instructions_close_ID != NULL);
-    *instructions_close_ID = CLOSE_INSTRUCTIONS_BUTTON_ID;
-    list_t *instructions_close_shape = generate_instructions_close_shape();
+    size_t *instructions_close_ID = generate_ID(CLOSE_INSTRUCTIONS_BUTTON_ID);
+    polygon_t *instructions_close_shape = generate_instructions_close_shape();
     sprite_info_t instructions_close_sprite = instructions_close_texture();
     body_t *my_button = body_init_with_info(instructions_close_shape, 
-            instructions_close_sprite, INFINITY, instructions_close_ID, free);
+            instructions_close_sprite, INFINITY, instructions_close_ID,
+            (free_func_t)free_ID);
 
     scene_add_body(scene, my_button);
 }
 
 void generate_menu(scene_t *scene)
 {
+    // the menu's bodies are looked up by ID, like the table's
+    scene_set_tagger(scene, body_id);
     menu_generate_background(scene);
     menu_generate_buttons(scene, NUM_BUTTONS);
     menu_generate_toggles(scene, NUM_TOGGLES);
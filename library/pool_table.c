@@ -1,17 +1,18 @@
 #include "pool_table.h"
+#include "event_sim.h"
 #include "forces.h"
 #include "graphics.h"
 #include "ids.h"
 #include "list.h"
 #include "polygon.h"
+#include "rng.h"
 #include "scene.h"
-#include "sdl_wrapper.h"
 #include "shape_utility.h"
+#include "slab.h"
 #include <assert.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
 
 // Ball constants
 const double BALL_MASS = 1;
@@ -19,6 +20,7 @@ const size_t NUM_STRIPED_BALLS = 7;
 const size_t NUM_SOLID_BALLS = 7;
 const double POCKET_RADIUS = 2;
 const size_t MAX_EXTRA_BALLS = 3;
+const size_t IDS_PER_PAGE = 64;
 
 const double DRAG_COEFF = 0.3;
 const double CONST_DRAG = 0.2;
@@ -29,9 +31,23 @@ const double CHAOS_BALL_BALL_SCALER = 0.5;
 // elasiticty coeff for
 const double WALL_BALL_CR = 0.8;
 const double STICK_MASS = 1;
+// elasticity coeff for stick-cueball collision
+const double STICK_BALL_CR = 0.8;
 
 // the threshold at which we say a ball stopped
 const double BALL_ZERO_THRESH = 0.05;
+// how long a body must stay below it before it falls asleep
+const double BALL_REST_TIME = 0.1;
+// below this speed the constant drag stops (see forces.c)
+extern const double VEL_THRESH;
+
+// Collision categories, as bitmasks for scene_add_collider()
+const size_t BALL_CATEGORY = 1 << 0;
+const size_t CUEBALL_CATEGORY = 1 << 1;
+const size_t WALL_CATEGORY = 1 << 2;
+const size_t POCKET_CATEGORY = 1 << 3;
+const size_t POWER_UP_CATEGORY = 1 << 4;
+const size_t STICK_CATEGORY = 1 << 5;
 
 // Volume constants
 const double DEFAULT_VOLUME = 128;
@@ -51,33 +67,53 @@ const double POWER_UP_MASS = 100;
 const vector_t POWER_UP_MIN = {200, 100};
 const vector_t POWER_UP_RANGE = {600, 300};
 
-void shuffle(size_t *array, size_t n) {
+// Plays collision/pocketing sounds; NULL in headless builds
+sound_handler_t sound_handler = NULL;
+
+void pool_table_on_sound(sound_handler_t handler) {
+    sound_handler = handler;
+}
+
+void play_sound(char *effect_path, double volume) {
+    if (sound_handler != NULL) {
+        sound_handler(effect_path, volume);
+    }
+}
+
+void shuffle(size_t *array, size_t n, rng_t *rng) {
     for (size_t i = 0; i < n; i++) {
-        size_t j = rand() % (n);
+        size_t j = rng_below(rng, n);
         size_t t = array[j];
         array[j] = array[i];
         array[i] = t;
     }
 }
 
+_Thread_local slab_t *id_slab = NULL;
+
 size_t *generate_ID(size_t object_id) {
-    size_t *object_ID = malloc(sizeof(size_t));
-    assert(object_ID != NULL);
+    if (id_slab == NULL) {
+        id_slab = slab_init("id", sizeof(size_t), IDS_PER_PAGE);
+    }
+    size_t *object_ID = slab_alloc(id_slab);
     *object_ID = object_id;
     return object_ID;
 }
 
+void free_ID(size_t *object_ID) {
+    slab_release(object_ID);
+}
+
 void generate_striped_balls(scene_t *scene, list_t *img_list, list_t *rack_pos) {
     for (size_t i = 0; i < NUM_STRIPED_BALLS; i++) {
         size_t *ball_ID = generate_ID(STRIPED_BALL_ID);
         vector_t position = *(vector_t *)list_get(rack_pos, 2 * i + 1);
-        list_t *stripedball_shape = generate_ball(position.x, position.y,
-                                                  get_ball_radius());
         sprite_info_t stripedball_sprite = striped_balls_textures(img_list,
                                                                   rack_pos, i);
         body_t *my_ball =
-            body_init_with_info(stripedball_shape, stripedball_sprite, BALL_MASS,
-                                ball_ID, free);
+            body_init_circle_with_info(position, get_ball_radius(),
+                                       stripedball_sprite, BALL_MASS,
+                                       ball_ID, (free_func_t)free_ID);
         body_set_velocity(my_ball, VEC_ZERO);
         scene_add_body(scene, my_ball);
     }
@@ -87,12 +123,11 @@ void generate_solid_balls(scene_t *scene, list_t *img_list, list_t *rack_pos) {
     for (size_t i = 0; i < NUM_SOLID_BALLS; i++) {
         size_t *ball_ID = generate_ID(SOLID_BALL_ID);
         vector_t position = *(vector_t *)list_get(rack_pos, 2 * i);
-        list_t *solidball_shape = generate_ball(position.x, position.y,
-                                                get_ball_radius());
         sprite_info_t solidball_sprite = solid_balls_textures(img_list, rack_pos, i);
         body_t *my_ball =
-            body_init_with_info(solidball_shape, solidball_sprite, BALL_MASS,
-                                ball_ID, free);
+            body_init_circle_with_info(position, get_ball_radius(),
+                                       solidball_sprite, BALL_MASS,
+                                       ball_ID, (free_func_t)free_ID);
         body_set_velocity(my_ball, VEC_ZERO);
         scene_add_body(scene, my_ball);
     }
@@ -101,12 +136,11 @@ void generate_solid_balls(scene_t *scene, list_t *img_list, list_t *rack_pos) {
 void generate_eightball(scene_t *scene) {
     size_t *ball_ID = generate_ID(EIGHTBALL_ID);
     vector_t eightball_pos = get_eightball_init_pos();
-    list_t *eightball_shape = generate_ball(eightball_pos.x, eightball_pos.y,
-                                            get_ball_radius());
     sprite_info_t eightball_sprite = eightball_texture();
     body_t *my_ball =
-        body_init_with_info(eightball_shape, eightball_sprite, BALL_MASS,
-                            ball_ID, free);
+        body_init_circle_with_info(eightball_pos, get_ball_radius(),
+                                   eightball_sprite, BALL_MASS, ball_ID,
+                                   (free_func_t)free_ID);
     body_set_velocity(my_ball, VEC_ZERO);
     scene_add_body(scene, my_ball);
 }
@@ -115,14 +149,14 @@ void ball_collision_sound(body_t *body1, body_t *body2, vector_t axis, void *aux
     double vel_mag = vec_magnitude(vec_subtract(body_get_velocity(body1),
                                                 body_get_velocity(body2)));
     double volume = DEFAULT_VOLUME * vel_mag / HIGH_VELOCITY;
-    sdl_play_sound_effect("assets/ballhitball.wav", volume);
+    play_sound("assets/ballhitball.wav", volume);
 }
 
 void poolstick_hit_cue_sound(body_t *body1, body_t *body2, vector_t axis, void *aux) {
     double vel_mag = vec_magnitude(vec_subtract(body_get_velocity(body1),
                                                 body_get_velocity(body2)));
     double volume = DEFAULT_VOLUME * vel_mag / HIGH_VELOCITY;
-    sdl_play_sound_effect("assets/poolstickhitcue.wav", volume);
+    play_sound("assets/poolstickhitcue.wav", volume);
 }
 
 double get_cr(bool chaos) {
@@ -135,60 +169,41 @@ double get_cr(bool chaos) {
 void ball_in_power_up(body_t *body1, body_t *body2, vector_t axis, void *aux) {
     body_remove(body1); // we destroy the powerup
     double volume = DEFAULT_VOLUME / 2;
-    sdl_play_sound_effect("assets/powerup.wav", volume);
+    play_sound("assets/powerup.wav", volume);
 }
 
-void put_cueball(scene_t *scene, list_t *shape, bool chaos, bool powerup) {
+void put_cueball(scene_t *scene, polygon_t *shape, bool chaos, bool powerup) {
     size_t *ball_ID = generate_ID(CUEBALL_ID);
-    sprite_info_t cueball_sprite = cueball_texture(polygon_centroid(shape));
+    vector_t cueball_pos = polygon_centroid(shape);
+    polygon_free(shape);
+    sprite_info_t cueball_sprite = cueball_texture(cueball_pos);
     body_t *my_ball =
-        body_init_with_info(shape, cueball_sprite, BALL_MASS, ball_ID, free);
+        body_init_circle_with_info(cueball_pos, get_ball_radius(),
+                                   cueball_sprite, BALL_MASS, ball_ID,
+                                   (free_func_t)free_ID);
     body_set_velocity(my_ball, VEC_ZERO);
     scene_add_body(scene, my_ball);
+    scene_add_collider(scene, my_ball, collision_categories(my_ball));
 
     size_t bodies = scene_bodies(scene);
-    size_t body_indexes[NUM_SOLID_BALLS + NUM_STRIPED_BALLS + MAX_EXTRA_BALLS];
-    size_t body_indexes2[NUM_SOLID_BALLS + NUM_STRIPED_BALLS + MAX_EXTRA_BALLS];
+    body_t *balls[NUM_SOLID_BALLS + NUM_STRIPED_BALLS + MAX_EXTRA_BALLS];
+    size_t partners[NUM_SOLID_BALLS + NUM_STRIPED_BALLS + MAX_EXTRA_BALLS];
     size_t k = 0;
     for (size_t i = 0; i < bodies; i++) {
         body_t *body = scene_get_body(scene, i);
-        if (body != my_ball) {
-            size_t info = *((size_t *)body_get_info(body));
-            if (is_ball(body)) { // ball-ball
-                create_physics_collision(scene, get_cr(chaos), my_ball, body);
-                create_collision(scene, my_ball, body,
-                                 (collision_handler_t)ball_collision_sound, NULL, NULL);
-                body_indexes[k] = i;
-                body_indexes2[k] = i;
-                k++;
-            }
-            // Wall-ball
-            if (info == WALL_ID) {
-                create_physics_collision(scene, WALL_BALL_CR, my_ball, body);
-                create_collision(scene, my_ball, body,
-                                 (collision_handler_t)ball_collision_sound, NULL, NULL);
-            }
-            // Pocketing collisions
-            if (info == POCKET_ID) {
-                create_collision(scene, my_ball, body,
-                                 (collision_handler_t)ball_in_pocket, NULL, NULL);
-            }
-            // Powerup "collision": just removes the powerup
-            if (info == POWER_UP_ID) {
-                create_collision(scene, body, my_ball,
-                                 (collision_handler_t)ball_in_power_up, NULL, NULL);
-            }
+        if (body != my_ball && is_ball(body)) {
+            balls[k] = body;
+            partners[k] = k;
+            k++;
         }
     }
 
     if (chaos) {
-        shuffle(body_indexes2, k);
+        shuffle(partners, k, scene_rng(scene));
         for (size_t j = 0; j < k; j++) {
-            if (body_indexes[j] != body_indexes2[j]) {
-                body_t *bodyB = scene_get_body(scene, body_indexes[j]);
-                body_t *bodyC = scene_get_body(scene, body_indexes2[j]);
-                create_chaos_physics_collision(scene, get_cr(chaos),
-                                               my_ball, bodyB, bodyC);
+            if (partners[j] != j) {
+                create_chaos_physics_collision(scene, get_cr(chaos), my_ball,
+                                               balls[j], balls[partners[j]]);
             }
         }
     }
@@ -200,11 +215,11 @@ void put_cueball(scene_t *scene, list_t *shape, bool chaos, bool powerup) {
 void generate_cueball(scene_t *scene) {
     size_t *ball_ID = generate_ID(CUEBALL_ID);
     vector_t cueball_pos = get_cueball_init_pos();
-    list_t *cueball_shape = generate_ball(cueball_pos.x, cueball_pos.y,
-                                          get_ball_radius());
     sprite_info_t cueball_sprite = cueball_texture(get_cueball_init_pos());
     body_t *my_ball =
-        body_init_with_info(cueball_shape, cueball_sprite, BALL_MASS, ball_ID, free);
+        body_init_circle_with_info(cueball_pos, get_ball_radius(),
+                                   cueball_sprite, BALL_MASS, ball_ID,
+                                   (free_func_t)free_ID);
     body_set_velocity(my_ball, VEC_ZERO);
     scene_add_body(scene, my_ball);
 }
@@ -212,37 +227,41 @@ void generate_cueball(scene_t *scene) {
 /* Generates the top wall of the pool table and overlays the entire pooltable sprite. */
 void generate_table_top(scene_t *scene) {
     size_t *wall_ID = generate_ID(WALL_ID);
-    list_t *table_top_shape = generate_table_top_shape();
+    polygon_t *table_top_shape = generate_table_top_shape();
     sprite_info_t table_top_sprite = table_top_texture();
     body_t *my_table = body_init_with_info(table_top_shape, table_top_sprite,
-                                           INFINITY, wall_ID, free);
+                                           INFINITY, wall_ID,
+                                           (free_func_t)free_ID);
     scene_add_body(scene, my_table);
 }
 
 void generate_table_left(scene_t *scene) {
     size_t *wall_ID = generate_ID(WALL_ID);
-    list_t *table_left_shape = generate_table_left_shape();
+    polygon_t *table_left_shape = generate_table_left_shape();
     sprite_info_t wall_sprite = wall_texture();
     body_t *my_table = body_init_with_info(table_left_shape, wall_sprite,
-                                           INFINITY, wall_ID, free);
+                                           INFINITY, wall_ID,
+                                           (free_func_t)free_ID);
     scene_add_body(scene, my_table);
 }
 
 void generate_table_right(scene_t *scene) {
     size_t *wall_ID = generate_ID(WALL_ID);
-    list_t *table_right_shape = generate_table_right_shape();
+    polygon_t *table_right_shape = generate_table_right_shape();
     sprite_info_t wall_sprite = wall_texture();
     body_t *my_table = body_init_with_info(table_right_shape, wall_sprite,
-                                           INFINITY, wall_ID, free);
+                                           INFINITY, wall_ID,
+                                           (free_func_t)free_ID);
     scene_add_body(scene, my_table);
 }
 
 void generate_table_bottom(scene_t *scene) {
     size_t *wall_ID = generate_ID(WALL_ID);
-    list_t *table_bottom_shape = generate_table_bottom_shape();
+    polygon_t *table_bottom_shape = generate_table_bottom_shape();
     sprite_info_t wall_sprite = wall_texture();
     body_t *my_table = body_init_with_info(table_bottom_shape, wall_sprite,
-                                           INFINITY, wall_ID, free);
+                                           INFINITY, wall_ID,
+                                           (free_func_t)free_ID);
     scene_add_body(scene, my_table);
 }
 
@@ -255,11 +274,10 @@ void generate_table_body(scene_t *scene) {
 
 void generate_pocket(scene_t *scene, double x, double y, double radius) {
     size_t *pocket_ID = generate_ID(POCKET_ID);
-    list_t *pocket_shape = generate_ball(x, y, radius);
     sprite_info_t pocket_sprite = pocket_texture();
     body_t *my_pocket =
-        body_init_with_info(pocket_shape, pocket_sprite, INFINITY,
-                            pocket_ID, free);
+        body_init_circle_with_info((vector_t){x, y}, radius, pocket_sprite,
+                                   INFINITY, pocket_ID, (free_func_t)free_ID);
     scene_add_body(scene, my_pocket);
 }
 
@@ -282,28 +300,45 @@ void generate_ball_rack(scene_t *scene) {
     generate_eightball(scene);
     generate_cueball(scene);
     list_free(rack_pos);
+    list_free(img_list);
 }
 
 /* Generates all the table objects */
+event_sim_t *pool_event_sim(scene_t *scene) {
+    event_sim_params_t params = {.ball_radius = get_ball_radius(),
+                                 .ball_mass = BALL_MASS,
+                                 .drag = DRAG_COEFF,
+                                 .constant_drag = CONST_DRAG,
+                                 .constant_drag_min_speed = VEL_THRESH,
+                                 .stop_speed = BALL_ZERO_THRESH,
+                                 .ball_elasticity = BALL_BALL_CR,
+                                 .cushion_elasticity = WALL_BALL_CR};
+    event_sim_t *sim = event_sim_init(params);
+    for (size_t i = 0; i < scene_bodies(scene); i++) {
+        body_t *body = scene_get_body(scene, i);
+        size_t categories = collision_categories(body);
+        if (categories & BALL_CATEGORY) {
+            event_sim_add_ball(sim, body, body_get_centroid(body),
+                               body_get_velocity(body));
+        } else if (categories & WALL_CATEGORY) {
+            event_sim_add_cushion(sim, body_get_shape(body));
+        } else if (categories & POCKET_CATEGORY) {
+            event_sim_add_pocket(sim, body_get_centroid(body),
+                                 body_get_radius(body));
+        }
+    }
+    return sim;
+}
+
 void generate_table(scene_t *scene) {
     generate_table_body(scene);
     generate_all_pockets(scene);
 }
 
 bool balls_stopped(scene_t *scene) {
-    if (get_poolstick_body(scene) != NULL) {
-        return false;
-    }
-    for (size_t i = 0; i < scene_bodies(scene); i++) {
-        body_t *my_body = scene_get_body(scene, i);
-        if (is_ball(my_body)) {
-            if (fabs(body_get_velocity(my_body).x) > BALL_ZERO_THRESH ||
-                fabs(body_get_velocity(my_body).y) > BALL_ZERO_THRESH) {
-                return false;
-            }
-        }
-    }
-    return true;
+    // the table, pockets and resting balls all fall asleep, so the scene is
+    // only fully asleep once every ball has stopped
+    return scene_is_asleep(scene) && get_poolstick_body(scene) == NULL;
 }
 
 bool is_ball(body_t *body) {
@@ -323,7 +358,7 @@ bool is_ball(body_t *body) {
 void ball_in_pocket(body_t *body1, body_t *body2, vector_t axis, void *aux) {
     body_remove(body1); // we destroy the ball
     double volume = DEFAULT_VOLUME;
-    sdl_play_sound_effect("assets/ballinpocket.wav", volume);
+    play_sound("assets/ballinpocket.wav", volume);
 }
 
 bool is_cueball(body_t *body) {
@@ -336,88 +371,97 @@ bool is_powerup(body_t *body) {
     return (*((size_t *)info) == POWER_UP_ID);
 }
 
+size_t collision_categories(body_t *body) {
+    size_t info = *((size_t *)body_get_info(body));
+    if (is_cueball(body)) {
+        return BALL_CATEGORY | CUEBALL_CATEGORY;
+    } else if (is_ball(body)) {
+        return BALL_CATEGORY;
+    } else if (info == WALL_ID) {
+        return WALL_CATEGORY;
+    } else if (info == POCKET_ID) {
+        return POCKET_CATEGORY;
+    } else if (info == POWER_UP_ID) {
+        return POWER_UP_CATEGORY;
+    } else if (info == POOLSTICK_ID) {
+        return STICK_CATEGORY;
+    }
+    return 0;
+}
+
+void add_collision_rules(scene_t *scene, bool chaos) {
+    create_physics_collision_rule(scene, get_cr(chaos), BALL_CATEGORY,
+                                  BALL_CATEGORY);
+    create_physics_collision_rule(scene, WALL_BALL_CR, BALL_CATEGORY,
+                                  WALL_CATEGORY);
+    scene_add_collision_rule(scene, BALL_CATEGORY,
+                             BALL_CATEGORY | WALL_CATEGORY,
+                             (collision_handler_t)ball_collision_sound, NULL,
+                             NULL);
+    scene_add_collision_rule(scene, BALL_CATEGORY, POCKET_CATEGORY,
+                             (collision_handler_t)ball_in_pocket, NULL, NULL);
+    // Powerup "collision": just removes the powerup
+    scene_add_collision_rule(scene, POWER_UP_CATEGORY, CUEBALL_CATEGORY,
+                             (collision_handler_t)ball_in_power_up, NULL, NULL);
+    // The stick is destroyed once it hits the cueball
+    create_destructive_physics_collision_rule(scene, STICK_BALL_CR,
+                                              CUEBALL_CATEGORY, STICK_CATEGORY);
+    scene_add_collision_rule(scene, CUEBALL_CATEGORY, STICK_CATEGORY,
+                             (collision_handler_t)poolstick_hit_cue_sound,
+                             NULL, NULL);
+    if (chaos) {
+        // The chaos forcers also react to balls hitting the powerup
+        scene_add_collision_rule(scene, BALL_CATEGORY, POWER_UP_CATEGORY, NULL,
+                                 NULL, NULL);
+    }
+}
+
 void add_collisions(scene_t *scene, bool chaos, bool powerup) {
     size_t body_count = scene_bodies(scene);
-
-    // Adding the drag forces
-    for (size_t i = 0; i < body_count; i++) {
-        body_t *body = scene_get_body(scene, i);
-        if (is_ball(body)) {
-            create_drag(scene, DRAG_COEFF, body);
-            create_constant_drag_force(scene, CONST_DRAG, body);
-        }
-    }
     double ball_ball = get_cr(chaos);
+    add_collision_rules(scene, chaos);
 
-    // Adding collisions
     size_t extra_balls = 2; // cueball and eightball
     if (powerup) {
         extra_balls++;
     }
-    size_t body_indexes[NUM_SOLID_BALLS + NUM_STRIPED_BALLS + extra_balls];
-    size_t body_indexes2[NUM_SOLID_BALLS + NUM_STRIPED_BALLS + extra_balls];
+    body_t *balls[NUM_SOLID_BALLS + NUM_STRIPED_BALLS + extra_balls];
+    size_t partners[NUM_SOLID_BALLS + NUM_STRIPED_BALLS + extra_balls];
     size_t k = 0;
-    for (size_t i = 1; i < body_count; i++) {
-        body_t *body1 = scene_get_body(scene, i);
-        if (is_ball(body1) || is_powerup(body1)) {
-            body_indexes[k] = i;
-            body_indexes2[k] = i;
+    for (size_t i = 0; i < body_count; i++) {
+        body_t *body = scene_get_body(scene, i);
+        // Adding the drag forces
+        if (is_ball(body)) {
+            create_drag(scene, DRAG_COEFF, body);
+            create_constant_drag_force(scene, CONST_DRAG, body);
+        }
+        if (is_ball(body) || is_powerup(body)) {
+            balls[k] = body;
+            partners[k] = k;
             k++;
         }
-        for (size_t j = 0; j < i; j++) {
-            body_t *body2 = scene_get_body(scene, j);
-            size_t info1 = *((size_t *)body_get_info(body1));
-            size_t info2 = *((size_t *)body_get_info(body2));
-            if (is_ball(body1) && is_ball(body2)) { // ball-ball
-                create_physics_collision(scene, ball_ball, body1, body2);
-                create_collision(scene, body1, body2,
-                                 (collision_handler_t)ball_collision_sound, NULL, NULL);
-            }
-            // Wall-ball
-            if ((is_ball(body1) && info2 == WALL_ID) ||
-                (info1 == WALL_ID && is_ball(body2))) {
-                create_physics_collision(scene, WALL_BALL_CR, body1, body2);
-                create_collision(scene, body1, body2,
-                                 (collision_handler_t)ball_collision_sound, NULL, NULL);
-            }
-            // Pocketing collisions
-            if (info1 == POCKET_ID && is_ball(body2)) {
-                create_collision(scene, body2, body1,
-                                 (collision_handler_t)ball_in_pocket, NULL, NULL);
-            }
-            if (info2 == POCKET_ID && is_ball(body1)) {
-                create_collision(scene, body1, body2,
-                                 (collision_handler_t)ball_in_pocket, NULL, NULL);
-            }
-            // Powerup "collision": just removes the powerup
-            if (info1 == POWER_UP_ID && is_cueball(body2)) {
-                create_collision(scene, body1, body2,
-                                 (collision_handler_t)ball_in_power_up, NULL, NULL);
-            }
-            if (info2 == POWER_UP_ID && is_cueball(body1)) {
-                create_collision(scene, body2, body1,
-                                 (collision_handler_t)ball_in_power_up, NULL, NULL);
-            }
+        size_t categories = collision_categories(body);
+        if (categories != 0) {
+            scene_add_collider(scene, body, categories);
         }
     }
 
     // Chaos mode setup between balls
     if (chaos) {
-        shuffle(body_indexes2, k);
+        shuffle(partners, k, scene_rng(scene));
         for (size_t i = 0; i < k; i++) {
             for (size_t j = 0; j < k; j++) {
                 if (i != j) {
-                    body_t *bodyA = scene_get_body(scene, body_indexes[i]);
-                    body_t *bodyB = scene_get_body(scene, body_indexes[j]);
                     body_t *bodyC;
                     if (i < j) {
-                        bodyC = scene_get_body(scene, body_indexes2[i]);
+                        bodyC = balls[partners[i]];
                     } else {
-                        bodyC = scene_get_body(scene, body_indexes2[j]);
+                        bodyC = balls[partners[j]];
                     }
-                    if (body_indexes[i] != body_indexes2[i]) {
+                    if (partners[i] != i) {
                         create_chaos_physics_collision(scene, ball_ball,
-                                                       bodyA, bodyB, bodyC);
+                                                       balls[i], balls[j],
+                                                       bodyC);
                     }
                 }
             }
@@ -426,11 +470,11 @@ void add_collisions(scene_t *scene, bool chaos, bool powerup) {
 }
 
 vector_t random_spot(scene_t *scene) {
-    srand(time(NULL));
+    rng_t *rng = scene_rng(scene);
     bool keep_searching = true;
     while (keep_searching) {
-        double rand_x = rand() % (int32_t)POWER_UP_RANGE.x + POWER_UP_MIN.x;
-        double rand_y = rand() % (int32_t)POWER_UP_RANGE.y + POWER_UP_MIN.y;
+        double rand_x = rng_below(rng, POWER_UP_RANGE.x) + POWER_UP_MIN.x;
+        double rand_y = rng_below(rng, POWER_UP_RANGE.y) + POWER_UP_MIN.y;
         vector_t candidate = {rand_x, rand_y};
         keep_searching = false;
         for (int i = 0; i < scene_bodies(scene); i++) {
@@ -451,6 +495,9 @@ vector_t random_spot(scene_t *scene) {
 }
 
 void generate_pool_table(scene_t *scene, bool chaos, bool powerup) {
+    // every body in a pool scene has an ID, so the scene indexes them by it
+    scene_set_tagger(scene, body_id);
+    scene_set_sleep_threshold(scene, BALL_ZERO_THRESH, BALL_REST_TIME);
     generate_table(scene);
     generate_ball_rack(scene);
     if (powerup) {
@@ -464,32 +511,23 @@ void generate_poolstick(scene_t *scene, vector_t my_position,
                         vector_t cueball_position) {
     size_t *poolstick_ID = generate_ID(POOLSTICK_ID);
 
-    list_t *shape = poolstick_shape(my_position, cueball_position);
+    polygon_t *shape = poolstick_shape(my_position, cueball_position);
     sprite_info_t sprite = poolstick_texture();
 
     body_t *my_poolstick =
-        body_init_with_info(shape, sprite, STICK_MASS, poolstick_ID, free);
+        body_init_with_info(shape, sprite, STICK_MASS, poolstick_ID,
+                            (free_func_t)free_ID);
 
-    setup_ball_stick_collisions(my_poolstick, scene, 0.8);
     scene_add_body(scene, my_poolstick);
+    setup_ball_stick_collisions(my_poolstick, scene);
 }
 
-void setup_ball_stick_collisions(body_t *stick, scene_t *scene, double elasticity) {
-    body_t *my_body = get_cueball_body(scene);
-    create_destructive_physics_collision(scene, elasticity, my_body, stick);
-    create_collision(scene, my_body, stick,
-                     (collision_handler_t)poolstick_hit_cue_sound, NULL, NULL);
+void setup_ball_stick_collisions(body_t *stick, scene_t *scene) {
+    scene_add_collider(scene, stick, collision_categories(stick));
 }
 
 size_t count_balls(scene_t *scene, size_t searched_id) {
-    size_t ans = 0;
-    for (size_t i = 0; i < scene_bodies(scene); i++) {
-        body_t *my_body = scene_get_body(scene, i);
-        if (*(size_t *)body_get_info(my_body) == searched_id) {
-            ans++;
-        }
-    }
-    return ans;
+    return scene_tagged_count(scene, searched_id);
 }
 
 size_t striped_count(scene_t *scene) {
@@ -513,26 +551,20 @@ bool powerup_triggered(scene_t *scene) {
 }
 
 void generate_power_bar(scene_t *scene) {
-    list_t *inside_shape = generate_rect_shape(POWER_BAR_START.x, POWER_BAR_START.y,
-                                               POWER_BAR_WIDTH, POWER_BAR_HEIGHT);
-    list_t *outside_shape = generate_rect_shape(POWER_BAR_START.x, POWER_BAR_START.y,
+    polygon_t *inside_shape = generate_rect_shape(POWER_BAR_START.x, POWER_BAR_START.y,
+                                                  POWER_BAR_WIDTH, POWER_BAR_HEIGHT);
+    polygon_t *outside_shape = generate_rect_shape(POWER_BAR_START.x, POWER_BAR_START.y,
         POWER_BAR_WIDTH + POWER_BAR_OUTSIDE_GAP * 2,
         POWER_BAR_HEIGHT + POWER_BAR_OUTSIDE_GAP * 2);
-    list_t *charge_shape = generate_rect_shape(POWER_BAR_START.x, POWER_BAR_START.y 
+    polygon_t *charge_shape = generate_rect_shape(POWER_BAR_START.x, POWER_BAR_START.y 
         - POWER_BAR_HEIGHT / 2 + POWER_BAR_HEIGHT * POWER_BAR_INIT_CHARGE / 2,
         POWER_BAR_WIDTH, POWER_BAR_HEIGHT * POWER_BAR_INIT_CHARGE);
 
-    size_t *inside_shape_ID = malloc(sizeof(size_t));
-    assert(inside_shape_ID != NULL);
-    *inside_shape_ID = POWER_BAR_INSIDE_ID;
+    size_t *inside_shape_ID = generate_ID(POWER_BAR_INSIDE_ID);
 
-    size_t *outside_shape_ID = malloc(sizeof(size_t));
-    assert(outside_shape_ID != NULL);
-    *outside_shape_ID = POWER_BAR_OUTSIDE_ID;
+    size_t *outside_shape_ID = generate_ID(POWER_BAR_OUTSIDE_ID);
 
-    size_t *charge_shape_ID = malloc(sizeof(size_t));
-    assert(charge_shape_ID != NULL);
-    *charge_shape_ID = POWER_BAR_CHARGE_ID;
+    size_t *charge_shape_ID = generate_ID(POWER_BAR_CHARGE_ID);
 
     sprite_info_t inside_sprite = powerbar_inside_texture();
     sprite_info_t outside_sprite = powerbar_outside_texture();
@@ -540,15 +572,15 @@ void generate_power_bar(scene_t *scene) {
 
     body_t *inside_power_bar =
         body_init_with_info(inside_shape, inside_sprite, POWER_BAR_MASS,
-                            inside_shape_ID, free);
+                            inside_shape_ID, (free_func_t)free_ID);
 
     body_t *outside_power_bar =
         body_init_with_info(outside_shape, outside_sprite, POWER_BAR_MASS,
-                            outside_shape_ID, free);
+                            outside_shape_ID, (free_func_t)free_ID);
 
     body_t *charge_power_bar =
         body_init_with_info(charge_shape, charge_sprite, POWER_BAR_MASS,
-                            charge_shape_ID, free);
+                            charge_shape_ID, (free_func_t)free_ID);
 
     scene_add_body(scene, outside_power_bar);
     scene_add_body(scene, inside_power_bar);
@@ -557,9 +589,9 @@ void generate_power_bar(scene_t *scene) {
 
 double get_charge(scene_t *scene) {
     body_t *charge_body = get_power_bar_charge_body(scene);
-    list_t *charge_shape = body_get_shape(charge_body);
-    double charge = fabs(((*(vector_t *)list_get(charge_shape, 1)).y -
-                          (*(vector_t *)list_get(charge_shape, 2)).y) /
+    polygon_t *charge_shape = body_get_shape(charge_body);
+    double charge = fabs((polygon_get(charge_shape, 1).y -
+                          polygon_get(charge_shape, 2).y) /
                          POWER_BAR_HEIGHT);
     return charge;
 }
@@ -573,20 +605,17 @@ void charge_power_bar(scene_t *scene, double charge_add) {
         charge = 1.0;
     }
 
-    list_t *charge_shape = generate_rect_shape(POWER_BAR_START.x, POWER_BAR_START.y
+    polygon_t *charge_shape = generate_rect_shape(POWER_BAR_START.x, POWER_BAR_START.y
      - POWER_BAR_HEIGHT / 2 + POWER_BAR_HEIGHT * charge / 2, POWER_BAR_WIDTH,
      POWER_BAR_HEIGHT * charge);
     body_set_shape(power_bar, charge_shape);
 }
 
 body_t *get_specified_body(scene_t *scene, size_t id) {
-    for (size_t i = 0; i < scene_bodies(scene); i++) {
-        body_t *my_body = scene_get_body(scene, i);
-        if (*(size_t *)body_get_info(my_body) == id) {
-            return my_body;
-        }
+    if (scene_tagged_count(scene, id) == 0) {
+        return NULL;
     }
-    return NULL;
+    return scene_get_tagged(scene, id, 0);
 }
 
 size_t body_id(body_t *body) {
@@ -632,12 +661,12 @@ void update_poolstick(scene_t *scene, vector_t my_position) {
     if (poolstick == NULL) {
         generate_poolstick(scene, my_position, cue_point);
     } else {
-        list_t *shape = body_get_deepcopied_shape(poolstick);
+        polygon_t *shape = body_get_deepcopied_shape(poolstick);
         vector_t angle_of_attack = vec_unit(vec_subtract(my_position, cue_point));
         vector_t new_centroid = vec_add(vec_multiply(vec_magnitude(
                 POOLSTICK_DIMENSION) / 2, angle_of_attack), my_position);
-        vector_t b = vec_unit(vec_subtract(*(vector_t *)list_get(shape, 0),
-                                           *(vector_t *)list_get(shape, 1)));
+        vector_t b = vec_unit(vec_subtract(polygon_get(shape, 0),
+                                           polygon_get(shape, 1)));
         vector_t a = vec_multiply(-1, angle_of_attack);
         double angle = atan2(b.x * a.y - b.y * a.x, b.x * a.x + b.y * a.y);
 
@@ -650,11 +679,12 @@ void update_poolstick(scene_t *scene, vector_t my_position) {
 void generate_power_up(scene_t *scene, vector_t position) {
     size_t *power_up_ID = generate_ID(POWER_UP_ID);
 
-    list_t *shape = generate_ball(position.x, position.y, POWER_UP_RADIUS);
     sprite_info_t sprite = power_up_texture(position);
 
     body_t *my_power_up =
-        body_init_with_info(shape, sprite, POWER_UP_MASS, power_up_ID, free);
+        body_init_circle_with_info(position, POWER_UP_RADIUS, sprite,
+                                   POWER_UP_MASS, power_up_ID,
+                                   (free_func_t)free_ID);
 
     scene_add_body(scene, my_power_up);
 }
@@ -0,0 +1,49 @@
+#include "rng.h"
+#include <assert.h>
+
+uint64_t rotate_left(uint64_t x, int bits) {
+  return (x << bits) | (x >> (64 - bits));
+}
+
+// splitmix64, which spreads similar seeds over the whole state
+uint64_t splitmix(uint64_t *x) {
+  uint64_t z = (*x += 0x9e3779b97f4a7c15);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  return z ^ (z >> 31);
+}
+
+void rng_seed(rng_t *rng, uint64_t seed) {
+  for (size_t i = 0; i < 4; i++) {
+    rng->state[i] = splitmix(&seed);
+  }
+}
+
+uint64_t rng_next(rng_t *rng) {
+  uint64_t *s = rng->state;
+  uint64_t result = rotate_left(s[1] * 5, 7) * 9;
+  uint64_t t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotate_left(s[3], 45);
+  return result;
+}
+
+double rng_uniform(rng_t *rng) {
+  // the top 53 bits fill a double's mantissa exactly
+  return (rng_next(rng) >> 11) * 0x1.0p-53;
+}
+
+size_t rng_below(rng_t *rng, size_t n) {
+  assert(n > 0);
+  // reject the top partial copy of [0, n) so every result is equally likely
+  uint64_t limit = UINT64_MAX - UINT64_MAX % n;
+  uint64_t x;
+  do {
+    x = rng_next(rng);
+  } while (x >= limit);
+  return x % n;
+}
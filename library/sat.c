@@ -0,0 +1,231 @@
+#include "sat.h"
+#include "vector.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SAT_X86
+#endif
+
+sat_kernel_t sat_kernel = SAT_SCALAR;
+bool sat_kernel_chosen = false;
+
+// The vertices are stored as x, y pairs, so they can be read as doubles
+vector_t project_scalar(vector_t *vertices, size_t n_vertices, vector_t axis) {
+  double min = vertices[0].x * axis.x + vertices[0].y * axis.y;
+  double max = min;
+  for (size_t i = 1; i < n_vertices; i++) {
+    double proj = vertices[i].x * axis.x + vertices[i].y * axis.y;
+    if (proj < min) {
+      min = proj;
+    }
+    if (proj > max) {
+      max = proj;
+    }
+  }
+  return (vector_t){min, max};
+}
+
+#ifdef SAT_X86
+
+// Two vertices per step: deinterleave them into x and y lanes
+__attribute__((target("sse2"))) vector_t
+project_sse2(vector_t *vertices, size_t n_vertices, vector_t axis) {
+  double *xy = (double *)vertices;
+  __m128d ax = _mm_set1_pd(axis.x);
+  __m128d ay = _mm_set1_pd(axis.y);
+  __m128d lo = _mm_set1_pd(vertices[0].x * axis.x + vertices[0].y * axis.y);
+  __m128d hi = lo;
+  size_t i = 0;
+  for (; i + 2 <= n_vertices; i += 2) {
+    __m128d v0 = _mm_loadu_pd(xy + 2 * i);
+    __m128d v1 = _mm_loadu_pd(xy + 2 * i + 2);
+    __m128d xs = _mm_unpacklo_pd(v0, v1);
+    __m128d ys = _mm_unpackhi_pd(v0, v1);
+    __m128d proj = _mm_add_pd(_mm_mul_pd(xs, ax), _mm_mul_pd(ys, ay));
+    lo = _mm_min_pd(lo, proj);
+    hi = _mm_max_pd(hi, proj);
+  }
+  lo = _mm_min_sd(lo, _mm_unpackhi_pd(lo, lo));
+  hi = _mm_max_sd(hi, _mm_unpackhi_pd(hi, hi));
+  vector_t result = {_mm_cvtsd_f64(lo), _mm_cvtsd_f64(hi)};
+  if (i < n_vertices) {
+    vector_t tail = project_scalar(vertices + i, n_vertices - i, axis);
+    result.x = tail.x < result.x ? tail.x : result.x;
+    result.y = tail.y > result.y ? tail.y : result.y;
+  }
+  return result;
+}
+
+// Two axes per step: every vertex is broadcast and projected on both
+__attribute__((target("sse2"))) void
+project_axes_sse2(vector_t *vertices, size_t n_vertices, vector_t *axes,
+                  size_t n_axes, vector_t *projs) {
+  size_t k = 0;
+  for (; k + 2 <= n_axes; k += 2) {
+    __m128d ax = _mm_set_pd(axes[k + 1].x, axes[k].x);
+    __m128d ay = _mm_set_pd(axes[k + 1].y, axes[k].y);
+    __m128d lo = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(vertices[0].x), ax),
+                            _mm_mul_pd(_mm_set1_pd(vertices[0].y), ay));
+    __m128d hi = lo;
+    for (size_t i = 1; i < n_vertices; i++) {
+      __m128d proj = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(vertices[i].x), ax),
+                                _mm_mul_pd(_mm_set1_pd(vertices[i].y), ay));
+      lo = _mm_min_pd(lo, proj);
+      hi = _mm_max_pd(hi, proj);
+    }
+    _mm_storeu_pd((double *)&projs[k], _mm_unpacklo_pd(lo, hi));
+    _mm_storeu_pd((double *)&projs[k + 1], _mm_unpackhi_pd(lo, hi));
+  }
+  for (; k < n_axes; k++) {
+    projs[k] = project_sse2(vertices, n_vertices, axes[k]);
+  }
+}
+
+// Four vertices per step. Unpacking two registers of x, y, x, y gives the
+// lanes in the order 0, 2, 1, 3, which does not matter for extremes.
+__attribute__((target("avx2"))) vector_t
+project_avx2(vector_t *vertices, size_t n_vertices, vector_t axis) {
+  double *xy = (double *)vertices;
+  __m256d ax = _mm256_set1_pd(axis.x);
+  __m256d ay = _mm256_set1_pd(axis.y);
+  __m256d lo =
+      _mm256_set1_pd(vertices[0].x * axis.x + vertices[0].y * axis.y);
+  __m256d hi = lo;
+  size_t i = 0;
+  for (; i + 4 <= n_vertices; i += 4) {
+    __m256d v01 = _mm256_loadu_pd(xy + 2 * i);
+    __m256d v23 = _mm256_loadu_pd(xy + 2 * i + 4);
+    __m256d xs = _mm256_unpacklo_pd(v01, v23);
+    __m256d ys = _mm256_unpackhi_pd(v01, v23);
+    __m256d proj =
+        _mm256_add_pd(_mm256_mul_pd(xs, ax), _mm256_mul_pd(ys, ay));
+    lo = _mm256_min_pd(lo, proj);
+    hi = _mm256_max_pd(hi, proj);
+  }
+  __m128d lo2 = _mm_min_pd(_mm256_castpd256_pd128(lo),
+                           _mm256_extractf128_pd(lo, 1));
+  __m128d hi2 = _mm_max_pd(_mm256_castpd256_pd128(hi),
+                           _mm256_extractf128_pd(hi, 1));
+  lo2 = _mm_min_sd(lo2, _mm_unpackhi_pd(lo2, lo2));
+  hi2 = _mm_max_sd(hi2, _mm_unpackhi_pd(hi2, hi2));
+  vector_t result = {_mm_cvtsd_f64(lo2), _mm_cvtsd_f64(hi2)};
+  if (i < n_vertices) {
+    vector_t tail = project_scalar(vertices + i, n_vertices - i, axis);
+    result.x = tail.x < result.x ? tail.x : result.x;
+    result.y = tail.y > result.y ? tail.y : result.y;
+  }
+  return result;
+}
+
+// Four axes per step: every vertex is broadcast and projected on all four
+__attribute__((target("avx2"))) void
+project_axes_avx2(vector_t *vertices, size_t n_vertices, vector_t *axes,
+                  size_t n_axes, vector_t *projs) {
+  size_t k = 0;
+  for (; k + 4 <= n_axes; k += 4) {
+    __m256d ax =
+        _mm256_set_pd(axes[k + 3].x, axes[k + 2].x, axes[k + 1].x, axes[k].x);
+    __m256d ay =
+        _mm256_set_pd(axes[k + 3].y, axes[k + 2].y, axes[k + 1].y, axes[k].y);
+    __m256d lo =
+        _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(vertices[0].x), ax),
+                      _mm256_mul_pd(_mm256_set1_pd(vertices[0].y), ay));
+    __m256d hi = lo;
+    for (size_t i = 1; i < n_vertices; i++) {
+      __m256d proj =
+          _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(vertices[i].x), ax),
+                        _mm256_mul_pd(_mm256_set1_pd(vertices[i].y), ay));
+      lo = _mm256_min_pd(lo, proj);
+      hi = _mm256_max_pd(hi, proj);
+    }
+    // (lo0, hi0, lo2, hi2) and (lo1, hi1, lo3, hi3)
+    __m256d even = _mm256_unpacklo_pd(lo, hi);
+    __m256d odd = _mm256_unpackhi_pd(lo, hi);
+    double *out = (double *)&projs[k];
+    _mm256_storeu_pd(out, _mm256_permute2f128_pd(even, odd, 0x20));
+    _mm256_storeu_pd(out + 4, _mm256_permute2f128_pd(even, odd, 0x31));
+  }
+  for (; k < n_axes; k++) {
+    projs[k] = project_avx2(vertices, n_vertices, axes[k]);
+  }
+}
+
+#endif // #ifdef SAT_X86
+
+bool sat_kernel_supported(sat_kernel_t kernel) {
+  switch (kernel) {
+  case SAT_SCALAR:
+    return true;
+#ifdef SAT_X86
+  case SAT_SSE2:
+    return __builtin_cpu_supports("sse2");
+  case SAT_AVX2:
+    return __builtin_cpu_supports("avx2");
+#endif
+  default:
+    return false;
+  }
+}
+
+sat_kernel_t sat_get_kernel() {
+  if (!sat_kernel_chosen) {
+    sat_kernel = sat_kernel_supported(SAT_AVX2)   ? SAT_AVX2
+                 : sat_kernel_supported(SAT_SSE2) ? SAT_SSE2
+                                                  : SAT_SCALAR;
+    sat_kernel_chosen = true;
+  }
+  return sat_kernel;
+}
+
+void sat_set_kernel(sat_kernel_t kernel) {
+  assert(sat_kernel_supported(kernel));
+  sat_kernel = kernel;
+  sat_kernel_chosen = true;
+}
+
+const char *sat_kernel_name(sat_kernel_t kernel) {
+  switch (kernel) {
+  case SAT_SSE2:
+    return "sse2";
+  case SAT_AVX2:
+    return "avx2";
+  default:
+    return "scalar";
+  }
+}
+
+vector_t sat_project(vector_t *vertices, size_t n_vertices, vector_t axis) {
+  assert(n_vertices > 0);
+  switch (sat_get_kernel()) {
+#ifdef SAT_X86
+  case SAT_SSE2:
+    return project_sse2(vertices, n_vertices, axis);
+  case SAT_AVX2:
+    return project_avx2(vertices, n_vertices, axis);
+#endif
+  default:
+    return project_scalar(vertices, n_vertices, axis);
+  }
+}
+
+void sat_project_axes(vector_t *vertices, size_t n_vertices, vector_t *axes,
+                      size_t n_axes, vector_t *projs) {
+  assert(n_vertices > 0);
+  switch (sat_get_kernel()) {
+#ifdef SAT_X86
+  case SAT_SSE2:
+    project_axes_sse2(vertices, n_vertices, axes, n_axes, projs);
+    return;
+  case SAT_AVX2:
+    project_axes_avx2(vertices, n_vertices, axes, n_axes, projs);
+    return;
+#endif
+  default:
+    for (size_t k = 0; k < n_axes; k++) {
+      projs[k] = project_scalar(vertices, n_vertices, axes[k]);
+    }
+  }
+}
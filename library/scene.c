@@ -1,19 +1,94 @@
 #include "scene.h"
+#include "arena.h"
 #include "body.h"
+#include "broadphase.h"
+#include "contact.h"
+#include "gravity.h"
+#include "kinematics.h"
 #include "list.h"
 #include "polygon.h"
+#include "rng.h"
+#include "slab.h"
+#include "thread_pool.h"
 #include "vector.h"
 #include <assert.h>
 #include <math.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 const size_t INIT_BODY_COUNT = 10;
 const size_t INIT_FORCE_COUNT = 20;
+const double DEFAULT_TIMESTEP = 1e-3;
+const size_t DEFAULT_MAX_SUBSTEPS = 64;
+const uint64_t DEFAULT_SEED = 0;
+const size_t INIT_FRAME_SIZE = 4096;
+const size_t FORCERS_PER_PAGE = 64;
+const uint32_t NO_FREE_HANDLE = UINT32_MAX;
+// Force creators and slots handed to a pool thread at a time
+const size_t SCENE_FORCER_GRAIN = 64;
+const size_t SCENE_SLOT_GRAIN = 1024;
+// Tombstoned force creators stay in the list until they are more than this
+// share of it
+const double MAX_REMOVED_FORCER_SHARE = 0.5;
+
+// A slot of the handle table; handles to it are valid while the generations
+// match, and the slot is only reused once its body has been freed
+typedef struct handle_slot {
+  body_t *body; // NULL while the slot is free
+  uint32_t generation;
+  uint32_t next_free;
+} handle_slot_t;
+
+// The bodies with one tag, in scene order
+typedef struct tag_index {
+  list_t *bodies;
+  bool stale; // holds removed bodies that are being taken out
+} tag_index_t;
 
 typedef struct scene {
   list_t *bodies;
+  list_t *removed; // bodies marked by body_remove() but not yet taken out
+  handle_slot_t *handles;
+  size_t handle_count;
+  size_t handle_capacity;
+  uint32_t free_handle; // the first free slot, or NO_FREE_HANDLE
+  body_tagger_t tagger; // NULL while bodies are not indexed by tag
+  tag_index_t *tags;
+  size_t tag_count;
   list_t *forcer_specs;
+  kinematics_t *kinematics; // centroids, velocities, etc. of all bodies
+  broadphase_t *broadphase;
+  contact_solver_t *contacts;
+  size_t contact_passes; // made by the contact solver in the last tick
+  arena_t *frame; // temporaries that only live for one tick
+  double timestep; // fixed step for scene_step()
+  size_t max_substeps;
+  double accumulator; // time not yet simulated by scene_step()
+  double sleep_speed;  // 0 if bodies never fall asleep
+  double sleep_time;
+  gravity_t *gravity; // NULL without mutual gravity
+  thread_pool_t *pool; // NULL to tick on the calling thread only
+  integrator_t integrator;
+  // The force creators sorted into levels 1 to level_count (see
+  // schedule_forcers()): level l is schedule[level_starts[l - 1]] up to
+  // schedule[level_starts[l]]
+  struct forcer_spec **schedule;
+  size_t *level_starts;
+  size_t level_count;
+  size_t scheduled; // the number of force creators in the schedule
+  size_t schedule_capacity;
+  bool schedule_stale;
+  rng_t rng; // all randomness in the scene comes from here
+  // While snapshots are held, removed bodies and force creators are kept
+  // here instead of being freed, so scene_restore() can bring them back.
+  size_t snapshots;
+  list_t *detached_bodies;
+  list_t *detached_forcers;
+  struct scene_snapshot *spare_snapshots; // freed, kept for their buffers
+  size_t restores; // marks what the snapshot being restored holds
+  size_t removed_forcers; // tombstoned, but still in forcer_specs and the
+                          // schedule, which skip them
 } scene_t;
 
 typedef struct forcer_spec { // wrapper for force creator info
@@ -21,96 +96,985 @@ typedef struct forcer_spec { // wrapper for force creator info
   void *aux;
   free_func_t aux_freer;
   list_t *bodies;
+  bool parallel; // see scene_add_parallel_force_creator()
+  bool pure; // see scene_add_pure_force_creator()
+  bool removed; // a tombstone until the next compaction
+  void *state; // see scene_add_stateful_force_creator()
+  size_t state_size;
+  size_t restore_mark; // like body_get_restore_mark()
 } forcer_spec_t;
 
+_Thread_local slab_t *forcer_spec_slab = NULL;
+
+slab_t *forcer_spec_get_slab() {
+  if (forcer_spec_slab == NULL) {
+    forcer_spec_slab =
+        slab_init("forcer_spec", sizeof(forcer_spec_t), FORCERS_PER_PAGE);
+  }
+  return forcer_spec_slab;
+}
+
+// Freed snapshots go back to their scene, and the next snapshot reuses the
+// buffers, which only ever grow
+typedef struct scene_snapshot {
+  body_t **bodies; // in scene order
+  bool *removed;
+  size_t body_count;
+  size_t body_capacity;
+  forcer_spec_t **forcer_specs; // in scene order
+  size_t forcer_count;
+  size_t forcer_capacity;
+  char *forcer_states; // of the stateful force creators, in scene order
+  size_t states_size;
+  size_t states_capacity;
+  kinematics_t *kinematics;
+  broadphase_state_t *broadphase;
+  contact_solver_state_t *contacts;
+  double accumulator;
+  rng_t rng;
+  struct scene_snapshot *next; // among the scene's spare snapshots
+} scene_snapshot_t;
+
 void forcer_spec_freer(forcer_spec_t *forcer_spec) {
   if (forcer_spec->aux_freer != NULL) {
     forcer_spec->aux_freer(forcer_spec->aux);
   }
   list_free(forcer_spec->bodies);
-  free(forcer_spec);
+  slab_release(forcer_spec);
 }
 
 scene_t *scene_init(void) {
   scene_t *new_scene = malloc(sizeof(scene_t));
   assert(new_scene != NULL);
   new_scene->bodies = list_init(INIT_BODY_COUNT, (free_func_t)body_free);
+  new_scene->removed = list_init(INIT_BODY_COUNT, NULL);
+  new_scene->handles = malloc(sizeof(handle_slot_t) * INIT_BODY_COUNT);
+  assert(new_scene->handles != NULL);
+  new_scene->handle_count = 0;
+  new_scene->handle_capacity = INIT_BODY_COUNT;
+  new_scene->free_handle = NO_FREE_HANDLE;
+  new_scene->tagger = NULL;
+  new_scene->tags = NULL;
+  new_scene->tag_count = 0;
   new_scene->forcer_specs =
       list_init(INIT_FORCE_COUNT, (free_func_t)forcer_spec_freer);
+  new_scene->kinematics = kinematics_init(INIT_BODY_COUNT);
+  new_scene->broadphase = broadphase_init();
+  new_scene->contacts = contact_solver_init();
+  new_scene->contact_passes = 0;
+  new_scene->frame = arena_init(INIT_FRAME_SIZE);
+  new_scene->timestep = DEFAULT_TIMESTEP;
+  new_scene->max_substeps = DEFAULT_MAX_SUBSTEPS;
+  new_scene->accumulator = 0;
+  new_scene->sleep_speed = 0;
+  new_scene->sleep_time = 0;
+  new_scene->gravity = NULL;
+  new_scene->pool = NULL;
+  new_scene->integrator = INTEGRATOR_AVERAGE_VELOCITY;
+  new_scene->schedule = NULL;
+  new_scene->level_starts = NULL;
+  new_scene->level_count = 0;
+  new_scene->scheduled = 0;
+  new_scene->schedule_capacity = 0;
+  new_scene->schedule_stale = true;
+  new_scene->snapshots = 0;
+  rng_seed(&new_scene->rng, DEFAULT_SEED);
+  new_scene->detached_bodies = list_init(0, (free_func_t)body_free);
+  new_scene->detached_forcers = list_init(0, (free_func_t)forcer_spec_freer);
+  new_scene->removed_forcers = 0;
+  new_scene->spare_snapshots = NULL;
+  new_scene->restores = 0;
   return new_scene;
 }
 
+// Files a force creator under each of its bodies (see body_get_forcers())
+void forcer_spec_link(forcer_spec_t *forcer_spec) {
+  forcer_spec->removed = false;
+  for (size_t i = 0; i < list_size(forcer_spec->bodies); i++) {
+    list_add(body_get_forcers(list_get(forcer_spec->bodies, i)), forcer_spec);
+  }
+}
+
+// Tombstones a force creator and takes it out of its bodies' lists
+void forcer_spec_unlink(scene_t *scene, forcer_spec_t *forcer_spec) {
+  forcer_spec->removed = true;
+  scene->removed_forcers++;
+  for (size_t i = 0; i < list_size(forcer_spec->bodies); i++) {
+    list_t *forcers = body_get_forcers(list_get(forcer_spec->bodies, i));
+    for (size_t j = 0; j < list_size(forcers); j++) {
+      if (list_get(forcers, j) == forcer_spec) {
+        list_swap_remove(forcers, j);
+        break;
+      }
+    }
+  }
+}
+
 void scene_free(scene_t *scene) {
   list_free(scene->bodies);
+  list_free(scene->removed);
+  free(scene->handles);
+  for (size_t i = 0; i < scene->tag_count; i++) {
+    list_free(scene->tags[i].bodies);
+  }
+  free(scene->tags);
   list_free(scene->forcer_specs);
+  kinematics_free(scene->kinematics);
+  broadphase_free(scene->broadphase);
+  contact_solver_free(scene->contacts);
+  if (scene->gravity != NULL) {
+    gravity_free(scene->gravity);
+  }
+  arena_free(scene->frame);
+  free(scene->schedule);
+  free(scene->level_starts);
+  list_free(scene->detached_bodies);
+  list_free(scene->detached_forcers);
+  while (scene->spare_snapshots != NULL) {
+    scene_snapshot_t *snapshot = scene->spare_snapshots;
+    scene->spare_snapshots = snapshot->next;
+    free(snapshot->bodies);
+    free(snapshot->removed);
+    free(snapshot->forcer_specs);
+    free(snapshot->forcer_states);
+    kinematics_free(snapshot->kinematics);
+    broadphase_state_free(snapshot->broadphase);
+    contact_solver_state_free(snapshot->contacts);
+    free(snapshot);
+  }
   free(scene);
 }
 
 size_t scene_bodies(scene_t *scene) { return list_size(scene->bodies); }
 
+size_t scene_force_creators(scene_t *scene) {
+  return list_size(scene->forcer_specs) - scene->removed_forcers;
+}
+
 body_t *scene_get_body(scene_t *scene, size_t index) {
   return list_get(scene->bodies, index);
 }
 
+body_handle_t handle_acquire(scene_t *scene, body_t *body) {
+  uint32_t index = scene->free_handle;
+  if (index != NO_FREE_HANDLE) {
+    scene->free_handle = scene->handles[index].next_free;
+  } else {
+    if (scene->handle_count == scene->handle_capacity) {
+      scene->handle_capacity *= 2;
+      scene->handles = realloc(scene->handles, sizeof(handle_slot_t) *
+                                                   scene->handle_capacity);
+      assert(scene->handles != NULL);
+    }
+    index = scene->handle_count++;
+    scene->handles[index].generation = 0;
+  }
+  scene->handles[index].body = body;
+  return (body_handle_t){index, scene->handles[index].generation};
+}
+
+// Frees a body taken out of the scene, retiring its handle
+void scene_free_body(scene_t *scene, body_t *body) {
+  uint32_t index = body_get_handle(body).index;
+  handle_slot_t *slot = &scene->handles[index];
+  slot->body = NULL;
+  slot->generation++;
+  slot->next_free = scene->free_handle;
+  scene->free_handle = index;
+  body_free(body);
+}
+
+void tag_body(scene_t *scene, body_t *body) {
+  size_t tag = scene->tagger(body);
+  if (tag >= scene->tag_count) {
+    scene->tags = realloc(scene->tags, sizeof(tag_index_t) * (tag + 1));
+    assert(scene->tags != NULL);
+    for (size_t i = scene->tag_count; i <= tag; i++) {
+      scene->tags[i] = (tag_index_t){list_init(1, NULL), false};
+    }
+    scene->tag_count = tag + 1;
+  }
+  list_add(scene->tags[tag].bodies, body);
+}
+
+void retag_bodies(scene_t *scene) {
+  for (size_t i = 0; i < scene->tag_count; i++) {
+    while (list_size(scene->tags[i].bodies) > 0) {
+      list_pop(scene->tags[i].bodies);
+    }
+  }
+  for (size_t i = 0; i < scene_bodies(scene); i++) {
+    tag_body(scene, list_get(scene->bodies, i));
+  }
+}
+
 void scene_add_body(scene_t *scene, body_t *body) {
+  body_move_to_kinematics(body, scene->kinematics);
+  body_set_handle(body, handle_acquire(scene, body));
+  body_set_removal_queue(body, scene->removed);
+  if (body_is_removed(body)) {
+    list_add(scene->removed, body);
+  }
   list_add(scene->bodies, body);
+  if (scene->tagger != NULL) {
+    tag_body(scene, body);
+  }
+}
+
+body_handle_t scene_get_handle(scene_t *scene, body_t *body) {
+  body_handle_t handle = body_get_handle(body);
+  assert(handle.index < scene->handle_count &&
+         scene->handles[handle.index].body == body);
+  return handle;
+}
+
+void scene_set_tagger(scene_t *scene, body_tagger_t tagger) {
+  if (scene->tagger != tagger) {
+    scene->tagger = tagger;
+    if (tagger != NULL) {
+      retag_bodies(scene);
+    }
+  }
+}
+
+size_t scene_tagged_count(scene_t *scene, size_t tag) {
+  assert(scene->tagger != NULL);
+  return tag < scene->tag_count ? list_size(scene->tags[tag].bodies) : 0;
+}
+
+body_t *scene_get_tagged(scene_t *scene, size_t tag, size_t index) {
+  assert(index < scene_tagged_count(scene, tag));
+  return list_get(scene->tags[tag].bodies, index);
+}
+
+body_t *scene_resolve(scene_t *scene, body_handle_t handle) {
+  if (handle.index >= scene->handle_count) {
+    return NULL;
+  }
+  handle_slot_t slot = scene->handles[handle.index];
+  if (slot.generation != handle.generation || slot.body == NULL ||
+      body_is_removed(slot.body)) {
+    return NULL;
+  }
+  return slot.body;
 }
 
 void scene_remove_body(scene_t *scene, size_t index) {
   body_remove(list_get(scene->bodies, index));
 }
 
-void scene_add_force_creator(scene_t *scene, force_creator_t forcer, void *aux,
-                             free_func_t freer) {
-  forcer_spec_t *new_forcer = malloc(sizeof(forcer_spec_t));
-  assert(new_forcer != NULL);
+// Files a new force creator at the end of the scene's list
+forcer_spec_t *add_forcer_spec(scene_t *scene, force_creator_t forcer,
+                               void *aux, list_t *bodies, free_func_t freer,
+                               bool parallel) {
+  forcer_spec_t *new_forcer = slab_alloc(forcer_spec_get_slab());
   new_forcer->forcer = forcer;
   new_forcer->aux = aux;
   new_forcer->aux_freer = freer;
-  new_forcer->bodies = list_init(0, (free_func_t)body_free);
+  new_forcer->bodies = bodies;
+  new_forcer->parallel = parallel;
+  new_forcer->pure = false;
+  new_forcer->state = NULL;
+  new_forcer->state_size = 0;
+  new_forcer->restore_mark = 0;
+  forcer_spec_link(new_forcer);
   list_add(scene->forcer_specs, new_forcer);
+  scene->schedule_stale = true;
+  return new_forcer;
+}
+
+void scene_add_force_creator(scene_t *scene, force_creator_t forcer, void *aux,
+                             free_func_t freer) {
+  add_forcer_spec(scene, forcer, aux, list_init(0, (free_func_t)body_free),
+                  freer, false);
 }
 
 void scene_add_bodies_force_creator(scene_t *scene, force_creator_t forcer,
                                     void *aux, list_t *bodies,
                                     free_func_t freer) {
-  forcer_spec_t *new_forcer = malloc(sizeof(forcer_spec_t));
-  assert(new_forcer != NULL);
-  new_forcer->forcer = forcer;
-  new_forcer->aux = aux;
-  new_forcer->aux_freer = freer;
-  new_forcer->bodies = bodies;
-  list_add(scene->forcer_specs, new_forcer);
+  add_forcer_spec(scene, forcer, aux, bodies, freer, false);
+}
+
+void scene_add_parallel_force_creator(scene_t *scene, force_creator_t forcer,
+                                      void *aux, list_t *bodies,
+                                      free_func_t freer) {
+  add_forcer_spec(scene, forcer, aux, bodies, freer, true);
+}
+
+void scene_add_pure_force_creator(scene_t *scene, force_creator_t forcer,
+                                  void *aux, list_t *bodies,
+                                  free_func_t freer) {
+  // pure force creators meet every condition to run in parallel
+  add_forcer_spec(scene, forcer, aux, bodies, freer, true)->pure = true;
+}
+
+void scene_add_stateful_force_creator(scene_t *scene, force_creator_t forcer,
+                                      void *aux, list_t *bodies,
+                                      free_func_t freer, void *state,
+                                      size_t state_size) {
+  forcer_spec_t *forcer_spec =
+      add_forcer_spec(scene, forcer, aux, bodies, freer, false);
+  forcer_spec->state = state;
+  forcer_spec->state_size = state_size;
+}
+
+void scene_add_collider(scene_t *scene, body_t *body, size_t categories) {
+  broadphase_add_body(scene->broadphase, body, categories);
+}
+
+void scene_add_collision_rule(scene_t *scene, size_t categories1,
+                              size_t categories2, collision_handler_t handler,
+                              void *aux, free_func_t freer) {
+  broadphase_add_rule(scene->broadphase, categories1, categories2, handler, aux,
+                      freer);
+}
+
+void scene_add_contact_rule(scene_t *scene, size_t categories1,
+                            size_t categories2, double elasticity) {
+  broadphase_add_contact_rule(scene->broadphase, categories1, categories2,
+                              elasticity);
+}
+
+void scene_add_contact(scene_t *scene, contact_t contact) {
+  contact_solver_add(scene->contacts, contact);
+}
+
+void scene_set_contact_iterations(scene_t *scene, size_t max_iterations,
+                                  double tolerance) {
+  contact_solver_set_iterations(scene->contacts, max_iterations, tolerance);
+}
+
+size_t scene_contact_iterations(scene_t *scene) {
+  return scene->contact_passes;
+}
+
+size_t scene_collisions(scene_t *scene) {
+  return broadphase_collisions(scene->broadphase);
+}
+
+collision_event_t scene_get_collision(scene_t *scene, size_t index) {
+  return broadphase_get_collision(scene->broadphase, index);
+}
+
+size_t scene_collision_candidates(scene_t *scene) {
+  return broadphase_candidates(scene->broadphase);
+}
+
+// Tombstones every force creator acting on a removed body
+void detach_forcers(scene_t *scene, body_t *body) {
+  list_t *forcers = body_get_forcers(body);
+  while (list_size(forcers) > 0) {
+    forcer_spec_unlink(scene, list_get(forcers, list_size(forcers) - 1));
+  }
 }
 
+// Drops the tombstoned force creators in one pass that keeps the order.
+// A tombstone's bodies may be freed before it is dropped, so nothing but
+// this pass looks at them.
+void compact_forcers(scene_t *scene) {
+  if (scene->removed_forcers == 0) {
+    return;
+  }
+  size_t count = list_size(scene->forcer_specs);
+  forcer_spec_t **kept =
+      arena_alloc(scene->frame, sizeof(forcer_spec_t *) * count);
+  size_t kept_count = 0;
+  for (size_t i = 0; i < count; i++) {
+    forcer_spec_t *forcer_spec = list_get(scene->forcer_specs, i);
+    if (!forcer_spec->removed) {
+      kept[kept_count++] = forcer_spec;
+    } else if (scene->snapshots > 0) {
+      list_add(scene->detached_forcers, forcer_spec);
+    } else {
+      forcer_spec_freer(forcer_spec);
+    }
+  }
+  list_assign(scene->forcer_specs, (void **)kept, kept_count);
+  scene->removed_forcers = 0;
+  scene->schedule_stale = true;
+}
+
+// Compacts the force creators once tombstones make up too much of the list,
+// so removing a few bodies at a time does not copy the whole list each tick
+void compact_sparse_forcers(scene_t *scene) {
+  if (scene->removed_forcers >
+      MAX_REMOVED_FORCER_SHARE * list_size(scene->forcer_specs)) {
+    compact_forcers(scene);
+  }
+}
+
+// Catches bodies removed since the last tick, before their forces are applied
 void eliminate_redundant_forcers(scene_t *scene) {
-  for (int32_t i = list_size(scene->forcer_specs) - 1; i >= 0; i--) {
+  for (size_t i = 0; i < list_size(scene->removed); i++) {
+    detach_forcers(scene, list_get(scene->removed, i));
+  }
+  compact_sparse_forcers(scene);
+}
+
+// Drops the removed bodies from a list in one pass that keeps the order
+void drop_removed_bodies(scene_t *scene, list_t *bodies) {
+  size_t count = list_size(bodies);
+  body_t **kept = arena_alloc(scene->frame, sizeof(body_t *) * count);
+  size_t kept_count = 0;
+  for (size_t i = 0; i < count; i++) {
+    body_t *body = list_get(bodies, i);
+    if (!body_is_removed(body)) {
+      kept[kept_count++] = body;
+    }
+  }
+  list_assign(bodies, (void **)kept, kept_count);
+}
+
+// Takes the removed bodies out of the kinematic storage, the body list
+// (which keeps its order, as it is also the drawing order) and the tag index
+void take_out_removed_bodies(scene_t *scene) {
+  for (size_t i = 0; i < list_size(scene->removed); i++) {
+    body_t *body = list_get(scene->removed, i);
+    if (scene->tagger != NULL) {
+      scene->tags[scene->tagger(body)].stale = true;
+    }
+    detach_forcers(scene, body);
+    body_t *moved = kinematics_remove(scene->kinematics, body_get_slot(body));
+    if (moved != NULL) {
+      body_set_slot(moved, body_get_slot(body));
+    }
+    body_set_removal_queue(body, NULL);
+  }
+  drop_removed_bodies(scene, scene->bodies);
+  for (size_t i = 0; i < scene->tag_count; i++) {
+    if (scene->tags[i].stale) {
+      drop_removed_bodies(scene, scene->tags[i].bodies);
+      scene->tags[i].stale = false;
+    }
+  }
+}
+
+// The level of a force creator that may run in parallel: one after the
+// last level acting on any of its bodies, and no earlier than floor.
+// Returns 0 if a body is not in the scene, as then its slot says nothing.
+size_t parallel_level(scene_t *scene, forcer_spec_t *forcer_spec,
+                      size_t *last, size_t floor) {
+  kinematics_t *kin = scene->kinematics;
+  size_t level = floor;
+  for (size_t i = 0; i < list_size(forcer_spec->bodies); i++) {
+    body_t *body = list_get(forcer_spec->bodies, i);
+    size_t slot = body_get_slot(body);
+    if (slot >= kin->size || kin->owner[slot] != body) {
+      return 0;
+    }
+    level = last[slot] > level ? last[slot] : level;
+  }
+  return level + 1;
+}
+
+// Sorts the force creators into levels whose force creators can run at the
+// same time. A parallel force creator goes one level after the last one
+// acting on any of its bodies; any other force creator gets a level to
+// itself, after all earlier ones. Every body thus gets its forces in list
+// order, and running the levels in order matches running the list.
+void schedule_forcers(scene_t *scene) {
+  size_t count = list_size(scene->forcer_specs);
+  if (scene->level_starts == NULL || scene->schedule_capacity < count) {
+    scene->schedule =
+        realloc(scene->schedule, sizeof(forcer_spec_t *) * count);
+    scene->level_starts =
+        realloc(scene->level_starts, sizeof(size_t) * (count + 1));
+    assert(scene->schedule != NULL && scene->level_starts != NULL);
+    scene->schedule_capacity = count;
+  }
+  size_t slots = scene->kinematics->size;
+  size_t *last = arena_alloc(scene->frame, sizeof(size_t) * (slots + 1));
+  size_t *levels = arena_alloc(scene->frame, sizeof(size_t) * (count + 1));
+  memset(last, 0, sizeof(size_t) * slots);
+  size_t floor = 0;
+  size_t top = 0;
+  for (size_t i = 0; i < count; i++) {
     forcer_spec_t *forcer_spec = list_get(scene->forcer_specs, i);
+    if (forcer_spec->removed) {
+      // level 0 never runs
+      levels[i] = 0;
+      continue;
+    }
+    size_t level = forcer_spec->parallel
+                       ? parallel_level(scene, forcer_spec, last, floor)
+                       : 0;
+    if (level == 0) {
+      level = floor = top + 1;
+    }
     for (size_t j = 0; j < list_size(forcer_spec->bodies); j++) {
-      if (body_is_removed(list_get(forcer_spec->bodies, j))) {
-        forcer_spec_freer(list_remove(scene->forcer_specs, i));
-        break;
+      size_t slot = body_get_slot(list_get(forcer_spec->bodies, j));
+      if (slot < slots) {
+        last[slot] = level;
       }
     }
+    levels[i] = level;
+    top = level > top ? level : top;
+  }
+  // counting sort, keeping list order within each level; level_starts[l]
+  // ends up one past the last force creator of level l
+  memset(scene->level_starts, 0, sizeof(size_t) * (top + 1));
+  for (size_t i = 0; i < count; i++) {
+    scene->level_starts[levels[i]]++;
+  }
+  for (size_t l = 0, start = 0; l <= top; l++) {
+    size_t size = scene->level_starts[l];
+    scene->level_starts[l] = start;
+    start += size;
+  }
+  for (size_t i = 0; i < count; i++) {
+    scene->schedule[scene->level_starts[levels[i]]++] =
+        list_get(scene->forcer_specs, i);
+  }
+  scene->level_count = top;
+  scene->scheduled = count;
+  scene->schedule_stale = false;
+}
+
+// Which force creators a pass over the list runs: all of them, only the
+// pure ones (which integrators with several stages evaluate again), or
+// only the others
+typedef enum forcer_pass {
+  EVERY_FORCER,
+  PURE_FORCERS,
+  OTHER_FORCERS
+} forcer_pass_t;
+
+bool forcer_in_pass(forcer_spec_t *forcer_spec, forcer_pass_t pass) {
+  if (forcer_spec->removed) {
+    return false;
+  }
+  switch (pass) {
+  case PURE_FORCERS:
+    return forcer_spec->pure;
+  case OTHER_FORCERS:
+    return !forcer_spec->pure;
+  default:
+    return true;
+  }
+}
+
+void run_forcer_list(scene_t *scene, forcer_pass_t pass) {
+  for (size_t i = 0; i < list_size(scene->forcer_specs); i++) {
+    forcer_spec_t *forcer_spec = list_get(scene->forcer_specs, i);
+    if (forcer_in_pass(forcer_spec, pass)) {
+      forcer_spec->forcer(forcer_spec->aux);
+    }
+  }
+}
+
+typedef struct forcer_job {
+  forcer_spec_t **forcer_specs;
+  forcer_pass_t pass;
+} forcer_job_t;
+
+void run_forcers(void *aux, size_t start, size_t end) {
+  forcer_job_t *job = aux;
+  for (size_t i = start; i < end; i++) {
+    forcer_spec_t *forcer_spec = job->forcer_specs[i];
+    if (forcer_in_pass(forcer_spec, job->pass)) {
+      forcer_spec->forcer(forcer_spec->aux);
+    }
+  }
+}
+
+// Runs the force creators level by level on the scene's pool
+void run_forcers_parallel(scene_t *scene, forcer_pass_t pass) {
+  if (scene->schedule_stale) {
+    schedule_forcers(scene);
+  }
+  for (size_t l = 1; l <= scene->level_count; l++) {
+    size_t start = scene->level_starts[l - 1];
+    forcer_job_t job = {scene->schedule + start, pass};
+    thread_pool_for(scene->pool, scene->level_starts[l] - start,
+                    SCENE_FORCER_GRAIN, run_forcers, &job);
+  }
+  // force creators added by the ones that ran start right away, as they
+  // would have in list order
+  for (size_t i = scene->scheduled; i < list_size(scene->forcer_specs); i++) {
+    forcer_spec_t *forcer_spec = list_get(scene->forcer_specs, i);
+    if (forcer_in_pass(forcer_spec, pass)) {
+      forcer_spec->forcer(forcer_spec->aux);
+    }
+  }
+}
+
+typedef struct tick_job {
+  kinematics_t *kin;
+  double dt;
+  integrator_t integrator;
+  size_t stage;
+  kinematics_stages_t *stages;
+} tick_job_t;
+
+void apply_fields_range(void *aux, size_t start, size_t end) {
+  tick_job_t *job = aux;
+  kinematics_apply_fields(job->kin, start, end);
+}
+
+void integrate_range(void *aux, size_t start, size_t end) {
+  tick_job_t *job = aux;
+  if (job->integrator == INTEGRATOR_SEMI_IMPLICIT_EULER) {
+    kinematics_integrate_euler(job->kin, start, end, job->dt);
+  } else {
+    kinematics_integrate(job->kin, start, end, job->dt);
+  }
+}
+
+void begin_stages_range(void *aux, size_t start, size_t end) {
+  tick_job_t *job = aux;
+  kinematics_begin_stages(job->kin, job->stages, start, end);
+}
+
+void stage_range(void *aux, size_t start, size_t end) {
+  tick_job_t *job = aux;
+  kinematics_stage(job->kin, job->integrator, job->stage, job->stages, start,
+                   end, job->dt);
+}
+
+// Runs a pass of force creators, then adds the field forces and mutual
+// gravity
+void apply_forces(scene_t *scene, forcer_pass_t pass, tick_job_t *job) {
+  // levels only pay off with threads to spread them over; the list runs in
+  // an order that is easier on the cache
+  if (scene->pool != NULL && thread_pool_threads(scene->pool) > 1) {
+    run_forcers_parallel(scene, pass);
+  } else {
+    run_forcer_list(scene, pass);
+  }
+  thread_pool_for(scene->pool, scene->kinematics->size, SCENE_SLOT_GRAIN,
+                  apply_fields_range, job);
+  if (scene->gravity != NULL) {
+    gravity_apply(scene->gravity, scene->kinematics, scene->pool);
+  }
+}
+
+// Takes out the bodies removed so far this tick, returning whether there
+// were any
+bool take_out_removals(scene_t *scene) {
+  if (list_size(scene->removed) == 0) {
+    return false;
+  }
+  broadphase_prune(scene->broadphase);
+  take_out_removed_bodies(scene);
+  return true;
+}
+
+// Advances the bodies with an integrator that evaluates the forces again at
+// each stage; the other force creators run once, up front
+void integrate_stages(scene_t *scene, tick_job_t *job) {
+  kinematics_t *kin = scene->kinematics;
+  size_t bytes = sizeof(vector_t) * (kin->size + 1);
+  kinematics_stages_t stages = {arena_alloc(scene->frame, bytes),
+                                arena_alloc(scene->frame, bytes),
+                                arena_alloc(scene->frame, bytes),
+                                arena_alloc(scene->frame, bytes),
+                                arena_alloc(scene->frame, bytes)};
+  job->stages = &stages;
+  thread_pool_for(scene->pool, kin->size, SCENE_SLOT_GRAIN, begin_stages_range,
+                  job);
+  for (size_t s = 0; s < integrator_stages(scene->integrator); s++) {
+    apply_forces(scene, PURE_FORCERS, job);
+    job->stage = s;
+    thread_pool_for(scene->pool, kin->size, SCENE_SLOT_GRAIN, stage_range,
+                    job);
   }
 }
 
 void scene_tick(scene_t *scene, double dt) {
-  eliminate_redundant_forcers(scene);
+  bool removals = list_size(scene->removed) > 0;
+  if (removals) {
+    eliminate_redundant_forcers(scene);
+    broadphase_prune(scene->broadphase);
+  }
+  // contacts first, so force creators can read this tick's collisions
+  broadphase_tick(scene->broadphase, dt, scene->contacts);
+  tick_job_t job = {scene->kinematics, dt, scene->integrator, 0, NULL};
+  // every body left after take_out_removals() occupies one of the dense
+  // slots [0, size)
+  if (integrator_stages(scene->integrator) == 1) {
+    apply_forces(scene, EVERY_FORCER, &job);
+    removals = take_out_removals(scene);
+    scene->contact_passes =
+        contact_solver_solve(scene->contacts, scene->kinematics, dt);
+    thread_pool_for(scene->pool, scene->kinematics->size, SCENE_SLOT_GRAIN,
+                    integrate_range, &job);
+  } else {
+    run_forcer_list(scene, OTHER_FORCERS);
+    removals = take_out_removals(scene);
+    // only the forces so far are known; the stages add the rest
+    scene->contact_passes =
+        contact_solver_solve(scene->contacts, scene->kinematics, dt);
+    integrate_stages(scene, &job);
+  }
+  contact_solver_arrive(scene->contacts, dt);
+  if (scene->sleep_speed > 0) {
+    kinematics_settle(scene->kinematics, 0, scene->kinematics->size,
+                      scene->sleep_speed, scene->sleep_time, dt);
+  }
+  if (removals) {
+    compact_sparse_forcers(scene);
+    while (list_size(scene->removed) > 0) {
+      body_t *body = list_pop(scene->removed);
+      if (scene->snapshots > 0) {
+        list_add(scene->detached_bodies, body);
+      } else {
+        scene_free_body(scene, body);
+      }
+    }
+  }
+  arena_reset(scene->frame);
+}
+
+arena_t *scene_arena(scene_t *scene) { return scene->frame; }
+
+void scene_set_sleep_threshold(scene_t *scene, double max_speed,
+                               double rest_time) {
+  assert(max_speed >= 0 && rest_time >= 0);
+  scene->sleep_speed = max_speed;
+  scene->sleep_time = rest_time;
+}
+
+void scene_set_gravity(scene_t *scene, gravity_t *gravity) {
+  if (scene->gravity != NULL && scene->gravity != gravity) {
+    gravity_free(scene->gravity);
+  }
+  scene->gravity = gravity;
+}
+
+gravity_t *scene_get_gravity(scene_t *scene) { return scene->gravity; }
+
+void scene_set_integrator(scene_t *scene, integrator_t integrator) {
+  scene->integrator = integrator;
+}
+
+integrator_t scene_get_integrator(scene_t *scene) { return scene->integrator; }
+
+void scene_set_thread_pool(scene_t *scene, thread_pool_t *pool) {
+  scene->pool = pool;
+}
+
+bool scene_is_asleep(scene_t *scene) {
+  return scene->kinematics->awake == 0;
+}
+
+void scene_seed(scene_t *scene, uint64_t seed) {
+  rng_seed(&scene->rng, seed);
+}
+
+rng_t *scene_rng(scene_t *scene) { return &scene->rng; }
+
+void scene_set_timestep(scene_t *scene, double timestep, size_t max_substeps) {
+  assert(timestep > 0 && max_substeps > 0);
+  scene->timestep = timestep;
+  scene->max_substeps = max_substeps;
+}
+
+double scene_step(scene_t *scene, double elapsed) {
+  scene->accumulator += elapsed;
+  for (size_t i = 0;
+       i < scene->max_substeps && scene->accumulator >= scene->timestep; i++) {
+    scene_tick(scene, scene->timestep);
+    scene->accumulator -= scene->timestep;
+  }
+  if (scene->accumulator >= scene->timestep) {
+    scene->accumulator = fmod(scene->accumulator, scene->timestep);
+  }
+  return scene->accumulator / scene->timestep;
+}
+
+// Grows a snapshot array to hold at least count elements
+void *snapshot_reserve(void *array, size_t *capacity, size_t count,
+                       size_t size) {
+  if (*capacity < count) {
+    *capacity = count > 2 * *capacity ? count : 2 * *capacity;
+    array = realloc(array, size * *capacity);
+    assert(array != NULL);
+  }
+  return array;
+}
+
+scene_snapshot_t *scene_snapshot(scene_t *scene) {
+  // the bodies of tombstones may be gone, so restoring must not relink them
+  compact_forcers(scene);
+  scene_snapshot_t *snapshot = scene->spare_snapshots;
+  if (snapshot != NULL) {
+    scene->spare_snapshots = snapshot->next;
+  } else {
+    snapshot = calloc(1, sizeof(scene_snapshot_t));
+    assert(snapshot != NULL);
+    snapshot->kinematics = kinematics_init(scene->kinematics->size);
+  }
+  size_t body_count = list_size(scene->bodies);
+  // bodies and removed always grow together, to body_capacity
+  size_t body_capacity = snapshot->body_capacity;
+  snapshot->bodies = snapshot_reserve(snapshot->bodies, &body_capacity,
+                                      body_count + 1, sizeof(body_t *));
+  snapshot->removed = snapshot_reserve(
+      snapshot->removed, &snapshot->body_capacity, body_count + 1,
+      sizeof(bool));
+  for (size_t i = 0; i < body_count; i++) {
+    snapshot->bodies[i] = list_get(scene->bodies, i);
+    snapshot->removed[i] = body_is_removed(snapshot->bodies[i]);
+  }
+  snapshot->body_count = body_count;
+  size_t forcer_count = list_size(scene->forcer_specs);
+  snapshot->forcer_specs = snapshot_reserve(
+      snapshot->forcer_specs, &snapshot->forcer_capacity, forcer_count + 1,
+      sizeof(forcer_spec_t *));
+  size_t states_size = 0;
+  for (size_t i = 0; i < forcer_count; i++) {
+    forcer_spec_t *forcer_spec = list_get(scene->forcer_specs, i);
+    snapshot->forcer_specs[i] = forcer_spec;
+    states_size += forcer_spec->state_size;
+  }
+  snapshot->forcer_count = forcer_count;
+  snapshot->forcer_states =
+      snapshot_reserve(snapshot->forcer_states, &snapshot->states_capacity,
+                       states_size + 1, sizeof(char));
+  snapshot->states_size = 0;
+  for (size_t i = 0; i < forcer_count; i++) {
+    forcer_spec_t *forcer_spec = snapshot->forcer_specs[i];
+    memcpy(snapshot->forcer_states + snapshot->states_size, forcer_spec->state,
+           forcer_spec->state_size);
+    snapshot->states_size += forcer_spec->state_size;
+  }
+  kinematics_copy(snapshot->kinematics, scene->kinematics);
+  snapshot->broadphase =
+      broadphase_save(scene->broadphase, snapshot->broadphase);
+  snapshot->contacts = contact_solver_save(scene->contacts, snapshot->contacts);
+  snapshot->accumulator = scene->accumulator;
+  snapshot->rng = scene->rng;
+  scene->snapshots++;
+  return snapshot;
+}
+
+bool body_held(void *body, size_t mark) {
+  return body_get_restore_mark(body) == mark;
+}
+
+bool forcer_spec_held(void *forcer_spec, size_t mark) {
+  return ((forcer_spec_t *)forcer_spec)->restore_mark == mark;
+}
+
+// Replaces the contents of live with the snapshot's items, moving whatever
+// the snapshot does not hold into detached and taking back what it does.
+// held() tells the items the restore marked with mark from the others.
+// Returns whether live changed.
+bool restore_list(list_t *live, list_t *detached, void **items, size_t count,
+                  bool (*held)(void *item, size_t mark), size_t mark) {
+  bool changed = false;
+  for (int32_t i = list_size(detached) - 1; i >= 0; i--) {
+    if (held(list_get(detached, i), mark)) {
+      list_remove(detached, i);
+      changed = true;
+    }
+  }
+  for (size_t i = 0; i < list_size(live); i++) {
+    void *item = list_get(live, i);
+    if (!held(item, mark)) {
+      list_add(detached, item);
+      changed = true;
+    }
+  }
+  list_assign(live, items, count);
+  return changed;
+}
+
+void clear_forcers(body_t *body) {
+  list_t *forcers = body_get_forcers(body);
+  while (list_size(forcers) > 0) {
+    list_pop(forcers);
+  }
+}
+
+// Rebuilds every body's list of force creators from the scene's
+void relink_forcers(scene_t *scene) {
+  for (size_t i = 0; i < scene_bodies(scene); i++) {
+    clear_forcers(list_get(scene->bodies, i));
+  }
   for (size_t i = 0; i < list_size(scene->forcer_specs); i++) {
     forcer_spec_t *forcer_spec = list_get(scene->forcer_specs, i);
-    forcer_spec->forcer(forcer_spec->aux);
+    for (size_t j = 0; j < list_size(forcer_spec->bodies); j++) {
+      clear_forcers(list_get(forcer_spec->bodies, j));
+    }
+  }
+  for (size_t i = 0; i < list_size(scene->forcer_specs); i++) {
+    forcer_spec_link(list_get(scene->forcer_specs, i));
+  }
+  scene->removed_forcers = 0;
+}
+
+void scene_restore(scene_t *scene, scene_snapshot_t *snapshot) {
+  // a mark no restore used before, so stale marks never count as held
+  size_t mark = ++scene->restores;
+  for (size_t i = 0; i < snapshot->body_count; i++) {
+    body_set_restore_mark(snapshot->bodies[i], mark);
+  }
+  for (size_t i = 0; i < snapshot->forcer_count; i++) {
+    snapshot->forcer_specs[i]->restore_mark = mark;
+  }
+  bool retag = restore_list(scene->bodies, scene->detached_bodies,
+                            (void **)snapshot->bodies, snapshot->body_count,
+                            body_held, mark);
+  bool relink = restore_list(scene->forcer_specs, scene->detached_forcers,
+                             (void **)snapshot->forcer_specs,
+                             snapshot->forcer_count, forcer_spec_held, mark);
+  if (retag) {
+    // bodies added since the snapshot are out of the scene again
+    for (size_t i = 0; i < list_size(scene->detached_bodies); i++) {
+      body_t *body = list_get(scene->detached_bodies, i);
+      body_set_removal_queue(body, NULL);
+      body_remove(body);
+    }
+  }
+  // the removal queue ends up holding the bodies removed at the snapshot
+  while (list_size(scene->removed) > 0) {
+    list_pop(scene->removed);
+  }
+  for (size_t i = 0; i < snapshot->body_count; i++) {
+    body_t *body = snapshot->bodies[i];
+    body_revive(body);
+    body_set_removal_queue(body, scene->removed);
+    if (snapshot->removed[i]) {
+      body_remove(body);
+    }
   }
-  list_t *removed_bodies = list_init(0, (free_func_t)body_free);
-  for (int32_t i = scene_bodies(scene) - 1; i >= 0; i--) {
-    body_t *body = list_get(scene->bodies, i);
-    if (body_is_removed(body)) {
-      list_add(removed_bodies, list_remove(scene->bodies, i));
-    } 
-    else {
-      body_tick(body, dt);
+  // force creators tombstoned since the snapshot are back too
+  if (relink || scene->removed_forcers > 0) {
+    relink_forcers(scene);
+    scene->schedule_stale = true;
+  }
+  for (size_t i = 0, offset = 0; i < snapshot->forcer_count; i++) {
+    forcer_spec_t *forcer_spec = snapshot->forcer_specs[i];
+    memcpy(forcer_spec->state, snapshot->forcer_states + offset,
+           forcer_spec->state_size);
+    offset += forcer_spec->state_size;
+  }
+  kinematics_t *kin = scene->kinematics;
+  kinematics_copy(kin, snapshot->kinematics);
+  for (size_t i = 0; i < kin->size; i++) {
+    body_set_slot(kin->owner[i], i);
+  }
+  if (retag && scene->tagger != NULL) {
+    retag_bodies(scene);
+  }
+  broadphase_restore(scene->broadphase, snapshot->broadphase);
+  contact_solver_restore(scene->contacts, snapshot->contacts);
+  scene->accumulator = snapshot->accumulator;
+  scene->rng = snapshot->rng;
+}
+
+void scene_snapshot_free(scene_t *scene, scene_snapshot_t *snapshot) {
+  assert(scene->snapshots > 0);
+  snapshot->next = scene->spare_snapshots;
+  scene->spare_snapshots = snapshot;
+  if (--scene->snapshots == 0) {
+    // nothing can bring the detached bodies back any more
+    while (list_size(scene->detached_bodies) > 0) {
+      scene_free_body(scene, list_pop(scene->detached_bodies));
+    }
+    while (list_size(scene->detached_forcers) > 0) {
+      forcer_spec_freer(list_pop(scene->detached_forcers));
     }
   }
-  eliminate_redundant_forcers(scene);
-  list_free(removed_bodies);
 }
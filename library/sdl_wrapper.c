@@ -317,9 +317,9 @@ vector_t sdl_get_image_dimensions(char *img_path) {
     return img_dim;
 }
 
-void sdl_draw_polygon(list_t *points, rgb_color_t color) {
+void sdl_draw_polygon(polygon_t *points, rgb_color_t color) {
     // Check parameters
-    size_t n = list_size(points);
+    size_t n = polygon_size(points);
     assert(n >= 3);
     assert(0 <= color.r && color.r <= 1);
     assert(0 <= color.g && color.g <= 1);
@@ -333,8 +333,7 @@ void sdl_draw_polygon(list_t *points, rgb_color_t color) {
     assert(x_points != NULL);
     assert(y_points != NULL);
     for (size_t i = 0; i < n; i++) {
-        vector_t *vertex = list_get(points, i);
-        vector_t pixel = get_window_position(*vertex, window_center);
+        vector_t pixel = get_window_position(polygon_get(points, i), window_center);
         x_points[i] = pixel.x;
         y_points[i] = pixel.y;
     }
@@ -378,7 +377,7 @@ void sdl_render_scene(scene_t *scene) {
         if (is_sprite && img_path != NULL) {
             sdl_draw_sprite(body);
         } else if (!is_sprite) {
-            list_t *points = body_get_shape(body);
+            polygon_t *points = body_get_shape(body);
             rgb_color_t color = body_sprite.color;
             sdl_draw_polygon(points, color);
         }
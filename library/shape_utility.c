@@ -20,30 +20,30 @@ vector_t *gen_pos_vec(double x, double y)
     return position;
 }
 
-list_t *generate_ball(double x, double y, double radius)
+polygon_t *generate_ball(double x, double y, double radius)
 {
-    list_t *my_ball_shape = list_init(BALL_RESOLUTION, free);
+    polygon_t *my_ball_shape = polygon_init(BALL_RESOLUTION);
     for (size_t point = 0; point < BALL_RESOLUTION; point++)
     {
         double angle = 2 * M_PI * point / BALL_RESOLUTION;
-        list_add(my_ball_shape, gen_pos_vec(x + radius * cos(angle),
-                                            y + radius * sin(angle)));
+        polygon_add(my_ball_shape, (vector_t){x + radius * cos(angle),
+                                              y + radius * sin(angle)});
     }
     return my_ball_shape;
 }
 
-list_t *generate_rect_shape(double rec_x, double rec_y, double rec_width,
-                            double rec_height)
+polygon_t *generate_rect_shape(double rec_x, double rec_y, double rec_width,
+                               double rec_height)
 {
-    list_t *rec_shape = list_init(RECT_RESOLUTION, free);
+    polygon_t *rec_shape = polygon_init(RECT_RESOLUTION);
 
-    list_add(rec_shape, gen_pos_vec(rec_x + rec_width / 2, 
-                                    rec_y + rec_height / 2));
-    list_add(rec_shape, gen_pos_vec(rec_x + rec_width / 2 * -1, 
-                                    rec_y + rec_height / 2));
-    list_add(rec_shape, gen_pos_vec(rec_x + rec_width / 2 * -1, 
-                                    rec_y + rec_height / 2 * -1));
-    list_add(rec_shape, gen_pos_vec(rec_x + rec_width / 2, 
-                                    rec_y + rec_height / 2 * -1));
+    polygon_add(rec_shape, (vector_t){rec_x + rec_width / 2, 
+                                      rec_y + rec_height / 2});
+    polygon_add(rec_shape, (vector_t){rec_x + rec_width / 2 * -1, 
+                                      rec_y + rec_height / 2});
+    polygon_add(rec_shape, (vector_t){rec_x + rec_width / 2 * -1, 
+                                      rec_y + rec_height / 2 * -1});
+    polygon_add(rec_shape, (vector_t){rec_x + rec_width / 2, 
+                                      rec_y + rec_height / 2 * -1});
     return rec_shape;
 }
\ No newline at end of file
@@ -0,0 +1,198 @@
+#include "slab.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct slab_page {
+  struct slab_page *next;
+  max_align_t data[];
+} slab_page_t;
+
+// Released objects hold the link to the next free one
+typedef struct free_object {
+  struct free_object *next;
+} free_object_t;
+
+// Every object is preceded by the slab it came from, so it can be
+// returned there from any thread
+typedef union slab_header {
+  struct slab *slab;
+  max_align_t align;
+} slab_header_t;
+
+typedef struct slab {
+  const char *name;
+  size_t objects_per_page;
+  size_t slot_size; // an object and its header
+  slab_page_t *pages; // the newest first
+  size_t fresh;       // objects of the newest page never handed out
+  free_object_t *free_list;
+  slab_stats_t stats;
+  // Objects released on other threads, waiting for this slab's thread to
+  // take them back. Other threads only ever push, and the slab's thread
+  // takes the whole list at once.
+  _Atomic(free_object_t *) remote;
+  atomic_size_t remote_count;
+  const void *thread; // the owning thread's slab_thread
+  struct slab *next;  // in the registry
+} slab_t;
+
+// Only its address is used, which is different on every thread
+_Thread_local char slab_thread;
+_Thread_local slab_t *slab_registry = NULL;
+
+// Slabs left behind by threads that exited while some of their objects
+// were still in use elsewhere. Those objects can still be released, so the
+// pages have to stay.
+slab_t *slab_orphans = NULL;
+pthread_mutex_t slab_orphans_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_key_t slab_exit_key;
+pthread_once_t slab_exit_once = PTHREAD_ONCE_INIT;
+
+// Runs as a thread exits, for the slabs it registered
+void slab_thread_exit(void *unused) {
+  while (slab_registry != NULL) {
+    slab_t *slab = slab_registry;
+    if (slab_stats(slab).live == 0) {
+      slab_free(slab);
+      continue;
+    }
+    slab_registry = slab->next;
+    slab->thread = NULL;
+    pthread_mutex_lock(&slab_orphans_lock);
+    slab->next = slab_orphans;
+    slab_orphans = slab;
+    pthread_mutex_unlock(&slab_orphans_lock);
+  }
+}
+
+void slab_exit_key_init() {
+  int error = pthread_key_create(&slab_exit_key, slab_thread_exit);
+  assert(error == 0);
+}
+
+slab_t *slab_init(const char *name, size_t object_size,
+                  size_t objects_per_page) {
+  assert(objects_per_page > 0);
+  slab_t *slab = malloc(sizeof(slab_t));
+  assert(slab != NULL);
+  size_t align = alignof(max_align_t);
+  if (object_size < sizeof(free_object_t)) {
+    object_size = sizeof(free_object_t);
+  }
+  slab->name = name;
+  slab->objects_per_page = objects_per_page;
+  slab->pages = NULL;
+  slab->fresh = 0;
+  slab->free_list = NULL;
+  slab->stats = (slab_stats_t){
+      .object_size = (object_size + align - 1) / align * align};
+  slab->slot_size = sizeof(slab_header_t) + slab->stats.object_size;
+  atomic_init(&slab->remote, NULL);
+  atomic_init(&slab->remote_count, 0);
+  slab->thread = &slab_thread;
+  if (slab_registry == NULL) {
+    // any non-NULL value, so the key's destructor runs when the thread exits
+    pthread_once(&slab_exit_once, slab_exit_key_init);
+    pthread_setspecific(slab_exit_key, &slab_thread);
+  }
+  slab->next = slab_registry;
+  slab_registry = slab;
+  return slab;
+}
+
+void slab_free(slab_t *slab) {
+  assert(slab->thread == &slab_thread);
+  slab_t **link = &slab_registry;
+  while (*link != slab) {
+    link = &(*link)->next;
+  }
+  *link = slab->next;
+  while (slab->pages != NULL) {
+    slab_page_t *next = slab->pages->next;
+    free(slab->pages);
+    slab->pages = next;
+  }
+  free(slab);
+}
+
+void *slab_alloc(slab_t *slab) {
+  assert(slab->thread == &slab_thread);
+  slab_stats_t *stats = &slab->stats;
+  if (slab->free_list == NULL &&
+      atomic_load_explicit(&slab->remote, memory_order_relaxed) != NULL) {
+    slab->free_list =
+        atomic_exchange_explicit(&slab->remote, NULL, memory_order_acquire);
+    stats->live -= atomic_exchange_explicit(&slab->remote_count, 0,
+                                            memory_order_relaxed);
+  }
+  stats->allocations++;
+  if (++stats->live > stats->peak) {
+    stats->peak = stats->live;
+  }
+  if (slab->free_list != NULL) {
+    stats->reused++;
+    free_object_t *object = slab->free_list;
+    slab->free_list = object->next;
+    return object;
+  }
+  if (slab->fresh == 0) {
+    slab_page_t *page =
+        malloc(sizeof(slab_page_t) + slab->slot_size * slab->objects_per_page);
+    assert(page != NULL);
+    page->next = slab->pages;
+    slab->pages = page;
+    slab->fresh = slab->objects_per_page;
+    stats->capacity += slab->objects_per_page;
+  }
+  size_t index = slab->objects_per_page - slab->fresh--;
+  slab_header_t *header =
+      (slab_header_t *)((char *)slab->pages->data + index * slab->slot_size);
+  header->slab = slab;
+  return header + 1;
+}
+
+void slab_release(void *object) {
+  slab_t *slab = ((slab_header_t *)object - 1)->slab;
+  free_object_t *released = object;
+  if (slab->thread == &slab_thread) {
+    assert(slab->stats.live > 0);
+    slab->stats.live--;
+    released->next = slab->free_list;
+    slab->free_list = released;
+    return;
+  }
+  released->next = atomic_load_explicit(&slab->remote, memory_order_relaxed);
+  while (!atomic_compare_exchange_weak_explicit(&slab->remote,
+                                                &released->next, released,
+                                                memory_order_release,
+                                                memory_order_relaxed)) {
+  }
+  atomic_fetch_add_explicit(&slab->remote_count, 1, memory_order_relaxed);
+}
+
+slab_stats_t slab_stats(slab_t *slab) {
+  slab_stats_t stats = slab->stats;
+  stats.live -=
+      atomic_load_explicit(&slab->remote_count, memory_order_relaxed);
+  return stats;
+}
+
+const char *slab_name(slab_t *slab) { return slab->name; }
+
+slab_t *slab_find(const char *name) {
+  for (slab_t *slab = slab_registry; slab != NULL; slab = slab->next) {
+    if (strcmp(slab->name, name) == 0) {
+      return slab;
+    }
+  }
+  return NULL;
+}
+
+slab_t *slab_next(slab_t *slab) {
+  return slab == NULL ? slab_registry : slab->next;
+}
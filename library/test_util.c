@@ -35,6 +35,8 @@ bool vec_isclose(vector_t v1, vector_t v2) {
   return isclose(v1.x, v2.x) && isclose(v1.y, v2.y);
 }
 
+sprite_info_t plain_sprite() { return (sprite_info_t){.is_sprite = false}; }
+
 void read_testname(char *filename, char *testname, size_t testname_size) {
   FILE *f = fopen(filename, "r");
   if (f == NULL) {
@@ -0,0 +1,176 @@
+#include "thread_pool.h"
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+enum { CACHE_LINE = 64 };
+
+// How many times threads yield while waiting for a loop to start or finish
+// before they sleep, so loops started in quick succession (like the levels
+// of force creators in a tick) do not pay for waking threads up each time
+const size_t THREAD_POOL_SPINS = 200;
+
+// The chunks a thread has left: it takes them from the front, and so do
+// threads stealing from it. Padded so threads do not share cache lines.
+typedef struct chunk_queue {
+  _Alignas(CACHE_LINE) atomic_size_t next;
+  size_t end;
+} chunk_queue_t;
+
+typedef struct worker {
+  struct thread_pool *pool;
+  size_t index;
+  pthread_t thread;
+} worker_t;
+
+typedef struct thread_pool {
+  size_t threads; // including the caller of thread_pool_for()
+  worker_t *workers; // threads - 1 of them
+  chunk_queue_t *queues; // one per thread, the caller's first
+  pthread_mutex_t lock;
+  pthread_cond_t wake; // a loop started, or the pool is stopping
+  pthread_cond_t done; // the last worker finished a loop
+  // Both change under lock, but are also read without it while spinning
+  atomic_size_t generation; // the number of loops started
+  atomic_size_t busy; // workers that have not finished the current loop
+  bool stopping;
+  // the current loop
+  parallel_func_t func;
+  void *aux;
+  size_t count;
+  size_t grain;
+} thread_pool_t;
+
+// Runs chunks until there are none left: the thread's own, then stolen ones
+void thread_pool_work(thread_pool_t *pool, size_t index) {
+  for (size_t k = 0; k < pool->threads; k++) {
+    chunk_queue_t *queue = &pool->queues[(index + k) % pool->threads];
+    while (true) {
+      size_t chunk = atomic_fetch_add(&queue->next, 1);
+      if (chunk >= queue->end) {
+        break;
+      }
+      size_t start = chunk * pool->grain;
+      size_t end = start + pool->grain;
+      pool->func(pool->aux, start, end < pool->count ? end : pool->count);
+    }
+  }
+}
+
+void *thread_pool_worker(void *arg) {
+  worker_t *worker = arg;
+  thread_pool_t *pool = worker->pool;
+  size_t seen = 0;
+  while (true) {
+    for (size_t i = 0; i < THREAD_POOL_SPINS &&
+                       atomic_load(&pool->generation) == seen;
+         i++) {
+      sched_yield();
+    }
+    pthread_mutex_lock(&pool->lock);
+    while (atomic_load(&pool->generation) == seen && !pool->stopping) {
+      pthread_cond_wait(&pool->wake, &pool->lock);
+    }
+    if (pool->stopping) {
+      pthread_mutex_unlock(&pool->lock);
+      return NULL;
+    }
+    seen = atomic_load(&pool->generation);
+    pthread_mutex_unlock(&pool->lock);
+    thread_pool_work(pool, worker->index);
+    if (atomic_fetch_sub(&pool->busy, 1) == 1) {
+      pthread_mutex_lock(&pool->lock);
+      pthread_cond_signal(&pool->done);
+      pthread_mutex_unlock(&pool->lock);
+    }
+  }
+}
+
+thread_pool_t *thread_pool_init(size_t threads) {
+  assert(threads >= 1);
+  thread_pool_t *pool = malloc(sizeof(thread_pool_t));
+  assert(pool != NULL);
+  pool->workers = malloc(sizeof(worker_t) * threads);
+  pool->queues = aligned_alloc(CACHE_LINE, sizeof(chunk_queue_t) * threads);
+  assert(pool->workers != NULL && pool->queues != NULL);
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->wake, NULL);
+  pthread_cond_init(&pool->done, NULL);
+  atomic_init(&pool->generation, 0);
+  atomic_init(&pool->busy, 0);
+  pool->stopping = false;
+  pool->threads = 1;
+  for (size_t i = 0; i < threads; i++) {
+    atomic_init(&pool->queues[i].next, 0);
+    pool->queues[i].end = 0;
+  }
+  // worker i runs as thread i + 1; stop at the first one that fails to start
+  for (size_t i = 0; i + 1 < threads; i++) {
+    worker_t *worker = &pool->workers[i];
+    worker->pool = pool;
+    worker->index = i + 1;
+    if (pthread_create(&worker->thread, NULL, thread_pool_worker, worker) !=
+        0) {
+      break;
+    }
+    pool->threads++;
+  }
+  return pool;
+}
+
+void thread_pool_free(thread_pool_t *pool) {
+  pthread_mutex_lock(&pool->lock);
+  pool->stopping = true;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+  for (size_t i = 0; i + 1 < pool->threads; i++) {
+    pthread_join(pool->workers[i].thread, NULL);
+  }
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->wake);
+  pthread_cond_destroy(&pool->done);
+  free(pool->workers);
+  free(pool->queues);
+  free(pool);
+}
+
+size_t thread_pool_threads(thread_pool_t *pool) { return pool->threads; }
+
+void thread_pool_for(thread_pool_t *pool, size_t count, size_t grain,
+                     parallel_func_t func, void *aux) {
+  assert(grain >= 1);
+  if (pool == NULL || pool->threads == 1 || count <= grain) {
+    if (count > 0) {
+      func(aux, 0, count);
+    }
+    return;
+  }
+  size_t chunks = (count + grain - 1) / grain;
+  pthread_mutex_lock(&pool->lock);
+  pool->func = func;
+  pool->aux = aux;
+  pool->count = count;
+  pool->grain = grain;
+  for (size_t t = 0; t < pool->threads; t++) {
+    atomic_store(&pool->queues[t].next, chunks * t / pool->threads);
+    pool->queues[t].end = chunks * (t + 1) / pool->threads;
+  }
+  atomic_store(&pool->busy, pool->threads - 1);
+  atomic_fetch_add(&pool->generation, 1);
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+
+  thread_pool_work(pool, 0);
+  for (size_t i = 0; i < THREAD_POOL_SPINS && atomic_load(&pool->busy) > 0;
+       i++) {
+    sched_yield();
+  }
+  pthread_mutex_lock(&pool->lock);
+  while (atomic_load(&pool->busy) > 0) {
+    pthread_cond_wait(&pool->done, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+}
@@ -0,0 +1,130 @@
+#include "arena.h"
+#include "body.h"
+#include "collision.h"
+#include "pool_table.h"
+#include "scene.h"
+#include "shape_utility.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// The suite is linked with --wrap so every allocation is counted
+size_t allocations = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *memory, size_t size);
+
+void *__wrap_malloc(size_t size) {
+  allocations++;
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+  allocations++;
+  return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *memory, size_t size) {
+  allocations++;
+  return __real_realloc(memory, size);
+}
+
+bool is_aligned(void *memory) {
+  return (uintptr_t)memory % alignof(max_align_t) == 0;
+}
+
+void test_alloc() {
+  size_t before = allocations;
+  arena_t *arena = arena_init(64);
+  assert(allocations > before);
+  char *a = arena_alloc(arena, 3);
+  double *b = arena_alloc(arena, sizeof(double));
+  assert(is_aligned(a) && is_aligned(b));
+  assert((char *)b >= a + 3);
+  // the reset hands out the same memory again
+  arena_reset(arena);
+  assert(arena_alloc(arena, 3) == a);
+  arena_free(arena);
+}
+
+// Overflowing chains on a block; the reset merges them into one
+void test_growth() {
+  arena_t *arena = arena_init(64);
+  for (size_t i = 0; i < 10; i++) {
+    arena_alloc(arena, 48);
+  }
+  size_t capacity = arena_capacity(arena);
+  assert(capacity >= 480);
+  arena_reset(arena);
+  assert(arena_capacity(arena) == capacity);
+  // a tick no busier than the last one allocates nothing
+  size_t before = allocations;
+  for (size_t tick = 0; tick < 3; tick++) {
+    for (size_t i = 0; i < 10; i++) {
+      arena_alloc(arena, 48);
+    }
+    arena_reset(arena);
+  }
+  assert(allocations == before);
+  arena_free(arena);
+}
+
+void test_collision_allocations() {
+  polygon_t *rect = generate_rect_shape(0, 0, 10, 10);
+  polygon_t *ball = generate_ball(0, 8, 5);
+  polygon_t *far = generate_ball(50, 50, 5);
+  size_t before = allocations;
+  for (size_t i = 0; i < 100; i++) {
+    assert(find_collision(rect, ball).collided);
+    assert(!find_collision(rect, far).collided);
+  }
+  assert(allocations == before);
+  polygon_free(rect);
+  polygon_free(ball);
+  polygon_free(far);
+}
+
+void play_break(scene_t *scene) {
+  body_add_impulse(get_cueball_body(scene),
+                   vec_rotate((vector_t){1500, 0}, 185 * M_PI / 180));
+  for (size_t i = 0; i < 30000 && !balls_stopped(scene); i++) {
+    scene_tick(scene, 1e-3);
+  }
+}
+
+// Once the break has been played through, replaying it allocates nothing
+void test_tick_allocations() {
+  scene_t *scene = scene_init();
+  generate_pool_table(scene, true, true);
+  scene_snapshot_t *snapshot = scene_snapshot(scene);
+  play_break(scene);
+  size_t bodies = scene_bodies(scene);
+  scene_restore(scene, snapshot);
+  size_t before = allocations;
+  play_break(scene);
+  assert(allocations == before);
+  assert(scene_bodies(scene) == bodies);
+  scene_snapshot_free(scene, snapshot);
+  scene_free(scene);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_alloc)
+  DO_TEST(test_growth)
+  DO_TEST(test_collision_allocations)
+  DO_TEST(test_tick_allocations)
+
+  puts("arena_test PASS");
+}
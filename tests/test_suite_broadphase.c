@@ -0,0 +1,222 @@
+#include "body.h"
+#include "collision.h"
+#include "forces.h"
+#include "scene.h"
+#include "shape_utility.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+const size_t RED = 1 << 0;
+const size_t BLUE = 1 << 1;
+const size_t WALL = 1 << 2;
+
+typedef struct hit {
+  body_t *body1;
+  body_t *body2;
+  vector_t axis;
+} hit_t;
+
+typedef struct hits {
+  size_t count;
+  hit_t last;
+} hits_t;
+
+void record_hit(body_t *body1, body_t *body2, vector_t axis, void *aux) {
+  hits_t *hits = aux;
+  hits->count++;
+  hits->last = (hit_t){body1, body2, axis};
+}
+
+body_t *make_circle(scene_t *scene, double x, double y, size_t categories) {
+  sprite_info_t sprite = {.is_sprite = false};
+  body_t *body = body_init_circle((vector_t){x, y}, 1, sprite, 1);
+  scene_add_body(scene, body);
+  scene_add_collider(scene, body, categories);
+  return body;
+}
+
+// Handlers get the bodies in the order of the rule's categories
+void test_rule_order() {
+  scene_t *scene = scene_init();
+  hits_t hits = {0};
+  scene_add_collision_rule(scene, BLUE, RED, record_hit, &hits, NULL);
+  body_t *red = make_circle(scene, 0, 0, RED);
+  body_t *blue = make_circle(scene, 1.5, 0, BLUE);
+  scene_tick(scene, 0);
+  assert(hits.count == 1);
+  assert(hits.last.body1 == blue && hits.last.body2 == red);
+  assert(vec_isclose(hits.last.axis, (vector_t){-1, 0}));
+  // no rule for red-red, and the red-blue contact carries on
+  make_circle(scene, -1.5, 0, RED);
+  for (size_t i = 0; i < 20; i++) {
+    scene_tick(scene, 0);
+  }
+  assert(hits.count == 1);
+  scene_free(scene);
+}
+
+// A resting contact fires once, and again only when the bodies move
+// towards each other or meet again after parting
+void test_touching() {
+  scene_t *scene = scene_init();
+  hits_t hits = {0};
+  scene_add_collision_rule(scene, RED, RED, record_hit, &hits, NULL);
+  body_t *left = make_circle(scene, 0, 0, RED);
+  body_t *right = make_circle(scene, 1, 0, RED);
+  scene_tick(scene, 0);
+  assert(hits.count == 1);
+  for (size_t i = 0; i < 20; i++) {
+    scene_tick(scene, 0);
+    assert(scene_collision_candidates(scene) == 0);
+  }
+  assert(hits.count == 1);
+  // pushed together while touching
+  body_set_velocity(right, (vector_t){-0.5, 0});
+  scene_tick(scene, 0);
+  assert(hits.count == 2);
+  // moving apart while touching does not fire
+  body_set_velocity(right, (vector_t){1, 0});
+  scene_tick(scene, 0.1);
+  assert(hits.count == 2);
+  // parted, then back
+  body_set_centroid(right, (vector_t){5, 0});
+  body_set_velocity(right, VEC_ZERO);
+  scene_tick(scene, 0);
+  body_set_centroid(right, (vector_t){1.5, 0});
+  scene_tick(scene, 0);
+  assert(hits.count == 3);
+  assert(vec_equal(body_get_velocity(left), VEC_ZERO));
+  scene_free(scene);
+}
+
+void remove_first(body_t *body1, body_t *body2, vector_t axis, void *aux) {
+  body_remove(body1);
+}
+
+void test_removal() {
+  scene_t *scene = scene_init();
+  scene_add_collision_rule(scene, RED, WALL, remove_first, NULL, NULL);
+  polygon_t *wall_shape = generate_rect_shape(0, -10, 100, 2);
+  sprite_info_t sprite = {.is_sprite = false};
+  body_t *wall = body_init(wall_shape, sprite, INFINITY);
+  scene_add_body(scene, wall);
+  scene_add_collider(scene, wall, WALL);
+  for (size_t i = 0; i < 10; i++) {
+    body_t *ball = make_circle(scene, 10.0 * i - 45, 0, RED);
+    body_set_velocity(ball, (vector_t){0, -1});
+  }
+  for (size_t i = 0; i < 10; i++) {
+    scene_tick(scene, 1);
+  }
+  assert(scene_bodies(scene) == 1);
+  assert(scene_get_body(scene, 0) == wall);
+  scene_tick(scene, 1);
+  scene_free(scene);
+}
+
+// Only pairs with overlapping boxes reach the narrowphase
+void test_scaling() {
+  scene_t *scene = scene_init();
+  hits_t hits = {0};
+  scene_add_collision_rule(scene, RED, RED, record_hit, &hits, NULL);
+  for (size_t i = 0; i < 2000; i++) {
+    make_circle(scene, 3.0 * (i % 50), 3.0 * (i / 50), RED);
+  }
+  // this one touches two others
+  make_circle(scene, 1.5, 0, RED);
+  scene_tick(scene, 0);
+  assert(scene_collision_candidates(scene) == 2);
+  assert(hits.count == 2);
+  scene_free(scene);
+}
+
+// Contacts are published once per pair, whatever subscribes to them
+void test_events() {
+  scene_t *scene = scene_init();
+  hits_t hits = {0};
+  scene_add_collision_rule(scene, RED, BLUE, record_hit, &hits, NULL);
+  scene_add_collision_rule(scene, RED, BLUE, record_hit, &hits, NULL);
+  scene_add_collision_rule(scene, RED, RED, NULL, NULL, NULL);
+  body_t *red1 = make_circle(scene, 0, 0, RED);
+  body_t *red2 = make_circle(scene, 1, 0, RED);
+  body_t *blue = make_circle(scene, -1.2, 0, BLUE);
+  make_circle(scene, -0.5, 1.9, BLUE); // no rule for blue-blue
+  scene_tick(scene, 0);
+  assert(hits.count == 4);
+  assert(scene_collision_candidates(scene) == 4);
+  assert(scene_collisions(scene) == 3);
+  bool found = false;
+  for (size_t i = 0; i < scene_collisions(scene); i++) {
+    collision_event_t event = scene_get_collision(scene, i);
+    if (event.body1 == red2 || event.body2 == red2) {
+      assert(event.body1 == red1 || event.body2 == red1);
+      found = true;
+    }
+  }
+  assert(found);
+  // removed bodies disappear from the events
+  body_remove(blue);
+  scene_tick(scene, 0);
+  assert(scene_collisions(scene) == 0);
+  scene_free(scene);
+}
+
+// Chaos collisions read the published contacts
+void test_chaos_subscriber() {
+  scene_t *scene = scene_init();
+  scene_add_collision_rule(scene, RED, RED, NULL, NULL, NULL);
+  body_t *ball1 = make_circle(scene, 0, 0, RED);
+  body_t *ball2 = make_circle(scene, 1.5, 0, RED);
+  body_set_velocity(ball1, (vector_t){1, 0});
+  sprite_info_t sprite = {.is_sprite = false};
+  body_t *ball3 = body_init_circle((vector_t){100, 0}, 1, sprite, 1);
+  scene_add_body(scene, ball3);
+  create_chaos_physics_collision(scene, 1, ball1, ball2, ball3);
+  scene_tick(scene, 1);
+  // ball1 and ball3 swap velocities; ball2 is untouched
+  assert(vec_isclose(body_get_velocity(ball1), VEC_ZERO));
+  assert(vec_isclose(body_get_velocity(ball2), VEC_ZERO));
+  assert(vec_isclose(body_get_velocity(ball3), (vector_t){1, 0}));
+  scene_free(scene);
+}
+
+// A ball moving several diameters per tick still bounces off a thin wall
+void test_no_tunneling() {
+  scene_t *scene = scene_init();
+  create_physics_collision_rule(scene, 1, RED, WALL);
+  polygon_t *wall_shape = generate_rect_shape(0, 0, 100, 0.1);
+  sprite_info_t sprite = {.is_sprite = false};
+  body_t *wall = body_init(wall_shape, sprite, INFINITY);
+  scene_add_body(scene, wall);
+  scene_add_collider(scene, wall, WALL);
+  body_t *ball = make_circle(scene, 0, 7, RED);
+  body_set_velocity(ball, (vector_t){0, -5});
+  for (size_t i = 0; i < 4; i++) {
+    scene_tick(scene, 1);
+  }
+  assert(body_get_centroid(ball).y > 0);
+  assert(vec_isclose(body_get_velocity(ball), (vector_t){0, 5}));
+  scene_free(scene);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_rule_order)
+  DO_TEST(test_touching)
+  DO_TEST(test_removal)
+  DO_TEST(test_scaling)
+  DO_TEST(test_events)
+  DO_TEST(test_chaos_subscriber)
+  DO_TEST(test_no_tunneling)
+
+  puts("broadphase_test PASS");
+}
@@ -1,52 +1,260 @@
+#include "body.h"
 #include "collision.h"
 #include "polygon.h"
+#include "shape_utility.h"
 #include "test_util.h"
-#include "vec_list.h"
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
 
 // Make square at for the given x and y coordinates
-list_t *make_square(double x1, double x2, double y1, double y2) {
-  list_t *sq = list_init(4, free);
-  vector_t *v = malloc(sizeof(*v));
-  *v = (vector_t){x1, y1};
-  list_add(sq, v);
-  v = malloc(sizeof(*v));
-  *v = (vector_t){x1, y2};
-  list_add(sq, v);
-  v = malloc(sizeof(*v));
-  *v = (vector_t){x2, y2};
-  list_add(sq, v);
-  v = malloc(sizeof(*v));
-  *v = (vector_t){x2, y1};
-  list_add(sq, v);
+polygon_t *make_square(double x1, double x2, double y1, double y2) {
+  polygon_t *sq = polygon_init(4);
+  polygon_add(sq, (vector_t){x1, y1});
+  polygon_add(sq, (vector_t){x1, y2});
+  polygon_add(sq, (vector_t){x2, y2});
+  polygon_add(sq, (vector_t){x2, y1});
   return sq;
 }
 
 void test_colliding_shapes() {
-  list_t *sq1 = make_square(-1, 1, -1, 1);
-  list_t *sq2 = make_square(0.5, 2.5, -1, 1);
+  polygon_t *sq1 = make_square(-1, 1, -1, 1);
+  polygon_t *sq2 = make_square(0.5, 2.5, -1, 1);
   assert(find_collision(sq1, sq2).collided);
   polygon_translate(sq2, (vector_t){0, 2});
   assert(find_collision(sq1, sq2).collided);
   polygon_rotate(sq2, M_PI_4, polygon_centroid(sq1));
   polygon_translate(sq2, (vector_t){0, -2});
   assert(find_collision(sq1, sq2).collided);
-  list_free(sq1);
-  list_free(sq2);
+  polygon_free(sq1);
+  polygon_free(sq2);
 }
 
 void test_noncolliding_shapes() {
-  list_t *sq1 = make_square(-1, 1, -1, 1);
-  list_t *sq2 = make_square(5, 7, -1, 1);
+  polygon_t *sq1 = make_square(-1, 1, -1, 1);
+  polygon_t *sq2 = make_square(5, 7, -1, 1);
   assert(find_collision(sq1, sq2).collided == false);
   polygon_rotate(sq2, M_PI_4, polygon_centroid(sq1));
   assert(find_collision(sq1, sq2).collided == false);
   polygon_translate(sq2, (vector_t){0, 100});
   assert(find_collision(sq1, sq2).collided == false);
-  list_free(sq1);
-  list_free(sq2);
+  polygon_free(sq1);
+  polygon_free(sq2);
+}
+
+void test_circles() {
+  collision_info_t info =
+      find_circle_collision((vector_t){0, 0}, 1, (vector_t){1.5, 0}, 1);
+  assert(info.collided);
+  assert(vec_isclose(info.axis, (vector_t){1, 0}));
+  info = find_circle_collision((vector_t){0, 0}, 1, (vector_t){0, 2}, 1);
+  assert(info.collided);
+  assert(vec_isclose(info.axis, (vector_t){0, 1}));
+  info = find_circle_collision((vector_t){0, 0}, 1, (vector_t){1.5, 1.5}, 1);
+  assert(info.collided == false);
+}
+
+void test_circle_polygon() {
+  polygon_t *sq = make_square(-1, 1, -1, 1);
+  // near an edge
+  collision_info_t info = find_circle_polygon_collision((vector_t){1.5, 0},
+                                                        1, sq);
+  assert(info.collided);
+  assert(vec_isclose(info.axis, (vector_t){-1, 0}));
+  // near a corner, but too far away
+  info = find_circle_polygon_collision((vector_t){1.8, 1.8}, 1, sq);
+  assert(info.collided == false);
+  // near a corner
+  info = find_circle_polygon_collision((vector_t){1.5, 1.5}, 1, sq);
+  assert(info.collided);
+  assert(vec_isclose(info.axis, vec_unit((vector_t){-1, -1})));
+  // center inside, closest to the top edge
+  info = find_circle_polygon_collision((vector_t){0, 0.9}, 0.5, sq);
+  assert(info.collided);
+  assert(vec_isclose(info.axis, (vector_t){0, -1}));
+  // the axis alone, for circles of any size
+  assert(vec_isclose(find_circle_polygon_axis((vector_t){5, 0}, sq),
+                     (vector_t){-1, 0}));
+  assert(vec_isclose(find_circle_polygon_axis((vector_t){4, 4}, sq),
+                     vec_unit((vector_t){-1, -1})));
+  assert(vec_isclose(find_circle_polygon_axis((vector_t){0, 0.9}, sq),
+                     (vector_t){0, -1}));
+  polygon_free(sq);
+}
+
+// Circles should agree with the 30-gon outlines used for balls before
+void test_matches_polygons() {
+  sprite_info_t sprite = {.is_sprite = false};
+  body_t *ball = body_init_circle((vector_t){0, 0}, 10, sprite, 1);
+  body_t *wall = body_init(make_square(-100, 100, 12, 20), sprite, INFINITY);
+  for (double x = 12; x < 25; x += 0.5) {
+    for (double y = -15; y < 15; y += 0.5) {
+      body_t *other = body_init_circle((vector_t){x, y}, 10, sprite, 1);
+      polygon_t *outline1 = body_get_deepcopied_shape(ball);
+      polygon_t *outline2 = body_get_deepcopied_shape(other);
+      collision_info_t exact = find_body_collision(ball, other);
+      collision_info_t sat = find_collision(outline1, outline2);
+      // the outlines are inscribed, so they can only miss grazing contacts
+      if (sat.collided) {
+        assert(exact.collided);
+      } else if (exact.collided) {
+        assert(vec_magnitude((vector_t){x, y}) > 19.5);
+      }
+      polygon_free(outline1);
+      polygon_free(outline2);
+      body_free(other);
+    }
+  }
+  collision_info_t info = find_body_collision(wall, ball);
+  assert(info.collided == false);
+  body_set_centroid(ball, (vector_t){0, 5});
+  info = find_body_collision(wall, ball);
+  assert(info.collided);
+  assert(vec_isclose(info.axis, (vector_t){0, -1}));
+  info = find_body_collision(ball, wall);
+  assert(vec_isclose(info.axis, (vector_t){0, 1}));
+  body_free(ball);
+  body_free(wall);
+}
+
+void test_lazy_outline() {
+  sprite_info_t sprite = {.is_sprite = false};
+  body_t *ball = body_init_circle((vector_t){3, 4}, 2, sprite, 1);
+  assert(body_get_shape_kind(ball) == SHAPE_CIRCLE);
+  assert(body_get_radius(ball) == 2);
+  body_set_centroid(ball, (vector_t){10, 0});
+  polygon_t *outline = body_get_shape(ball);
+  assert(vec_isclose(polygon_centroid(outline), (vector_t){10, 0}));
+  assert(isclose(vec_magnitude(vec_subtract(polygon_get(outline, 0),
+                                            (vector_t){10, 0})),
+                 2));
+  // the outline follows the body once created
+  body_set_centroid(ball, (vector_t){0, 0});
+  assert(vec_isclose(polygon_centroid(body_get_shape(ball)), VEC_ZERO));
+  body_free(ball);
+}
+
+void test_time_of_impact() {
+  // closing at 10 per unit time with a gap of 8
+  double t = circle_time_of_impact((vector_t){0, 0}, (vector_t){6, 0}, 1,
+                                   (vector_t){10, 0}, (vector_t){-4, 0}, 1, 1);
+  assert(isclose(t, 0.8));
+  assert(circle_time_of_impact((vector_t){0, 0}, (vector_t){6, 0}, 1,
+                               (vector_t){10, 0}, (vector_t){-4, 0}, 1,
+                               0.5) == INFINITY);
+  // moving apart or passing by
+  assert(circle_time_of_impact((vector_t){0, 0}, (vector_t){-6, 0}, 1,
+                               (vector_t){10, 0}, VEC_ZERO, 1, 10) == INFINITY);
+  assert(circle_time_of_impact((vector_t){0, 0}, (vector_t){6, 0}, 1,
+                               (vector_t){10, 3}, VEC_ZERO, 1, 10) == INFINITY);
+  assert(circle_time_of_impact(VEC_ZERO, VEC_ZERO, 1, (vector_t){1, 0},
+                               VEC_ZERO, 1, 0) == 0);
+
+  polygon_t *wall = make_square(-10, 10, -1, 1);
+  // hits the face
+  t = circle_polygon_time_of_impact((vector_t){0, 10}, (vector_t){0, -100}, 2,
+                                    wall, 1);
+  assert(isclose(t, 0.07));
+  // hits the corner at 45 degrees
+  t = circle_polygon_time_of_impact((vector_t){12, 3}, (vector_t){-1, -1}, 1,
+                                    wall, 10);
+  assert(isclose(t, 2 - sqrt(0.5)));
+  // misses the end
+  assert(circle_polygon_time_of_impact((vector_t){12, 10}, (vector_t){0, -100},
+                                       1, wall, 1) == INFINITY);
+  polygon_free(wall);
+}
+
+// A fast ball collides with a thin wall it would jump over in one tick
+void test_swept_collision() {
+  sprite_info_t sprite = {.is_sprite = false};
+  body_t *ball = body_init_circle((vector_t){0, 10}, 1, sprite, 1);
+  body_t *wall =
+      body_init(make_square(-10, 10, -0.5, 0.5), sprite, INFINITY);
+  body_set_velocity(ball, (vector_t){0, -1000});
+  assert(!find_body_collision(ball, wall).collided);
+  assert(!find_body_swept_collision(ball, wall, 0.001).collided);
+  collision_info_t info = find_body_swept_collision(ball, wall, 0.1);
+  assert(info.collided);
+  assert(vec_isclose(info.axis, (vector_t){0, -1}));
+  // the gap still to close, as a negative depth
+  assert(isclose(info.depth, -8.5));
+  info = find_body_swept_collision(wall, ball, 0.1);
+  assert(vec_isclose(info.axis, (vector_t){0, 1}));
+  assert(isclose(info.depth, -8.5));
+
+  body_t *other = body_init_circle((vector_t){0, -10}, 1, sprite, 1);
+  info = find_body_swept_collision(ball, other, 0.1);
+  assert(info.collided);
+  assert(vec_isclose(info.axis, (vector_t){0, -1}));
+  assert(isclose(info.depth, -18));
+  body_free(ball);
+  body_free(wall);
+  body_free(other);
+}
+
+// The cached bounds follow moves, rotations and new shapes
+void test_cached_bounds() {
+  sprite_info_t sprite = {.is_sprite = false};
+  body_t *bar = body_init(make_square(-4, 4, -1, 1), sprite, 1);
+  assert(isclose(body_get_bounding_radius(bar), sqrt(17)));
+  body_set_centroid(bar, (vector_t){10, 20});
+  aabb_t box = body_get_aabb(bar);
+  assert(vec_isclose(box.min, (vector_t){6, 19}));
+  assert(vec_isclose(box.max, (vector_t){14, 21}));
+  body_set_rotation(bar, M_PI / 2);
+  box = body_get_aabb(bar);
+  assert(vec_isclose(box.min, (vector_t){9, 16}));
+  assert(vec_isclose(box.max, (vector_t){11, 24}));
+  assert(isclose(body_get_bounding_radius(bar), sqrt(17)));
+  body_set_shape(bar, make_square(8, 12, 18, 22));
+  box = body_get_aabb(bar);
+  assert(vec_isclose(box.min, (vector_t){8, 18}));
+  assert(vec_isclose(box.max, (vector_t){12, 22}));
+  assert(isclose(body_get_bounding_radius(bar), sqrt(8)));
+
+  body_t *ball = body_init_circle((vector_t){1, 2}, 3, sprite, 1);
+  assert(body_get_bounding_radius(ball) == 3);
+  box = body_get_aabb(ball);
+  assert(vec_isclose(box.min, (vector_t){-2, -1}));
+  assert(vec_isclose(box.max, (vector_t){4, 5}));
+  body_free(bar);
+  body_free(ball);
+}
+
+// Pairs apart by their bounds are rejected without the exact test, and
+// the early-out never changes the result
+void test_bounds_rejects() {
+  sprite_info_t sprite = {.is_sprite = false};
+  body_t *wall = body_init(make_square(-10, 10, -0.5, 0.5), sprite, INFINITY);
+  body_t *ball = body_init_circle((vector_t){0, 5}, 1, sprite, 1);
+  collision_reset_stats();
+  // inside the wall's bounding circle, but clear of its box
+  assert(!find_body_collision(wall, ball).collided);
+  body_set_centroid(ball, (vector_t){30, 0});
+  assert(!find_body_collision(ball, wall).collided);
+  collision_stats_t stats = collision_get_stats();
+  assert(stats.tests == 2 && stats.rejects == 2 && stats.hits == 0);
+
+  // touching still counts as colliding
+  body_set_centroid(ball, (vector_t){0, 1.5});
+  assert(find_body_collision(ball, wall).collided);
+  polygon_t *square = make_square(10, 12, -1, 1);
+  body_t *block = body_init(square, sprite, 1);
+  assert(find_body_collision(wall, block).collided);
+  stats = collision_get_stats();
+  assert(stats.tests == 4 && stats.rejects == 2 && stats.hits == 2);
+
+  for (size_t i = 0; i < 100; i++) {
+    vector_t centroid = vec_rotate((vector_t){i * 0.2, 0}, i);
+    body_set_centroid(block, centroid);
+    assert(find_body_collision(wall, block).collided ==
+           find_collision(body_get_shape(wall), body_get_shape(block))
+               .collided);
+  }
+  body_free(wall);
+  body_free(ball);
+  body_free(block);
 }
 
 int main(int argc, char *argv[]) {
@@ -60,6 +268,14 @@ int main(int argc, char *argv[]) {
 
   DO_TEST(test_colliding_shapes)
   DO_TEST(test_noncolliding_shapes)
+  DO_TEST(test_circles)
+  DO_TEST(test_circle_polygon)
+  DO_TEST(test_matches_polygons)
+  DO_TEST(test_lazy_outline)
+  DO_TEST(test_time_of_impact)
+  DO_TEST(test_swept_collision)
+  DO_TEST(test_cached_bounds)
+  DO_TEST(test_bounds_rejects)
 
   puts("collision_test PASS");
 }
@@ -0,0 +1,266 @@
+#include "body.h"
+#include "contact.h"
+#include "forces.h"
+#include "scene.h"
+#include "shape_utility.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+const size_t BALL = 1 << 0;
+const size_t WALL = 1 << 1;
+
+body_t *make_ball(scene_t *scene, double x, double y, double mass) {
+  sprite_info_t sprite = {.is_sprite = false};
+  body_t *body = body_init_circle((vector_t){x, y}, 1, sprite, mass);
+  scene_add_body(scene, body);
+  scene_add_collider(scene, body, BALL);
+  return body;
+}
+
+// The speed at which the contact between two bodies is closing
+double approach(body_t *body1, body_t *body2) {
+  vector_t axis = vec_unit(
+      vec_subtract(body_get_centroid(body2), body_get_centroid(body1)));
+  return vec_dot(vec_subtract(body_get_velocity(body1),
+                              body_get_velocity(body2)),
+                 axis);
+}
+
+// A single contact gets exactly the one-shot elastic impulse
+void test_head_on() {
+  double elasticities[] = {0, 0.5, 1};
+  for (size_t i = 0; i < 3; i++) {
+    scene_t *scene = scene_init();
+    contact_solver_t *solver = contact_solver_init();
+    body_t *ball1 = make_ball(scene, 0, 0, 1);
+    body_t *ball2 = make_ball(scene, 2, 0, 3);
+    body_set_velocity(ball1, (vector_t){4, 0});
+    contact_solver_add(solver, (contact_t){ball1, ball2, (vector_t){1, 0}, 0,
+                                           elasticities[i]});
+    assert(contact_solver_contacts(solver) == 1);
+    contact_solver_solve(solver, body_get_kinematics(ball1), 0);
+    assert(contact_solver_contacts(solver) == 0);
+    // tick without moving, to apply the impulses
+    scene_tick(scene, 0);
+    vector_t v1 = body_get_velocity(ball1);
+    vector_t v2 = body_get_velocity(ball2);
+    assert(isclose(v1.x + 3 * v2.x, 4));
+    assert(isclose(v2.x - v1.x, 4 * elasticities[i]));
+    contact_solver_free(solver);
+    scene_free(scene);
+  }
+}
+
+// A ball driven into a row of touching balls leaves every contact
+// separating, instead of pushing into balls that already moved on
+void test_row() {
+  scene_t *scene = scene_init();
+  scene_add_contact_rule(scene, BALL, BALL, 0.9);
+  body_t *balls[5];
+  for (size_t i = 0; i < 5; i++) {
+    balls[i] = make_ball(scene, 2.0 * i, 0, 1);
+  }
+  body_set_velocity(balls[0], (vector_t){10, 0});
+  scene_tick(scene, 0);
+  assert(scene_contact_iterations(scene) > 1);
+  assert(scene_contact_iterations(scene) < CONTACT_SOLVER_ITERATIONS);
+  double momentum = 0;
+  for (size_t i = 0; i < 5; i++) {
+    momentum += body_get_velocity(balls[i]).x;
+    if (i > 0) {
+      assert(approach(balls[i - 1], balls[i]) < 1e-5);
+    }
+  }
+  assert(isclose(momentum, 10));
+  scene_free(scene);
+}
+
+// The cap stops the solver early
+void test_iteration_cap() {
+  scene_t *scene = scene_init();
+  scene_add_contact_rule(scene, BALL, BALL, 1);
+  scene_set_contact_iterations(scene, 1, 0);
+  for (size_t i = 0; i < 5; i++) {
+    make_ball(scene, 2.0 * i, 0, 1);
+  }
+  body_set_velocity(scene_get_body(scene, 0), (vector_t){10, 0});
+  scene_tick(scene, 0);
+  assert(scene_contact_iterations(scene) == 1);
+  // at rest, one pass finds nothing to do
+  scene_t *resting = scene_init();
+  scene_add_contact_rule(resting, BALL, BALL, 1);
+  make_ball(resting, 0, 0, 1);
+  make_ball(resting, 2, 0, 1);
+  scene_tick(resting, 0);
+  assert(scene_contact_iterations(resting) == 1);
+  scene_free(scene);
+  scene_free(resting);
+}
+
+// Infinite masses do not move, and bounce the other body back
+void test_wall() {
+  scene_t *scene = scene_init();
+  scene_add_contact_rule(scene, BALL, WALL, 0.5);
+  sprite_info_t sprite = {.is_sprite = false};
+  body_t *wall =
+      body_init(generate_rect_shape(0, -2, 20, 2), sprite, INFINITY);
+  scene_add_body(scene, wall);
+  scene_add_collider(scene, wall, WALL);
+  body_t *ball = make_ball(scene, 0, 0, 2);
+  body_set_velocity(ball, (vector_t){1, -4});
+  scene_tick(scene, 0.01);
+  assert(vec_isclose(body_get_velocity(ball), (vector_t){1, 2}));
+  assert(vec_equal(body_get_velocity(wall), VEC_ZERO));
+  assert(vec_equal(body_get_centroid(wall), (vector_t){0, -2}));
+  scene_free(scene);
+}
+
+// Overlapping bodies at rest are pushed apart without gaining speed
+void test_overlap() {
+  scene_t *scene = scene_init();
+  scene_add_contact_rule(scene, BALL, BALL, 1);
+  body_t *light = make_ball(scene, 0, 0, 1);
+  body_t *heavy = make_ball(scene, 1.5, 0, 3);
+  for (size_t i = 0; i < 20; i++) {
+    scene_tick(scene, 0.01);
+  }
+  double gap = body_get_centroid(heavy).x - body_get_centroid(light).x;
+  assert(gap > 2 - 0.01 && gap <= 2);
+  // the light one moved three times as far
+  assert(within(1e-9, -body_get_centroid(light).x,
+                3 * (body_get_centroid(heavy).x - 1.5)));
+  assert(vec_equal(body_get_velocity(light), VEC_ZERO));
+  assert(vec_equal(body_get_velocity(heavy), VEC_ZERO));
+  scene_free(scene);
+}
+
+// A resting body under gravity stays on the floor instead of sinking or
+// bouncing
+void test_resting() {
+  scene_t *scene = scene_init();
+  scene_add_contact_rule(scene, BALL, WALL, 0.5);
+  sprite_info_t sprite = {.is_sprite = false};
+  body_t *floor =
+      body_init(generate_rect_shape(0, -2, 20, 2), sprite, INFINITY);
+  scene_add_body(scene, floor);
+  scene_add_collider(scene, floor, WALL);
+  body_t *ball = make_ball(scene, 0, 0, 1);
+  create_uniform_gravity(scene, (vector_t){0, -10}, ball);
+  for (size_t i = 0; i < 600; i++) {
+    scene_tick(scene, 1.0 / 60);
+    assert(fabs(body_get_centroid(ball).y) < 1e-2);
+  }
+  assert(vec_isclose(body_get_velocity(ball), VEC_ZERO));
+  scene_free(scene);
+}
+
+// A tall column under gravity holds up: every contact carries the weight
+// above it, which the solver keeps from tick to tick instead of finding
+// again, so the column barely sinks and is soon solved in a few passes
+void test_column() {
+  scene_t *scene = scene_init();
+  scene_add_contact_rule(scene, BALL, BALL, 0.5);
+  scene_add_contact_rule(scene, BALL, WALL, 0.5);
+  sprite_info_t sprite = {.is_sprite = false};
+  body_t *floor =
+      body_init(generate_rect_shape(0, -1, 10, 2), sprite, INFINITY);
+  scene_add_body(scene, floor);
+  scene_add_collider(scene, floor, WALL);
+  size_t height = 30;
+  body_t *top = NULL;
+  for (size_t i = 0; i < height; i++) {
+    top = make_ball(scene, 0, 1 + 2.0 * i, 1);
+    create_uniform_gravity(scene, (vector_t){0, -100}, top);
+  }
+  double rest = 1 + 2.0 * (height - 1);
+  for (size_t i = 0; i < 600; i++) {
+    scene_tick(scene, 1.0 / 60);
+    assert(fabs(rest - body_get_centroid(top).y) < 1);
+  }
+  assert(fabs(rest - body_get_centroid(top).y) < 0.1);
+  assert(fabs(body_get_velocity(top).y) < 1e-3);
+  assert(scene_contact_iterations(scene) < 5);
+  scene_free(scene);
+}
+
+// Pairwise physics collisions feed the same solver
+void test_pair_contacts() {
+  scene_t *scene = scene_init();
+  sprite_info_t sprite = {.is_sprite = false};
+  body_t *ball1 = body_init_circle((vector_t){0, 0}, 1, sprite, 1);
+  body_t *ball2 = body_init_circle((vector_t){2, 0}, 1, sprite, 1);
+  body_t *ball3 = body_init_circle((vector_t){4, 0}, 1, sprite, 1);
+  scene_add_body(scene, ball1);
+  scene_add_body(scene, ball2);
+  scene_add_body(scene, ball3);
+  create_physics_collision(scene, 1, ball1, ball2);
+  create_physics_collision(scene, 1, ball2, ball3);
+  body_set_velocity(ball1, (vector_t){3, 0});
+  scene_tick(scene, 0);
+  assert(approach(ball1, ball2) < 1e-5 && approach(ball2, ball3) < 1e-5);
+  assert(isclose(body_get_velocity(ball1).x + body_get_velocity(ball2).x +
+                     body_get_velocity(ball3).x,
+                 3));
+  scene_free(scene);
+}
+
+// A contact found ahead of time lets its bodies close the gap, but no more,
+// and they only bounce once they meet
+void test_speculative() {
+  scene_t *scene = scene_init();
+  contact_solver_t *solver = contact_solver_init();
+  sprite_info_t sprite = {.is_sprite = false};
+  body_t *wall = body_init(generate_rect_shape(4, 0, 2, 20), sprite, INFINITY);
+  scene_add_body(scene, wall);
+  body_t *ball = make_ball(scene, 0, 0, 1);
+  // too slow to reach the wall this tick
+  body_set_velocity(ball, (vector_t){1.5, 0});
+  contact_solver_add(solver, (contact_t){ball, wall, (vector_t){1, 0}, -2, 1});
+  contact_solver_solve(solver, body_get_kinematics(ball), 1);
+  scene_tick(scene, 0);
+  assert(vec_equal(body_get_velocity(ball), (vector_t){1.5, 0}));
+  contact_solver_free(solver);
+  scene_free(scene);
+
+  // Fast enough to get there halfway through the tick, so the ball turns
+  // back at the wall rather than where it started
+  double elasticities[] = {0, 0.5, 1};
+  for (size_t i = 0; i < 3; i++) {
+    scene = scene_init();
+    scene_add_contact_rule(scene, BALL, WALL, elasticities[i]);
+    wall = body_init(generate_rect_shape(4, 0, 2, 20), sprite, INFINITY);
+    scene_add_body(scene, wall);
+    scene_add_collider(scene, wall, WALL);
+    ball = make_ball(scene, 0, 0, 1);
+    body_set_velocity(ball, (vector_t){4, 0});
+    scene_tick(scene, 1);
+    double speed = 4 * elasticities[i];
+    assert(vec_isclose(body_get_velocity(ball), (vector_t){-speed, 0}));
+    assert(isclose(body_get_centroid(ball).x, 2 - speed / 2));
+    scene_free(scene);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_head_on)
+  DO_TEST(test_row)
+  DO_TEST(test_iteration_cap)
+  DO_TEST(test_wall)
+  DO_TEST(test_overlap)
+  DO_TEST(test_resting)
+  DO_TEST(test_column)
+  DO_TEST(test_pair_contacts)
+  DO_TEST(test_speculative)
+
+  puts("contact_test PASS");
+}
@@ -4,20 +4,12 @@
 #include <math.h>
 #include <stdlib.h>
 
-list_t *make_shape() {
-  list_t *shape = list_init(4, free);
-  vector_t *v = malloc(sizeof(*v));
-  *v = (vector_t){-1, -1};
-  list_add(shape, v);
-  v = malloc(sizeof(*v));
-  *v = (vector_t){+1, -1};
-  list_add(shape, v);
-  v = malloc(sizeof(*v));
-  *v = (vector_t){+1, +1};
-  list_add(shape, v);
-  v = malloc(sizeof(*v));
-  *v = (vector_t){-1, +1};
-  list_add(shape, v);
+polygon_t *make_shape() {
+  polygon_t *shape = polygon_init(4);
+  polygon_add(shape, (vector_t){-1, -1});
+  polygon_add(shape, (vector_t){+1, -1});
+  polygon_add(shape, (vector_t){+1, +1});
+  polygon_add(shape, (vector_t){-1, +1});
   return shape;
 }
 
@@ -78,16 +70,10 @@ void test_energy_conservation() {
 }
 
 body_t *make_triangle_body() {
-  list_t *shape = list_init(3, free);
-  vector_t *v = malloc(sizeof(*v));
-  *v = (vector_t){1, 0};
-  list_add(shape, v);
-  v = malloc(sizeof(*v));
-  *v = (vector_t){-0.5, +sqrt(3) / 2};
-  list_add(shape, v);
-  v = malloc(sizeof(*v));
-  *v = (vector_t){-0.5, -sqrt(3) / 2};
-  list_add(shape, v);
+  polygon_t *shape = polygon_init(3);
+  polygon_add(shape, (vector_t){1, 0});
+  polygon_add(shape, (vector_t){-0.5, +sqrt(3) / 2});
+  polygon_add(shape, (vector_t){-0.5, -sqrt(3) / 2});
   return body_init(shape, 1, (rgb_color_t){0, 0, 0});
 }
 
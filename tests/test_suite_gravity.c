@@ -0,0 +1,186 @@
+#include "body.h"
+#include "forces.h"
+#include "gravity.h"
+#include "kinematics.h"
+#include "rng.h"
+#include "scene.h"
+#include "shape_utility.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+const double TEST_G = 15;
+const double TEST_MIN_DISTANCE = 5;
+const size_t TEST_BODIES = 300;
+
+// Bodies of mass 1 to 10 scattered over a 1000 x 1000 square
+kinematics_t *random_bodies(size_t n, uint64_t seed) {
+  rng_t rng;
+  rng_seed(&rng, seed);
+  kinematics_t *kin = kinematics_init(n);
+  for (size_t i = 0; i < n; i++) {
+    vector_t centroid = {rng_uniform(&rng) * 1000, rng_uniform(&rng) * 1000};
+    size_t slot =
+        kinematics_add(kin, NULL, centroid, 1 / (1 + 9 * rng_uniform(&rng)));
+    kin->gravitating[slot] = true;
+  }
+  return kin;
+}
+
+// The force create_newtonian_gravity() would put on a slot
+vector_t pairwise_force(kinematics_t *kin, size_t slot) {
+  vector_t force = VEC_ZERO;
+  for (size_t j = 0; j < kin->size; j++) {
+    vector_t r = vec_subtract(kin->centroid[j], kin->centroid[slot]);
+    double distance = vec_magnitude(r);
+    if (j != slot && distance >= TEST_MIN_DISTANCE) {
+      double m1 = 1 / kin->inv_mass[slot];
+      double m2 = 1 / kin->inv_mass[j];
+      force = vec_add(force, vec_multiply(TEST_G * m1 * m2 /
+                                              pow(distance, 3), r));
+    }
+  }
+  return force;
+}
+
+// Theta = 0 gives the exact pairwise forces, without building a tree
+void test_exact() {
+  kinematics_t *kin = random_bodies(TEST_BODIES, 1);
+  gravity_t *gravity = gravity_init(TEST_G, 0, TEST_MIN_DISTANCE);
+  gravity_apply(gravity, kin, NULL);
+  assert(gravity_interactions(gravity) == TEST_BODIES * (TEST_BODIES - 1));
+  assert(gravity_cells(gravity) == 0);
+  for (size_t i = 0; i < kin->size; i++) {
+    vector_t expected = pairwise_force(kin, i);
+    vector_t error = vec_subtract(kin->force[i], expected);
+    assert(vec_magnitude(error) <= 1e-9 * vec_magnitude(expected));
+  }
+  gravity_free(gravity);
+  kinematics_free(kin);
+}
+
+// Larger angles do less work for a small error
+void test_opening_angle() {
+  kinematics_t *kin = random_bodies(TEST_BODIES, 2);
+  gravity_t *gravity = gravity_init(TEST_G, 0.5, TEST_MIN_DISTANCE);
+  assert(gravity_get_theta(gravity) == 0.5);
+  size_t interactions = 0;
+  for (size_t round = 0; round < 2; round++) {
+    for (size_t i = 0; i < kin->size; i++) {
+      kin->force[i] = VEC_ZERO;
+    }
+    gravity_apply(gravity, kin, NULL);
+    double error = 0;
+    double total = 0;
+    for (size_t i = 0; i < kin->size; i++) {
+      vector_t expected = pairwise_force(kin, i);
+      error += vec_dot(vec_subtract(kin->force[i], expected),
+                       vec_subtract(kin->force[i], expected));
+      total += vec_dot(expected, expected);
+    }
+    assert(sqrt(error / total) < 0.02);
+    // the same bodies build the same tree
+    assert(round == 0 || gravity_interactions(gravity) == interactions);
+    interactions = gravity_interactions(gravity);
+  }
+  assert(interactions < TEST_BODIES * (TEST_BODIES - 1) / 2);
+  assert(gravity_cells(gravity) > TEST_BODIES);
+  gravity_set_theta(gravity, 1);
+  gravity_apply(gravity, kin, NULL);
+  assert(gravity_interactions(gravity) < interactions);
+  gravity_free(gravity);
+  kinematics_free(kin);
+}
+
+// Only gravitating slots with finite mass take part, close bodies do not
+// attract, and bodies in the same spot do not split cells forever
+void test_members() {
+  kinematics_t *kin = kinematics_init(0);
+  size_t a = kinematics_add(kin, NULL, (vector_t){0, 0}, 1);
+  size_t b = kinematics_add(kin, NULL, (vector_t){10, 0}, 0.5);
+  size_t near = kinematics_add(kin, NULL, (vector_t){13, 0}, 1);
+  size_t wall = kinematics_add(kin, NULL, (vector_t){-10, 0}, 0);
+  size_t outsider = kinematics_add(kin, NULL, (vector_t){0, 10}, 1);
+  kin->gravitating[a] = kin->gravitating[b] = kin->gravitating[near] = true;
+  kin->gravitating[wall] = true;
+  gravity_t *gravity = gravity_init(1, 0, TEST_MIN_DISTANCE);
+  gravity_apply(gravity, kin, NULL);
+  // a is pulled by b (2 / 10^2) and near (1 / 13^2); b only by a
+  assert(vec_isclose(kin->force[a], (vector_t){0.02 + 1.0 / 169, 0}));
+  assert(vec_isclose(kin->force[b], (vector_t){-0.02, 0}));
+  assert(vec_equal(kin->force[wall], VEC_ZERO));
+  assert(vec_equal(kin->force[outsider], VEC_ZERO));
+  kinematics_free(kin);
+
+  kin = kinematics_init(0);
+  for (size_t i = 0; i <= 10; i++) {
+    vector_t centroid = i < 10 ? (vector_t){1, 1} : (vector_t){101, 1};
+    size_t slot = kinematics_add(kin, NULL, centroid, 1);
+    kin->gravitating[slot] = true;
+  }
+  gravity_set_theta(gravity, 0.5);
+  gravity_apply(gravity, kin, NULL);
+  assert(gravity_cells(gravity) > 0);
+  assert(vec_isclose(kin->force[0], (vector_t){1e-4, 0}));
+  assert(vec_isclose(kin->force[10], (vector_t){-1e-3, 0}));
+  gravity_free(gravity);
+  kinematics_free(kin);
+}
+
+// A scene with mutual gravity moves like one with a force creator per pair
+void test_scene() {
+  scene_t *pairwise = scene_init();
+  scene_t *tree = scene_init();
+  body_t *bodies[2][6];
+  for (size_t s = 0; s < 2; s++) {
+    for (size_t i = 0; i < 6; i++) {
+      bodies[s][i] = body_init(
+          generate_rect_shape(i * 37 % 100, i * 61 % 100, 2, 2),
+          plain_sprite(), 1 + i);
+      scene_add_body(s == 0 ? pairwise : tree, bodies[s][i]);
+      body_set_gravitating(bodies[s][i], true);
+    }
+  }
+  for (size_t i = 0; i < 6; i++) {
+    for (size_t j = i + 1; j < 6; j++) {
+      create_newtonian_gravity(pairwise, TEST_G, bodies[0][i], bodies[0][j]);
+    }
+  }
+  create_mutual_gravity(tree, TEST_G, 0);
+  assert(scene_force_creators(tree) == 0);
+  assert(body_is_gravitating(bodies[1][0]));
+  for (size_t t = 0; t < 100; t++) {
+    scene_tick(pairwise, 0.01);
+    scene_tick(tree, 0.01);
+  }
+  for (size_t i = 0; i < 6; i++) {
+    assert(vec_isclose(body_get_centroid(bodies[0][i]),
+                       body_get_centroid(bodies[1][i])));
+    assert(!vec_equal(body_get_velocity(bodies[1][i]), VEC_ZERO));
+  }
+  // turning it off stops the pull
+  scene_set_gravity(tree, NULL);
+  vector_t velocity = body_get_velocity(bodies[1][0]);
+  scene_tick(tree, 0.01);
+  assert(vec_equal(body_get_velocity(bodies[1][0]), velocity));
+  scene_free(pairwise);
+  scene_free(tree);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_exact)
+  DO_TEST(test_opening_angle)
+  DO_TEST(test_members)
+  DO_TEST(test_scene)
+
+  puts("gravity_test PASS");
+}
@@ -0,0 +1,730 @@
+#include "body.h"
+#include "forces.h"
+#include "ids.h"
+#include "kinematics.h"
+#include "pool_table.h"
+#include "scene.h"
+#include "shape_utility.h"
+#include "slab.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+body_t *make_square_body(double x, double y, double mass) {
+  return body_init(generate_rect_shape(x, y, 2, 2), plain_sprite(), mass);
+}
+
+void test_integrate() {
+  kinematics_t *kin = kinematics_init(0);
+  size_t a = kinematics_add(kin, NULL, (vector_t){0, 0}, 1.0 / 2);
+  size_t b = kinematics_add(kin, NULL, (vector_t){5, 5}, 0);
+  assert(kin->size == 2);
+  kin->velocity[a] = (vector_t){1, 0};
+  kin->force[a] = (vector_t){0, 4};
+  kin->impulse[b] = (vector_t){100, 100};
+  kinematics_integrate(kin, 0, kin->size, 1);
+  // v = (1, 0) + (0, 4) / 2 = (1, 2), moved by the average velocity
+  assert(vec_isclose(kin->velocity[a], (vector_t){1, 2}));
+  assert(vec_isclose(kin->centroid[a], (vector_t){1, 1}));
+  assert(vec_equal(kin->force[a], VEC_ZERO));
+  // infinite mass ignores impulses
+  assert(vec_equal(kin->velocity[b], VEC_ZERO));
+  assert(vec_equal(kin->centroid[b], (vector_t){5, 5}));
+  assert(vec_equal(kin->impulse[b], VEC_ZERO));
+  kinematics_free(kin);
+}
+
+void test_swap_remove() {
+  kinematics_t *kin = kinematics_init(1);
+  int owners[3];
+  for (size_t i = 0; i < 3; i++) {
+    kinematics_add(kin, &owners[i], (vector_t){i, 0}, 1);
+  }
+  assert(kin->capacity >= 3);
+  assert(kinematics_remove(kin, 0) == &owners[2]);
+  assert(kin->size == 2);
+  assert(vec_equal(kin->centroid[0], (vector_t){2, 0}));
+  assert(kinematics_remove(kin, 1) == NULL);
+  assert(kin->size == 1);
+  kinematics_free(kin);
+}
+
+// Bodies must keep working after they move into the scene's arrays and
+// after other bodies are removed around them.
+void test_scene_handles() {
+  scene_t *scene = scene_init();
+  body_t *bodies[20];
+  for (size_t i = 0; i < 20; i++) {
+    bodies[i] = make_square_body(10 * i, 0, 1);
+    body_set_velocity(bodies[i], (vector_t){i, 1});
+    scene_add_body(scene, bodies[i]);
+  }
+  for (size_t i = 0; i < 20; i += 3) {
+    body_remove(bodies[i]);
+  }
+  scene_tick(scene, 1);
+  assert(scene_bodies(scene) == 13);
+  for (size_t i = 0; i < 20; i++) {
+    if (i % 3 == 0) {
+      continue;
+    }
+    assert(vec_isclose(body_get_centroid(bodies[i]), (vector_t){11 * i, 1}));
+    assert(vec_isclose(body_get_velocity(bodies[i]), (vector_t){i, 1}));
+  }
+  scene_free(scene);
+}
+
+// Handles keep resolving to their body while others come and go,
+// and stop once it is removed, even after its slot is reused
+void test_body_handles() {
+  scene_t *scene = scene_init();
+  body_t *bodies[20];
+  body_handle_t handles[20];
+  for (size_t i = 0; i < 20; i++) {
+    bodies[i] = make_square_body(10 * i, 0, 1);
+    scene_add_body(scene, bodies[i]);
+    handles[i] = scene_get_handle(scene, bodies[i]);
+  }
+  for (size_t i = 0; i < 20; i += 2) {
+    body_remove(bodies[i]);
+    assert(scene_resolve(scene, handles[i]) == NULL);
+  }
+  scene_tick(scene, 1);
+  assert(scene_bodies(scene) == 10);
+  for (size_t i = 1; i < 20; i += 2) {
+    assert(scene_resolve(scene, handles[i]) == bodies[i]);
+    // the survivors keep their order
+    assert(scene_get_body(scene, i / 2) == bodies[i]);
+  }
+  body_t *reused = make_square_body(0, 0, 1);
+  scene_add_body(scene, reused);
+  body_handle_t handle = scene_get_handle(scene, reused);
+  assert(scene_resolve(scene, handle) == reused);
+  for (size_t i = 0; i < 20; i += 2) {
+    assert(scene_resolve(scene, handles[i]) == NULL);
+  }
+  scene_free(scene);
+}
+
+// Removed bodies come back with their handles when a snapshot is restored
+void test_handles_restore() {
+  scene_t *scene = scene_init();
+  body_t *kept = make_square_body(0, 0, 1);
+  body_t *removed = make_square_body(5, 0, 1);
+  scene_add_body(scene, kept);
+  scene_add_body(scene, removed);
+  body_handle_t handle = scene_get_handle(scene, removed);
+  scene_snapshot_t *snapshot = scene_snapshot(scene);
+  body_remove(removed);
+  scene_tick(scene, 1);
+  assert(scene_bodies(scene) == 1);
+  // the removed body's slot is not reused while the snapshot holds it
+  body_t *added = make_square_body(10, 0, 1);
+  scene_add_body(scene, added);
+  body_handle_t added_handle = scene_get_handle(scene, added);
+  assert(added_handle.index != handle.index);
+  scene_restore(scene, snapshot);
+  assert(scene_resolve(scene, handle) == removed);
+  assert(scene_resolve(scene, added_handle) == NULL);
+  assert(scene_bodies(scene) == 2);
+  scene_tick(scene, 1);
+  assert(scene_bodies(scene) == 2);
+  scene_snapshot_free(scene, snapshot);
+  assert(scene_resolve(scene, handle) == removed);
+  scene_free(scene);
+}
+
+// The shape and sprite follow the centroid even though integration
+// only touches the kinematic arrays.
+void test_lazy_shape() {
+  scene_t *scene = scene_init();
+  body_t *body = make_square_body(0, 0, 1);
+  scene_add_body(scene, body);
+  body_set_velocity(body, (vector_t){3, 0});
+  for (size_t i = 0; i < 10; i++) {
+    scene_tick(scene, 0.5);
+  }
+  polygon_t *shape = body_get_shape(body);
+  assert(vec_isclose(polygon_get(shape, 0), (vector_t){16, 1}));
+  assert(vec_isclose(body_get_sprite(body).img_pos, (vector_t){15, 0}));
+  // teleporting moves the shape but not the sprite
+  body_set_centroid(body, (vector_t){0, 0});
+  assert(body_get_shape(body) == shape);
+  assert(vec_isclose(polygon_get(shape, 0), (vector_t){1, 1}));
+  assert(vec_isclose(body_get_sprite(body).img_pos, (vector_t){15, 0}));
+  scene_free(scene);
+}
+
+// Drag and gravity act through the coefficient arrays, not force creators
+void test_field_forces() {
+  scene_t *scene = scene_init();
+  body_t *drifting = make_square_body(0, 0, 2);
+  body_t *falling = make_square_body(10, 0, 2);
+  body_t *wall = make_square_body(20, 0, INFINITY);
+  body_t *late = make_square_body(30, 0, 4);
+  scene_add_body(scene, drifting);
+  scene_add_body(scene, falling);
+  scene_add_body(scene, wall);
+  body_set_velocity(drifting, (vector_t){4, 0});
+  create_drag(scene, 0.5, drifting);
+  create_constant_drag_force(scene, 1, drifting);
+  create_uniform_gravity(scene, (vector_t){0, -10}, falling);
+  create_uniform_gravity(scene, (vector_t){0, -10}, wall);
+  // fields set before the body joins the scene come along with it
+  create_uniform_gravity(scene, (vector_t){0, -10}, late);
+  scene_add_body(scene, late);
+  assert(scene_force_creators(scene) == 0);
+
+  scene_tick(scene, 0.1);
+  // -0.5 * 4 - 1 over a mass of 2
+  assert(vec_isclose(body_get_velocity(drifting), (vector_t){3.85, 0}));
+  assert(vec_isclose(body_get_velocity(falling), (vector_t){0, -1}));
+  assert(vec_isclose(body_get_velocity(late), (vector_t){0, -1}));
+  assert(vec_equal(body_get_velocity(wall), VEC_ZERO));
+
+  // constant drag stops below VEL_THRESH
+  body_set_velocity(drifting, (vector_t){0.05, 0});
+  scene_tick(scene, 0.1);
+  assert(vec_isclose(body_get_velocity(drifting), (vector_t){0.04875, 0}));
+
+  // the coefficients move with the slots
+  body_remove(falling);
+  scene_tick(scene, 0.1);
+  assert(vec_isclose(body_get_velocity(late), (vector_t){0, -3}));
+  assert(vec_equal(body_get_velocity(wall), VEC_ZERO));
+
+  // the threshold belongs to the body: constant drag added without one
+  // acts at any speed, until the body is given its own
+  body_t *sliding = make_square_body(40, 0, 2);
+  scene_add_body(scene, sliding);
+  body_add_constant_drag(sliding, 1);
+  body_set_velocity(sliding, (vector_t){0.05, 0});
+  scene_tick(scene, 0.01);
+  assert(vec_isclose(body_get_velocity(sliding), (vector_t){0.045, 0}));
+  body_set_constant_drag_min_speed(sliding, 0.1);
+  scene_tick(scene, 0.01);
+  assert(vec_isclose(body_get_velocity(sliding), (vector_t){0.045, 0}));
+  scene_free(scene);
+}
+
+// A mass on a spring to an anchor follows A cos(sqrt(K / M) t) as closely as
+// the default integrator does with dt = 1e-6, in 100 times (velocity
+// Verlet) and 10000 times (RK4) fewer steps
+void test_integrators() {
+  const double M = 10;
+  const double K = 2;
+  const double A = 3;
+  integrator_t integrators[] = {INTEGRATOR_VELOCITY_VERLET, INTEGRATOR_RK4};
+  double dts[] = {1e-4, 1e-2};
+  for (size_t i = 0; i < 2; i++) {
+    scene_t *scene = scene_init();
+    scene_set_integrator(scene, integrators[i]);
+    assert(scene_get_integrator(scene) == integrators[i]);
+    body_t *mass = make_square_body(A, 0, M);
+    body_t *anchor = make_square_body(0, 0, INFINITY);
+    scene_add_body(scene, mass);
+    scene_add_body(scene, anchor);
+    create_spring(scene, K, mass, anchor);
+    size_t steps = (size_t)round(1 / dts[i]);
+    for (size_t step = 0; step <= steps; step++) {
+      assert(vec_isclose(body_get_centroid(mass),
+                         (vector_t){A * cos(sqrt(K / M) * step * dts[i]), 0}));
+      assert(vec_equal(body_get_centroid(anchor), VEC_ZERO));
+      scene_tick(scene, dts[i]);
+    }
+    scene_free(scene);
+  }
+  // semi-implicit Euler is only first order, but keeps the energy
+  scene_t *scene = scene_init();
+  scene_set_integrator(scene, INTEGRATOR_SEMI_IMPLICIT_EULER);
+  body_t *mass = make_square_body(A, 0, M);
+  scene_add_body(scene, mass);
+  body_t *anchor = make_square_body(0, 0, INFINITY);
+  scene_add_body(scene, anchor);
+  create_spring(scene, K, mass, anchor);
+  for (size_t step = 0; step < 100000; step++) {
+    scene_tick(scene, 0.01);
+  }
+  double x = body_get_centroid(mass).x;
+  double v = body_get_velocity(mass).x;
+  assert(within(0.01, (K * x * x + M * v * v) / (K * A * A), 1));
+  scene_free(scene);
+}
+
+void count_and_push(body_t *body) {
+  size_t *calls = body_get_info(body);
+  (*calls)++;
+  body_add_force(body, (vector_t){4, 0});
+}
+
+void remove_aux(body_t *body) { body_remove(body); }
+
+void count_call(size_t *calls) { (*calls)++; }
+
+void add_counter(scene_t *scene, body_t *body, size_t *calls, bool pure) {
+  list_t *bodies = list_init(1, NULL);
+  list_add(bodies, body);
+  if (pure) {
+    scene_add_pure_force_creator(scene, (force_creator_t)count_call, calls,
+                                 bodies, NULL);
+  } else {
+    scene_add_parallel_force_creator(scene, (force_creator_t)count_call,
+                                     calls, bodies, NULL);
+  }
+}
+
+// Integrators with several stages run other force creators once per tick
+// and hold their forces, and start with the impulses. Only pure force
+// creators run at every stage, not every parallel one.
+void test_integrator_stages() {
+  integrator_t integrators[] = {INTEGRATOR_VELOCITY_VERLET, INTEGRATOR_RK4};
+  for (size_t i = 0; i < 2; i++) {
+    scene_t *scene = scene_init();
+    scene_set_integrator(scene, integrators[i]);
+    size_t calls = 0;
+    body_t *body = body_init_with_info(generate_rect_shape(0, 0, 2, 2),
+                                       plain_sprite(), 2, &calls, NULL);
+    scene_add_body(scene, body);
+    create_uniform_gravity(scene, (vector_t){0, -10}, body);
+    list_t *bodies = list_init(1, NULL);
+    list_add(bodies, body);
+    scene_add_bodies_force_creator(scene, (force_creator_t)count_and_push,
+                                   body, bodies, NULL);
+    size_t parallel_calls = 0;
+    size_t pure_calls = 0;
+    add_counter(scene, body, &parallel_calls, false);
+    add_counter(scene, body, &pure_calls, true);
+    body_add_impulse(body, (vector_t){2, 0});
+    scene_tick(scene, 0.5);
+    assert(calls == 1);
+    assert(parallel_calls == 1);
+    assert(pure_calls == integrator_stages(integrators[i]));
+    // constant acceleration (2, -10) from a velocity of (1, 0)
+    assert(vec_isclose(body_get_velocity(body), (vector_t){2, -5}));
+    assert(vec_isclose(body_get_centroid(body), (vector_t){0.75, -1.25}));
+
+    // a body taken out mid-tick drops its springs from the later stages
+    body_t *other = make_square_body(5, 0, 1);
+    scene_add_body(scene, other);
+    body_t *doomed = make_square_body(10, 0, 1);
+    scene_add_body(scene, doomed);
+    create_spring(scene, 100, other, doomed);
+    list_t *doomed_bodies = list_init(1, NULL);
+    list_add(doomed_bodies, doomed);
+    scene_add_bodies_force_creator(scene, (force_creator_t)remove_aux, doomed,
+                                   doomed_bodies, NULL);
+    scene_tick(scene, 0.5);
+    assert(scene_bodies(scene) == 2);
+    assert(vec_equal(body_get_velocity(other), VEC_ZERO));
+    scene_free(scene);
+  }
+}
+
+// Frame times are split into fixed ticks, whatever the frame rate
+void test_fixed_step() {
+  scene_t *scene = scene_init();
+  body_t *body = make_square_body(0, 0, 1);
+  scene_add_body(scene, body);
+  body_set_velocity(body, (vector_t){1, 0});
+  scene_set_timestep(scene, 0.25, 4);
+  assert(isclose(scene_step(scene, 0.1), 0.4));
+  assert(vec_isclose(body_get_centroid(body), VEC_ZERO));
+  assert(isclose(scene_step(scene, 0.5), 0.4));
+  assert(vec_isclose(body_get_centroid(body), (vector_t){0.5, 0}));
+  // a long frame runs at most 4 ticks and drops the rest
+  assert(isclose(scene_step(scene, 10), 0.4));
+  assert(vec_isclose(body_get_centroid(body), (vector_t){1.5, 0}));
+  scene_free(scene);
+}
+
+// Still bodies fall asleep and wake on impulses and contacts
+void test_sleep() {
+  scene_t *scene = scene_init();
+  scene_add_collision_rule(scene, 1, 1, NULL, NULL, NULL);
+  scene_set_sleep_threshold(scene, 0.1, 0.5);
+  body_t *still = make_square_body(0, 0, 1);
+  body_t *moving = make_square_body(10, 0, 1);
+  scene_add_body(scene, still);
+  scene_add_body(scene, moving);
+  scene_add_collider(scene, still, 1);
+  scene_add_collider(scene, moving, 1);
+  body_set_velocity(moving, (vector_t){-1, 0});
+  for (size_t i = 0; i < 2; i++) {
+    scene_tick(scene, 0.25);
+  }
+  assert(body_is_asleep(still) && !body_is_asleep(moving));
+  assert(!scene_is_asleep(scene));
+  // forces are dropped while asleep
+  body_add_force(still, (vector_t){100, 0});
+  scene_tick(scene, 0.25);
+  assert(vec_isclose(body_get_centroid(still), VEC_ZERO));
+  // moving runs into still, which wakes up
+  for (size_t i = 0; i < 40 && body_is_asleep(still); i++) {
+    scene_tick(scene, 0.25);
+  }
+  assert(!body_is_asleep(still));
+  body_set_velocity(moving, VEC_ZERO);
+  body_set_velocity(still, VEC_ZERO);
+  for (size_t i = 0; i < 2; i++) {
+    scene_tick(scene, 0.25);
+  }
+  assert(scene_is_asleep(scene));
+  body_add_impulse(moving, (vector_t){1, 0});
+  assert(!body_is_asleep(moving) && !scene_is_asleep(scene));
+  scene_free(scene);
+}
+
+// Runs a break shot until the balls stop
+void play_break(scene_t *scene) {
+  // sinks four balls
+  body_add_impulse(get_cueball_body(scene),
+                   vec_rotate((vector_t){1500, 0}, 185 * M_PI / 180));
+  for (size_t i = 0; i < 30000 && !balls_stopped(scene); i++) {
+    scene_tick(scene, 1e-3);
+  }
+}
+
+// A rollout can be undone, pocketed balls included, and replays exactly
+void test_snapshot() {
+  scene_t *scene = scene_init();
+  generate_pool_table(scene, false, false);
+  size_t bodies = scene_bodies(scene);
+  vector_t *before = malloc(sizeof(vector_t) * bodies);
+  for (size_t i = 0; i < bodies; i++) {
+    before[i] = body_get_centroid(scene_get_body(scene, i));
+  }
+  scene_snapshot_t *snapshot = scene_snapshot(scene);
+  play_break(scene);
+  size_t after_bodies = scene_bodies(scene);
+  assert(after_bodies < bodies);
+  vector_t *after = malloc(sizeof(vector_t) * after_bodies);
+  for (size_t i = 0; i < after_bodies; i++) {
+    after[i] = body_get_centroid(scene_get_body(scene, i));
+  }
+  scene_restore(scene, snapshot);
+  assert(scene_bodies(scene) == bodies);
+  for (size_t i = 0; i < bodies; i++) {
+    body_t *body = scene_get_body(scene, i);
+    assert(!body_is_removed(body));
+    assert(vec_equal(body_get_centroid(body), before[i]));
+    assert(vec_equal(body_get_velocity(body), VEC_ZERO));
+  }
+  play_break(scene);
+  assert(scene_bodies(scene) == after_bodies);
+  for (size_t i = 0; i < after_bodies; i++) {
+    assert(vec_equal(body_get_centroid(scene_get_body(scene, i)), after[i]));
+  }
+  scene_restore(scene, snapshot);
+  scene_snapshot_free(scene, snapshot);
+  assert(scene_bodies(scene) == bodies);
+  play_break(scene);
+  assert(scene_bodies(scene) == after_bodies);
+  free(before);
+  free(after);
+  scene_free(scene);
+}
+
+// The ticks at which bounce_back() ran
+size_t bounces[8];
+size_t bounce_count = 0;
+size_t bounce_tick = 0;
+
+// Sends the first body back at a tenth of its speed, so the bodies keep
+// overlapping for a few ticks as they separate
+void bounce_back(body_t *body1, body_t *body2, vector_t axis, void *aux) {
+  assert(bounce_count < sizeof(bounces) / sizeof(*bounces));
+  bounces[bounce_count++] = bounce_tick;
+  body_set_velocity(body1, vec_multiply(-0.1, body_get_velocity(body1)));
+}
+
+void tick_bounces(scene_t *scene, size_t ticks) {
+  for (size_t i = 0; i < ticks; i++) {
+    bounce_tick++;
+    scene_tick(scene, 1e-2);
+  }
+}
+
+// A snapshot taken while a collision carries over from one tick to the next
+// replays the same collisions: the collision still knows the bodies were
+// touching, and does not fire again
+void test_snapshot_replay() {
+  scene_t *scene = scene_init();
+  body_t *ball = body_init_circle(VEC_ZERO, 1, plain_sprite(), 1);
+  body_t *post =
+      body_init_circle((vector_t){2.45, 0}, 1, plain_sprite(), INFINITY);
+  scene_add_body(scene, ball);
+  scene_add_body(scene, post);
+  create_collision(scene, ball, post, bounce_back, NULL, NULL);
+  body_set_velocity(ball, (vector_t){10, 0});
+  bounce_count = bounce_tick = 0;
+  tick_bounces(scene, 8);
+  assert(bounce_count == 1);
+  assert(find_body_collision(ball, post).collided);
+
+  scene_snapshot_t *snapshot = scene_snapshot(scene);
+  size_t snapshot_bounces = bounce_count;
+  tick_bounces(scene, 10);
+  assert(!find_body_collision(ball, post).collided);
+  size_t played[8];
+  size_t played_count = bounce_count;
+  memcpy(played, bounces, sizeof(bounces));
+  vector_t played_centroid = body_get_centroid(ball);
+
+  scene_restore(scene, snapshot);
+  bounce_count = snapshot_bounces;
+  bounce_tick -= 10;
+  tick_bounces(scene, 10);
+  assert(bounce_count == played_count);
+  for (size_t i = 0; i < played_count; i++) {
+    assert(bounces[i] == played[i]);
+  }
+  assert(vec_equal(body_get_centroid(ball), played_centroid));
+  scene_snapshot_free(scene, snapshot);
+  scene_free(scene);
+}
+
+// Snapshots reuse the memory of freed ones, and still hold only their own
+// moment
+void test_snapshot_reuse() {
+  scene_t *scene = scene_init();
+  generate_pool_table(scene, false, false);
+  size_t bodies = scene_bodies(scene);
+  scene_snapshot_t *snapshot = scene_snapshot(scene);
+  scene_snapshot_free(scene, snapshot);
+  scene_snapshot_t *reused = scene_snapshot(scene);
+  assert(reused == snapshot);
+  play_break(scene);
+  size_t after_bodies = scene_bodies(scene);
+  assert(after_bodies < bodies);
+  scene_snapshot_t *later = scene_snapshot(scene);
+  assert(later != reused);
+  scene_restore(scene, reused);
+  assert(scene_bodies(scene) == bodies);
+  scene_restore(scene, later);
+  assert(scene_bodies(scene) == after_bodies);
+  scene_restore(scene, reused);
+  assert(scene_bodies(scene) == bodies);
+  scene_snapshot_free(scene, later);
+  scene_snapshot_free(scene, reused);
+  scene_free(scene);
+}
+
+// The labels of the force creators applied in the last tick, in order
+size_t applied[4];
+size_t applied_count = 0;
+
+void log_force(size_t *label) { applied[applied_count++] = *label; }
+
+void add_logged_forcer(scene_t *scene, size_t *label, body_t *body1,
+                       body_t *body2) {
+  list_t *bodies = list_init(2, NULL);
+  list_add(bodies, body1);
+  if (body2 != NULL) {
+    list_add(bodies, body2);
+  }
+  scene_add_bodies_force_creator(scene, (force_creator_t)log_force, label,
+                                 bodies, NULL);
+}
+
+void tick_logged(scene_t *scene, size_t expected[], size_t count) {
+  applied_count = 0;
+  scene_tick(scene, 1e-3);
+  assert(applied_count == count);
+  for (size_t i = 0; i < count; i++) {
+    assert(applied[i] == expected[i]);
+  }
+}
+
+// Removing a body drops exactly the force creators on it, keeping the order
+void test_forcer_removal() {
+  size_t labels[] = {0, 1, 2, 3};
+  scene_t *scene = scene_init();
+  body_t *bodies[4];
+  for (size_t i = 0; i < 4; i++) {
+    bodies[i] = make_square_body(3 * i, 0, 1);
+    scene_add_body(scene, bodies[i]);
+  }
+  add_logged_forcer(scene, &labels[0], bodies[0], bodies[1]);
+  add_logged_forcer(scene, &labels[1], bodies[1], bodies[2]);
+  add_logged_forcer(scene, &labels[2], bodies[2], bodies[3]);
+  add_logged_forcer(scene, &labels[3], bodies[0], NULL);
+  assert(list_size(body_get_forcers(bodies[0])) == 2);
+  assert(list_size(body_get_forcers(bodies[1])) == 2);
+  tick_logged(scene, (size_t[]){0, 1, 2, 3}, 4);
+
+  scene_snapshot_t *snapshot = scene_snapshot(scene);
+  body_remove(bodies[1]);
+  tick_logged(scene, (size_t[]){2, 3}, 2);
+  assert(list_size(body_get_forcers(bodies[0])) == 1);
+  assert(list_size(body_get_forcers(bodies[2])) == 1);
+
+  // the restored force creators are back on their bodies
+  scene_restore(scene, snapshot);
+  scene_snapshot_free(scene, snapshot);
+  assert(list_size(body_get_forcers(bodies[0])) == 2);
+  assert(list_size(body_get_forcers(bodies[2])) == 2);
+  tick_logged(scene, (size_t[]){0, 1, 2, 3}, 4);
+  body_remove(bodies[2]);
+  tick_logged(scene, (size_t[]){0, 3}, 2);
+  body_remove(bodies[0]);
+  tick_logged(scene, NULL, 0);
+  assert(scene_bodies(scene) == 2);
+  scene_free(scene);
+}
+
+// Tombstones are only dropped once they make up over half the list, and
+// never run or reach a snapshot in the meantime
+void test_forcer_compaction() {
+  size_t labels[] = {0, 1, 2, 3};
+  scene_t *scene = scene_init();
+  body_t *bodies[4];
+  for (size_t i = 0; i < 4; i++) {
+    bodies[i] = make_square_body(3 * i, 0, 1);
+    scene_add_body(scene, bodies[i]);
+    add_logged_forcer(scene, &labels[i], bodies[i], NULL);
+  }
+  slab_t *forcer_slab = slab_find("forcer_spec");
+  size_t live = slab_stats(forcer_slab).live;
+  body_remove(bodies[1]);
+  tick_logged(scene, (size_t[]){0, 2, 3}, 3);
+  body_remove(bodies[3]);
+  tick_logged(scene, (size_t[]){0, 2}, 2);
+  assert(scene_force_creators(scene) == 2);
+  assert(slab_stats(forcer_slab).live == live);
+  // a snapshot compacts, so restoring it brings nothing back
+  scene_snapshot_t *snapshot = scene_snapshot(scene);
+  assert(slab_stats(forcer_slab).live == live - 2);
+  scene_snapshot_free(scene, snapshot);
+  body_remove(bodies[0]);
+  tick_logged(scene, (size_t[]){2}, 1);
+  assert(slab_stats(forcer_slab).live == live - 2);
+  body_remove(bodies[2]);
+  tick_logged(scene, NULL, 0);
+  assert(slab_stats(forcer_slab).live == live - 4);
+  assert(scene_force_creators(scene) == 0);
+  scene_free(scene);
+}
+
+size_t tag_by_x(body_t *body) { return (size_t)body_get_centroid(body).x % 3; }
+
+// The tag index follows additions, removals and restores
+void test_tag_index() {
+  scene_t *scene = scene_init();
+  body_t *bodies[9];
+  for (size_t i = 0; i < 6; i++) {
+    bodies[i] = make_square_body(i, 0, 1);
+    scene_add_body(scene, bodies[i]);
+  }
+  scene_set_tagger(scene, tag_by_x);
+  assert(scene_tagged_count(scene, 0) == 2);
+  assert(scene_tagged_count(scene, 7) == 0);
+  for (size_t i = 6; i < 9; i++) {
+    bodies[i] = make_square_body(i, 0, 1);
+    scene_add_body(scene, bodies[i]);
+  }
+  for (size_t tag = 0; tag < 3; tag++) {
+    assert(scene_tagged_count(scene, tag) == 3);
+    for (size_t i = 0; i < 3; i++) {
+      assert(scene_get_tagged(scene, tag, i) == bodies[tag + 3 * i]);
+    }
+  }
+  scene_snapshot_t *snapshot = scene_snapshot(scene);
+  body_remove(bodies[1]);
+  body_remove(bodies[4]);
+  // removed bodies stay indexed until the tick takes them out
+  assert(scene_tagged_count(scene, 1) == 3);
+  scene_tick(scene, 0);
+  assert(scene_tagged_count(scene, 1) == 1);
+  assert(scene_get_tagged(scene, 1, 0) == bodies[7]);
+  assert(scene_tagged_count(scene, 0) == 3);
+  scene_restore(scene, snapshot);
+  scene_snapshot_free(scene, snapshot);
+  assert(scene_tagged_count(scene, 1) == 3);
+  assert(scene_get_tagged(scene, 1, 1) == bodies[4]);
+  scene_free(scene);
+}
+
+// The index gives the same answers as scanning the bodies
+void test_pool_lookups() {
+  scene_t *scene = scene_init();
+  generate_pool_table(scene, false, false);
+  play_break(scene);
+  size_t ids[] = {STRIPED_BALL_ID, SOLID_BALL_ID, EIGHTBALL_ID, CUEBALL_ID,
+                  WALL_ID, POCKET_ID};
+  for (size_t i = 0; i < sizeof(ids) / sizeof(*ids); i++) {
+    size_t count = 0;
+    body_t *first = NULL;
+    for (size_t j = 0; j < scene_bodies(scene); j++) {
+      body_t *body = scene_get_body(scene, j);
+      if (body_id(body) == ids[i]) {
+        first = first == NULL ? body : first;
+        count++;
+      }
+    }
+    assert(count_balls(scene, ids[i]) == count);
+    assert(get_specified_body(scene, ids[i]) == first);
+  }
+  assert(striped_count(scene) + solid_count(scene) < 14);
+  scene_free(scene);
+}
+
+scene_t *seeded_table(uint64_t seed) {
+  scene_t *scene = scene_init();
+  scene_seed(scene, seed);
+  generate_pool_table(scene, true, true);
+  return scene;
+}
+
+// Chaos pairings and the powerup spot come from the seed alone
+void test_seeded_table() {
+  scene_t *scene1 = seeded_table(7);
+  scene_t *scene2 = seeded_table(7);
+  scene_t *other = seeded_table(8);
+  assert(!vec_equal(body_get_centroid(get_specified_body(scene1, POWER_UP_ID)),
+                    body_get_centroid(get_specified_body(other, POWER_UP_ID))));
+  play_break(scene1);
+  play_break(scene2);
+  assert(scene_bodies(scene1) == scene_bodies(scene2));
+  for (size_t i = 0; i < scene_bodies(scene1); i++) {
+    assert(vec_equal(body_get_centroid(scene_get_body(scene1, i)),
+                     body_get_centroid(scene_get_body(scene2, i))));
+  }
+  assert(rng_next(scene_rng(scene1)) == rng_next(scene_rng(scene2)));
+  scene_free(scene1);
+  scene_free(scene2);
+  scene_free(other);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_integrate)
+  DO_TEST(test_swap_remove)
+  DO_TEST(test_scene_handles)
+  DO_TEST(test_body_handles)
+  DO_TEST(test_handles_restore)
+  DO_TEST(test_lazy_shape)
+  DO_TEST(test_field_forces)
+  DO_TEST(test_integrators)
+  DO_TEST(test_integrator_stages)
+  DO_TEST(test_fixed_step)
+  DO_TEST(test_sleep)
+  DO_TEST(test_snapshot)
+  DO_TEST(test_snapshot_replay)
+  DO_TEST(test_snapshot_reuse)
+  DO_TEST(test_forcer_removal)
+  DO_TEST(test_forcer_compaction)
+  DO_TEST(test_tag_index)
+  DO_TEST(test_pool_lookups)
+  DO_TEST(test_seeded_table)
+
+  puts("kinematics_test PASS");
+}
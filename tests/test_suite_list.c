@@ -196,6 +196,29 @@ void test_out_of_bounds_access() {
   free(access);
 }
 
+void test_swap_remove() {
+  list_t *l = list_init(4, free);
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    *v = (vector_t){i, i};
+    list_add(l, v);
+  }
+  // the last element fills the gap
+  vector_t *v = list_swap_remove(l, 1);
+  assert(vec_equal(*v, (vector_t){1, 1}));
+  free(v);
+  assert(list_size(l) == 3);
+  assert(vec_equal(*((vector_t *)list_get(l, 0)), (vector_t){0, 0}));
+  assert(vec_equal(*((vector_t *)list_get(l, 1)), (vector_t){3, 3}));
+  assert(vec_equal(*((vector_t *)list_get(l, 2)), (vector_t){2, 2}));
+  // removing the last element moves nothing
+  v = list_swap_remove(l, 2);
+  assert(vec_equal(*v, (vector_t){2, 2}));
+  free(v);
+  assert(list_size(l) == 2);
+  list_free(l);
+}
+
 void remove_from_empty(void *l) { list_remove((list_t *)l, 0); }
 void test_empty_remove() {
   const size_t size = 100;
@@ -242,6 +265,7 @@ int main(int argc, char *argv[]) {
   DO_TEST(test_list_large_get_set)
   DO_TEST(test_list_large_add_remove)
   DO_TEST(test_out_of_bounds_access)
+  DO_TEST(test_swap_remove)
   DO_TEST(test_empty_remove)
   DO_TEST(test_null_values)
 
@@ -0,0 +1,132 @@
+#include "body.h"
+#include "mesh.h"
+#include "polygon.h"
+#include "shape_utility.h"
+#include "slab.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+polygon_t *make_rect(double width, double height) {
+  polygon_t *rect = polygon_init(4);
+  polygon_add(rect, (vector_t){-width / 2, -height / 2});
+  polygon_add(rect, (vector_t){width / 2, -height / 2});
+  polygon_add(rect, (vector_t){width / 2, height / 2});
+  polygon_add(rect, (vector_t){-width / 2, height / 2});
+  return rect;
+}
+
+void test_mesh_bounds() {
+  mesh_t *mesh = mesh_init(make_rect(6, 8));
+  assert(mesh_refs(mesh) == 1);
+  assert(mesh_size(mesh) == 4);
+  assert(isclose(mesh_radius(mesh), 5));
+  aabb_t bounds = mesh_bounds(mesh);
+  assert(vec_isclose(bounds.min, (vector_t){-3, -4}));
+  assert(vec_isclose(bounds.max, (vector_t){3, 4}));
+  assert(mesh_retain(mesh) == mesh && mesh_refs(mesh) == 2);
+  mesh_release(mesh);
+  assert(mesh_refs(mesh) == 1);
+  mesh_release(mesh);
+}
+
+// Balls of one radius share one outline, which goes away with the last one
+void test_circle_sharing() {
+  slab_t *meshes = slab_find("mesh");
+  size_t live = meshes == NULL ? 0 : slab_stats(meshes).live;
+  body_t *balls[3];
+  for (size_t i = 0; i < 3; i++) {
+    balls[i] = body_init_circle((vector_t){i * 10, 0}, 2, plain_sprite(), 1);
+  }
+  body_t *big = body_init_circle(VEC_ZERO, 3, plain_sprite(), 1);
+  mesh_t *mesh = body_get_mesh(balls[0]);
+  assert(body_get_mesh(balls[1]) == mesh && body_get_mesh(balls[2]) == mesh);
+  assert(mesh_refs(mesh) == 3);
+  assert(body_get_mesh(big) != mesh);
+  assert(mesh_size(mesh) == polygon_size(body_get_shape(balls[2])));
+  assert(vec_isclose(polygon_centroid(body_get_shape(balls[2])),
+                     (vector_t){20, 0}));
+  assert(slab_stats(slab_find("mesh")).live == live + 2);
+  for (size_t i = 0; i < 3; i++) {
+    body_free(balls[i]);
+  }
+  body_free(big);
+  assert(slab_stats(slab_find("mesh")).live == live);
+}
+
+// World vertices come from the mesh and the body's transform, and
+// moving or turning the body does not change the mesh
+void test_transform() {
+  polygon_t *rect = make_rect(4, 2);
+  polygon_translate(rect, (vector_t){5, 5});
+  body_t *body = body_init(rect, plain_sprite(), 1);
+  // the polygon passed in stays the body's outline
+  assert(body_get_shape(body) == rect);
+  vector_t *local = mesh_vertices(body_get_mesh(body));
+  assert(vec_isclose(local[0], (vector_t){-2, -1}));
+
+  body_set_centroid(body, (vector_t){10, 0});
+  body_set_rotation(body, M_PI / 2);
+  assert(vec_isclose(local[0], (vector_t){-2, -1}));
+  polygon_t *shape = body_get_shape(body);
+  assert(shape == rect);
+  assert(vec_isclose(polygon_get(shape, 0), (vector_t){11, -2}));
+  assert(vec_isclose(polygon_get(shape, 2), (vector_t){9, 2}));
+
+  // absolute angles do not build up rounding error
+  for (size_t i = 0; i < 1000; i++) {
+    body_set_rotation(body, i * 0.1);
+  }
+  body_set_rotation(body, 0);
+  assert(vec_equal(polygon_get(body_get_shape(body), 0), (vector_t){8, -1}));
+
+  // a new shape is taken at the current centroid and angle
+  body_set_rotation(body, M_PI / 2);
+  polygon_t *square = make_rect(2, 2);
+  polygon_translate(square, (vector_t){10, 0});
+  body_set_shape(body, square);
+  assert(body_get_shape(body) == square);
+  local = mesh_vertices(body_get_mesh(body));
+  assert(vec_isclose(local[0], (vector_t){-1, 1}));
+  body_free(body);
+}
+
+void test_shared_mesh() {
+  mesh_t *mesh = mesh_init(make_rect(2, 2));
+  body_t *first =
+      body_init_with_mesh(mesh, (vector_t){0, 0}, plain_sprite(), 1, NULL, NULL);
+  body_t *second =
+      body_init_with_mesh(mesh, (vector_t){5, 0}, plain_sprite(), 1, NULL, NULL);
+  mesh_release(mesh);
+  assert(mesh_refs(mesh) == 2);
+  assert(body_get_mesh(first) == mesh && body_get_mesh(second) == mesh);
+  body_set_rotation(second, M_PI / 4);
+  assert(isclose(body_get_bounding_radius(second), sqrt(2)));
+  aabb_t box = body_get_aabb(second);
+  assert(vec_isclose(box.min, (vector_t){5 - sqrt(2), -sqrt(2)}));
+  assert(vec_isclose(box.max, (vector_t){5 + sqrt(2), sqrt(2)}));
+  assert(vec_isclose(polygon_get(body_get_shape(first), 0), (vector_t){-1, -1}));
+  assert(vec_isclose(polygon_get(body_get_shape(second), 0),
+                     (vector_t){5, -sqrt(2)}));
+  body_free(first);
+  assert(mesh_refs(mesh) == 1);
+  body_free(second);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_mesh_bounds)
+  DO_TEST(test_circle_sharing)
+  DO_TEST(test_transform)
+  DO_TEST(test_shared_mesh)
+
+  puts("mesh_test PASS");
+}
@@ -0,0 +1,107 @@
+#include "collision.h"
+#include "polygon.h"
+#include "rng.h"
+#include "sat.h"
+#include "shape_utility.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+const size_t MAX_TEST_VERTICES = 40;
+const size_t TEST_AXES = 13; // not a multiple of any batch width
+
+vector_t random_vector(rng_t *rng) {
+  return (vector_t){rng_uniform(rng) * 200 - 100, rng_uniform(rng) * 200 - 100};
+}
+
+void test_square() {
+  vector_t square[] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+  for (sat_kernel_t k = SAT_SCALAR; k <= SAT_AVX2; k++) {
+    if (!sat_kernel_supported(k)) {
+      continue;
+    }
+    sat_set_kernel(k);
+    assert(vec_equal(sat_project(square, 4, (vector_t){1, 0}),
+                     (vector_t){-1, 1}));
+    assert(vec_isclose(sat_project(square, 4, (vector_t){M_SQRT1_2, M_SQRT1_2}),
+                       (vector_t){-M_SQRT2, M_SQRT2}));
+    assert(vec_equal(sat_project(square + 2, 1, (vector_t){0, 1}),
+                     (vector_t){1, 1}));
+  }
+}
+
+// Every kernel gives exactly the scalar results, for any number of vertices
+// and axes, one axis at a time or in a batch
+void test_kernels_agree() {
+  rng_t rng;
+  rng_seed(&rng, 20);
+  vector_t vertices[MAX_TEST_VERTICES];
+  vector_t axes[TEST_AXES];
+  vector_t expected[TEST_AXES];
+  vector_t batch[TEST_AXES];
+  for (size_t n = 1; n <= MAX_TEST_VERTICES; n++) {
+    for (size_t i = 0; i < n; i++) {
+      vertices[i] = random_vector(&rng);
+    }
+    for (size_t j = 0; j < TEST_AXES; j++) {
+      axes[j] = vec_unit(random_vector(&rng));
+    }
+    sat_set_kernel(SAT_SCALAR);
+    for (size_t j = 0; j < TEST_AXES; j++) {
+      expected[j] = sat_project(vertices, n, axes[j]);
+    }
+    for (sat_kernel_t k = SAT_SCALAR; k <= SAT_AVX2; k++) {
+      if (!sat_kernel_supported(k)) {
+        continue;
+      }
+      sat_set_kernel(k);
+      sat_project_axes(vertices, n, axes, TEST_AXES, batch);
+      for (size_t j = 0; j < TEST_AXES; j++) {
+        assert(vec_equal(sat_project(vertices, n, axes[j]), expected[j]));
+        assert(vec_equal(batch[j], expected[j]));
+      }
+    }
+  }
+}
+
+// The narrowphase does not depend on the kernel
+void test_collision_kernels() {
+  polygon_t *ball = generate_ball(0, 0, 10);
+  polygon_t *other = generate_ball(0, 0, 10);
+  vector_t position = VEC_ZERO;
+  for (size_t i = 0; i < 64; i++) {
+    vector_t offset = vec_rotate((vector_t){i * 0.5, 0}, i);
+    polygon_translate(other, vec_subtract(offset, position));
+    position = offset;
+    sat_set_kernel(SAT_SCALAR);
+    collision_info_t expected = find_collision(ball, other);
+    for (sat_kernel_t k = SAT_SSE2; k <= SAT_AVX2; k++) {
+      if (!sat_kernel_supported(k)) {
+        continue;
+      }
+      sat_set_kernel(k);
+      collision_info_t info = find_collision(ball, other);
+      assert(info.collided == expected.collided);
+      assert(!info.collided || vec_equal(info.axis, expected.axis));
+    }
+  }
+  polygon_free(ball);
+  polygon_free(other);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_square)
+  DO_TEST(test_kernels_agree)
+  DO_TEST(test_collision_kernels)
+
+  puts("sat_test PASS");
+}
@@ -17,20 +17,12 @@ void test_empty_scene() {
   scene_free(scene);
 }
 
-list_t *make_shape() {
-  list_t *shape = list_init(4, free);
-  vector_t *v = malloc(sizeof(*v));
-  *v = (vector_t){-1, -1};
-  list_add(shape, v);
-  v = malloc(sizeof(*v));
-  *v = (vector_t){+1, -1};
-  list_add(shape, v);
-  v = malloc(sizeof(*v));
-  *v = (vector_t){+1, +1};
-  list_add(shape, v);
-  v = malloc(sizeof(*v));
-  *v = (vector_t){-1, +1};
-  list_add(shape, v);
+polygon_t *make_shape() {
+  polygon_t *shape = polygon_init(4);
+  polygon_add(shape, (vector_t){-1, -1});
+  polygon_add(shape, (vector_t){+1, -1});
+  polygon_add(shape, (vector_t){+1, +1});
+  polygon_add(shape, (vector_t){-1, +1});
   return shape;
 }
 
@@ -0,0 +1,192 @@
+#include "body.h"
+#include "pool_table.h"
+#include "scene.h"
+#include "shape_utility.h"
+#include "slab.h"
+#include "test_util.h"
+#include "thread_pool.h"
+#include <assert.h>
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool is_aligned(void *memory) {
+  return (uintptr_t)memory % alignof(max_align_t) == 0;
+}
+
+void test_alloc() {
+  slab_t *slab = slab_init("test_alloc", 3, 4);
+  assert(slab_find("test_alloc") == slab);
+  char *objects[6];
+  for (size_t i = 0; i < 6; i++) {
+    objects[i] = slab_alloc(slab);
+    assert(is_aligned(objects[i]));
+    for (size_t j = 0; j < i; j++) {
+      assert(objects[i] != objects[j]);
+    }
+  }
+  slab_stats_t stats = slab_stats(slab);
+  assert(stats.object_size >= 3);
+  assert(stats.live == 6 && stats.peak == 6);
+  assert(stats.capacity == 8);
+  assert(stats.allocations == 6 && stats.reused == 0);
+  slab_free(slab);
+  assert(slab_find("test_alloc") == NULL);
+}
+
+// Released objects are handed out again before any new page is allocated
+void test_reuse() {
+  slab_t *slab = slab_init("test_reuse", sizeof(double), 4);
+  double *a = slab_alloc(slab);
+  double *b = slab_alloc(slab);
+  slab_release(a);
+  slab_release(b);
+  assert(slab_alloc(slab) == b);
+  assert(slab_alloc(slab) == a);
+  slab_stats_t stats = slab_stats(slab);
+  assert(stats.live == 2 && stats.peak == 2);
+  assert(stats.capacity == 4);
+  assert(stats.allocations == 4 && stats.reused == 2);
+  slab_free(slab);
+}
+
+void test_registry() {
+  slab_t *first = slab_init("test_first", 1, 1);
+  slab_t *second = slab_init("test_second", 1, 1);
+  assert(slab_find("test_first") == first);
+  assert(slab_find("test_second") == second);
+  assert(strcmp(slab_name(first), "test_first") == 0);
+  size_t found = 0;
+  for (slab_t *slab = slab_next(NULL); slab != NULL; slab = slab_next(slab)) {
+    found += slab == first || slab == second;
+  }
+  assert(found == 2);
+  slab_free(first);
+  assert(slab_find("test_first") == NULL);
+  assert(slab_find("test_second") == second);
+  slab_free(second);
+}
+
+void test_body_churn() {
+  body_t *body = body_init_circle((vector_t){1, 2}, 3, (sprite_info_t){0}, 1);
+  slab_stats_t before = slab_stats(slab_find("body"));
+  body_free(body);
+  for (size_t i = 0; i < 100; i++) {
+    body = body_init_circle((vector_t){1, 2}, 3, (sprite_info_t){0}, 1);
+    assert(vec_equal(body_get_centroid(body), (vector_t){1, 2}));
+    body_free(body);
+  }
+  slab_stats_t after = slab_stats(slab_find("body"));
+  assert(after.live == before.live - 1);
+  assert(after.capacity == before.capacity);
+  assert(after.reused == before.reused + 100);
+}
+
+// Tearing a table down and setting it up again reuses every slot
+void test_table_churn() {
+  const char *names[] = {"body", "forcer_spec", "chaos_collision_params",
+                         "elasticity", "id"};
+  size_t count = sizeof(names) / sizeof(names[0]);
+  scene_t *scene = scene_init();
+  generate_pool_table(scene, true, true);
+  scene_free(scene);
+  slab_stats_t before[count];
+  for (size_t i = 0; i < count; i++) {
+    assert(slab_find(names[i]) != NULL);
+    before[i] = slab_stats(slab_find(names[i]));
+  }
+  for (size_t round = 0; round < 5; round++) {
+    scene = scene_init();
+    generate_pool_table(scene, true, true);
+    scene_free(scene);
+  }
+  for (size_t i = 0; i < count; i++) {
+    slab_stats_t after = slab_stats(slab_find(names[i]));
+    assert(after.live == before[i].live);
+    assert(after.capacity == before[i].capacity);
+    assert(after.allocations > before[i].allocations);
+    assert(after.reused - before[i].reused ==
+           after.allocations - before[i].allocations);
+  }
+}
+
+const size_t TEST_THREADS = 4;
+
+// Sets tables up and tears them down on whichever thread runs it, checking
+// that the thread's own slabs get every object back
+void churn_tables(void *aux, size_t start, size_t end) {
+  for (size_t i = start; i < end; i++) {
+    scene_t *scene = scene_init();
+    generate_pool_table(scene, true, true);
+    scene_free(scene);
+    slab_t *bodies = slab_find("body");
+    assert(bodies != NULL);
+    slab_stats_t before = slab_stats(bodies);
+    scene = scene_init();
+    generate_pool_table(scene, true, true);
+    scene_free(scene);
+    assert(slab_find("body") == bodies);
+    assert(slab_stats(bodies).live == before.live);
+    assert(slab_stats(bodies).capacity == before.capacity);
+  }
+}
+
+// Threads building their own tables at once do not share slabs
+void test_threads() {
+  thread_pool_t *pool = thread_pool_init(TEST_THREADS);
+  thread_pool_for(pool, 4 * TEST_THREADS, 1, churn_tables, NULL);
+  thread_pool_free(pool);
+}
+
+void release_objects(void *aux, size_t start, size_t end) {
+  void **objects = aux;
+  for (size_t i = start; i < end; i++) {
+    slab_release(objects[i]);
+  }
+}
+
+// Objects released on other threads go back to the slab they came from
+void test_remote_release() {
+  slab_t *slab = slab_init("test_remote_release", sizeof(double), 16);
+  void *objects[64];
+  for (size_t i = 0; i < 64; i++) {
+    objects[i] = slab_alloc(slab);
+  }
+  thread_pool_t *pool = thread_pool_init(TEST_THREADS);
+  thread_pool_for(pool, 64, 1, release_objects, objects);
+  thread_pool_free(pool);
+  assert(slab_stats(slab).live == 0);
+  for (size_t i = 0; i < 64; i++) {
+    void *object = slab_alloc(slab);
+    bool found = false;
+    for (size_t j = 0; j < 64 && !found; j++) {
+      found = objects[j] == object;
+    }
+    assert(found);
+  }
+  slab_stats_t stats = slab_stats(slab);
+  assert(stats.live == 64 && stats.capacity == 64);
+  assert(stats.reused == 64);
+  slab_free(slab);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_alloc)
+  DO_TEST(test_reuse)
+  DO_TEST(test_registry)
+  DO_TEST(test_body_churn)
+  DO_TEST(test_table_churn)
+  DO_TEST(test_threads)
+  DO_TEST(test_remote_release)
+
+  puts("slab_test PASS");
+}
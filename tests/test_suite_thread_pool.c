@@ -0,0 +1,151 @@
+#include "body.h"
+#include "forces.h"
+#include "kinematics.h"
+#include "scene.h"
+#include "shape_utility.h"
+#include "test_util.h"
+#include "thread_pool.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+const size_t TEST_THREADS[] = {1, 2, 3, 8};
+const size_t TEST_POOLS = sizeof(TEST_THREADS) / sizeof(TEST_THREADS[0]);
+const size_t TEST_BODIES = 120;
+const size_t TEST_TICKS = 40;
+
+void count_visits(void *aux, size_t start, size_t end) {
+  size_t *visits = aux;
+  for (size_t i = start; i < end; i++) {
+    visits[i]++;
+  }
+}
+
+// Every index is visited once, whatever the threads and grain
+void test_coverage() {
+  size_t counts[] = {0, 1, 7, 64, 1000, 4099};
+  for (size_t p = 0; p < TEST_POOLS; p++) {
+    thread_pool_t *pool = thread_pool_init(TEST_THREADS[p]);
+    assert(thread_pool_threads(pool) >= 1 &&
+           thread_pool_threads(pool) <= TEST_THREADS[p]);
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+      for (size_t grain = 1; grain <= 100; grain *= 10) {
+        size_t *visits = calloc(counts[c] + 1, sizeof(size_t));
+        thread_pool_for(pool, counts[c], grain, count_visits, visits);
+        for (size_t i = 0; i < counts[c]; i++) {
+          assert(visits[i] == 1);
+        }
+        free(visits);
+      }
+    }
+    thread_pool_free(pool);
+  }
+  // no pool runs on the calling thread
+  size_t visits[5] = {0};
+  thread_pool_for(NULL, 5, 1, count_visits, visits);
+  assert(visits[0] == 1 && visits[4] == 1);
+}
+
+// Pushes a body against the force it has gathered so far, so the result
+// depends on which force creators ran before it
+void push_back(body_t *body) {
+  kinematics_t *kin = body_get_kinematics(body);
+  body_add_force(body, vec_multiply(-0.5, kin->force[body_get_slot(body)]));
+}
+
+// Bodies on a grid, with springs between neighbors, pairwise gravity
+// among some of them, mutual gravity, drag and an order-sensitive
+// force creator that is not parallel
+scene_t *make_scene(thread_pool_t *pool, integrator_t integrator) {
+  scene_t *scene = scene_init();
+  scene_set_thread_pool(scene, pool);
+  scene_set_integrator(scene, integrator);
+  for (size_t i = 0; i < TEST_BODIES; i++) {
+    vector_t centroid = {(i % 12) * 30.0 + (i % 5), (i / 12) * 30.0};
+    body_t *body = body_init(generate_rect_shape(centroid.x, centroid.y, 2, 2),
+                             plain_sprite(), 1 + i % 3);
+    scene_add_body(scene, body);
+    body_set_gravitating(body, true);
+    create_drag(scene, 0.01, body);
+  }
+  for (size_t i = 0; i + 1 < TEST_BODIES; i++) {
+    create_spring(scene, 0.5, scene_get_body(scene, i),
+                  scene_get_body(scene, i + 1));
+    if (i % 10 == 0) {
+      body_t *body = scene_get_body(scene, i);
+      list_t *bodies = list_init(1, NULL);
+      list_add(bodies, body);
+      scene_add_bodies_force_creator(scene, (force_creator_t)push_back, body,
+                                     bodies, NULL);
+    }
+  }
+  for (size_t i = 0; i < 40; i++) {
+    for (size_t j = i + 1; j < 40; j++) {
+      create_newtonian_gravity(scene, 100, scene_get_body(scene, 3 * i),
+                               scene_get_body(scene, 3 * j));
+    }
+  }
+  create_mutual_gravity(scene, 50, 0.5);
+  return scene;
+}
+
+// Ticks give the same bits with any number of threads, or none,
+// including after bodies and their force creators are removed
+void check_deterministic(integrator_t integrator) {
+  scene_t *expected = make_scene(NULL, integrator);
+  scene_t *scenes[TEST_POOLS];
+  thread_pool_t *pools[TEST_POOLS];
+  for (size_t p = 0; p < TEST_POOLS; p++) {
+    pools[p] = thread_pool_init(TEST_THREADS[p]);
+    scenes[p] = make_scene(pools[p], integrator);
+  }
+  size_t forcers = scene_force_creators(expected);
+  for (size_t t = 0; t < TEST_TICKS; t++) {
+    if (t == TEST_TICKS / 2) {
+      body_remove(scene_get_body(expected, 6));
+      for (size_t p = 0; p < TEST_POOLS; p++) {
+        body_remove(scene_get_body(scenes[p], 6));
+      }
+    }
+    scene_tick(expected, 0.01);
+    for (size_t p = 0; p < TEST_POOLS; p++) {
+      scene_tick(scenes[p], 0.01);
+    }
+  }
+  assert(scene_force_creators(expected) < forcers);
+  for (size_t p = 0; p < TEST_POOLS; p++) {
+    assert(scene_bodies(scenes[p]) == scene_bodies(expected));
+    for (size_t i = 0; i < scene_bodies(expected); i++) {
+      body_t *body = scene_get_body(expected, i);
+      body_t *other = scene_get_body(scenes[p], i);
+      assert(vec_equal(body_get_centroid(body), body_get_centroid(other)));
+      assert(vec_equal(body_get_velocity(body), body_get_velocity(other)));
+    }
+    scene_free(scenes[p]);
+    thread_pool_free(pools[p]);
+  }
+  // something did happen
+  assert(!vec_equal(body_get_velocity(scene_get_body(expected, 0)), VEC_ZERO));
+  scene_free(expected);
+}
+
+void test_deterministic() {
+  check_deterministic(INTEGRATOR_AVERAGE_VELOCITY);
+  // stages re-run the parallel force creators
+  check_deterministic(INTEGRATOR_RK4);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_coverage)
+  DO_TEST(test_deterministic)
+
+  puts("thread_pool_test PASS");
+}